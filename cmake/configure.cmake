@@ -28,6 +28,10 @@ if(NOT WITH_PROFILER)
     add_definitions(-DPADDLE_DISABLE_PROFILER)
 endif(NOT WITH_PROFILER)
 
+# The CPU kernels evaluate the Eigen expressions on the intra-op thread pool,
+# Eigen only declares its ThreadPoolDevice with this.
+add_definitions(-DEIGEN_USE_THREADS)
+
 if(WITH_AVX AND AVX_FOUND)
     set(SIMD_FLAG ${AVX_FLAG})
     add_definitions(-DPADDLE_WITH_AVX)
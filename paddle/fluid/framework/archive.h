@@ -341,8 +341,8 @@ Archive<AR>& operator>>(Archive<AR>& ar, T (&p)[N]) {
   return ar;
 }
 
-template <class AR, class T>
-Archive<AR>& operator<<(Archive<AR>& ar, const std::vector<T>& p) {
+template <class AR, class T, class A>
+Archive<AR>& operator<<(Archive<AR>& ar, const std::vector<T, A>& p) {
 #ifdef _LINUX
   ar << (size_t)p.size();
 #else
@@ -354,8 +354,8 @@ Archive<AR>& operator<<(Archive<AR>& ar, const std::vector<T>& p) {
   return ar;
 }
 
-template <class AR, class T>
-Archive<AR>& operator>>(Archive<AR>& ar, std::vector<T>& p) {
+template <class AR, class T, class A>
+Archive<AR>& operator>>(Archive<AR>& ar, std::vector<T, A>& p) {
 #ifdef _LINUX
   p.resize(ar.template Get<size_t>());
 #else
@@ -415,6 +415,33 @@ inline BinaryArchive& operator>>(BinaryArchive& ar, std::string& s) {
   return ar;
 }
 
+// The strings of the other allocators, e.g. the RecordString.
+template <class Traits, class A>
+BinaryArchive& operator<<(BinaryArchive& ar,
+                          const std::basic_string<char, Traits, A>& s) {
+#ifdef _LINUX
+  ar << (size_t)s.length();
+#else
+  ar << (uint64_t)s.length();
+#endif
+  ar.Write(s.data(), s.length());
+  return ar;
+}
+
+template <class Traits, class A>
+BinaryArchive& operator>>(BinaryArchive& ar,
+                          std::basic_string<char, Traits, A>& s) {
+#ifdef _LINUX
+  size_t len = ar.template Get<size_t>();
+#else
+  size_t len = ar.template Get<uint64_t>();
+#endif
+  ar.PrepareRead(len);
+  s.assign(ar.Cursor(), len);
+  ar.AdvanceCursor(len);
+  return ar;
+}
+
 template <class AR, class T1, class T2>
 Archive<AR>& operator<<(Archive<AR>& ar, const std::pair<T1, T2>& x) {
   return ar << x.first << x.second;
@@ -0,0 +1,417 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/binary_slot_format.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/string/string_helper.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+constexpr char kMagic[4] = {'P', 'D', 'S', 'B'};
+constexpr char kIndexMagic[4] = {'P', 'D', 'S', 'I'};
+constexpr uint32_t kVersion = 1;
+
+uint32_t Crc32(const char* data, size_t size) {
+  static const std::vector<uint32_t> table = [] {
+    std::vector<uint32_t> t(256);
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+      }
+      t[i] = c;
+    }
+    return t;
+  }();
+  uint32_t crc = 0xFFFFFFFFU;
+  for (size_t i = 0; i < size; ++i) {
+    crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFU;
+}
+
+template <typename T>
+void Append(std::string* buffer, const T& value) {
+  buffer->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void AppendVarint(std::string* buffer, uint64_t value) {
+  while (value >= 0x80) {
+    buffer->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  buffer->push_back(static_cast<char>(value));
+}
+
+void AppendString(std::string* buffer, const std::string& str) {
+  AppendVarint(buffer, str.size());
+  buffer->append(str);
+}
+
+// Decode the payload of a block, every read is checked against its end.
+class PayloadReader {
+ public:
+  PayloadReader(const char* data, size_t size)
+      : pos_(data), end_(data + size) {}
+
+  uint64_t Varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      Check(1);
+      uint8_t byte = static_cast<uint8_t>(*pos_++);
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if (byte < 0x80) return value;
+    }
+    PADDLE_THROW(platform::errors::InvalidArgument(
+        "The binary slot block has an invalid varint."));
+  }
+
+  void Raw(void* data, size_t size) {
+    Check(size);
+    std::memcpy(data, pos_, size);
+    pos_ += size;
+  }
+
+  void String(std::string* str) {
+    size_t size = Varint();
+    Check(size);
+    str->assign(pos_, size);
+    pos_ += size;
+  }
+
+  bool AtEnd() const { return pos_ == end_; }
+
+ private:
+  void Check(size_t size) const {
+    PADDLE_ENFORCE_LE(size, static_cast<size_t>(end_ - pos_),
+                      platform::errors::InvalidArgument(
+                          "The binary slot block is truncated."));
+  }
+
+  const char* pos_;
+  const char* end_;
+};
+
+void CheckSlotTypes(const std::string& slot_types) {
+  for (char type : slot_types) {
+    PADDLE_ENFORCE_EQ(type == 'u' || type == 'f', true,
+                      platform::errors::InvalidArgument(
+                          "The slot type should be 'u' or 'f', but got '%c'.",
+                          type));
+  }
+}
+
+}  // namespace
+
+void BinarySlotBlock::Reset(const std::string& slot_types) {
+  num_instances = 0;
+  offsets.resize(slot_types.size());
+  uint64_values.resize(slot_types.size());
+  float_values.resize(slot_types.size());
+  for (size_t i = 0; i < slot_types.size(); ++i) {
+    offsets[i].assign(1, 0);
+    uint64_values[i].clear();
+    float_values[i].clear();
+  }
+  ins_ids.clear();
+  contents.clear();
+  log_keys.clear();
+}
+
+void BinarySlotBlock::EndInstance() {
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    offsets[i].push_back(static_cast<uint32_t>(uint64_values[i].size() +
+                                               float_values[i].size()));
+  }
+  ++num_instances;
+}
+
+BinarySlotWriter::BinarySlotWriter(FILE* fp, const std::string& slot_types,
+                                   uint32_t flags, size_t block_size)
+    : fp_(fp), slot_types_(slot_types), flags_(flags), block_size_(block_size) {
+  PADDLE_ENFORCE_NOT_NULL(fp, platform::errors::InvalidArgument(
+                                  "The file of BinarySlotWriter is null."));
+  PADDLE_ENFORCE_GT(block_size, 0UL,
+                    platform::errors::InvalidArgument(
+                        "The block size should be greater than 0."));
+  CheckSlotTypes(slot_types);
+  block_.Reset(slot_types_);
+  std::string header(kMagic, sizeof(kMagic));
+  Append(&header, kVersion);
+  Append(&header, flags_);
+  Append(&header, static_cast<uint32_t>(slot_types_.size()));
+  header.append(slot_types_);
+  Write(header.data(), header.size());
+}
+
+void BinarySlotWriter::EndInstance() {
+  block_.EndInstance();
+  if (block_.num_instances >= block_size_) Flush();
+}
+
+void BinarySlotWriter::Flush() {
+  if (block_.num_instances == 0) return;
+  buffer_.clear();
+  for (size_t i = 0; i < slot_types_.size(); ++i) {
+    const auto& offsets = block_.offsets[i];
+    for (size_t k = 0; k < block_.num_instances; ++k) {
+      AppendVarint(&buffer_, offsets[k + 1] - offsets[k]);
+    }
+    if (slot_types_[i] == 'u') {
+      uint64_t prev = 0;
+      for (uint64_t value : block_.uint64_values[i]) {
+        auto delta = static_cast<int64_t>(value - prev);
+        AppendVarint(&buffer_, (static_cast<uint64_t>(delta) << 1) ^
+                                   static_cast<uint64_t>(delta >> 63));
+        prev = value;
+      }
+    } else {
+      const auto& values = block_.float_values[i];
+      buffer_.append(reinterpret_cast<const char*>(values.data()),
+                     values.size() * sizeof(float));
+    }
+  }
+  auto append_strings = [this](uint32_t flag,
+                               const std::vector<std::string>& strs) {
+    if (!(flags_ & flag)) return;
+    PADDLE_ENFORCE_EQ(strs.size(), block_.num_instances,
+                      platform::errors::InvalidArgument(
+                          "Every instance should have the strings given by "
+                          "the flags."));
+    for (auto& str : strs) AppendString(&buffer_, str);
+  };
+  append_strings(kBinarySlotHasInsId, block_.ins_ids);
+  append_strings(kBinarySlotHasContent, block_.contents);
+  append_strings(kBinarySlotHasLogKey, block_.log_keys);
+
+  index_.push_back({offset_, static_cast<uint32_t>(block_.num_instances)});
+  std::string header;
+  Append(&header, static_cast<uint32_t>(block_.num_instances));
+  Append(&header, static_cast<uint32_t>(buffer_.size()));
+  Append(&header, Crc32(buffer_.data(), buffer_.size()));
+  Write(header.data(), header.size());
+  Write(buffer_.data(), buffer_.size());
+  block_.Reset(slot_types_);
+}
+
+void BinarySlotWriter::Close() {
+  Flush();
+  std::string tail;
+  Append(&tail, static_cast<uint32_t>(0));
+  uint64_t index_offset = offset_ + tail.size();
+  Append(&tail, static_cast<uint64_t>(index_.size()));
+  for (auto& info : index_) {
+    Append(&tail, info.offset);
+    Append(&tail, info.num_instances);
+  }
+  Append(&tail, index_offset);
+  tail.append(kIndexMagic, sizeof(kIndexMagic));
+  Write(tail.data(), tail.size());
+  PADDLE_ENFORCE_EQ(fflush(fp_), 0,
+                    platform::errors::Unavailable(
+                        "Failed to flush the binary slot file."));
+}
+
+void BinarySlotWriter::Write(const void* data, size_t size) {
+  PADDLE_ENFORCE_EQ(fwrite(data, 1, size, fp_), size,
+                    platform::errors::Unavailable(
+                        "Failed to write the binary slot file."));
+  offset_ += size;
+}
+
+BinarySlotReader::BinarySlotReader(FILE* fp) : fp_(fp) {
+  PADDLE_ENFORCE_NOT_NULL(fp, platform::errors::InvalidArgument(
+                                  "The file of BinarySlotReader is null."));
+  char magic[sizeof(kMagic)];
+  Read(magic, sizeof(magic));
+  PADDLE_ENFORCE_EQ(std::memcmp(magic, kMagic, sizeof(kMagic)), 0,
+                    platform::errors::InvalidArgument(
+                        "The file is not in the binary slot format."));
+  uint32_t version;
+  Read(&version, sizeof(version));
+  PADDLE_ENFORCE_EQ(version, kVersion,
+                    platform::errors::InvalidArgument(
+                        "Only version %d of the binary slot format is "
+                        "supported, but got %d.",
+                        kVersion, version));
+  Read(&flags_, sizeof(flags_));
+  uint32_t num_slots;
+  Read(&num_slots, sizeof(num_slots));
+  slot_types_.resize(num_slots);
+  Read(&slot_types_[0], num_slots);
+  CheckSlotTypes(slot_types_);
+}
+
+bool BinarySlotReader::ReadBlock(BinarySlotBlock* block) {
+  block->Reset(slot_types_);
+  uint32_t num_instances;
+  Read(&num_instances, sizeof(num_instances));
+  if (num_instances == 0) return false;
+  uint32_t size;
+  uint32_t crc;
+  Read(&size, sizeof(size));
+  Read(&crc, sizeof(crc));
+  buffer_.resize(size);
+  Read(&buffer_[0], size);
+  PADDLE_ENFORCE_EQ(Crc32(buffer_.data(), size), crc,
+                    platform::errors::InvalidArgument(
+                        "The checksum of the binary slot block mismatches."));
+
+  PayloadReader reader(buffer_.data(), size);
+  for (size_t i = 0; i < slot_types_.size(); ++i) {
+    auto& offsets = block->offsets[i];
+    offsets.resize(num_instances + 1);
+    for (uint32_t k = 0; k < num_instances; ++k) {
+      offsets[k + 1] = offsets[k] + static_cast<uint32_t>(reader.Varint());
+    }
+    size_t num_values = offsets[num_instances];
+    if (slot_types_[i] == 'u') {
+      auto& values = block->uint64_values[i];
+      values.resize(num_values);
+      uint64_t prev = 0;
+      for (size_t k = 0; k < num_values; ++k) {
+        uint64_t zigzag = reader.Varint();
+        prev += (zigzag >> 1) ^ (~(zigzag & 1) + 1);
+        values[k] = prev;
+      }
+    } else {
+      auto& values = block->float_values[i];
+      values.resize(num_values);
+      reader.Raw(values.data(), num_values * sizeof(float));
+    }
+  }
+  auto read_strings = [&](uint32_t flag, std::vector<std::string>* strs) {
+    if (!(flags_ & flag)) return;
+    strs->resize(num_instances);
+    for (auto& str : *strs) reader.String(&str);
+  };
+  read_strings(kBinarySlotHasInsId, &block->ins_ids);
+  read_strings(kBinarySlotHasContent, &block->contents);
+  read_strings(kBinarySlotHasLogKey, &block->log_keys);
+  PADDLE_ENFORCE_EQ(reader.AtEnd(), true,
+                    platform::errors::InvalidArgument(
+                        "The binary slot block has trailing bytes."));
+  block->num_instances = num_instances;
+  return true;
+}
+
+void BinarySlotReader::Read(void* data, size_t size) {
+  PADDLE_ENFORCE_EQ(fread(data, 1, size, fp_), size,
+                    platform::errors::InvalidArgument(
+                        "The binary slot file is truncated."));
+}
+
+std::vector<BinarySlotBlockInfo> ReadBinarySlotIndex(const std::string& path) {
+  std::unique_ptr<FILE, int (*)(FILE*)> fp(fopen(path.c_str(), "rb"),
+                                           &fclose);
+  PADDLE_ENFORCE_NOT_NULL(fp.get(), platform::errors::NotFound(
+                                        "Cannot open the file %s.", path));
+  auto read = [&fp, &path](void* data, size_t size) {
+    PADDLE_ENFORCE_EQ(fread(data, 1, size, fp.get()), size,
+                      platform::errors::InvalidArgument(
+                          "The index of %s is truncated.", path));
+  };
+  uint64_t index_offset;
+  char magic[sizeof(kIndexMagic)];
+  PADDLE_ENFORCE_EQ(
+      fseek(fp.get(), -static_cast<long>(sizeof(index_offset) +  // NOLINT
+                                         sizeof(magic)),
+            SEEK_END),
+      0, platform::errors::InvalidArgument("%s is not seekable.", path));
+  read(&index_offset, sizeof(index_offset));
+  read(magic, sizeof(magic));
+  PADDLE_ENFORCE_EQ(std::memcmp(magic, kIndexMagic, sizeof(magic)), 0,
+                    platform::errors::InvalidArgument(
+                        "%s has no binary slot index.", path));
+  PADDLE_ENFORCE_EQ(
+      fseek(fp.get(), static_cast<long>(index_offset), SEEK_SET),  // NOLINT
+      0, platform::errors::InvalidArgument("%s is not seekable.", path));
+  uint64_t num_blocks;
+  read(&num_blocks, sizeof(num_blocks));
+  std::vector<BinarySlotBlockInfo> index(num_blocks);
+  for (auto& info : index) {
+    read(&info.offset, sizeof(info.offset));
+    read(&info.num_instances, sizeof(info.num_instances));
+  }
+  return index;
+}
+
+int64_t ConvertMultiSlotTextToBinary(FILE* in, BinarySlotWriter* writer) {
+  string::LineFileReader line_reader;
+  const auto& slot_types = writer->slot_types();
+  uint32_t flags = writer->flags();
+  int64_t num_instances = 0;
+  while (line_reader.getline(in)) {
+    if (line_reader.length() == 0) continue;
+    char* pos = line_reader.get();
+    auto* block = writer->block();
+    auto parse_string = [&pos, &line_reader](std::string* str) {
+      int num = strtol(pos, &pos, 10);
+      PADDLE_ENFORCE_EQ(num, 1, platform::errors::InvalidArgument(
+                                    "Invalid line: %s", line_reader.get()));
+      while (*pos == ' ') ++pos;
+      char* end = pos;
+      while (*end != ' ' && *end != '\0') ++end;
+      str->assign(pos, end - pos);
+      pos = end;
+    };
+    if (flags & kBinarySlotHasInsId) {
+      block->ins_ids.emplace_back();
+      parse_string(&block->ins_ids.back());
+    }
+    if (flags & kBinarySlotHasContent) {
+      block->contents.emplace_back();
+      parse_string(&block->contents.back());
+    }
+    if (flags & kBinarySlotHasLogKey) {
+      block->log_keys.emplace_back();
+      parse_string(&block->log_keys.back());
+    }
+    for (size_t i = 0; i < slot_types.size(); ++i) {
+      char* end = pos;
+      int num = strtol(pos, &end, 10);
+      PADDLE_ENFORCE_EQ(end != pos && num > 0, true,
+                        platform::errors::InvalidArgument(
+                            "The number of ids of slot %d should be greater "
+                            "than 0, invalid line: %s",
+                            i, line_reader.get()));
+      pos = end;
+      for (int j = 0; j < num; ++j) {
+        if (slot_types[i] == 'u') {
+          block->uint64_values[i].push_back(strtoull(pos, &end, 10));
+        } else {
+          block->float_values[i].push_back(strtof(pos, &end));
+        }
+        PADDLE_ENFORCE_NE(end, pos, platform::errors::InvalidArgument(
+                                        "Invalid value of slot %d, line: %s",
+                                        i, line_reader.get()));
+        pos = end;
+      }
+    }
+    writer->EndInstance();
+    ++num_instances;
+  }
+  return num_instances;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,137 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// The binary columnar format of the MultiSlot instances, loaded by
+// MultiSlotInMemoryDataFeed without parsing any text.
+//
+// A file is a header, a sequence of blocks, an end mark, a block index and
+// a trailer, all little-endian:
+//
+//   header:  magic "PDSB", uint32 version, uint32 flags, uint32 slot num,
+//            one char 'u' or 'f' per slot
+//   block:   uint32 instance num (> 0), uint32 payload bytes,
+//            uint32 CRC32 of the payload, payload
+//   end:     uint32 0
+//   index:   uint64 block num, then uint64 offset and uint32 instance num
+//            of every block
+//   trailer: uint64 offset of the index, magic "PDSI"
+//
+// The payload stores the instances of a block by columns. For every slot,
+// the varint feasign counts of the instances, then the values, uint64 ones
+// as zigzag varints of the deltas between the neighbours, float ones raw.
+// Then the varint length prefixed ins_id, content and log_key strings of
+// the instances, for the ones present in the flags.
+//
+// The blocks are read sequentially, so a file is read through the pipes of
+// fs_open_read as well. The index is only for the seekable files, e.g. to
+// split a file between the readers.
+
+constexpr uint32_t kBinarySlotHasInsId = 1;
+constexpr uint32_t kBinarySlotHasContent = 2;
+constexpr uint32_t kBinarySlotHasLogKey = 4;
+
+// The instances of a block by columns.
+struct BinarySlotBlock {
+  // Resize the columns for the slot types, and clear them.
+  void Reset(const std::string& slot_types);
+  // Close the instance whose values are appended to the columns.
+  void EndInstance();
+
+  size_t num_instances{0};
+  // The values of the instance i of a slot are in
+  // [offsets[slot][i], offsets[slot][i + 1]).
+  std::vector<std::vector<uint32_t>> offsets;
+  std::vector<std::vector<uint64_t>> uint64_values;
+  std::vector<std::vector<float>> float_values;
+  std::vector<std::string> ins_ids;
+  std::vector<std::string> contents;
+  std::vector<std::string> log_keys;
+};
+
+struct BinarySlotBlockInfo {
+  uint64_t offset;
+  uint32_t num_instances;
+};
+
+class BinarySlotWriter {
+ public:
+  // slot_types has one char 'u' or 'f' per slot.
+  BinarySlotWriter(FILE* fp, const std::string& slot_types, uint32_t flags,
+                   size_t block_size = 4096);
+
+  // Append the values and the strings of an instance to the columns, then
+  // call EndInstance().
+  BinarySlotBlock* block() { return &block_; }
+  void EndInstance();
+  const std::string& slot_types() const { return slot_types_; }
+  uint32_t flags() const { return flags_; }
+  // Write the last block, the end mark, the index and the trailer.
+  void Close();
+
+ private:
+  void Flush();
+  void Write(const void* data, size_t size);
+
+  FILE* fp_;
+  std::string slot_types_;
+  uint32_t flags_;
+  size_t block_size_;
+  uint64_t offset_{0};
+  BinarySlotBlock block_;
+  std::vector<BinarySlotBlockInfo> index_;
+  std::string buffer_;
+};
+
+class BinarySlotReader {
+ public:
+  // Read the header of the file.
+  explicit BinarySlotReader(FILE* fp);
+
+  const std::string& slot_types() const { return slot_types_; }
+  uint32_t flags() const { return flags_; }
+
+  // Read and verify the next block, return false at the end of the blocks.
+  bool ReadBlock(BinarySlotBlock* block);
+
+ private:
+  void Read(void* data, size_t size);
+
+  FILE* fp_;
+  std::string slot_types_;
+  uint32_t flags_{0};
+  std::string buffer_;
+};
+
+// Read the block index of a seekable file.
+std::vector<BinarySlotBlockInfo> ReadBinarySlotIndex(const std::string& path);
+
+// Convert the MultiSlot text instances of `in` to `writer`, every line has
+// the optional "1 <ins_id>", "1 <content>" and "1 <log_key>" given by the
+// flags of the writer, then "<num> <value>..." of every slot. The zero
+// values are kept, the data feed drops them as it does for the text.
+// Return the number of the instances.
+int64_t ConvertMultiSlotTextToBinary(FILE* in, BinarySlotWriter* writer);
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,103 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/binary_slot_format.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+const char kText[] =
+    "1 ins_0 2 12345678901234 7 2 1 0.5\n"
+    "1 ins_1 1 0 2 -1.5 0\n"
+    "1 ins_2 3 3 2 1 1 2.25\n";
+
+// Convert kText to `path` with 2 instances per block.
+void WriteBinary(const std::string& path) {
+  FILE* in = tmpfile();
+  fputs(kText, in);
+  rewind(in);
+  FILE* out = fopen(path.c_str(), "wb");
+  BinarySlotWriter writer(out, "uf", kBinarySlotHasInsId, 2);
+  ASSERT_EQ(ConvertMultiSlotTextToBinary(in, &writer), 3);
+  writer.Close();
+  fclose(out);
+  fclose(in);
+}
+
+}  // namespace
+
+TEST(BinarySlotFormat, ConvertAndRead) {
+  std::string path = "binary_slot_format_test.bin";
+  WriteBinary(path);
+
+  FILE* fp = fopen(path.c_str(), "rb");
+  BinarySlotReader reader(fp);
+  ASSERT_EQ(reader.slot_types(), "uf");
+  ASSERT_EQ(reader.flags(), kBinarySlotHasInsId);
+
+  BinarySlotBlock block;
+  ASSERT_TRUE(reader.ReadBlock(&block));
+  ASSERT_EQ(block.num_instances, 2UL);
+  ASSERT_EQ(block.ins_ids, std::vector<std::string>({"ins_0", "ins_1"}));
+  ASSERT_EQ(block.offsets[0], std::vector<uint32_t>({0, 2, 3}));
+  ASSERT_EQ(block.uint64_values[0],
+            std::vector<uint64_t>({12345678901234ULL, 7, 0}));
+  ASSERT_EQ(block.offsets[1], std::vector<uint32_t>({0, 2, 4}));
+  ASSERT_EQ(block.float_values[1],
+            std::vector<float>({1.0f, 0.5f, -1.5f, 0.0f}));
+
+  ASSERT_TRUE(reader.ReadBlock(&block));
+  ASSERT_EQ(block.num_instances, 1UL);
+  ASSERT_EQ(block.ins_ids[0], "ins_2");
+  ASSERT_EQ(block.uint64_values[0], std::vector<uint64_t>({3, 2, 1}));
+  ASSERT_EQ(block.float_values[1], std::vector<float>({2.25f}));
+  ASSERT_FALSE(reader.ReadBlock(&block));
+  fclose(fp);
+
+  auto index = ReadBinarySlotIndex(path);
+  ASSERT_EQ(index.size(), 2UL);
+  ASSERT_EQ(index[0].num_instances, 2U);
+  ASSERT_EQ(index[1].num_instances, 1U);
+  ASSERT_LT(index[0].offset, index[1].offset);
+  remove(path.c_str());
+}
+
+TEST(BinarySlotFormat, Checksum) {
+  std::string path = "binary_slot_format_checksum_test.bin";
+  WriteBinary(path);
+  // Flip the last byte of the first payload, before the second block.
+  auto index = ReadBinarySlotIndex(path);
+  FILE* fp = fopen(path.c_str(), "r+b");
+  fseek(fp, static_cast<long>(index[1].offset - 1), SEEK_SET);  // NOLINT
+  int byte = fgetc(fp);
+  fseek(fp, static_cast<long>(index[1].offset - 1), SEEK_SET);  // NOLINT
+  fputc(byte ^ 0xFF, fp);
+  rewind(fp);
+  BinarySlotReader reader(fp);
+  BinarySlotBlock block;
+  ASSERT_ANY_THROW(reader.ReadBlock(&block));
+  fclose(fp);
+  remove(path.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
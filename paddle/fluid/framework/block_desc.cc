@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/block_desc.h"
 
+#include <mutex>  // NOLINT
 #include <queue>
 #include <unordered_set>
 #include <utility>
@@ -227,6 +228,37 @@ BlockDesc::BlockDesc(const BlockDesc &other, proto::BlockDesc *desc,
   }
 }
 
+namespace {
+struct DestroyHooks {
+  std::mutex mutex;
+  std::vector<BlockDesc::DestroyHook> hooks;
+};
+
+// Never deleted, the blocks of the static programs may be destroyed after it.
+DestroyHooks &GetDestroyHooks() {
+  static auto *hooks = new DestroyHooks();
+  return *hooks;
+}
+}  // namespace
+
+BlockDesc::~BlockDesc() {
+  auto &destroy_hooks = GetDestroyHooks();
+  std::vector<DestroyHook> hooks;
+  {
+    std::lock_guard<std::mutex> guard(destroy_hooks.mutex);
+    hooks = destroy_hooks.hooks;
+  }
+  for (auto hook : hooks) {
+    hook(this);
+  }
+}
+
+void BlockDesc::AddDestroyHook(DestroyHook hook) {
+  auto &destroy_hooks = GetDestroyHooks();
+  std::lock_guard<std::mutex> guard(destroy_hooks.mutex);
+  destroy_hooks.hooks.push_back(hook);
+}
+
 void BlockDesc::SetForwardBlockID(int32_t forward_block_id) {
   PADDLE_ENFORCE_EQ(
       desc_->has_forward_block_idx(), false,
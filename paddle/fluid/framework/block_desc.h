@@ -41,6 +41,13 @@ class BlockDesc {
 
   BlockDesc(const BlockDesc &other, proto::BlockDesc *desc, ProgramDesc *prog);
 
+  ~BlockDesc();
+
+  // The hooks are called with each BlockDesc being destroyed, so that the
+  // caches keyed by its address can drop their entries.
+  using DestroyHook = void (*)(const BlockDesc *);
+  static void AddDestroyHook(DestroyHook hook);
+
   int32_t ID() const { return desc_->idx(); }
 
   int32_t Parent() const { return desc_->parent_idx(); }
@@ -29,6 +29,7 @@
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/expect.h"
+#include "paddle/fluid/framework/mpmc_ring.h"
 
 namespace paddle {
 namespace framework {
@@ -43,13 +44,52 @@ class ChannelObject {
     capacity_ = (std::min)(MaxCapacity(), capacity);
   }
 
-  const std::deque<T>& GetData() const { return data_; }
+  const std::deque<T>& GetData() const {
+    CHECK(ring_ == nullptr) << "lock-free channel has no deque";
+    return data_;
+  }
   void Clear() {
     std::unique_lock<std::mutex> lock(mutex_);
+    if (ring_ != nullptr) {
+      T val;
+      while (ring_->TryPop(&val)) {
+      }
+    }
     data_.clear();
     data_.shrink_to_fit();
   }
 
+  // Move the data to a lock-free MpmcRing of at least capacity items, then
+  // Get/Put/Read/Write take no mutex. The ring is bounded, so it suits the
+  // phases moving a known number of items, e.g. a training pass of Dataset.
+  // SetLockFree(0) moves the data back to the deque. Only switch while no
+  // other thread uses the channel.
+  void SetLockFree(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ring_ != nullptr) {
+      T val;
+      while (ring_->TryPop(&val)) {
+        data_.push_back(std::move(val));
+      }
+      closed_ = ring_->Closed();
+      ring_.reset();
+    }
+    if (capacity == 0) {
+      return;
+    }
+    ring_.reset(new MpmcRing<T>((std::max)(capacity, data_.size())));
+    for (auto& val : data_) {
+      ring_->TryPush(&val);
+    }
+    data_.clear();
+    data_.shrink_to_fit();
+    if (closed_) {
+      ring_->Close();
+    }
+  }
+
+  bool LockFree() { return ring_ != nullptr; }
+
   size_t Capacity() {
     return capacity_;  // atomic
   }
@@ -78,11 +118,18 @@ class ChannelObject {
   }
 
   bool Closed() {
+    if (ring_ != nullptr) {
+      return ring_->Closed();
+    }
     return closed_;  // atomic
   }
 
   // open channel, then data can be write() to channel
   void Open() {
+    if (ring_ != nullptr) {
+      ring_->Open();
+      return;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = false;
     Notify();
@@ -90,17 +137,27 @@ class ChannelObject {
 
   // close channel, then no more data can be write() to channel
   void Close() {
+    if (ring_ != nullptr) {
+      ring_->Close();
+      return;
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     closed_ = true;
     Notify();
   }
 
   size_t Size() {
+    if (ring_ != nullptr) {
+      return ring_->Size();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return data_.size();
   }
 
   bool Empty() {
+    if (ring_ != nullptr) {
+      return ring_->Empty();
+    }
     std::lock_guard<std::mutex> lock(mutex_);
     return EmptyUnlocked();
   }
@@ -114,6 +171,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_ != nullptr) {
+      return ring_->Read(n, p);
+    }
 
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Read(n, p, lock);
@@ -133,6 +193,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_ != nullptr) {
+      return ring_->Write(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = Write(n, p, lock);
     Notify();
@@ -144,6 +207,9 @@ class ChannelObject {
     if (n == 0) {
       return 0;
     }
+    if (ring_ != nullptr) {
+      return ring_->WriteMove(n, p);
+    }
     std::unique_lock<std::mutex> lock(mutex_);
     size_t finished = WriteMove(n, p, lock);
     Notify();
@@ -191,6 +257,8 @@ class ChannelObject {
   int full_waiters_ = 0;
   std::condition_variable empty_cond_;
   std::condition_variable full_cond_;
+  // set by SetLockFree(), then it holds the data instead of data_
+  std::unique_ptr<MpmcRing<T>> ring_;
 
   static constexpr size_t MaxCapacity() {
     return (std::numeric_limits<size_t>::max)() / 2;
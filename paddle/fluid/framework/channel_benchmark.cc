@@ -0,0 +1,95 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Compare the mutex guarded ChannelObject against the same channel after
+// SetLockFree(), with producer threads writing blocks of items and consumer
+// threads reading them as the data feeds do. Report the items per second.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/channel.h"
+
+DEFINE_int32(producers, 4, "The number of the producer threads.");
+DEFINE_int32(consumers, 4, "The number of the consumer threads.");
+DEFINE_int64(items, 10000000, "The number of the items per producer.");
+DEFINE_int32(block_size, 32, "The block size of the channel.");
+DEFINE_int64(capacity, 65536, "The capacity of the channel.");
+
+namespace paddle {
+namespace framework {
+
+void Bench(const char* name, bool lock_free) {
+  auto channel = MakeChannel<uint64_t>();
+  channel->SetBlockSize(FLAGS_block_size);
+  channel->SetCapacity(FLAGS_capacity);
+  if (lock_free) {
+    channel->SetLockFree(FLAGS_capacity);
+  }
+  std::atomic<uint64_t> checksum{0};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> producers;
+  for (int t = 0; t < FLAGS_producers; ++t) {
+    producers.emplace_back([&channel]() {
+      std::vector<uint64_t> block;
+      for (int64_t i = 0; i < FLAGS_items; i += FLAGS_block_size) {
+        int64_t n = std::min<int64_t>(FLAGS_block_size, FLAGS_items - i);
+        block.resize(n);
+        for (int64_t j = 0; j < n; ++j) block[j] = i + j;
+        channel->Write(std::move(block));
+      }
+    });
+  }
+  std::vector<std::thread> consumers;
+  for (int t = 0; t < FLAGS_consumers; ++t) {
+    consumers.emplace_back([&channel, &checksum]() {
+      std::vector<uint64_t> block;
+      uint64_t sum = 0;
+      while (channel->Read(block) != 0) {
+        for (auto item : block) sum += item;
+      }
+      checksum += sum;
+    });
+  }
+  for (auto& thread : producers) thread.join();
+  channel->Close();
+  for (auto& thread : consumers) thread.join();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  LOG(INFO) << name << ": " << FLAGS_producers * FLAGS_items / seconds
+            << " items/s, checksum " << checksum.load();
+}
+
+void RunBenchmark() {
+  LOG(INFO) << FLAGS_producers << " producers, " << FLAGS_consumers
+            << " consumers, block size " << FLAGS_block_size;
+  Bench("ChannelObject", false);
+  Bench("ChannelObject lock-free", true);
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::RunBenchmark();
+  return 0;
+}
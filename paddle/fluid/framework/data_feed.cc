@@ -35,11 +35,105 @@ limitations under the License. */
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/fleet/box_wrapper.h"
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
+#include "paddle/fluid/framework/slot_text_parser.h"
 #include "paddle/fluid/platform/timer.h"
 
 namespace paddle {
 namespace framework {
 
+namespace {
+
+// Split the line read by the current thread into its tokens.
+const SlotTextTokenizer& SplitLine(const char* line, size_t size) {
+  thread_local SlotTextTokenizer tokens;
+  tokens.Split(line, size);
+  return tokens;
+}
+
+// Read the feasign number of a slot at tokens[*pos], and move *pos to its
+// first feasign.
+int ReadSlotNum(const SlotTextTokenizer& tokens, size_t* pos,
+                const char* line) {
+  uint64_t num = 0;
+  bool valid = *pos < tokens.size() &&
+               ParseUint64(tokens.begin(*pos), tokens.end(*pos), &num) &&
+               num > 0;
+  PADDLE_ENFORCE_EQ(
+      valid, true,
+      platform::errors::InvalidArgument(
+          "The number of ids can not be zero, you need padding "
+          "it in data generator; or if there is something wrong with "
+          "the data, please check if the data contains unresolvable "
+          "characters.\nplease check this error line: %s",
+          line));
+  ++*pos;
+  PADDLE_ENFORCE_LE(*pos + num, tokens.size(),
+                    platform::errors::InvalidArgument(
+                        "The line has fewer feasigns than its slot needs, "
+                        "please check this error line: %s",
+                        line));
+  return static_cast<int>(num);
+}
+
+uint64_t ReadUint64Feasign(const SlotTextTokenizer& tokens, size_t pos,
+                           const char* line) {
+  uint64_t feasign = 0;
+  PADDLE_ENFORCE_EQ(
+      ParseUint64(tokens.begin(pos), tokens.end(pos), &feasign), true,
+      platform::errors::InvalidArgument(
+          "Invalid uint64 feasign %s, please check this error line: %s",
+          std::string(tokens.begin(pos), tokens.end(pos)), line));
+  return feasign;
+}
+
+float ReadFloatFeasign(const SlotTextTokenizer& tokens, size_t pos,
+                       const char* line) {
+  float feasign = 0;
+  PADDLE_ENFORCE_EQ(
+      ParseFloat(tokens.begin(pos), tokens.end(pos), &feasign), true,
+      platform::errors::InvalidArgument(
+          "Invalid float feasign %s, please check this error line: %s",
+          std::string(tokens.begin(pos), tokens.end(pos)), line));
+  return feasign;
+}
+
+// Read the "1 <string>" field at tokens[*pos], e.g. the ins_id.
+std::string ReadStringField(const SlotTextTokenizer& tokens, size_t* pos,
+                            const char* line) {
+  int num = ReadSlotNum(tokens, pos, line);
+  PADDLE_ENFORCE_EQ(num, 1, platform::errors::InvalidArgument(
+                                "The ins_id, content and log_key should have "
+                                "1 value, but got %d in line: %s",
+                                num, line));
+  std::string field(tokens.begin(*pos), tokens.end(*pos));
+  ++*pos;
+  return field;
+}
+
+// The feasigns of the instance parsed by the current thread. They are copied
+// to the Record at once, so that the RecordArena keeps no buffer outgrown by
+// the push_backs.
+struct InstanceFeasigns {
+  void CopyTo(Record* instance) const {
+    instance->uint64_feasigns_.assign(uint64_feasigns.begin(),
+                                      uint64_feasigns.end());
+    instance->float_feasigns_.assign(float_feasigns.begin(),
+                                     float_feasigns.end());
+  }
+
+  std::vector<FeatureItem> uint64_feasigns;
+  std::vector<FeatureItem> float_feasigns;
+};
+
+InstanceFeasigns& NewInstanceFeasigns() {
+  thread_local InstanceFeasigns feasigns;
+  feasigns.uint64_feasigns.clear();
+  feasigns.float_feasigns.clear();
+  return feasigns;
+}
+
+}  // namespace
+
 void RecordCandidateList::ReSize(size_t length) {
   _mutex.lock();
   _capacity = length;
@@ -245,7 +339,9 @@ template <typename T>
 bool InMemoryDataFeed<T>::Start() {
 #ifdef _LINUX
   this->CheckSetFileList();
-  if (output_channel_->Size() == 0 && input_channel_->Size() != 0) {
+  // The input channel of a streaming shuffle belongs to its senders.
+  if (!streaming_input_ && output_channel_->Size() == 0 &&
+      input_channel_->Size() != 0) {
     std::vector<T> data;
     input_channel_->Read(data);
     output_channel_->Write(std::move(data));
@@ -269,19 +365,29 @@ int InMemoryDataFeed<T>::Next() {
   std::vector<T> ins_vec;
   ins_vec.reserve(this->default_batch_size_);
   while (index < this->default_batch_size_) {
-    if (output_channel_->Size() == 0) {
-      break;
+    if (streaming_input_) {
+      // Get() waits for the shuffled data, and fails once the shuffle
+      // closed the drained channel.
+      if (!output_channel_->Get(instance)) {
+        break;
+      }
+    } else {
+      if (output_channel_->Size() == 0) {
+        break;
+      }
+      output_channel_->Get(instance);
     }
-    output_channel_->Get(instance);
-    ins_vec.push_back(instance);
+    ins_vec.push_back(std::move(instance));
     ++index;
-    consume_channel_->Put(std::move(instance));
   }
   this->batch_size_ = index;
   VLOG(3) << "batch_size_=" << this->batch_size_
           << ", thread_id=" << thread_id_;
   if (this->batch_size_ != 0) {
     PutToFeedVec(ins_vec);
+    // Hand the instances over to the consume channel after feeding them,
+    // instead of copying every one of them.
+    consume_channel_->Write(std::move(ins_vec));
   } else {
     VLOG(3) << "finish reading, output_channel_ size="
             << output_channel_->Size()
@@ -347,6 +453,16 @@ void InMemoryDataFeed<T>::SetParseLogKey(bool parse_logkey) {
   parse_logkey_ = parse_logkey;
 }
 
+template <typename T>
+void InMemoryDataFeed<T>::SetStreamingInput(bool streaming_input) {
+  streaming_input_ = streaming_input;
+}
+
+template <typename T>
+void InMemoryDataFeed<T>::SetReadAhead(ReadAheadReader* read_ahead) {
+  read_ahead_ = read_ahead;
+}
+
 template <typename T>
 void InMemoryDataFeed<T>::SetEnablePvMerge(bool enable_pv_merge) {
   enable_pv_merge_ = enable_pv_merge;
@@ -377,7 +493,11 @@ void InMemoryDataFeed<T>::LoadIntoMemory() {
     } else {
 #endif
       int err_no = 0;
-      this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_);
+      if (read_ahead_ != nullptr) {
+        this->fp_ = read_ahead_->Open(filename, &err_no);
+      } else {
+        this->fp_ = fs_open_read(filename, &err_no, this->pipe_command_);
+      }
 #ifdef PADDLE_WITH_BOX_PS
     }
 #endif
@@ -602,43 +722,25 @@ bool MultiSlotDataFeed::ParseOneInstanceFromPipe(
     instance->resize(use_slots_num);
 
     const char* str = reader.get();
-    std::string line = std::string(str);
-    // VLOG(3) << line;
-    char* endptr = const_cast<char*>(str);
-    int pos = 0;
+    const auto& tokens = SplitLine(str, reader.length());
+    size_t pos = 0;
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
-      PADDLE_ENFORCE_NE(
-          num, 0,
-          platform::errors::InvalidArgument(
-              "The number of ids can not be zero, you need padding "
-              "it in data generator; or if there is something wrong with "
-              "the data, please check if the data contains unresolvable "
-              "characters.\nplease check this error line: %s",
-              str));
+      int num = ReadSlotNum(tokens, &pos, str);
       if (idx != -1) {
         (*instance)[idx].Init(all_slots_type_[i]);
         if ((*instance)[idx].GetType()[0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
-            (*instance)[idx].AddValue(feasign);
+            (*instance)[idx].AddValue(ReadFloatFeasign(tokens, pos + j, str));
           }
         } else if ((*instance)[idx].GetType()[0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
-            (*instance)[idx].AddValue(feasign);
-          }
-        }
-        pos = endptr - str;
-      } else {
-        for (int j = 0; j <= num; ++j) {
-          // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
-            pos++;
+            (*instance)[idx].AddValue(
+                ReadUint64Feasign(tokens, pos + j, str));
           }
         }
       }
+      pos += num;
     }
     return true;
   }
@@ -655,38 +757,25 @@ bool MultiSlotDataFeed::ParseOneInstance(std::vector<MultiSlotType>* instance) {
     instance->resize(use_slots_num);
     // parse line
     const char* str = line.c_str();
-    char* endptr = const_cast<char*>(str);
-    int pos = 0;
+    const auto& tokens = SplitLine(str, line.size());
+    size_t pos = 0;
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
-      PADDLE_ENFORCE(
-          num,
-          "The number of ids can not be zero, you need padding "
-          "it in data generator; or if there is something wrong with "
-          "the data, please check if the data contains unresolvable "
-          "characters.\nplease check this error line: %s",
-          str);
-
+      int num = ReadSlotNum(tokens, &pos, str);
       if (idx != -1) {
         (*instance)[idx].Init(all_slots_type_[i]);
         if ((*instance)[idx].GetType()[0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
-            (*instance)[idx].AddValue(feasign);
+            (*instance)[idx].AddValue(ReadFloatFeasign(tokens, pos + j, str));
           }
         } else if ((*instance)[idx].GetType()[0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
-            (*instance)[idx].AddValue(feasign);
+            (*instance)[idx].AddValue(
+                ReadUint64Feasign(tokens, pos + j, str));
           }
         }
-        pos = endptr - str;
-      } else {
-        for (int j = 0; j <= num; ++j) {
-          pos = line.find_first_of(' ', pos + 1);
-        }
       }
+      pos += num;
     }
   } else {
     return false;
@@ -812,6 +901,13 @@ void MultiSlotInMemoryDataFeed::Init(
   }
   visit_.resize(all_slot_num, false);
   pipe_command_ = data_feed_desc.pipe_command();
+  PADDLE_ENFORCE_EQ(
+      data_feed_desc.data_format() == "text" ||
+          data_feed_desc.data_format() == "binary",
+      true, platform::errors::InvalidArgument(
+                "The data format should be text or binary, but got %s.",
+                data_feed_desc.data_format()));
+  binary_format_ = data_feed_desc.data_format() == "binary";
   finish_init_ = true;
 }
 
@@ -829,52 +925,111 @@ void MultiSlotInMemoryDataFeed::GetMsgFromLogKey(const std::string& log_key,
   *rank = (uint32_t)strtoul(rank_str.c_str(), NULL, 16);
 }
 
+bool MultiSlotInMemoryDataFeed::ParseOneBinaryInstance(Record* instance) {
+  if (binary_reader_ == nullptr) {
+    binary_reader_.reset(new BinarySlotReader(fp_.get()));
+    const auto& slot_types = binary_reader_->slot_types();
+    PADDLE_ENFORCE_EQ(slot_types.size(), all_slots_type_.size(),
+                      platform::errors::InvalidArgument(
+                          "The binary file has %d slots, but the data feed "
+                          "has %d.",
+                          slot_types.size(), all_slots_type_.size()));
+    for (size_t i = 0; i < slot_types.size(); ++i) {
+      PADDLE_ENFORCE_EQ(slot_types[i], all_slots_type_[i][0],
+                        platform::errors::InvalidArgument(
+                            "The type of slot %s mismatches the binary file.",
+                            all_slots_[i]));
+    }
+    uint32_t flags = binary_reader_->flags();
+    PADDLE_ENFORCE_EQ(
+        (!parse_ins_id_ || (flags & kBinarySlotHasInsId)) &&
+            (!parse_content_ || (flags & kBinarySlotHasContent)) &&
+            (!parse_logkey_ || (flags & kBinarySlotHasLogKey)),
+        true, platform::errors::InvalidArgument(
+                  "The binary file has no ins_id, content or log_key to "
+                  "parse."));
+    binary_block_pos_ = 0;
+    binary_block_.num_instances = 0;
+  }
+  if (binary_block_pos_ == binary_block_.num_instances) {
+    if (!binary_reader_->ReadBlock(&binary_block_)) {
+      binary_reader_.reset();
+      return false;
+    }
+    binary_block_pos_ = 0;
+  }
+  size_t k = binary_block_pos_++;
+  if (parse_ins_id_) {
+    const auto& ins_id = binary_block_.ins_ids[k];
+    instance->ins_id_.assign(ins_id.data(), ins_id.size());
+  }
+  if (parse_content_) {
+    const auto& content = binary_block_.contents[k];
+    instance->content_.assign(content.data(), content.size());
+  }
+  if (parse_logkey_) {
+    GetMsgFromLogKey(binary_block_.log_keys[k], &instance->search_id,
+                     &instance->cmatch, &instance->rank);
+  }
+  auto& feasigns = NewInstanceFeasigns();
+  for (size_t i = 0; i < use_slots_index_.size(); ++i) {
+    int idx = use_slots_index_[i];
+    if (idx == -1) continue;
+    bool is_dense = use_slots_is_dense_[idx];
+    uint32_t begin = binary_block_.offsets[i][k];
+    uint32_t end = binary_block_.offsets[i][k + 1];
+    FeatureKey f;
+    if (all_slots_type_[i][0] == 'f') {
+      const auto& values = binary_block_.float_values[i];
+      for (uint32_t j = begin; j < end; ++j) {
+        // if float feasign is equal to zero, ignore it
+        // except when slot is dense
+        if (fabs(values[j]) < 1e-6 && !is_dense) continue;
+        f.float_feasign_ = values[j];
+        feasigns.float_feasigns.push_back(FeatureItem(f, idx));
+      }
+    } else {
+      const auto& values = binary_block_.uint64_values[i];
+      for (uint32_t j = begin; j < end; ++j) {
+        // if uint64 feasign is equal to zero, ignore it
+        // except when slot is dense
+        if (values[j] == 0 && !is_dense) continue;
+        f.uint64_feasign_ = values[j];
+        feasigns.uint64_feasigns.push_back(FeatureItem(f, idx));
+      }
+    }
+  }
+  feasigns.CopyTo(instance);
+  return true;
+}
+
 bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
 #ifdef _LINUX
+  if (binary_format_) {
+    return ParseOneBinaryInstance(instance);
+  }
   thread_local string::LineFileReader reader;
 
   if (!reader.getline(&*(fp_.get()))) {
     return false;
   } else {
     const char* str = reader.get();
-    std::string line = std::string(str);
-    // VLOG(3) << line;
-    char* endptr = const_cast<char*>(str);
-    int pos = 0;
+    const auto& tokens = SplitLine(str, reader.length());
+    auto& feasigns = NewInstanceFeasigns();
+    size_t pos = 0;
     if (parse_ins_id_) {
-      int num = strtol(&str[pos], &endptr, 10);
-      CHECK(num == 1);  // NOLINT
-      pos = endptr - str + 1;
-      size_t len = 0;
-      while (str[pos + len] != ' ') {
-        ++len;
-      }
-      instance->ins_id_ = std::string(str + pos, len);
-      pos += len + 1;
+      std::string ins_id = ReadStringField(tokens, &pos, str);
+      instance->ins_id_.assign(ins_id.data(), ins_id.size());
       VLOG(3) << "ins_id " << instance->ins_id_;
     }
     if (parse_content_) {
-      int num = strtol(&str[pos], &endptr, 10);
-      CHECK(num == 1);  // NOLINT
-      pos = endptr - str + 1;
-      size_t len = 0;
-      while (str[pos + len] != ' ') {
-        ++len;
-      }
-      instance->content_ = std::string(str + pos, len);
-      pos += len + 1;
+      std::string content = ReadStringField(tokens, &pos, str);
+      instance->content_.assign(content.data(), content.size());
       VLOG(3) << "content " << instance->content_;
     }
     if (parse_logkey_) {
-      int num = strtol(&str[pos], &endptr, 10);
-      CHECK(num == 1);  // NOLINT
-      pos = endptr - str + 1;
-      size_t len = 0;
-      while (str[pos + len] != ' ') {
-        ++len;
-      }
       // parse_logkey
-      std::string log_key = std::string(str + pos, len);
+      std::string log_key = ReadStringField(tokens, &pos, str);
       uint64_t search_id;
       uint32_t cmatch;
       uint32_t rank;
@@ -883,22 +1038,14 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
       instance->search_id = search_id;
       instance->cmatch = cmatch;
       instance->rank = rank;
-      pos += len + 1;
     }
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
-      PADDLE_ENFORCE(
-          num,
-          "The number of ids can not be zero, you need padding "
-          "it in data generator; or if there is something wrong with "
-          "the data, please check if the data contains unresolvable "
-          "characters.\nplease check this error line: %s",
-          str);
+      int num = ReadSlotNum(tokens, &pos, str);
       if (idx != -1) {
         if (all_slots_type_[i][0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = ReadFloatFeasign(tokens, pos + j, str);
             // if float feasign is equal to zero, ignore it
             // except when slot is dense
             if (fabs(feasign) < 1e-6 && !use_slots_is_dense_[i]) {
@@ -906,11 +1053,11 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             }
             FeatureKey f;
             f.float_feasign_ = feasign;
-            instance->float_feasigns_.push_back(FeatureItem(f, idx));
+            feasigns.float_feasigns.push_back(FeatureItem(f, idx));
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = ReadUint64Feasign(tokens, pos + j, str);
             // if uint64 feasign is equal to zero, ignore it
             // except when slot is dense
             if (feasign == 0 && !use_slots_is_dense_[i]) {
@@ -918,21 +1065,13 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstanceFromPipe(Record* instance) {
             }
             FeatureKey f;
             f.uint64_feasign_ = feasign;
-            instance->uint64_feasigns_.push_back(FeatureItem(f, idx));
-          }
-        }
-        pos = endptr - str;
-      } else {
-        for (int j = 0; j <= num; ++j) {
-          // pos = line.find_first_of(' ', pos + 1);
-          while (line[pos + 1] != ' ') {
-            pos++;
+            feasigns.uint64_feasigns.push_back(FeatureItem(f, idx));
           }
         }
       }
+      pos += num;
     }
-    instance->float_feasigns_.shrink_to_fit();
-    instance->uint64_feasigns_.shrink_to_fit();
+    feasigns.CopyTo(instance);
     return true;
   }
 #else
@@ -947,50 +1086,38 @@ bool MultiSlotInMemoryDataFeed::ParseOneInstance(Record* instance) {
     VLOG(3) << line;
     // parse line
     const char* str = line.c_str();
-    char* endptr = const_cast<char*>(str);
-    int pos = 0;
+    const auto& tokens = SplitLine(str, line.size());
+    auto& feasigns = NewInstanceFeasigns();
+    size_t pos = 0;
     for (size_t i = 0; i < use_slots_index_.size(); ++i) {
       int idx = use_slots_index_[i];
-      int num = strtol(&str[pos], &endptr, 10);
-      PADDLE_ENFORCE(
-          num,
-          "The number of ids can not be zero, you need padding "
-          "it in data generator; or if there is something wrong with "
-          "the data, please check if the data contains unresolvable "
-          "characters.\nplease check this error line: %s",
-          str);
-
+      int num = ReadSlotNum(tokens, &pos, str);
       if (idx != -1) {
         if (all_slots_type_[i][0] == 'f') {  // float
           for (int j = 0; j < num; ++j) {
-            float feasign = strtof(endptr, &endptr);
+            float feasign = ReadFloatFeasign(tokens, pos + j, str);
             if (fabs(feasign) < 1e-6) {
               continue;
             }
             FeatureKey f;
             f.float_feasign_ = feasign;
-            instance->float_feasigns_.push_back(FeatureItem(f, idx));
+            feasigns.float_feasigns.push_back(FeatureItem(f, idx));
           }
         } else if (all_slots_type_[i][0] == 'u') {  // uint64
           for (int j = 0; j < num; ++j) {
-            uint64_t feasign = (uint64_t)strtoull(endptr, &endptr, 10);
+            uint64_t feasign = ReadUint64Feasign(tokens, pos + j, str);
             if (feasign == 0) {
               continue;
             }
             FeatureKey f;
             f.uint64_feasign_ = feasign;
-            instance->uint64_feasigns_.push_back(FeatureItem(f, idx));
+            feasigns.uint64_feasigns.push_back(FeatureItem(f, idx));
           }
         }
-        pos = endptr - str;
-      } else {
-        for (int j = 0; j <= num; ++j) {
-          pos = line.find_first_of(' ', pos + 1);
-        }
       }
+      pos += num;
     }
-    instance->float_feasigns_.shrink_to_fit();
-    instance->uint64_feasigns_.shrink_to_fit();
+    feasigns.CopyTo(instance);
     return true;
   } else {
     return false;
@@ -1014,8 +1141,8 @@ void MultiSlotInMemoryDataFeed::PutToFeedVec(
   ins_id_vec_.reserve(ins_vec.size());
   for (size_t i = 0; i < ins_vec.size(); ++i) {
     auto& r = ins_vec[i];
-    ins_id_vec_.push_back(r.ins_id_);
-    ins_content_vec_.push_back(r.content_);
+    ins_id_vec_.emplace_back(r.ins_id_.data(), r.ins_id_.size());
+    ins_content_vec_.emplace_back(r.content_.data(), r.content_.size());
     for (auto& item : r.float_feasigns_) {
       batch_float_feasigns_[item.slot()].push_back(item.sign().float_feasign_);
       visit_[item.slot()] = true;
@@ -1452,8 +1579,8 @@ void PaddleBoxDataFeed::PutToFeedVec(const std::vector<Record*>& ins_vec) {
   ins_id_vec_.reserve(ins_vec.size());
   for (size_t i = 0; i < ins_vec.size(); ++i) {
     auto r = ins_vec[i];
-    ins_id_vec_.push_back(r->ins_id_);
-    ins_content_vec_.push_back(r->content_);
+    ins_id_vec_.emplace_back(r->ins_id_.data(), r->ins_id_.size());
+    ins_content_vec_.emplace_back(r->content_.data(), r->content_.size());
     for (auto& item : r->float_feasigns_) {
       batch_float_feasigns_[item.slot()].push_back(item.sign().float_feasign_);
       visit_[item.slot()] = true;
@@ -31,10 +31,13 @@ limitations under the License. */
 #include <vector>
 
 #include "paddle/fluid/framework/archive.h"
+#include "paddle/fluid/framework/binary_slot_format.h"
 #include "paddle/fluid/framework/blocking_queue.h"
 #include "paddle/fluid/framework/channel.h"
 #include "paddle/fluid/framework/data_feed.pb.h"
+#include "paddle/fluid/framework/io/read_ahead.h"
 #include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/record_arena.h"
 #include "paddle/fluid/framework/reader.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/fluid/string/string_helper.h"
@@ -84,16 +87,27 @@ struct FeatureItem {
 };
 
 // sizeof Record is much less than std::vector<MultiSlotType>
+// The feasigns and the strings live in the RecordArena of the loading thread,
+// so that loading the instances does no malloc per instance.
 struct Record {
-  std::vector<FeatureItem> uint64_feasigns_;
-  std::vector<FeatureItem> float_feasigns_;
-  std::string ins_id_;
-  std::string content_;
+  RecordVector<FeatureItem> uint64_feasigns_;
+  RecordVector<FeatureItem> float_feasigns_;
+  RecordString ins_id_;
+  RecordString content_;
   uint64_t search_id;
   uint32_t rank;
   uint32_t cmatch;
 };
 
+// Move the storage of the record into the chunk of the calling thread, see
+// MoveToThreadChunk.
+inline void MoveToThreadChunk(Record* rec) {
+  MoveToThreadChunk(&rec->uint64_feasigns_);
+  MoveToThreadChunk(&rec->float_feasigns_);
+  MoveToThreadChunk(&rec->ins_id_);
+  MoveToThreadChunk(&rec->content_);
+}
+
 struct PvInstanceObject {
   std::vector<Record*> ads;
   void merge_instance(Record* ins) { ads.push_back(ins); }
@@ -161,6 +175,10 @@ class DataFeed {
   virtual void SetParseLogKey(bool parse_logkey) {}
   virtual void SetEnablePvMerge(bool enable_pv_merge) {}
   virtual void SetCurrentPhase(int current_phase) {}
+  // This function will do nothing at default
+  virtual void SetStreamingInput(bool streaming_input) {}
+  // This function will do nothing at default
+  virtual void SetReadAhead(ReadAheadReader* read_ahead) {}
   virtual void SetFileListMutex(std::mutex* mutex) {
     mutex_for_pick_file_ = mutex;
   }
@@ -297,6 +315,11 @@ class InMemoryDataFeed : public DataFeed {
   virtual void SetParseLogKey(bool parse_logkey);
   virtual void SetEnablePvMerge(bool enable_pv_merge);
   virtual void SetCurrentPhase(int current_phase);
+  // The output channel is still filled by a streaming global shuffle, so
+  // Next() waits for the data until the shuffle closes the channel.
+  virtual void SetStreamingInput(bool streaming_input);
+  // LoadIntoMemory() opens the files through the read-ahead of the dataset.
+  virtual void SetReadAhead(ReadAheadReader* read_ahead);
   virtual void LoadIntoMemory();
 
  protected:
@@ -311,6 +334,8 @@ class InMemoryDataFeed : public DataFeed {
   bool parse_logkey_;
   bool enable_pv_merge_;
   int current_phase_{-1};  // only for untest
+  bool streaming_input_{false};
+  ReadAheadReader* read_ahead_{nullptr};
   std::ifstream file_;
   std::shared_ptr<FILE> fp_;
   paddle::framework::ChannelObject<T>* input_channel_;
@@ -485,7 +510,7 @@ struct RecordCandidate {
 
   RecordCandidate& operator=(const Record& rec) {
     feas.clear();
-    ins_id_ = rec.ins_id_;
+    ins_id_.assign(rec.ins_id_.data(), rec.ins_id_.size());
     for (auto& fea : rec.uint64_feasigns_) {
       feas.insert({fea.slot(), fea.sign()});
     }
@@ -597,10 +622,19 @@ class MultiSlotInMemoryDataFeed : public InMemoryDataFeed<Record> {
   virtual void PutToFeedVec(const std::vector<Record>& ins_vec);
   virtual void GetMsgFromLogKey(const std::string& log_key, uint64_t* search_id,
                                 uint32_t* cmatch, uint32_t* rank);
+  // Take the next instance of the binary columnar file, the values are
+  // copied out of the decoded blocks without parsing any text.
+  bool ParseOneBinaryInstance(Record* instance);
   std::vector<std::vector<float>> batch_float_feasigns_;
   std::vector<std::vector<uint64_t>> batch_uint64_feasigns_;
   std::vector<std::vector<size_t>> offset_;
   std::vector<bool> visit_;
+
+  bool binary_format_{false};
+  // The reader of the current file, reset at its end.
+  std::unique_ptr<BinarySlotReader> binary_reader_;
+  BinarySlotBlock binary_block_;
+  size_t binary_block_pos_{0};
 };
 
 class PaddleBoxDataFeed : public MultiSlotInMemoryDataFeed {
@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/framework/data_set.h"
 #include <algorithm>
+#include <limits>
 #include <random>
 #include <unordered_map>
 #include <unordered_set>
@@ -34,6 +35,10 @@
 namespace paddle {
 namespace framework {
 
+// The message a trainer sends to every trainer after it sent all of its
+// data in a streaming global shuffle.
+constexpr int kShuffleEndMsgType = 1;
+
 // constructor
 template <typename T>
 DatasetImpl<T>::DatasetImpl() {
@@ -228,6 +233,7 @@ void DatasetImpl<T>::LoadIntoMemory() {
   VLOG(3) << "DatasetImpl<T>::LoadIntoMemory() begin";
   platform::Timer timeline;
   timeline.Start();
+  StartReadAhead(readers_);
   std::vector<std::thread> load_threads;
   for (int64_t i = 0; i < thread_num_; ++i) {
     load_threads.push_back(std::thread(
@@ -236,6 +242,7 @@ void DatasetImpl<T>::LoadIntoMemory() {
   for (std::thread& t : load_threads) {
     t.join();
   }
+  StopReadAhead();
   input_channel_->Close();
   int64_t in_chan_size = input_channel_->Size();
   input_channel_->SetBlockSize(in_chan_size / thread_num_ + 1);
@@ -251,6 +258,7 @@ void DatasetImpl<T>::PreLoadIntoMemory() {
   VLOG(3) << "DatasetImpl<T>::PreLoadIntoMemory() begin";
   if (preload_thread_num_ != 0) {
     CHECK(static_cast<size_t>(preload_thread_num_) == preload_readers_.size());
+    StartReadAhead(preload_readers_);
     preload_threads_.clear();
     for (int64_t i = 0; i < preload_thread_num_; ++i) {
       preload_threads_.push_back(
@@ -259,6 +267,7 @@ void DatasetImpl<T>::PreLoadIntoMemory() {
     }
   } else {
     CHECK(static_cast<size_t>(thread_num_) == readers_.size());
+    StartReadAhead(readers_);
     preload_threads_.clear();
     for (int64_t i = 0; i < thread_num_; ++i) {
       preload_threads_.push_back(std::thread(
@@ -274,6 +283,7 @@ void DatasetImpl<T>::WaitPreLoadDone() {
   for (std::thread& t : preload_threads_) {
     t.join();
   }
+  StopReadAhead();
   input_channel_->Close();
   int64_t in_chan_size = input_channel_->Size();
   input_channel_->SetBlockSize(in_chan_size / thread_num_ + 1);
@@ -284,6 +294,7 @@ void DatasetImpl<T>::WaitPreLoadDone() {
 template <typename T>
 void DatasetImpl<T>::ReleaseMemory() {
   VLOG(3) << "DatasetImpl<T>::ReleaseMemory() begin";
+  WaitShuffleDone();
   if (input_channel_) {
     input_channel_->Clear();
     input_channel_ = nullptr;
@@ -360,13 +371,19 @@ void DatasetImpl<T>::LocalShuffle() {
 
 template <typename T>
 void DatasetImpl<T>::GlobalShuffle(int thread_num) {
-#ifdef PADDLE_WITH_PSLIB
+#ifndef PADDLE_WITH_PSLIB
+  // No trainer to send to without the fleet, unless a sender is set.
+  if (!sender_) return;
+#endif
   VLOG(3) << "DatasetImpl<T>::GlobalShuffle() begin";
   platform::Timer timeline;
   timeline.Start();
   auto fleet_ptr = FleetWrapper::GetInstance();
+  shuffle_send_failures_ = 0;
 
-  if (!input_channel_ || input_channel_->Size() == 0) {
+  // A streaming shuffle sends its end messages even without data.
+  if (!input_channel_ ||
+      (input_channel_->Size() == 0 && !streaming_shuffle_)) {
     VLOG(3) << "DatasetImpl<T>::GlobalShuffle() end, no data to shuffle";
     return;
   }
@@ -417,11 +434,13 @@ void DatasetImpl<T>::GlobalShuffle(int thread_num) {
           continue;
         }
         std::string msg(ars[i].Buffer(), ars[i].Length());
-        auto ret = fleet_ptr->SendClientToClientMsg(0, i, msg);
+        auto ret = this->SendClientToClientMsg(0, i, msg);
         total_status.push_back(std::move(ret));
       }
       for (auto& t : total_status) {
-        t.wait();
+        if (!t.valid() || t.get() != 0) {
+          ++this->shuffle_send_failures_;
+        }
       }
       ars.clear();
       ars.shrink_to_fit();
@@ -436,10 +455,51 @@ void DatasetImpl<T>::GlobalShuffle(int thread_num) {
     }
   };
 
-  std::vector<std::thread> global_shuffle_threads;
   if (thread_num == -1) {
     thread_num = thread_num_;
   }
+  if (streaming_shuffle_) {
+    PADDLE_ENFORCE_NOT_NULL(
+        received_channel_,
+        platform::errors::PreconditionNotMet(
+            "Call SetStreamingShuffle before every streaming global shuffle."));
+    // Send in the background, the readers of the first pass wait for the
+    // data received until every trainer sent its end message.
+    streaming_input_ = true;
+    for (auto& reader : readers_) {
+      reader->SetStreamingInput(true);
+    }
+    shuffle_thread_ = std::thread([this, thread_num, global_shuffle_func]() {
+      std::vector<std::thread> send_threads;
+      for (int i = 0; i < thread_num; ++i) {
+        send_threads.push_back(std::thread(global_shuffle_func));
+      }
+      for (std::thread& t : send_threads) {
+        t.join();
+      }
+      this->input_channel_->Clear();
+      std::vector<std::future<int32_t>> total_status;
+      for (int i = 0; i < this->trainer_num_; ++i) {
+        total_status.push_back(
+            this->SendClientToClientMsg(kShuffleEndMsgType, i, ""));
+      }
+      for (int i = 0; i < this->trainer_num_; ++i) {
+        auto& t = total_status[i];
+        if (!t.valid() || t.get() != 0) {
+          LOG(ERROR) << "Failed to send the end of the streaming shuffle to "
+                     << "trainer " << i << ", its first pass never ends.";
+          ++this->shuffle_send_failures_;
+        }
+      }
+      VLOG(3) << "DatasetImpl<T>::GlobalShuffle() streaming send end";
+    });
+    timeline.Pause();
+    VLOG(3) << "DatasetImpl<T>::GlobalShuffle() started streaming, cost time="
+            << timeline.ElapsedSec() << " seconds";
+    return;
+  }
+
+  std::vector<std::thread> global_shuffle_threads;
   VLOG(3) << "start global shuffle threads, num = " << thread_num;
   for (int i = 0; i < thread_num; ++i) {
     global_shuffle_threads.push_back(std::thread(global_shuffle_func));
@@ -450,10 +510,220 @@ void DatasetImpl<T>::GlobalShuffle(int thread_num) {
   global_shuffle_threads.clear();
   global_shuffle_threads.shrink_to_fit();
   input_channel_->Clear();
+  PADDLE_ENFORCE_EQ(shuffle_send_failures_.load(), 0,
+                    platform::errors::Unavailable(
+                        "%d messages of the global shuffle failed to send, "
+                        "their records are lost.",
+                        shuffle_send_failures_.load()));
   timeline.Pause();
   VLOG(3) << "DatasetImpl<T>::GlobalShuffle() end, cost time="
           << timeline.ElapsedSec() << " seconds";
-#endif
+}
+
+template <typename T>
+std::future<int32_t> DatasetImpl<T>::SendClientToClientMsg(
+    int msg_type, int to_client_id, const std::string& msg) {
+  if (sender_) {
+    return sender_(msg_type, to_client_id, msg);
+  }
+  return FleetWrapper::GetInstance()->SendClientToClientMsg(
+      msg_type, to_client_id, msg);
+}
+
+template <typename T>
+void DatasetImpl<T>::SetStreamingShuffle(bool streaming,
+                                         int64_t channel_capacity) {
+  VLOG(3) << "SetStreamingShuffle streaming=" << streaming
+          << ", channel_capacity=" << channel_capacity;
+  WaitShuffleDone();
+  StopReceiving();
+  streaming_shuffle_ = streaming;
+  streaming_channel_capacity_ = channel_capacity;
+  shuffle_end_count_ = 0;
+  if (!streaming) {
+    for (auto& channel : multi_output_channel_) {
+      channel->SetCapacity(std::numeric_limits<size_t>::max());
+    }
+    return;
+  }
+  PADDLE_ENFORCE_GT(channel_capacity, 0,
+                    platform::errors::InvalidArgument(
+                        "The channel capacity of the streaming shuffle "
+                        "should be greater than 0, but got %d.",
+                        channel_capacity));
+  PADDLE_ENFORCE_EQ(cur_channel_, 0,
+                    platform::errors::PreconditionNotMet(
+                        "The streaming shuffle should follow the loading of "
+                        "the data, before any pass."));
+  // The other trainers send as soon as they pass the barrier, so bound the
+  // channels before it.
+  for (auto& channel : multi_output_channel_) {
+    channel->SetCapacity(channel_capacity);
+    channel->Open();
+  }
+  // The RPC handlers only buffer the records, this thread waits for the
+  // readers to make room in the channels. A handler blocked on a full
+  // channel would hold the handler pool, and the trainers sending to each
+  // other would wait for each other.
+  received_channel_ = paddle::framework::MakeChannel<T>();
+  received_channel_->SetBlockSize(fleet_send_batch_size_);
+  receive_thread_ = std::thread([this]() {
+    std::vector<T> data;
+    size_t index = 0;
+    while (received_channel_->Read(data)) {
+      multi_output_channel_[index++ % multi_output_channel_.size()]->Write(
+          std::move(data));
+      data.clear();
+    }
+    // Every trainer sent all of its data, so the readers end the pass once
+    // they drained the channels.
+    for (auto& channel : multi_output_channel_) {
+      channel->SetCapacity(std::numeric_limits<size_t>::max());
+      channel->Close();
+    }
+  });
+}
+
+template <typename T>
+void DatasetImpl<T>::StopReceiving() {
+  if (!receive_thread_.joinable()) {
+    return;
+  }
+  received_channel_->Close();
+  receive_thread_.join();
+  received_channel_ = nullptr;
+}
+
+template <typename T>
+void DatasetImpl<T>::WaitShuffleDone() {
+  if (shuffle_thread_.joinable()) {
+    shuffle_thread_.join();
+  }
+  if (!streaming_input_) {
+    return;
+  }
+  // The pass ended, so the end messages of all the trainers were received.
+  StopReceiving();
+  PADDLE_ENFORCE_EQ(shuffle_send_failures_.load(), 0,
+                    platform::errors::Unavailable(
+                        "%d messages of the streaming shuffle failed to send, "
+                        "their records are lost.",
+                        shuffle_send_failures_.load()));
+  // The first pass drained the closed channels, open them for the passes
+  // which put the consumed data back.
+  for (auto& channel : multi_output_channel_) {
+    channel->Open();
+  }
+  for (auto& reader : readers_) {
+    reader->SetStreamingInput(false);
+  }
+  streaming_input_ = false;
+}
+
+template <typename T>
+void DatasetImpl<T>::SetLockFreeChannel(bool lock_free) {
+  VLOG(3) << "SetLockFreeChannel lock_free=" << lock_free;
+  lock_free_channel_ = lock_free;
+}
+
+template <typename T>
+void DatasetImpl<T>::SetReadAhead(int file_num, int chunk_num,
+                                  int64_t chunk_size) {
+  VLOG(3) << "SetReadAhead file_num=" << file_num
+          << ", chunk_num=" << chunk_num << ", chunk_size=" << chunk_size;
+  PADDLE_ENFORCE_GE(file_num, 0,
+                    platform::errors::InvalidArgument(
+                        "The read-ahead file num should be greater than or "
+                        "equal to 0, but got %d.",
+                        file_num));
+  if (file_num > 0) {
+    PADDLE_ENFORCE_GT(chunk_num, 0,
+                      platform::errors::InvalidArgument(
+                          "The read-ahead chunk num should be greater than "
+                          "0, but got %d.",
+                          chunk_num));
+    PADDLE_ENFORCE_GT(chunk_size, 0,
+                      platform::errors::InvalidArgument(
+                          "The read-ahead chunk size should be greater than "
+                          "0, but got %d.",
+                          chunk_size));
+  }
+  read_ahead_file_num_ = file_num;
+  read_ahead_chunk_num_ = chunk_num;
+  read_ahead_chunk_size_ = chunk_size;
+}
+
+template <typename T>
+std::vector<FileReadStats> DatasetImpl<T>::GetReadStats() {
+  return read_stats_;
+}
+
+template <typename T>
+void DatasetImpl<T>::StartReadAhead(
+    const std::vector<std::shared_ptr<paddle::framework::DataFeed>>& readers) {
+  if (read_ahead_file_num_ == 0) {
+    return;
+  }
+  read_ahead_.reset(new ReadAheadReader(read_ahead_file_num_,
+                                        read_ahead_chunk_num_,
+                                        read_ahead_chunk_size_));
+  // The readers pick the files in the order of the list.
+  size_t begin = std::min(file_idx_, filelist_.size());
+  std::vector<std::string> files(filelist_.begin() + begin, filelist_.end());
+  read_ahead_->Start(files, data_feed_desc_.pipe_command());
+  for (auto& reader : readers) {
+    reader->SetReadAhead(read_ahead_.get());
+  }
+}
+
+template <typename T>
+void DatasetImpl<T>::StopReadAhead() {
+  if (read_ahead_ == nullptr) {
+    return;
+  }
+  read_ahead_->Stop();
+  read_stats_ = read_ahead_->Stats();
+  for (auto& reader : readers_) {
+    reader->SetReadAhead(nullptr);
+  }
+  for (auto& reader : preload_readers_) {
+    reader->SetReadAhead(nullptr);
+  }
+  read_ahead_.reset();
+  size_t bytes = 0;
+  double stall_seconds = 0;
+  for (auto& stats : read_stats_) {
+    bytes += stats.bytes;
+    stall_seconds += stats.stall_seconds;
+  }
+  VLOG(3) << "read ahead " << read_stats_.size() << " files, " << bytes
+          << " bytes, the readers stalled " << stall_seconds << " seconds";
+}
+
+template <typename T>
+void DatasetImpl<T>::SetPassChannelsLockFree(bool lock_free) {
+  for (size_t i = 0; i < multi_output_channel_.size() &&
+                     i < multi_consume_channel_.size();
+       ++i) {
+    // The readers of a pass drain the source channel of the pair into the
+    // destination one and never write back, so the source ring only needs
+    // the records it holds and the destination one all the records of the
+    // pair. The rings hold exactly that, at least 2 slots, at most twice the
+    // slots of the deques, and the slots of the drained ring are empty
+    // Records.
+    auto& source = cur_channel_ == 0 ? multi_output_channel_[i]
+                                     : multi_consume_channel_[i];
+    auto& dest = cur_channel_ == 0 ? multi_consume_channel_[i]
+                                   : multi_output_channel_[i];
+    size_t source_capacity = 0;
+    size_t dest_capacity = 0;
+    if (lock_free) {
+      source_capacity = (std::max)(source->Size(), static_cast<size_t>(1));
+      dest_capacity = source_capacity + dest->Size();
+    }
+    source->SetLockFree(source_capacity);
+    dest->SetLockFree(dest_capacity);
+  }
 }
 
 template <typename T>
@@ -464,6 +734,11 @@ void DatasetImpl<T>::DynamicAdjustChannelNum(int channel_num,
             << channel_num_ << ", channel_num_=channel_num, no need to adjust";
     return;
   }
+  PADDLE_ENFORCE_EQ(streaming_input_, false,
+                    platform::errors::PreconditionNotMet(
+                        "The channel num can not be adjusted during a "
+                        "streaming shuffle, please set the queue num to the "
+                        "thread num."));
   VLOG(3) << "adjust channel num from " << channel_num_ << " to "
           << channel_num;
   channel_num_ = channel_num;
@@ -626,6 +901,7 @@ void DatasetImpl<T>::CreateReaders() {
     // In fact, it does not affect the train process when paddle is
     // complied with Box_Ps.
     readers_[i]->SetCurrentPhase(current_phase_);
+    readers_[i]->SetStreamingInput(streaming_input_);
     if (input_channel_ != nullptr) {
       readers_[i]->SetInputChannel(input_channel_.get());
     }
@@ -650,6 +926,12 @@ void DatasetImpl<T>::CreateReaders() {
       channel_idx = 0;
     }
   }
+  // The first pass moving the input channel to the output channels, and the
+  // streaming shuffle, write an unknown number of records into the channels.
+  if (lock_free_channel_ && !streaming_input_ &&
+      (input_channel_ == nullptr || input_channel_->Size() == 0)) {
+    SetPassChannelsLockFree(true);
+  }
   VLOG(3) << "readers size: " << readers_.size();
 }
 
@@ -657,7 +939,12 @@ template <typename T>
 void DatasetImpl<T>::DestroyReaders() {
   VLOG(3) << "Calling DestroyReaders()";
   VLOG(3) << "readers size1: " << readers_.size();
+  // The pass consumed the streaming shuffle, the next ones read the channels
+  // as usual.
+  WaitShuffleDone();
   std::vector<std::shared_ptr<paddle::framework::DataFeed>>().swap(readers_);
+  // Shuffles and merges between the passes need the deques.
+  SetPassChannelsLockFree(false);
   VLOG(3) << "readers size: " << readers_.size();
   file_idx_ = 0;
   cur_channel_ = 1 - cur_channel_;
@@ -739,6 +1026,14 @@ int DatasetImpl<T>::ReceiveFromClient(int msg_type, int client_id,
 #ifdef _LINUX
   VLOG(3) << "ReceiveFromClient msg_type=" << msg_type
           << ", client_id=" << client_id << ", msg length=" << msg.length();
+  if (msg_type == kShuffleEndMsgType) {
+    // The hand-off thread closes the output channels once it moved the
+    // records received before.
+    if (++shuffle_end_count_ == trainer_num_) {
+      received_channel_->Close();
+    }
+    return 0;
+  }
   if (msg.length() == 0) {
     return 0;
   }
@@ -752,6 +1047,11 @@ int DatasetImpl<T>::ReceiveFromClient(int msg_type, int client_id,
     data.push_back(ar.Get<T>());
   }
   CHECK(ar.Cursor() == ar.Finish());
+  if (streaming_shuffle_) {
+    // Never blocks, the channel of the received records is not bounded.
+    received_channel_->Write(std::move(data));
+    return 0;
+  }
 
   auto fleet_ptr = FleetWrapper::GetInstance();
   // not use random because it doesn't perform well here.
@@ -1114,6 +1414,11 @@ void MultiSlotDataset::MergeByInsId() {
     i = j;
   }
   std::vector<Record>().swap(recs);
+  // The merged records grew in the chunks left by the loaded ones, move
+  // them so that those chunks are freed.
+  for (auto& rec : results) {
+    MoveToThreadChunk(&rec);
+  }
   VLOG(3) << "results size " << results.size();
   LOG(WARNING) << "total drop ins num: " << drop_ins_num;
   results.shrink_to_fit();
@@ -1169,6 +1474,11 @@ void MultiSlotDataset::GetRandomData(const std::set<uint16_t>& slots_to_replace,
     }
     result->push_back(std::move(new_rec));
   }
+  // The shuffled records are kept for the whole pass, next to the buffers
+  // they outgrew, move them into compact chunks.
+  for (auto& rec : *result) {
+    MoveToThreadChunk(&rec);
+  }
   VLOG(2) << "erase feasign num: " << debug_erase_cnt
           << " repush feasign num: " << debug_push_cnt;
 }
@@ -15,7 +15,10 @@
 #pragma once
 
 #include <ThreadPool.h>
+#include <atomic>
 #include <fstream>
+#include <functional>
+#include <future>  // NOLINT
 #include <memory>
 #include <mutex>  // NOLINT
 #include <set>
@@ -147,6 +150,24 @@ class Dataset {
   virtual void DynamicAdjustReadersNum(int thread_num) = 0;
   // set fleet send sleep seconds
   virtual void SetFleetSendSleepSeconds(int seconds) = 0;
+  // set streaming global shuffle, GlobalShuffle returns at once and the
+  // first pass reads the data while it is still being sent. Each output
+  // channel holds at most channel_capacity records, the records received
+  // beyond that wait in a buffer. Set it before the barrier of GlobalShuffle.
+  virtual void SetStreamingShuffle(bool streaming,
+                                   int64_t channel_capacity) = 0;
+  // wait the streaming global shuffle done
+  virtual void WaitShuffleDone() = 0;
+  // set lock-free channels, the output and consume channels of a pass are
+  // bounded lock-free rings instead of mutex guarded deques
+  virtual void SetLockFreeChannel(bool lock_free) = 0;
+  // set read-ahead of LoadIntoMemory/PreLoadIntoMemory, file_num files are
+  // read at a time into at most chunk_num chunks of chunk_size bytes each,
+  // file_num 0 turns it off
+  virtual void SetReadAhead(int file_num, int chunk_num,
+                            int64_t chunk_size) = 0;
+  // get the I/O counters of the files read ahead by the last load
+  virtual std::vector<FileReadStats> GetReadStats() = 0;
 
  protected:
   virtual int ReceiveFromClient(int msg_type, int client_id,
@@ -159,7 +180,22 @@ template <typename T>
 class DatasetImpl : public Dataset {
  public:
   DatasetImpl();
-  virtual ~DatasetImpl() {}
+  virtual ~DatasetImpl() {
+    if (shuffle_thread_.joinable()) {
+      shuffle_thread_.join();
+    }
+    StopReceiving();
+  }
+
+  // Sends a message of the global shuffle to a trainer, the future holds
+  // its status, 0 for success.
+  using ClientToClientSender = std::function<std::future<int32_t>(
+      int msg_type, int to_client_id, const std::string& msg)>;
+  // replace FleetWrapper::SendClientToClientMsg, e.g. to shuffle between the
+  // datasets of a process in a test
+  void SetClientToClientSender(ClientToClientSender sender) {
+    sender_ = std::move(sender);
+  }
 
   virtual void SetFileList(const std::vector<std::string>& filelist);
   virtual void SetThreadNum(int thread_num);
@@ -225,10 +261,24 @@ class DatasetImpl : public Dataset {
                                        bool discard_remaining_ins = false);
   virtual void DynamicAdjustReadersNum(int thread_num);
   virtual void SetFleetSendSleepSeconds(int seconds);
+  virtual void SetStreamingShuffle(bool streaming, int64_t channel_capacity);
+  virtual void SetLockFreeChannel(bool lock_free);
+  virtual void SetReadAhead(int file_num, int chunk_num, int64_t chunk_size);
+  virtual std::vector<FileReadStats> GetReadStats();
+  virtual void WaitShuffleDone();
 
  protected:
   virtual int ReceiveFromClient(int msg_type, int client_id,
                                 const std::string& msg);
+  void SetPassChannelsLockFree(bool lock_free);
+  std::future<int32_t> SendClientToClientMsg(int msg_type, int to_client_id,
+                                             const std::string& msg);
+  // Close the buffer of a streaming shuffle which never started and join
+  // its hand-off thread.
+  void StopReceiving();
+  void StartReadAhead(
+      const std::vector<std::shared_ptr<paddle::framework::DataFeed>>& readers);
+  void StopReadAhead();
   std::vector<std::shared_ptr<paddle::framework::DataFeed>> readers_;
   std::vector<std::shared_ptr<paddle::framework::DataFeed>> preload_readers_;
   paddle::framework::Channel<T> input_channel_;
@@ -273,6 +323,26 @@ class DatasetImpl : public Dataset {
   int64_t global_index_ = 0;
   std::vector<std::shared_ptr<ThreadPool>> consume_task_pool_;
   std::vector<T> input_records_;  // only for paddleboxdatafeed
+  bool streaming_shuffle_ = false;
+  int64_t streaming_channel_capacity_ = 0;
+  // the readers of the next pass consume the streaming shuffle
+  bool streaming_input_ = false;
+  // the number of the trainers which sent all their shuffled data to this
+  std::atomic<int> shuffle_end_count_{0};
+  std::thread shuffle_thread_;
+  // the records of a streaming shuffle, received without blocking the RPC
+  // handlers and moved to the bounded output channels by receive_thread_
+  paddle::framework::Channel<T> received_channel_;
+  std::thread receive_thread_;
+  // the number of the messages of the global shuffle failed to send
+  std::atomic<int> shuffle_send_failures_{0};
+  ClientToClientSender sender_;
+  bool lock_free_channel_ = false;
+  int read_ahead_file_num_ = 0;
+  int read_ahead_chunk_num_ = 0;
+  int64_t read_ahead_chunk_size_ = 0;
+  std::unique_ptr<ReadAheadReader> read_ahead_;
+  std::vector<FileReadStats> read_stats_;
 };
 
 // use std::vector<MultiSlotType> or Record as data type
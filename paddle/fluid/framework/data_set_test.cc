@@ -0,0 +1,175 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/data_set.h"
+
+#if defined _WIN32 || defined __APPLE__
+#else
+#define _LINUX
+#endif
+
+namespace paddle {
+namespace framework {
+
+// A trainer of the global shuffle, the datasets of the test send to each
+// other in process.
+class ShuffleTestDataset : public MultiSlotDataset {
+ public:
+  std::vector<std::string> AddRecords(int trainer_id, int num) {
+    CreateChannel();
+    std::vector<std::string> ids;
+    std::vector<Record> recs(num);
+    for (int i = 0; i < num; ++i) {
+      ids.push_back(std::to_string(trainer_id) + "_" + std::to_string(i));
+      recs[i].ins_id_.assign(ids.back().begin(), ids.back().end());
+    }
+    input_channel_->Write(std::move(recs));
+    return ids;
+  }
+
+  int Receive(int msg_type, int client_id, const std::string& msg) {
+    return ReceiveFromClient(msg_type, client_id, msg);
+  }
+
+  // Read the output channels until they are closed, as the readers of the
+  // first pass of a streaming shuffle do.
+  std::vector<std::string> Consume() {
+    std::vector<std::string> ids;
+    std::mutex mutex;
+    std::vector<std::thread> threads;
+    for (auto& channel : multi_output_channel_) {
+      threads.emplace_back([&ids, &mutex, channel] {
+        std::vector<Record> recs;
+        while (channel->Read(recs)) {
+          std::lock_guard<std::mutex> lock(mutex);
+          for (auto& rec : recs) {
+            ids.emplace_back(rec.ins_id_.begin(), rec.ins_id_.end());
+          }
+          recs.clear();
+        }
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    return ids;
+  }
+
+  std::vector<std::string> TakeAll() {
+    for (auto& channel : multi_output_channel_) channel->Close();
+    return Consume();
+  }
+};
+
+static std::vector<std::unique_ptr<ShuffleTestDataset>> MakeTrainers(
+    int trainer_num, int num_records, std::vector<std::string>* ids) {
+  std::vector<std::unique_ptr<ShuffleTestDataset>> datasets;
+  for (int i = 0; i < trainer_num; ++i) {
+    datasets.emplace_back(new ShuffleTestDataset());
+    auto* dataset = datasets.back().get();
+    dataset->SetTrainerNum(trainer_num);
+    dataset->SetThreadNum(2);
+    dataset->SetFleetSendBatchSize(16);
+    auto added = dataset->AddRecords(i, num_records);
+    ids->insert(ids->end(), added.begin(), added.end());
+  }
+  std::vector<ShuffleTestDataset*> trainers;
+  for (auto& dataset : datasets) trainers.push_back(dataset.get());
+  for (int i = 0; i < trainer_num; ++i) {
+    datasets[i]->SetClientToClientSender(
+        [trainers, i](int msg_type, int to_client_id, const std::string& msg) {
+          return std::async(std::launch::async, [=] {
+            return trainers[to_client_id]->Receive(msg_type, i, msg);
+          });
+        });
+  }
+  return datasets;
+}
+
+TEST(DatasetImpl, GlobalShuffle) {
+#ifdef _LINUX
+  std::vector<std::string> ids;
+  auto datasets = MakeTrainers(2, 500, &ids);
+  std::vector<std::future<void>> shuffles;
+  for (auto& dataset : datasets) {
+    auto* trainer = dataset.get();
+    shuffles.push_back(std::async(std::launch::async,
+                                  [trainer] { trainer->GlobalShuffle(); }));
+  }
+  for (auto& shuffle : shuffles) shuffle.get();
+
+  std::vector<std::string> shuffled;
+  for (auto& dataset : datasets) {
+    auto taken = dataset->TakeAll();
+    shuffled.insert(shuffled.end(), taken.begin(), taken.end());
+  }
+  std::sort(ids.begin(), ids.end());
+  std::sort(shuffled.begin(), shuffled.end());
+  EXPECT_EQ(ids, shuffled);
+#endif
+}
+
+TEST(DatasetImpl, StreamingGlobalShuffle) {
+#ifdef _LINUX
+  // The channels hold less than a message, so the records received wait in
+  // the buffers while the RPC handlers return.
+  std::vector<std::string> ids;
+  auto datasets = MakeTrainers(2, 1000, &ids);
+  for (auto& dataset : datasets) {
+    dataset->SetStreamingShuffle(true, 8);
+  }
+  for (auto& dataset : datasets) {
+    dataset->GlobalShuffle();
+  }
+  std::vector<std::future<std::vector<std::string>>> consumed;
+  for (auto& dataset : datasets) {
+    auto* trainer = dataset.get();
+    consumed.push_back(std::async(std::launch::async,
+                                  [trainer] { return trainer->Consume(); }));
+  }
+  std::vector<std::string> shuffled;
+  for (auto& ids_consumed : consumed) {
+    auto taken = ids_consumed.get();
+    shuffled.insert(shuffled.end(), taken.begin(), taken.end());
+  }
+  for (auto& dataset : datasets) {
+    dataset->WaitShuffleDone();
+  }
+  std::sort(ids.begin(), ids.end());
+  std::sort(shuffled.begin(), shuffled.end());
+  EXPECT_EQ(ids, shuffled);
+#endif
+}
+
+TEST(DatasetImpl, GlobalShuffleSendFailure) {
+#ifdef _LINUX
+  std::vector<std::string> ids;
+  auto datasets = MakeTrainers(1, 100, &ids);
+  datasets[0]->SetClientToClientSender([](int, int, const std::string&) {
+    std::promise<int32_t> status;
+    status.set_value(-1);
+    return status.get_future();
+  });
+  EXPECT_THROW(datasets[0]->GlobalShuffle(), platform::EnforceNotMet);
+#endif
+}
+
+}  // namespace framework
+}  // namespace paddle
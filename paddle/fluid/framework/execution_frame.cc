@@ -0,0 +1,216 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/execution_frame.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "paddle/fluid/framework/executor_gc_helper.h"
+#include "paddle/fluid/framework/variable_helper.h"
+
+namespace paddle {
+namespace framework {
+
+ExecutionFrame::ExecutionFrame(
+    const BlockDesc& block,
+    const std::vector<std::unique_ptr<OperatorBase>>& ops)
+    : block_(block) {
+  for (auto* var : block.AllVars()) {
+    int slot = AddSlot(var->Name());
+    if (slot < 0) continue;
+    block_vars_.push_back(BlockVar{slot, var->GetType(), var->Persistable()});
+  }
+
+  op_frames_.resize(ops.size());
+  for (size_t i = 0; i < ops.size(); ++i) {
+    auto& frame = op_frames_[i];
+    frame.op = ops[i].get();
+    VariableValueMap inputs;
+    VariableValueMap outputs;
+    for (auto& item : frame.op->Inputs()) {
+      std::vector<int> slots;
+      for (auto& name : item.second) slots.push_back(AddSlot(name));
+      inputs[item.first].resize(slots.size(), nullptr);
+      frame.input_slots.emplace_back(std::move(slots));
+    }
+    for (auto& item : frame.op->Outputs()) {
+      std::vector<int> slots;
+      for (auto& name : item.second) slots.push_back(AddSlot(name));
+      outputs[item.first].resize(slots.size(), nullptr);
+      frame.output_slots.emplace_back(std::move(slots));
+    }
+    if (auto* kernel_op = dynamic_cast<OperatorWithKernel*>(frame.op)) {
+      kernel_op->PrepareRunWithContext();
+      frame.ctx.reset(new RuntimeContext(inputs, outputs));
+    }
+  }
+  slots_.resize(slot_names_.size(), nullptr);
+  VLOG(3) << "ExecutionFrame of block " << block.ID() << " has "
+          << slot_names_.size() << " slots for " << ops.size()
+          << " operators.";
+}
+
+bool ExecutionFrame::IsSupported(const BlockDesc& block) {
+  static const std::unordered_set<std::string> kEraseVarOps = {"delete_var"};
+  for (auto* op : block.AllOps()) {
+    if (kEraseVarOps.count(op->Type())) {
+      VLOG(3) << "Block " << block.ID() << " has operator " << op->Type()
+              << ", which can not run in an ExecutionFrame.";
+      return false;
+    }
+  }
+  return true;
+}
+
+int ExecutionFrame::AddSlot(const std::string& name) {
+  if (name == kEmptyVarName) return -1;
+  auto iter = slot_ids_.find(name);
+  if (iter != slot_ids_.end()) return iter->second;
+  int slot = static_cast<int>(slot_names_.size());
+  slot_names_.push_back(name);
+  slot_ids_.emplace(name, slot);
+  return slot;
+}
+
+void ExecutionFrame::CreateVariables(Scope* scope) {
+  const Scope* ancestor_scope = scope;
+  while (ancestor_scope->parent()) {
+    ancestor_scope = ancestor_scope->parent();
+  }
+  std::fill(slots_.begin(), slots_.end(), nullptr);
+  for (auto& var : block_vars_) {
+    Scope* owner = (ancestor_scope != scope && var.persistable)
+                       ? const_cast<Scope*>(ancestor_scope)
+                       : scope;
+    auto* ptr = owner->Var(slot_names_[var.slot]);
+    InitializeVariable(ptr, var.type);
+    slots_[var.slot] = ptr;
+  }
+  // The variables of the outer blocks.
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    if (slots_[i] == nullptr) slots_[i] = scope->FindVar(slot_names_[i]);
+  }
+  scope_ = scope;
+  BindOps();
+}
+
+void ExecutionFrame::Bind(const Scope& scope) {
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    slots_[i] = scope.FindVar(slot_names_[i]);
+  }
+  scope_ = &scope;
+  BindOps();
+}
+
+void ExecutionFrame::BindOps() {
+  auto resolve = [this](int slot) {
+    return slot < 0 ? nullptr : slots_[slot];
+  };
+  for (auto& frame : op_frames_) {
+    frame.unused_vars.clear();
+    frame.unused_vars_bound = true;
+    for (int slot : frame.unused_slots) {
+      if (slots_[slot] != nullptr) {
+        frame.unused_vars.push_back(slots_[slot]);
+      } else {
+        frame.unused_vars_bound = false;
+      }
+    }
+
+    if (frame.ctx == nullptr) continue;
+    frame.bound = true;
+    size_t k = 0;
+    for (auto& item : frame.ctx->inputs) {
+      auto& slots = frame.input_slots[k++];
+      for (size_t j = 0; j < slots.size(); ++j) {
+        item.second[j] = resolve(slots[j]);
+        frame.bound &= slots[j] < 0 || item.second[j] != nullptr;
+      }
+    }
+    k = 0;
+    for (auto& item : frame.ctx->outputs) {
+      auto& slots = frame.output_slots[k++];
+      for (size_t j = 0; j < slots.size(); ++j) {
+        item.second[j] = resolve(slots[j]);
+        frame.bound &= slots[j] < 0 || item.second[j] != nullptr;
+      }
+    }
+  }
+}
+
+size_t ExecutionFrame::num_bound_ops() const {
+  return std::count_if(op_frames_.begin(), op_frames_.end(),
+                       [](const OpFrame& frame) { return frame.bound; });
+}
+
+void ExecutionFrame::RunOp(size_t op_idx, const platform::Place& place) {
+  PADDLE_ENFORCE_NOT_NULL(
+      scope_, platform::errors::PreconditionNotMet(
+                  "ExecutionFrame should be bound to a scope before running."));
+  auto& frame = op_frames_[op_idx];
+  if (!frame.bound) {
+    frame.op->Run(*scope_, place);
+    return;
+  }
+  // PrepareData may point the inputs to the transferred variables, point
+  // them back to the slots.
+  size_t k = 0;
+  for (auto& item : frame.ctx->inputs) {
+    auto& slots = frame.input_slots[k++];
+    for (size_t j = 0; j < slots.size(); ++j) {
+      item.second[j] = slots[j] < 0 ? nullptr : slots_[slots[j]];
+    }
+  }
+  static_cast<OperatorWithKernel*>(frame.op)->RunWithPreparedContext(
+      *scope_, place, frame.ctx.get(), false);
+}
+
+void ExecutionFrame::SetUnusedVars(
+    const std::unordered_map<const OperatorBase*, std::vector<std::string>>&
+        unused_vars) {
+  for (auto& frame : op_frames_) {
+    frame.unused_slots.clear();
+    frame.unused_names.clear();
+    auto iter = unused_vars.find(frame.op);
+    if (iter == unused_vars.end()) continue;
+    frame.unused_names = iter->second;
+    for (auto& name : iter->second) {
+      int slot = AddSlot(name);
+      if (slot >= 0) frame.unused_slots.push_back(slot);
+    }
+  }
+  slots_.resize(slot_names_.size(), nullptr);
+}
+
+void ExecutionFrame::DeleteUnusedTensors(size_t op_idx,
+                                         GarbageCollector* gc) const {
+  auto& frame = op_frames_[op_idx];
+  if (frame.unused_vars_bound) {
+    if (!frame.unused_vars.empty()) {
+      framework::DeleteUnusedTensors(frame.unused_vars, gc);
+    }
+    return;
+  }
+  // Some variables are created by the operators after the frame is bound.
+  std::vector<Variable*> vars;
+  for (auto& name : frame.unused_names) {
+    auto* var = scope_->FindVar(name);
+    if (var != nullptr) vars.push_back(var);
+  }
+  framework::DeleteUnusedTensors(vars, gc);
+}
+
+}  // namespace framework
+}  // namespace paddle
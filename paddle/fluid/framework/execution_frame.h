@@ -0,0 +1,123 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "paddle/fluid/framework/block_desc.h"
+#include "paddle/fluid/framework/garbage_collector.h"
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/scope.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * ExecutionFrame runs the operators of a block without looking up their
+ * variables by name.
+ *
+ * When the frame is built, every variable of the block and every variable
+ * used by the operators gets an integer slot, and every operator with kernel
+ * gets a RuntimeContext whose inputs and outputs are mapped to the slots.
+ * Binding the frame to a scope resolves each slot once, or creates the
+ * variables of the block and fills their slots on the way. The operators then
+ * run with their prepared contexts and no variable is looked up by name. The
+ * operators without kernel, e.g. the control flow ops, and the ones using a
+ * variable not in the scope when it is bound run through OperatorBase::Run.
+ *
+ * The frame keeps the variables of one scope at a time, so it must not be
+ * bound or run by two threads at once, and the variables must not be erased
+ * from the scope while it is bound.
+ */
+class ExecutionFrame {
+ public:
+  ExecutionFrame(const BlockDesc& block,
+                 const std::vector<std::unique_ptr<OperatorBase>>& ops);
+
+  // Whether the operators of block can run in a frame. The ones erasing the
+  // variables of the scope they run in, e.g. delete_var, invalidate the
+  // slots.
+  static bool IsSupported(const BlockDesc& block);
+
+  // Create the variables of the block in scope as Executor::CreateVariables
+  // does, and bind the frame to scope.
+  void CreateVariables(Scope* scope);
+
+  // Bind the frame to the variables in scope and its ancestors.
+  void Bind(const Scope& scope);
+
+  // Run the op_idx-th operator in the bound scope.
+  void RunOp(size_t op_idx, const platform::Place& place);
+
+  // Set the variables that the garbage collector deletes after each
+  // operator, see GetUnusedVars. Call before binding.
+  void SetUnusedVars(
+      const std::unordered_map<const OperatorBase*, std::vector<std::string>>&
+          unused_vars);
+
+  // Delete the unused variables of the op_idx-th operator in the bound scope.
+  void DeleteUnusedTensors(size_t op_idx, GarbageCollector* gc) const;
+
+  const BlockDesc& block() const { return block_; }
+  size_t num_slots() const { return slot_names_.size(); }
+  // The number of the operators running with a prepared context in the bound
+  // scope.
+  size_t num_bound_ops() const;
+
+ private:
+  // The slot of a variable name, -1 for kEmptyVarName.
+  int AddSlot(const std::string& name);
+
+  void BindOps();
+
+  struct BlockVar {
+    int slot;
+    proto::VarType::Type type;
+    bool persistable;
+  };
+
+  struct OpFrame {
+    OperatorBase* op;
+    // Null if the operator has no kernel.
+    std::unique_ptr<RuntimeContext> ctx;
+    // The slots of ctx->inputs and ctx->outputs, in the order of the maps.
+    std::vector<std::vector<int>> input_slots;
+    std::vector<std::vector<int>> output_slots;
+    // Whether all the variables of ctx are found in the bound scope.
+    bool bound{false};
+    std::vector<int> unused_slots;
+    std::vector<std::string> unused_names;
+    // Resolved from unused_slots, or from unused_names if some are not
+    // found when bound.
+    std::vector<Variable*> unused_vars;
+    bool unused_vars_bound{true};
+  };
+
+  const BlockDesc& block_;
+  std::vector<std::string> slot_names_;
+  std::unordered_map<std::string, int> slot_ids_;
+  std::vector<BlockVar> block_vars_;
+  std::vector<OpFrame> op_frames_;
+
+  const Scope* scope_{nullptr};
+  std::vector<Variable*> slots_;
+
+  DISABLE_COPY_AND_ASSIGN(ExecutionFrame);
+};
+
+}  // namespace framework
+}  // namespace paddle
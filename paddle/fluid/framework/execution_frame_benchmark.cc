@@ -0,0 +1,137 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Time the dispatch of the operators on a chain of small elementwise_add ops,
+// x_{i+1} = x_i + y, where the kernels cost little next to the lookups of the
+// variables. Run the block with Executor and NaiveExecutor, looking up the
+// variables by name and with an ExecutionFrame, and report the nanoseconds
+// per operator.
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/executor.h"
+#include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+DEFINE_int32(num_ops, 500, "The number of the elementwise_add ops.");
+DEFINE_int32(numel, 4, "The number of the elements of each tensor.");
+DEFINE_int32(repeat, 200, "The number of the runs of the program.");
+
+DECLARE_bool(use_execution_frame);
+
+namespace paddle {
+namespace framework {
+
+static std::string VarName(int i) { return "x" + std::to_string(i); }
+
+// x0 and y are persistable, so Executor creates them once in the root scope
+// and the other variables in a local scope on every run.
+static void BuildProgram(ProgramDesc* program) {
+  auto* block = program->MutableBlock(0);
+  for (int i = 0; i <= FLAGS_num_ops; ++i) {
+    auto* var = block->Var(VarName(i));
+    var->SetType(proto::VarType::LOD_TENSOR);
+    var->SetPersistable(i == 0);
+  }
+  auto* y = block->Var("y");
+  y->SetType(proto::VarType::LOD_TENSOR);
+  y->SetPersistable(true);
+  for (int i = 0; i < FLAGS_num_ops; ++i) {
+    auto* add = block->AppendOp();
+    add->SetType("elementwise_add");
+    add->SetInput("X", {VarName(i)});
+    add->SetInput("Y", {"y"});
+    add->SetOutput("Out", {VarName(i + 1)});
+    add->SetAttr("axis", -1);
+  }
+}
+
+static void FillInputs(Scope* scope) {
+  for (auto name : {"x0", "y"}) {
+    auto* tensor = scope->Var(name)->GetMutable<LoDTensor>();
+    float* data =
+        tensor->mutable_data<float>({FLAGS_numel}, platform::CPUPlace());
+    std::fill_n(data, FLAGS_numel, 1.0f);
+  }
+}
+
+static double TimeNsPerOp(const std::function<void()>& fn) {
+  fn();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) fn();
+  std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / FLAGS_repeat / FLAGS_num_ops;
+}
+
+static double RunExecutor(const ProgramDesc& program, bool use_frame) {
+  FLAGS_use_execution_frame = use_frame;
+  platform::CPUPlace place;
+  Executor exe(place);
+  Scope scope;
+  FillInputs(&scope);
+  auto ctx = Executor::Prepare(program, 0);
+  return TimeNsPerOp([&] { exe.RunPreparedContext(ctx.get(), &scope); });
+}
+
+static double RunNaiveExecutor(const ProgramDesc& program, bool use_frame) {
+  platform::CPUPlace place;
+  Scope scope;
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, &scope);
+  exe.Prepare(&scope, program, 0, false);
+  FillInputs(&scope);
+  if (use_frame) {
+    PADDLE_ENFORCE_EQ(exe.EnableExecutionFrame(program), true,
+                      platform::errors::Unavailable(
+                          "The program can not run in an ExecutionFrame."));
+  }
+  return TimeNsPerOp([&] { exe.Run(); });
+}
+
+void RunBenchmark() {
+  ProgramDesc program;
+  BuildProgram(&program);
+  LOG(INFO) << "num_ops " << FLAGS_num_ops << ", numel " << FLAGS_numel
+            << ", repeat " << FLAGS_repeat;
+
+  double by_name = RunExecutor(program, false);
+  double frame = RunExecutor(program, true);
+  LOG(INFO) << "Executor " << by_name << " ns/op, frame " << frame
+            << " ns/op, speedup " << by_name / frame;
+
+  by_name = RunNaiveExecutor(program, false);
+  frame = RunNaiveExecutor(program, true);
+  LOG(INFO) << "NaiveExecutor " << by_name << " ns/op, frame " << frame
+            << " ns/op, speedup " << by_name / frame;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::RunBenchmark();
+  return 0;
+}
+
+USE_OP(elementwise_add);
@@ -0,0 +1,172 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+DECLARE_bool(use_execution_frame);
+DECLARE_double(eager_delete_tensor_gb);
+
+namespace paddle {
+namespace framework {
+
+static constexpr int kNumOps = 4;
+static constexpr int kNumel = 8;
+
+static std::string VarName(int i) { return "x" + std::to_string(i); }
+
+// x_{i+1} = x_i + y. x0, y and the output are persistable, the garbage
+// collector deletes the other variables once their last reader has run.
+static void BuildProgram(ProgramDesc* program) {
+  auto* block = program->MutableBlock(0);
+  for (int i = 0; i <= kNumOps; ++i) {
+    auto* var = block->Var(VarName(i));
+    var->SetType(proto::VarType::LOD_TENSOR);
+    var->SetPersistable(i == 0 || i == kNumOps);
+  }
+  auto* y = block->Var("y");
+  y->SetType(proto::VarType::LOD_TENSOR);
+  y->SetPersistable(true);
+  for (int i = 0; i < kNumOps; ++i) {
+    auto* add = block->AppendOp();
+    add->SetType("elementwise_add");
+    add->SetInput("X", {VarName(i)});
+    add->SetInput("Y", {"y"});
+    add->SetOutput("Out", {VarName(i + 1)});
+  }
+}
+
+static void FillInputs(Scope* scope, float base) {
+  auto place = platform::CPUPlace();
+  auto* x0 = scope->Var(VarName(0))->GetMutable<LoDTensor>();
+  auto* y = scope->Var("y")->GetMutable<LoDTensor>();
+  x0->Resize({2, kNumel / 2});
+  y->Resize({2, kNumel / 2});
+  auto* x0_data = x0->mutable_data<float>(place);
+  auto* y_data = y->mutable_data<float>(place);
+  for (int i = 0; i < kNumel; ++i) {
+    x0_data[i] = base + i;
+    y_data[i] = 0.5f * i;
+  }
+}
+
+static float Expected(float base, int i) {
+  return base + i + kNumOps * 0.5f * i;
+}
+
+// Runs the program in a root scope, so that every variable is created in it
+// and the intermediate ones can be checked after the garbage collector.
+static std::vector<float> RunWithGC(bool use_frame, int repeat) {
+  FLAGS_use_execution_frame = use_frame;
+  ProgramDesc program;
+  BuildProgram(&program);
+  auto place = platform::CPUPlace();
+  Executor exe(place);
+  auto ctx = Executor::Prepare(program, 0);
+  EXPECT_EQ(ctx->frame_ != nullptr, use_frame);
+
+  Scope scope;
+  std::vector<float> out;
+  for (int run = 0; run < repeat; ++run) {
+    FillInputs(&scope, run);
+    exe.RunPreparedContext(ctx.get(), &scope, false, true);
+    for (int i = 1; i < kNumOps; ++i) {
+      auto* var = scope.FindVar(VarName(i));
+      EXPECT_NE(var, nullptr);
+      if (var != nullptr) {
+        EXPECT_FALSE(var->Get<LoDTensor>().IsInitialized());
+      }
+    }
+    auto& res = scope.FindVar(VarName(kNumOps))->Get<LoDTensor>();
+    EXPECT_EQ(res.dims(), make_ddim({2, kNumel / 2}));
+    out.insert(out.end(), res.data<float>(), res.data<float>() + kNumel);
+  }
+  return out;
+}
+
+TEST(ExecutionFrame, ExecutorGarbageCollection) {
+  bool use_frame = FLAGS_use_execution_frame;
+  double gc_threshold = FLAGS_eager_delete_tensor_gb;
+  FLAGS_eager_delete_tensor_gb = 0.0;
+
+  auto by_name = RunWithGC(false, 3);
+  auto frame = RunWithGC(true, 3);
+  ASSERT_EQ(by_name.size(), 3UL * kNumel);
+  EXPECT_EQ(by_name, frame);
+  for (int run = 0; run < 3; ++run) {
+    for (int i = 0; i < kNumel; ++i) {
+      EXPECT_NEAR(frame[run * kNumel + i], Expected(run, i), 1e-5);
+    }
+  }
+
+  FLAGS_use_execution_frame = use_frame;
+  FLAGS_eager_delete_tensor_gb = gc_threshold;
+}
+
+// The runs sharing the prepared context that do not get the frame fall back
+// to looking up the variables by name in their own scopes.
+TEST(ExecutionFrame, ExecutorConcurrentRuns) {
+  bool use_frame = FLAGS_use_execution_frame;
+  double gc_threshold = FLAGS_eager_delete_tensor_gb;
+  FLAGS_use_execution_frame = true;
+  FLAGS_eager_delete_tensor_gb = 0.0;
+
+  ProgramDesc program;
+  BuildProgram(&program);
+  auto place = platform::CPUPlace();
+  auto ctx = Executor::Prepare(program, 0);
+  ASSERT_NE(ctx->frame_, nullptr);
+
+  const int num_threads = 4;
+  std::vector<int> num_errors(num_threads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      Executor exe(place);
+      Scope scope;
+      for (int run = 0; run < 50; ++run) {
+        float base = t * 100 + run;
+        FillInputs(&scope, base);
+        exe.RunPreparedContext(ctx.get(), &scope, false, true);
+        auto& res = scope.FindVar(VarName(kNumOps))->Get<LoDTensor>();
+        for (int i = 0; i < kNumel; ++i) {
+          if (std::abs(res.data<float>()[i] - Expected(base, i)) > 1e-3) {
+            ++num_errors[t];
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (int t = 0; t < num_threads; ++t) {
+    EXPECT_EQ(num_errors[t], 0) << "thread " << t;
+  }
+
+  FLAGS_use_execution_frame = use_frame;
+  FLAGS_eager_delete_tensor_gb = gc_threshold;
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+USE_OP(elementwise_add);
@@ -40,6 +40,10 @@ limitations under the License. */
 
 DECLARE_bool(benchmark);
 DEFINE_bool(use_mkldnn, false, "Use MKLDNN to run");
+DEFINE_bool(use_execution_frame, false,
+            "Bind the operators of a prepared block to the variable slots of "
+            "an ExecutionFrame, so that running them looks up no variable by "
+            "name.");
 
 namespace paddle {
 namespace framework {
@@ -73,6 +77,16 @@ void ExecutorPrepareContext::PrepareUnusedVars(
   unused_vars_ = GetUnusedVars(prog_.Block(block_id_), ops_, keep_vars);
 }
 
+void ExecutorPrepareContext::PrepareExecutionFrame() {
+  auto& block = prog_.Block(block_id_);
+  if (!ExecutionFrame::IsSupported(block)) {
+    frame_.reset();
+    return;
+  }
+  frame_.reset(new ExecutionFrame(block, ops_));
+  frame_->SetUnusedVars(unused_vars_);
+}
+
 ExecutorPrepareContext::~ExecutorPrepareContext() {
   VLOG(5) << "destroy ExecutorPrepareContext";
 }
@@ -392,6 +406,9 @@ std::unique_ptr<ExecutorPrepareContext> Executor::Prepare(
     ctx->ops_.push_back(OpRegistry::CreateOp(*op_desc));
   }
   ctx->PrepareUnusedVars(skip_ref_cnt_vars, force_disable_gc);
+  if (FLAGS_use_execution_frame) {
+    ctx->PrepareExecutionFrame();
+  }
   return ctx;
 }
 
@@ -423,6 +440,9 @@ std::vector<std::shared_ptr<ExecutorPrepareContext>> Executor::Prepare(
     } else {
       ctx->PrepareUnusedVars(skip_ref_cnt_vars[idx], force_disable_gc);
     }
+    if (FLAGS_use_execution_frame) {
+      ctx->PrepareExecutionFrame();
+    }
     result.push_back(std::shared_ptr<ExecutorPrepareContext>(ctx));
     ++idx;
   }
@@ -437,12 +457,26 @@ void Executor::RunPartialPreparedContext(ExecutorPrepareContext* ctx,
   platform::RecordBlock b(kProgramId);
   PADDLE_ENFORCE_NOT_NULL(
       scope, platform::errors::InvalidArgument("Scope shouldn't be null"));
+  std::unique_lock<std::mutex> frame_lock;
+  ExecutionFrame* frame = nullptr;
+  if (ctx->frame_) {
+    frame_lock = std::unique_lock<std::mutex>(ctx->frame_mutex_,
+                                              std::try_to_lock);
+    if (frame_lock.owns_lock()) frame = ctx->frame_.get();
+  }
+
   Scope* local_scope = scope;
   if (create_vars) {
     if (create_local_scope) {
       local_scope = &scope->NewScope();
     }
-    CreateVariables(ctx->prog_, local_scope, ctx->block_id_);
+    if (frame) {
+      frame->CreateVariables(local_scope);
+    } else {
+      CreateVariables(ctx->prog_, local_scope, ctx->block_id_);
+    }
+  } else if (frame) {
+    frame->Bind(*local_scope);
   }
 
   int64_t max_memory_size = GetEagerDeletionThreshold();
@@ -468,6 +502,13 @@ void Executor::RunPartialPreparedContext(ExecutorPrepareContext* ctx,
 
   for (int64_t i = start_op_index; i < end_op_index; ++i) {
     auto& op = ctx->ops_[i];
+    if (frame) {
+      frame->RunOp(i, place_);
+      if (gc) {
+        frame->DeleteUnusedTensors(i, gc.get());
+      }
+      continue;
+    }
     op->Run(*local_scope, place_);
     if (gc) {
       DeleteUnusedTensors(*local_scope, op.get(), ctx->unused_vars_, gc.get());
@@ -16,10 +16,12 @@ limitations under the License. */
 
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include "paddle/fluid/framework/data_set.h"
+#include "paddle/fluid/framework/execution_frame.h"
 #include "paddle/fluid/framework/executor_gc_helper.h"
 #include "paddle/fluid/framework/garbage_collector.h"
 #include "paddle/fluid/framework/op_info.h"
@@ -40,6 +42,10 @@ struct ExecutorPrepareContext {
   void PrepareUnusedVars(const std::vector<std::string>& keep_vars,
                          bool force_disable_gc = false);
 
+  // Run the operators in an ExecutionFrame if the block supports it. Called
+  // after PrepareUnusedVars when FLAGS_use_execution_frame is set.
+  void PrepareExecutionFrame();
+
   const framework::ProgramDesc& prog_;
   const size_t block_id_;
 
@@ -48,6 +54,11 @@ struct ExecutorPrepareContext {
   std::unordered_map<const OperatorBase*, std::vector<std::string>>
       unused_vars_;
   bool force_disable_gc_{false};
+
+  std::unique_ptr<ExecutionFrame> frame_;
+  // Held by the run using frame_, a concurrent run of this context goes
+  // without the frame.
+  std::mutex frame_mutex_;
 };
 
 class Executor {
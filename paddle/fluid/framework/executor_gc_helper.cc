@@ -143,6 +143,26 @@ GetUnusedVars(const BlockDesc &block,
   return result;
 }
 
+// Move the memory of the tensors in var to garbages. Returns false if the
+// type of var is not supported.
+static bool CollectGarbages(
+    Variable *var, std::deque<std::shared_ptr<memory::Allocation>> *garbages) {
+  if (var->IsType<LoDTensor>()) {
+    garbages->emplace_back(var->GetMutable<LoDTensor>()->MoveMemoryHolder());
+  } else if (var->IsType<SelectedRows>()) {
+    garbages->emplace_back(
+        var->GetMutable<SelectedRows>()->mutable_value()->MoveMemoryHolder());
+  } else if (var->IsType<LoDTensorArray>()) {
+    auto *lod_tensor_arr = var->GetMutable<LoDTensorArray>();
+    for (auto &t : *lod_tensor_arr) {
+      garbages->emplace_back(t.MoveMemoryHolder());
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
 void DeleteUnusedTensors(
     const Scope &scope, const OperatorBase *op,
     const std::unordered_map<const OperatorBase *, std::vector<std::string>>
@@ -164,17 +184,7 @@ void DeleteUnusedTensors(
     }
 
     VLOG(2) << "Erase variable " << var_name;
-    if (var->IsType<LoDTensor>()) {
-      garbages.emplace_back(var->GetMutable<LoDTensor>()->MoveMemoryHolder());
-    } else if (var->IsType<SelectedRows>()) {
-      garbages.emplace_back(
-          var->GetMutable<SelectedRows>()->mutable_value()->MoveMemoryHolder());
-    } else if (var->IsType<LoDTensorArray>()) {
-      auto *lod_tensor_arr = var->GetMutable<LoDTensorArray>();
-      for (auto &t : *lod_tensor_arr) {
-        garbages.emplace_back(t.MoveMemoryHolder());
-      }
-    } else {
+    if (!CollectGarbages(var, &garbages)) {
       PADDLE_THROW("Type %s of %s is not supported eager deletion",
                    framework::ToTypeName(var->Type()), var_name);
     }
@@ -185,5 +195,21 @@ void DeleteUnusedTensors(
   }
 }
 
+void DeleteUnusedTensors(const std::vector<Variable *> &delete_vars,
+                         GarbageCollector *gc) {
+  std::deque<std::shared_ptr<memory::Allocation>> garbages;
+
+  for (auto *var : delete_vars) {
+    if (!CollectGarbages(var, &garbages)) {
+      PADDLE_THROW("Type %s is not supported eager deletion",
+                   framework::ToTypeName(var->Type()));
+    }
+  }
+
+  if (!garbages.empty()) {
+    gc->Add(std::move(garbages));
+  }
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -38,5 +38,10 @@ void DeleteUnusedTensors(
         &delete_vars_map,
     GarbageCollector *gc);
 
+// Collect the unused tensors of the given variables, which are found already,
+// e.g. by ExecutionFrame.
+void DeleteUnusedTensors(const std::vector<Variable *> &delete_vars,
+                         GarbageCollector *gc);
+
 }  // namespace framework
 }  // namespace paddle
@@ -0,0 +1,266 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/io/read_ahead.h"
+
+#include <sys/types.h>
+#include <algorithm>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <deque>
+#include <mutex>  // NOLINT
+#include <utility>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/io/fs.h"
+
+#if defined _WIN32 || defined __APPLE__
+#else
+#define _LINUX
+#endif
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+double SecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+}  // namespace
+
+struct ReadAheadReader::State {
+  // guards the files, their chunks and their counters
+  std::mutex mutex;
+  // the readers wait for the chunks
+  std::condition_variable data_cond;
+  // the I/O threads wait for the space in the chunks, or for the readers
+  // to open the files read to the end
+  std::condition_variable space_cond;
+  bool stop = false;
+};
+
+struct ReadAheadReader::File {
+  FileReadStats stats;
+  std::deque<std::vector<char>> chunks;
+  // the I/O thread read the file to the end, or gave up
+  bool eof = false;
+  bool opened = false;
+  // the reader closed the file
+  bool closed = false;
+};
+
+// The cookie of a FILE returned by Open().
+class ReadAheadReader::Handle {
+ public:
+  Handle(std::shared_ptr<State> state, std::shared_ptr<File> file)
+      : state_(std::move(state)), file_(std::move(file)) {}
+
+#ifdef _LINUX
+  static ssize_t CookieRead(void* cookie, char* buf, size_t size) {
+    return static_cast<Handle*>(cookie)->Read(buf, size);
+  }
+
+  static int CookieClose(void* cookie) {
+    Handle* handle = static_cast<Handle*>(cookie);
+    handle->Close();
+    delete handle;
+    return 0;
+  }
+#endif
+
+ private:
+  ssize_t Read(char* buf, size_t size) {
+    if (offset_ == chunk_.size()) {
+      std::unique_lock<std::mutex> lock(state_->mutex);
+      if (file_->chunks.empty() && !file_->eof && !state_->stop) {
+        auto start = std::chrono::steady_clock::now();
+        state_->data_cond.wait(lock, [this] {
+          return !file_->chunks.empty() || file_->eof || state_->stop;
+        });
+        file_->stats.stall_seconds += SecondsSince(start);
+        ++file_->stats.stalls;
+      }
+      if (file_->chunks.empty()) {
+        // The reader stopped before the end of the file.
+        return file_->eof ? 0 : -1;
+      }
+      chunk_ = std::move(file_->chunks.front());
+      file_->chunks.pop_front();
+      offset_ = 0;
+      state_->space_cond.notify_all();
+    }
+    size_t n = std::min(size, chunk_.size() - offset_);
+    memcpy(buf, chunk_.data() + offset_, n);
+    offset_ += n;
+    return static_cast<ssize_t>(n);
+  }
+
+  void Close() {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    file_->closed = true;
+    file_->chunks.clear();
+    state_->space_cond.notify_all();
+  }
+
+  std::shared_ptr<State> state_;
+  std::shared_ptr<File> file_;
+  std::vector<char> chunk_;
+  size_t offset_ = 0;
+};
+
+ReadAheadReader::ReadAheadReader(int file_num, int chunk_num,
+                                 size_t chunk_size)
+    : file_num_(file_num),
+      chunk_num_(chunk_num),
+      chunk_size_(chunk_size),
+      state_(std::make_shared<State>()) {
+  CHECK_GT(file_num_, 0);
+  CHECK_GT(chunk_num_, 0);
+  CHECK_GT(chunk_size_, 0UL);
+}
+
+ReadAheadReader::~ReadAheadReader() { Stop(); }
+
+void ReadAheadReader::Start(const std::vector<std::string>& paths,
+                            const std::string& converter) {
+  CHECK(threads_.empty()) << "read ahead has been started";
+  converter_ = converter;
+#ifdef _LINUX
+  for (auto& path : paths) {
+    files_.push_back(std::make_shared<File>());
+    files_.back()->stats.path = path;
+    unopened_.emplace(path, files_.back());
+  }
+  int thread_num = std::min(file_num_, static_cast<int>(paths.size()));
+  for (int i = 0; i < thread_num; ++i) {
+    threads_.push_back(std::thread(&ReadAheadReader::IoThread, this));
+  }
+#endif
+}
+
+std::shared_ptr<FILE> ReadAheadReader::Open(const std::string& path,
+                                            int* err_no) {
+#ifdef _LINUX
+  std::shared_ptr<File> file;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    auto it = unopened_.find(path);
+    if (it != unopened_.end()) {
+      file = it->second;
+      unopened_.erase(it);
+      file->opened = true;
+    }
+  }
+  if (file != nullptr) {
+    state_->space_cond.notify_all();
+    cookie_io_functions_t funcs = {&Handle::CookieRead, nullptr, nullptr,
+                                   &Handle::CookieClose};
+    Handle* handle = new Handle(state_, file);
+    FILE* fp = fopencookie(handle, "r", funcs);
+    CHECK(fp != nullptr) << "fopencookie failed, path=" << path;
+    return {fp, [](FILE* fp) { fclose(fp); }};
+  }
+#endif
+  return fs_open_read(path, err_no, converter_);
+}
+
+void ReadAheadReader::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->stop = true;
+    unopened_.clear();
+  }
+  state_->data_cond.notify_all();
+  state_->space_cond.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+  threads_.clear();
+}
+
+std::vector<FileReadStats> ReadAheadReader::Stats() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  std::vector<FileReadStats> stats;
+  for (auto& file : files_) {
+    stats.push_back(file->stats);
+  }
+  return stats;
+}
+
+void ReadAheadReader::IoThread() {
+  for (;;) {
+    std::shared_ptr<File> file;
+    {
+      std::lock_guard<std::mutex> lock(state_->mutex);
+      if (state_->stop || next_file_ >= files_.size()) {
+        return;
+      }
+      file = files_[next_file_++];
+    }
+    ReadFile(file.get());
+    // Buffer no more files until a reader takes this one.
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    state_->space_cond.wait(
+        lock, [&file, this] { return file->opened || state_->stop; });
+  }
+}
+
+void ReadAheadReader::ReadFile(File* file) {
+  auto start = std::chrono::steady_clock::now();
+  int err_no = 0;
+  std::shared_ptr<FILE> fp = fs_open_read(file->stats.path, &err_no,
+                                          converter_);
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    file->stats.open_seconds = SecondsSince(start);
+  }
+  while (fp != nullptr) {
+    {
+      std::unique_lock<std::mutex> lock(state_->mutex);
+      state_->space_cond.wait(lock, [file, this] {
+        return file->chunks.size() < static_cast<size_t>(chunk_num_) ||
+               file->closed || state_->stop;
+      });
+      if (file->closed || state_->stop) {
+        break;
+      }
+    }
+    std::vector<char> chunk(chunk_size_);
+    start = std::chrono::steady_clock::now();
+    size_t n = fread(chunk.data(), 1, chunk.size(), fp.get());
+    double read_seconds = SecondsSince(start);
+    chunk.resize(n);
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    file->stats.read_seconds += read_seconds;
+    if (n == 0) {
+      break;
+    }
+    file->stats.bytes += n;
+    file->chunks.push_back(std::move(chunk));
+    state_->data_cond.notify_all();
+  }
+  // Close the file, the pipe commands log their errors on the close.
+  fp = nullptr;
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  file->eof = true;
+  state_->data_cond.notify_all();
+}
+
+}  // namespace framework
+}  // namespace paddle
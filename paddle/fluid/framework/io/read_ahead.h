@@ -0,0 +1,90 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdio.h>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// The I/O counters of a file read through a ReadAheadReader.
+struct FileReadStats {
+  std::string path;
+  size_t bytes = 0;
+  // the I/O thread opening the file, e.g. starting the pipe command
+  double open_seconds = 0;
+  // the I/O thread reading the file
+  double read_seconds = 0;
+  // the reader waiting for the data, and the number of the waits
+  double stall_seconds = 0;
+  int64_t stalls = 0;
+};
+
+// Read a list of files ahead of their readers. file_num I/O threads each
+// open the next file of the list with fs_open_read, and read it into at
+// most chunk_num chunks of chunk_size bytes, so the opening of the pipe
+// commands and the reads overlap with the parsing. Open() returns a FILE
+// over the chunks. An I/O thread moves on to the next file once the file
+// is opened and read to the end, so at most file_num files are buffered.
+// The readers are expected to open the files in about the order of the
+// list, as DataFeed::PickOneFile does.
+class ReadAheadReader {
+ public:
+  ReadAheadReader(int file_num, int chunk_num, size_t chunk_size);
+  ~ReadAheadReader();
+
+  // Start reading the files, the converter is passed to fs_open_read.
+  void Start(const std::vector<std::string>& paths,
+             const std::string& converter);
+
+  // A FILE reading path, the files not in the list are opened directly
+  // with fs_open_read. The errors of the pipe commands are logged by the
+  // I/O threads instead of set to err_no.
+  std::shared_ptr<FILE> Open(const std::string& path, int* err_no);
+
+  // Stop the I/O threads, the files not opened yet are dropped.
+  void Stop();
+
+  // The counters of the files in the list, in its order.
+  std::vector<FileReadStats> Stats();
+
+ private:
+  struct File;
+  struct State;
+  class Handle;
+
+  void IoThread();
+  void ReadFile(File* file);
+
+  int file_num_;
+  int chunk_num_;
+  size_t chunk_size_;
+  std::string converter_;
+  std::vector<std::shared_ptr<File>> files_;
+  std::unordered_multimap<std::string, std::shared_ptr<File>> unopened_;
+  size_t next_file_ = 0;
+  std::vector<std::thread> threads_;
+  // the lock and the conditions, shared with the open FILEs which may
+  // outlive the reader
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace framework
+}  // namespace paddle
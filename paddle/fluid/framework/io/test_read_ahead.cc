@@ -0,0 +1,110 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "paddle/fluid/framework/io/read_ahead.h"
+
+#if defined _WIN32 || defined __APPLE__
+#else
+#define _LINUX
+#endif
+
+namespace {
+
+std::string ReadAll(FILE* fp) {
+  std::string data;
+  char buf[7];
+  size_t n = 0;
+  while ((n = fread(buf, 1, sizeof(buf), fp)) != 0) {
+    data.append(buf, n);
+  }
+  return data;
+}
+
+std::vector<std::string> WriteFiles(int num) {
+  std::vector<std::string> paths;
+  for (int i = 0; i < num; ++i) {
+    paths.push_back("read_ahead_" + std::to_string(i) + ".txt");
+    std::ofstream out(paths.back());
+    for (int j = 0; j < 100 * i; ++j) {
+      out << i << " " << j << "\n";
+    }
+  }
+  return paths;
+}
+
+std::string Expected(int i) {
+  std::string data;
+  for (int j = 0; j < 100 * i; ++j) {
+    data += std::to_string(i) + " " + std::to_string(j) + "\n";
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(ReadAheadReader, ReadInOrder) {
+#ifdef _LINUX
+  auto paths = WriteFiles(5);
+  paddle::framework::ReadAheadReader reader(2, 2, 64);
+  reader.Start(paths, "");
+  for (size_t i = 0; i < paths.size(); ++i) {
+    int err_no = 0;
+    auto fp = reader.Open(paths[i], &err_no);
+    ASSERT_EQ(ReadAll(fp.get()), Expected(i));
+  }
+  auto stats = reader.Stats();
+  ASSERT_EQ(stats.size(), paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    ASSERT_EQ(stats[i].path, paths[i]);
+    ASSERT_EQ(stats[i].bytes, Expected(i).size());
+  }
+  reader.Stop();
+  for (auto& path : paths) {
+    remove(path.c_str());
+  }
+#endif
+}
+
+TEST(ReadAheadReader, CloseEarlyAndStop) {
+#ifdef _LINUX
+  auto paths = WriteFiles(5);
+  std::vector<std::string> list(paths.begin(), paths.begin() + 4);
+  paddle::framework::ReadAheadReader reader(1, 1, 16);
+  reader.Start(list, "");
+  int err_no = 0;
+  auto fp = reader.Open(list[0], &err_no);
+  ASSERT_EQ(ReadAll(fp.get()), "");
+  {
+    // Close before the end, the I/O thread moves on.
+    auto fp = reader.Open(list[1], &err_no);
+    char buf[4];
+    ASSERT_EQ(fread(buf, 1, sizeof(buf), fp.get()), sizeof(buf));
+  }
+  fp = reader.Open(list[2], &err_no);
+  ASSERT_EQ(ReadAll(fp.get()), Expected(2));
+  // A file out of the list is read directly.
+  fp = reader.Open(paths[4], &err_no);
+  ASSERT_EQ(ReadAll(fp.get()), Expected(4));
+  // The files not opened are dropped.
+  reader.Stop();
+  for (auto& path : paths) {
+    remove(path.c_str());
+  }
+#endif
+}
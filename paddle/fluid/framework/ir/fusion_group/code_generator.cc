@@ -16,6 +16,7 @@ limitations under the License. */
 #include <sstream>
 #include <unordered_set>
 #include "paddle/fluid/framework/ir/fusion_group/code_generator_helper.h"
+#include "paddle/fluid/framework/ir/fusion_group/cpu_resources.h"
 #include "paddle/fluid/framework/ir/fusion_group/cuda_resources.h"
 #include "paddle/fluid/framework/ir/fusion_group/operation.h"
 
@@ -45,11 +46,12 @@ std::string ExtractDataType(const std::vector<Node*>& nodes) {
   return dtype_str;
 }
 
-CodeGenerator::CodeGenerator() {
+CodeGenerator::CodeGenerator(bool use_gpu) : use_gpu_(use_gpu) {
   // Only support elementwise operations now.
   code_templates_.resize(1);
 
-  CodeTemplate elementwise_t(cuda_kernel_template_1d);
+  CodeTemplate elementwise_t(use_gpu ? cuda_kernel_template_1d
+                                     : cpu_kernel_template_1d);
   code_templates_[0] = elementwise_t;
 }
 
@@ -162,6 +164,20 @@ std::string CodeGenerator::Generate(
   for (const auto& type : dtypes) {
     all_dtype.insert(type.second);
   }
+  if (!use_gpu_) {
+    PADDLE_ENFORCE_EQ(all_dtype.find("__half"), all_dtype.end(),
+                      platform::errors::Unimplemented(
+                          "The generated CPU kernels do not support float16."));
+    std::string predefined_cpu_functions_all = predefined_cpu_functions;
+    if (all_dtype.find("float") != all_dtype.end()) {
+      predefined_cpu_functions_all += predefined_cpu_functions_fp32;
+    }
+    if (all_dtype.find("double") != all_dtype.end()) {
+      predefined_cpu_functions_all += predefined_cpu_functions_fp64;
+    }
+    return predefined_cpu_functions_all +
+           code_templates_[0].Format(template_var);
+  }
   std::string predefined_cuda_functions = "";
   if (all_dtype.find("float") != all_dtype.end() &&
       all_dtype.find("__half") == all_dtype.end()) {
@@ -250,6 +266,9 @@ std::string CodeGenerator::EmitParameters(
     const std::set<int>& input_ids, const std::set<int>& output_ids,
     const std::set<int>& intermediate_ids,
     const std::unordered_map<int, std::string>& dtypes) const {
+  if (!use_gpu_) {
+    return EmitCPUParameters(input_ids, output_ids, intermediate_ids, dtypes);
+  }
   std::stringstream ret;
   ret << "int N, ";
 
@@ -280,6 +299,35 @@ std::string CodeGenerator::EmitParameters(
   return ret.str();
 }
 
+// The CPU kernel gets the parameters from args, in the same order as those of
+// the CUDA kernel, see cpu_kernel_template_1d.
+std::string CodeGenerator::EmitCPUParameters(
+    const std::set<int>& input_ids, const std::set<int>& output_ids,
+    const std::set<int>& intermediate_ids,
+    const std::unordered_map<int, std::string>& dtypes) const {
+  std::stringstream ret;
+  // args[0] is the number of elements.
+  size_t index = 1;
+  for (auto id : input_ids) {
+    if (output_ids.find(id) == output_ids.end()) {
+      const std::string& dtype = dtypes.at(id);
+      ret << "const " << dtype << "* __restrict__ " << ArgName(id)
+          << " = *static_cast<const " << dtype << "* const*>(args[" << index
+          << "]);";
+      index++;
+    }
+  }
+  for (auto id : output_ids) {
+    if (intermediate_ids.find(id) == intermediate_ids.end()) {
+      const std::string& dtype = dtypes.at(id);
+      ret << dtype << "* __restrict__ " << ArgName(id) << " = *static_cast<"
+          << dtype << "* const*>(args[" << index << "]);";
+      index++;
+    }
+  }
+  return ret.str();
+}
+
 std::string CodeGenerator::EmitComputeBody(
     const std::vector<OperationExpression>& expressions,
     const std::set<int>& input_ids, const std::set<int>& output_ids,
@@ -297,9 +345,13 @@ std::string CodeGenerator::EmitComputeBody(
   for (auto id : input_ids) {
     if (output_ids.find(id) == output_ids.end() &&
         used.find(id) != used.end()) {
-      load << dtypes.at(id) << " " << TmpName(id) << " = "
-           << "__ldg(&" << VarName(id) << ")"
-           << ";";
+      load << dtypes.at(id) << " " << TmpName(id) << " = ";
+      if (use_gpu_) {
+        load << "__ldg(&" << VarName(id) << ")";
+      } else {
+        load << VarName(id);
+      }
+      load << ";";
     }
   }
   // Store temporal variables to memory.
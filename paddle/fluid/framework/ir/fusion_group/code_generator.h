@@ -27,9 +27,11 @@ namespace framework {
 namespace ir {
 namespace fusion_group {
 
+// Generates the CUDA kernel launched by platform::CUDADeviceCode, or the host
+// kernel launched by platform::CPUDeviceCode when use_gpu is false.
 class CodeGenerator {
  public:
-  CodeGenerator();
+  explicit CodeGenerator(bool use_gpu = true);
 
   std::string Generate(std::string func_name,
                        const std::vector<OperationExpression>& expressions);
@@ -54,6 +56,11 @@ class CodeGenerator {
       const std::set<int>& intermediate_ids,
       const std::unordered_map<int, std::string>& dtypes) const;
 
+  std::string EmitCPUParameters(
+      const std::set<int>& input_ids, const std::set<int>& output_ids,
+      const std::set<int>& intermediate_ids,
+      const std::unordered_map<int, std::string>& dtypes) const;
+
   std::string EmitComputeBody(
       const std::vector<OperationExpression>& expressions,
       const std::set<int>& input_ids, const std::set<int>& output_ids,
@@ -64,6 +71,7 @@ class CodeGenerator {
   std::unordered_map<std::string, int> EncodeVarNodes(SubGraph* subgraph);
 
  private:
+  bool use_gpu_;
   std::vector<CodeTemplate> code_templates_;
 };
 
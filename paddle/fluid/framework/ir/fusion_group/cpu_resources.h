@@ -0,0 +1,63 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+namespace paddle {
+namespace framework {
+namespace ir {
+namespace fusion_group {
+
+static constexpr char predefined_cpu_functions[] = R"(
+#include <math.h>
+#include <stdint.h>
+
+)";
+
+static constexpr char predefined_cpu_functions_fp32[] = R"(
+static inline float Max(float x, float y) { return x > y ? x : y; }
+static inline float Exp(float x) { return expf(x); }
+static inline float Log(float x) { return logf(x); }
+static inline float Sqrt(float x) { return sqrtf(x); }
+
+)";
+
+static constexpr char predefined_cpu_functions_fp64[] = R"(
+static inline double Max(double x, double y) { return x > y ? x : y; }
+static inline double Exp(double x) { return exp(x); }
+static inline double Log(double x) { return log(x); }
+static inline double Sqrt(double x) { return sqrt(x); }
+
+)";
+
+// The elements [begin, end) are computed in one call, the loop is vectorized
+// by the compiler and the ranges are run by the threads of the intra-op pool,
+// see platform::CPUDeviceCode. args[0] points to the number of elements, and
+// args[i] to the pointer of the (i - 1)-th parameter.
+static constexpr char cpu_kernel_template_1d[] = R"(
+extern "C" void $func_name(int64_t begin, int64_t end, void** args) {
+  $parameters
+#pragma omp simd
+  for(int64_t idx = begin;
+      idx < end;
+      ++idx) {
+    $compute_body
+  }
+}
+)";
+
+}  // namespace fusion_group
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
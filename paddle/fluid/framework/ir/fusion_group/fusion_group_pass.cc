@@ -29,18 +29,32 @@ namespace ir {
 
 void FusionGroupPass::ApplyImpl(ir::Graph* graph) const {
   FusePassBase::Init("fusion_group_pass", graph);
+  // TODO(liuyiqun): supported different places
+  platform::Place place = platform::CPUPlace();
   if (Get<bool>("use_gpu")) {
-    fusion_group::OperationMap::Init();
-    int num_elementwise_groups = DetectFusionGroup(graph, 0);
-    AddStatis(num_elementwise_groups);
-    LOG(INFO) << "Detect " << num_elementwise_groups
-              << " elementwise fusion groups.";
+    place = platform::CUDAPlace(0);
   }
+  fusion_group::OperationMap::Init();
+  int num_elementwise_groups = DetectFusionGroup(graph, place, 0);
+  AddStatis(num_elementwise_groups);
+  LOG(INFO) << "Detect " << num_elementwise_groups
+            << " elementwise fusion groups.";
 }
 
-int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
-  // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
+// The generated CPU kernels compute in float and double only.
+static bool HasFP16Var(const fusion_group::SubGraph& subgraph) {
+  for (auto* n : subgraph.Nodes()) {
+    if (n && n->IsVar() && n->Var() &&
+        n->Var()->GetDataType() == proto::VarType::FP16) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int FusionGroupPass::DetectFusionGroup(Graph* graph,
+                                       const platform::Place& place,
+                                       int type) const {
   int index = platform::DeviceCodePool::Init({place}).size(place);
 
   std::vector<std::vector<Node*>> subgraphs =
@@ -60,9 +74,13 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
     if (subgraph.RemoveIntermediateOut()) {
       subgraph.DetectIntermediateOutWithGraph(graph);
     }
+    if (platform::is_cpu_place(place) && HasFP16Var(subgraph)) {
+      VLOG(2) << "Skip the subgraph of float16 on CPU.";
+      continue;
+    }
     if (subgraph.IsValid(min_subgraph_size)) {
       subgraph.SetFuncName("FusedElementwise" + std::to_string(index++));
-      if (GenerateCode(&subgraph)) {
+      if (GenerateCode(&subgraph, place)) {
         InsertFusionGroupOp(graph, &subgraph);
         num_subgraphs++;
       }
@@ -71,15 +89,26 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
   return num_subgraphs;
 }
 
-bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph) const {
-  fusion_group::CodeGenerator code_generator;
+bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph,
+                                   const platform::Place& place) const {
+  bool use_gpu = platform::is_gpu_place(place);
+  fusion_group::CodeGenerator code_generator(use_gpu);
   std::string code_str = code_generator.Generate(subgraph);
   VLOG(3) << code_str;
 
-  // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
-  std::unique_ptr<platform::CUDADeviceCode> device_code(
-      new platform::CUDADeviceCode(place, subgraph->GetFuncName(), code_str));
+  std::unique_ptr<platform::DeviceCode> device_code;
+  if (use_gpu) {
+#ifdef PADDLE_WITH_CUDA
+    device_code.reset(new platform::CUDADeviceCode(
+        place, subgraph->GetFuncName(), code_str));
+#endif
+  } else {
+    device_code.reset(new platform::CPUDeviceCode(
+        place, subgraph->GetFuncName(), code_str));
+  }
+  if (device_code == nullptr) {
+    return false;
+  }
   bool is_compiled = device_code->Compile();
   if (is_compiled) {
     platform::DeviceCodePool& pool = platform::DeviceCodePool::Init({place});
@@ -15,6 +15,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/ir/fusion_group/fusion_group_pass.h"
 
 #include <gtest/gtest.h>
+#include <vector>
 #include "paddle/fluid/framework/ir/fusion_group/operation.h"
 #include "paddle/fluid/framework/ir/pass_tester_helper.h"
 
@@ -133,10 +134,11 @@ std::unique_ptr<Graph> BuildElementwiseTreeGraph(bool backward = false) {
 #endif
 }
 
-int TestMain(std::unique_ptr<Graph> graph, std::string prefix) {
+int TestMain(std::unique_ptr<Graph> graph, std::string prefix,
+             bool use_gpu) {
   // VisualizeGraph(&graph, prefix + ".dot");
   auto pass = PassRegistry::Instance().Get("fusion_group_pass");
-  pass->Set("use_gpu", new bool(true));
+  pass->Set("use_gpu", new bool(use_gpu));
   VLOG(3) << DebugString(graph);
 
   graph.reset(pass->Apply(graph.release()));
@@ -147,16 +149,30 @@ int TestMain(std::unique_ptr<Graph> graph, std::string prefix) {
   return num_fusion_group_ops;
 }
 
+static std::vector<bool> UseGPUs() {
+#ifdef PADDLE_WITH_CUDA
+  return {false, true};
+#else
+  return {false};
+#endif
+}
+
 TEST(FusionGroupPass, elementwise_list) {
-  std::unique_ptr<Graph> graph = BuildElementwiseListGraph(true);
-  int num_fusion_group_ops = TestMain(std::move(graph), "elementwise_list");
-  EXPECT_EQ(num_fusion_group_ops, 2);
+  for (bool use_gpu : UseGPUs()) {
+    std::unique_ptr<Graph> graph = BuildElementwiseListGraph(true);
+    int num_fusion_group_ops =
+        TestMain(std::move(graph), "elementwise_list", use_gpu);
+    EXPECT_EQ(num_fusion_group_ops, 2);
+  }
 }
 
 TEST(FusionGroupPass, elementwise_tree) {
-  std::unique_ptr<Graph> graph = BuildElementwiseTreeGraph(true);
-  int num_fusion_group_ops = TestMain(std::move(graph), "elementwise_tree");
-  EXPECT_EQ(num_fusion_group_ops, 4);
+  for (bool use_gpu : UseGPUs()) {
+    std::unique_ptr<Graph> graph = BuildElementwiseTreeGraph(true);
+    int num_fusion_group_ops =
+        TestMain(std::move(graph), "elementwise_tree", use_gpu);
+    EXPECT_EQ(num_fusion_group_ops, 4);
+  }
 }
 
 }  // namespace ir
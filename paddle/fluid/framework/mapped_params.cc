@@ -0,0 +1,295 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/mapped_params.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <utility>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/memory/malloc.h"
+#ifndef _WIN32
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
+#endif
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+constexpr char kMagic[8] = {'P', 'D', 'M', 'P', 'A', 'R', 'A', 'M'};
+constexpr uint32_t kVersion = 0;
+// Enough for the widest SIMD loads and the cache line.
+constexpr uint32_t kAlignment = 64;
+constexpr size_t kHeaderSize = sizeof(kMagic) + 2 * sizeof(uint32_t) +
+                               2 * sizeof(uint64_t);
+
+uint64_t AlignUp(uint64_t offset, uint64_t alignment) {
+  return (offset + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+void WritePOD(std::ostream& os, const T& value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void WritePadding(std::ostream& os, uint64_t size) {
+  static const char kZeros[kAlignment] = {0};
+  while (size > 0) {
+    auto n = std::min<uint64_t>(size, kAlignment);
+    os.write(kZeros, n);
+    size -= n;
+  }
+}
+
+// Reads the fields of the header and the index with bounds checking, the
+// fields are not aligned.
+class BufferReader {
+ public:
+  BufferReader(const char* data, size_t size, size_t pos)
+      : data_(data), size_(size), pos_(pos) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    std::memcpy(&value, Advance(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  const char* Advance(size_t size) {
+    PADDLE_ENFORCE_LE(
+        pos_ + size, size_,
+        platform::errors::InvalidArgument(
+            "The mapped params are truncated, please check whether the "
+            "model file is complete or damaged."));
+    const char* ptr = data_ + pos_;
+    pos_ += size;
+    return ptr;
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t pos_;
+};
+
+// A payload in the mapped params, it keeps the mapping alive while any
+// tensor holds it.
+class MappedParamsSlice : public memory::Allocation {
+ public:
+  MappedParamsSlice(const char* ptr, size_t size,
+                    std::shared_ptr<memory::Allocation> mapping)
+      : Allocation(const_cast<char*>(ptr), size, platform::CPUPlace()),
+        mapping_(std::move(mapping)) {}
+
+ private:
+  std::shared_ptr<memory::Allocation> mapping_;
+};
+
+// Load the tensors from `data`. The CPU tensors share the payloads if
+// `mapping` owns `data`, otherwise the payloads are copied.
+void LoadMappedParams(const char* data, size_t size,
+                      const std::shared_ptr<memory::Allocation>& mapping,
+                      const std::vector<LoDTensor*>& tensors,
+                      const platform::Place& place) {
+  PADDLE_ENFORCE_EQ(IsMappedParams(data, size), true,
+                    platform::errors::InvalidArgument(
+                        "The buffer is not in the mapped params layout."));
+  BufferReader header(data, size, sizeof(kMagic));
+  auto version = header.Read<uint32_t>();
+  PADDLE_ENFORCE_EQ(version, kVersion,
+                    platform::errors::InvalidArgument(
+                        "The mapped params version %u is not supported.",
+                        version));
+  header.Read<uint32_t>();  // alignment
+  auto index_offset = header.Read<uint64_t>();
+  auto num_tensors = header.Read<uint64_t>();
+  PADDLE_ENFORCE_EQ(num_tensors, tensors.size(),
+                    platform::errors::InvalidArgument(
+                        "The mapped params hold %d tensors, but %d tensors "
+                        "are to be loaded. Loading partial data is not "
+                        "allowed.",
+                        num_tensors, tensors.size()));
+
+  BufferReader index(data, size, index_offset);
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    auto* tensor = tensors[i];
+    auto name_size = index.Read<uint32_t>();
+    std::string name(index.Advance(name_size), name_size);
+
+    auto lod_level = index.Read<uint64_t>();
+    LoD lod(lod_level);
+    for (auto& level : lod) {
+      auto level_bytes = index.Read<uint64_t>();
+      level.resize(level_bytes / sizeof(size_t));
+      std::memcpy(level.data(), index.Advance(level_bytes), level_bytes);
+    }
+
+    auto desc_size = index.Read<int32_t>();
+    proto::VarType::TensorDesc desc;
+    PADDLE_ENFORCE_EQ(
+        desc.ParseFromArray(index.Advance(desc_size), desc_size), true,
+        platform::errors::InvalidArgument(
+            "Cannot parse the description of tensor %s.", name));
+    std::vector<int64_t> dims(desc.dims().begin(), desc.dims().end());
+
+    auto payload_offset = index.Read<uint64_t>();
+    auto payload_size = index.Read<uint64_t>();
+    BufferReader payload(data, size, payload_offset);
+    const char* payload_data = payload.Advance(payload_size);
+    PADDLE_ENFORCE_EQ(
+        payload_size, product(make_ddim(dims)) * SizeOfType(desc.data_type()),
+        platform::errors::InvalidArgument(
+            "The payload size of tensor %s does not match its dims.", name));
+
+    tensor->clear();
+    tensor->Resize(make_ddim(dims));
+    tensor->set_lod(lod);
+    if (mapping && platform::is_cpu_place(place)) {
+      tensor->ResetHolderWithType(
+          std::make_shared<MappedParamsSlice>(payload_data, payload_size,
+                                              mapping),
+          desc.data_type());
+    } else {
+      Tensor view;
+      view.Resize(make_ddim(dims));
+      view.ResetHolderWithType(std::make_shared<MappedParamsSlice>(
+                                   payload_data, payload_size, nullptr),
+                               desc.data_type());
+      TensorCopySync(view, place, tensor);
+    }
+    VLOG(4) << "Load mapped param " << name << " to tensor " << i;
+  }
+}
+
+}  // namespace
+
+bool IsMappedParams(const char* data, size_t size) {
+  return size >= kHeaderSize &&
+         std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool IsMappedParamsFile(const std::string& filename) {
+  std::ifstream fin(filename, std::ios::binary);
+  char header[sizeof(kMagic)];
+  fin.read(header, sizeof(header));
+  return static_cast<bool>(fin) &&
+         std::memcmp(header, kMagic, sizeof(kMagic)) == 0;
+}
+
+void SerializeToMappedParams(std::ostream& os,
+                             const std::vector<std::string>& names,
+                             const std::vector<const LoDTensor*>& tensors,
+                             const platform::DeviceContext& dev_ctx) {
+  PADDLE_ENFORCE_EQ(names.size(), tensors.size(),
+                    platform::errors::InvalidArgument(
+                        "The number of names (%d) and tensors (%d) to "
+                        "serialize should be equal.",
+                        names.size(), tensors.size()));
+  // The layout is computed first, so the file is written in one pass.
+  std::vector<uint64_t> payload_offsets(tensors.size());
+  std::vector<uint64_t> payload_sizes(tensors.size());
+  uint64_t offset = AlignUp(kHeaderSize, kAlignment);
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    payload_offsets[i] = offset;
+    payload_sizes[i] = tensors[i]->numel() * SizeOfType(tensors[i]->type());
+    offset = AlignUp(offset + payload_sizes[i], kAlignment);
+  }
+
+  os.write(kMagic, sizeof(kMagic));
+  WritePOD(os, kVersion);
+  WritePOD(os, kAlignment);
+  WritePOD(os, offset);
+  WritePOD(os, static_cast<uint64_t>(tensors.size()));
+
+  uint64_t written = kHeaderSize;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    WritePadding(os, payload_offsets[i] - written);
+    const Tensor* tensor = tensors[i];
+    Tensor cpu_tensor;
+    if (!platform::is_cpu_place(tensor->place())) {
+      TensorCopySync(*tensor, platform::CPUPlace(), &cpu_tensor);
+      tensor = &cpu_tensor;
+    }
+    os.write(reinterpret_cast<const char*>(tensor->data<void>()),
+             static_cast<std::streamsize>(payload_sizes[i]));
+    written = payload_offsets[i] + payload_sizes[i];
+  }
+  WritePadding(os, offset - written);
+
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    auto& name = names[i];
+    WritePOD(os, static_cast<uint32_t>(name.size()));
+    os.write(name.data(), name.size());
+
+    auto& lod = tensors[i]->lod();
+    WritePOD(os, static_cast<uint64_t>(lod.size()));
+    for (auto& level : lod) {
+      uint64_t size = level.size() * sizeof(LoD::value_type::value_type);
+      WritePOD(os, size);
+      os.write(reinterpret_cast<const char*>(level.data()),
+               static_cast<std::streamsize>(size));
+    }
+
+    proto::VarType::TensorDesc desc;
+    desc.set_data_type(tensors[i]->type());
+    auto dims = vectorize(tensors[i]->dims());
+    auto* pb_dims = desc.mutable_dims();
+    pb_dims->Resize(static_cast<int>(dims.size()), 0);
+    std::copy(dims.begin(), dims.end(), pb_dims->begin());
+    auto desc_str = desc.SerializeAsString();
+    WritePOD(os, static_cast<int32_t>(desc_str.size()));
+    os.write(desc_str.data(), desc_str.size());
+
+    WritePOD(os, payload_offsets[i]);
+    WritePOD(os, payload_sizes[i]);
+  }
+}
+
+void LoadMappedParamsFile(const std::string& filename,
+                          const std::vector<LoDTensor*>& tensors,
+                          const platform::Place& place) {
+#ifndef _WIN32
+  std::shared_ptr<memory::Allocation> mapping =
+      memory::allocation::AllocateMemoryMapFileAllocation(filename);
+#else
+  // No mapping on Windows, the file is read into one buffer shared by the
+  // tensors instead.
+  std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                    platform::errors::Unavailable(
+                        "Cannot open mapped params file %s.", filename));
+  size_t file_size = static_cast<size_t>(fin.tellg());
+  fin.seekg(0, std::ios::beg);
+  std::shared_ptr<memory::Allocation> mapping =
+      memory::AllocShared(platform::CPUPlace(), file_size);
+  fin.read(reinterpret_cast<char*>(mapping->ptr()), file_size);
+#endif
+  LoadMappedParams(reinterpret_cast<const char*>(mapping->ptr()),
+                   mapping->size(), mapping, tensors, place);
+}
+
+void LoadMappedParamsBuffer(const char* data, size_t size,
+                            const std::vector<LoDTensor*>& tensors,
+                            const platform::Place& place) {
+  LoadMappedParams(data, size, nullptr, tensors, place);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,77 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * The mapped params layout of a combined params file. Unlike the stream
+ * written by SerializeToStream, the payloads of the tensors are aligned and
+ * the descriptions are gathered in an index at the end of the file, so the
+ * loader maps the file and shares each payload with its tensor directly:
+ *
+ *   header:   char[8]  magic "PDMPARAM"
+ *             uint32_t version
+ *             uint32_t payload alignment in bytes
+ *             uint64_t index offset
+ *             uint64_t number of tensors
+ *   payloads: the data of every tensor, each one starts at an aligned offset
+ *   index:    for every tensor, in the order of the payloads
+ *             uint32_t name size, char* name
+ *             uint64_t lod_level, then for each level
+ *                 uint64_t size in bytes, size_t* data
+ *             int32_t  TensorDesc size, void* TensorDesc protobuf message
+ *             uint64_t payload offset, uint64_t payload size in bytes
+ */
+
+// Whether `data` starts with the header of the mapped params layout.
+bool IsMappedParams(const char* data, size_t size);
+bool IsMappedParamsFile(const std::string& filename);
+
+// Write the tensors in the mapped params layout, `os` should be empty.
+void SerializeToMappedParams(std::ostream& os,
+                             const std::vector<std::string>& names,
+                             const std::vector<const LoDTensor*>& tensors,
+                             const platform::DeviceContext& dev_ctx);
+
+// Load the tensors of a mapped params file in order. On CPU, the tensors
+// hold slices of the file mapping, which is released with the last of them,
+// and the pages are only read when the tensors are used. A write to such a
+// tensor goes to a private copy of the page, never to the file. The file
+// should be replaced, not truncated or overwritten in place while it is
+// mapped, the mapped tensors fault on the pages cut off. save_combine
+// writes a new file and renames it. On the other places, the payloads are
+// copied to the place.
+void LoadMappedParamsFile(const std::string& filename,
+                          const std::vector<LoDTensor*>& tensors,
+                          const platform::Place& place);
+
+// Load the tensors from a buffer in the mapped params layout, the payloads
+// are copied since the buffer is not owned by the tensors.
+void LoadMappedParamsBuffer(const char* data, size_t size,
+                            const std::vector<LoDTensor*>& tensors,
+                            const platform::Place& place);
+
+}  // namespace framework
+}  // namespace paddle
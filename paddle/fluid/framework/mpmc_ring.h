@@ -0,0 +1,289 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#if defined _WIN32 || defined __APPLE__
+#else
+#define _LINUX
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+
+#ifdef _LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#endif
+
+namespace paddle {
+namespace framework {
+
+// The threads blocked on a condition of an MpmcRing. A waiter takes a ticket
+// with Prepare(), checks its condition again, then Wait()s for the ticket to
+// change; a Notify() after changing the condition bumps the ticket. Waiting
+// is a futex on Linux, a condition variable elsewhere. The notifier only
+// makes a system call when someone waits.
+class RingWaiters {
+ public:
+  uint32_t Prepare() {
+    waiters_.fetch_add(1);
+    return ticket_.load();
+  }
+
+  void Cancel() { waiters_.fetch_sub(1); }
+
+  void Wait(uint32_t ticket) {
+#ifdef _LINUX
+    syscall(SYS_futex, reinterpret_cast<int32_t*>(&ticket_),
+            FUTEX_WAIT_PRIVATE, static_cast<int32_t>(ticket), nullptr, nullptr,
+            0);
+#else
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [&] { return ticket_.load() != ticket; });
+#endif
+    waiters_.fetch_sub(1);
+  }
+
+  void Notify() {
+    // Pairs with the fetch_add of Prepare(), either the waiter sees the
+    // changed condition or the notifier sees the waiter.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load() == 0) {
+      return;
+    }
+    ticket_.fetch_add(1);
+#ifdef _LINUX
+    syscall(SYS_futex, reinterpret_cast<int32_t*>(&ticket_),
+            FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    std::lock_guard<std::mutex> lock(mutex_);
+    cond_.notify_all();
+#endif
+  }
+
+ private:
+  std::atomic<uint32_t> ticket_{0};
+  std::atomic<int> waiters_{0};
+#ifndef _LINUX
+  std::mutex mutex_;
+  std::condition_variable cond_;
+#endif
+};
+
+// A bounded lock-free multi-producer multi-consumer ring. Every cell has a
+// sequence number telling whether it waits for the push or the pop of the
+// current lap (D. Vyukov's bounded MPMC queue), so the producers and the
+// consumers only race on their own cursor. The blocking Read()/Write() claim
+// a block of cells with one CAS on the cursor, then fill or drain the cells,
+// and follow the semantics of ChannelObject.
+template <class T>
+class MpmcRing {
+ public:
+  // The ring holds exactly capacity items, so a ring sized for a known
+  // number of items wastes no cells. It has at least 2 cells, the sequence
+  // numbers of a full and an empty cell would be the same with one.
+  explicit MpmcRing(size_t capacity) {
+    size_ = (std::max)(capacity, static_cast<size_t>(2));
+    cells_.reset(new Cell[size_]);
+    for (size_t i = 0; i < size_; ++i) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpmcRing(const MpmcRing&) = delete;
+  MpmcRing& operator=(const MpmcRing&) = delete;
+
+  size_t Capacity() const { return size_; }
+
+  // The claimed cells, some may still be in the middle of a push or a pop.
+  size_t Size() const {
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t tail = tail_.load(std::memory_order_acquire);
+    return tail > head ? tail - head : 0;
+  }
+
+  bool Empty() const { return Size() == 0; }
+
+  bool Closed() const { return closed_.load(std::memory_order_acquire); }
+
+  void Open() { closed_.store(false, std::memory_order_release); }
+
+  void Close() {
+    closed_.store(true, std::memory_order_release);
+    not_empty_.Notify();
+    not_full_.Notify();
+  }
+
+  bool TryPush(T* value) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos % size_];
+      size_t seq = cell.seq.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          cell.value = std::move(*value);
+          cell.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // full
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool TryPop(T* value) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[pos % size_];
+      size_t seq = cell.seq.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (head_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          *value = std::move(cell.value);
+          cell.seq.store(pos + size_, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;  // empty
+      } else {
+        pos = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Move n items in, block while the ring is full. Return the number
+  // written, less than n if the ring is closed.
+  size_t WriteMove(size_t n, T* p) { return WriteBlocks(n, p); }
+
+  size_t Write(size_t n, const T* p) { return WriteBlocks(n, p); }
+
+  // Read n items, block while the ring is empty. Return the number read,
+  // less than n if the ring is closed and drained.
+  size_t Read(size_t n, T* p) {
+    size_t finished = 0;
+    while (finished < n) {
+      bool closed = Closed();
+      size_t pos = head_.load(std::memory_order_relaxed);
+      size_t tail = tail_.load(std::memory_order_acquire);
+      if (tail <= pos) {
+        // The writes which claimed their cells before the close are
+        // visible in tail_ now.
+        if (closed) {
+          break;
+        }
+        not_full_.Notify();
+        uint32_t ticket = not_empty_.Prepare();
+        if (!Empty() || Closed()) {
+          not_empty_.Cancel();
+          continue;
+        }
+        not_empty_.Wait(ticket);
+        continue;
+      }
+      size_t m = (std::min)(n - finished, tail - pos);
+      if (!head_.compare_exchange_weak(pos, pos + m,
+                                       std::memory_order_relaxed)) {
+        continue;
+      }
+      for (size_t i = 0; i < m; ++i) {
+        Cell& cell = WaitCell(pos + i, pos + i + 1);
+        p[finished++] = std::move(cell.value);
+        cell.seq.store(pos + i + size_, std::memory_order_release);
+      }
+      not_full_.Notify();
+    }
+    return finished;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> seq;
+    T value;
+  };
+
+  // The cell at pos once its sequence number is seq. The claimed cells of a
+  // block are only busy for the move of the previous push or pop.
+  Cell& WaitCell(size_t pos, size_t seq) {
+    Cell& cell = cells_[pos % size_];
+    while (cell.seq.load(std::memory_order_acquire) != seq) {
+      std::this_thread::yield();
+    }
+    return cell;
+  }
+
+  // Moves the items of p in, copies them if U is const.
+  template <class U>
+  size_t WriteBlocks(size_t n, U* p) {
+    size_t finished = 0;
+    while (finished < n) {
+      if (Closed()) {
+        break;
+      }
+      size_t pos = tail_.load(std::memory_order_relaxed);
+      size_t head = head_.load(std::memory_order_acquire);
+      size_t used = pos > head ? pos - head : 0;
+      if (used >= Capacity()) {
+        not_empty_.Notify();
+        uint32_t ticket = not_full_.Prepare();
+        if (Size() < Capacity() || Closed()) {
+          not_full_.Cancel();
+          continue;
+        }
+        not_full_.Wait(ticket);
+        continue;
+      }
+      size_t m = (std::min)(n - finished, Capacity() - used);
+      if (!tail_.compare_exchange_weak(pos, pos + m,
+                                       std::memory_order_relaxed)) {
+        continue;
+      }
+      for (size_t i = 0; i < m; ++i) {
+        Cell& cell = WaitCell(pos + i, pos + i);
+        cell.value = std::move(p[finished++]);
+        cell.seq.store(pos + i + 1, std::memory_order_release);
+      }
+      not_empty_.Notify();
+    }
+    return finished;
+  }
+
+  // Keep the cursors on their own cache lines.
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) std::atomic<bool> closed_{false};
+  size_t size_;
+  std::unique_ptr<Cell[]> cells_;
+  RingWaiters not_empty_;
+  RingWaiters not_full_;
+};
+
+}  // namespace framework
+}  // namespace paddle
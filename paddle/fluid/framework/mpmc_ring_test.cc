@@ -0,0 +1,136 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/mpmc_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/channel.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(MpmcRing, TryPushPop) {
+  MpmcRing<int> ring(3);
+  ASSERT_EQ(ring.Capacity(), 3UL);
+  // A few laps, the cursors wrap around the cells.
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 3; ++i) {
+      int value = lap * 3 + i;
+      ASSERT_TRUE(ring.TryPush(&value));
+    }
+    int value = -1;
+    ASSERT_FALSE(ring.TryPush(&value));
+    ASSERT_EQ(ring.Size(), 3UL);
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(ring.TryPop(&value));
+      ASSERT_EQ(value, lap * 3 + i);
+    }
+    ASSERT_FALSE(ring.TryPop(&value));
+    ASSERT_TRUE(ring.Empty());
+  }
+}
+
+TEST(MpmcRing, MinCapacity) {
+  MpmcRing<int> ring(1);
+  ASSERT_EQ(ring.Capacity(), 2UL);
+  for (int lap = 0; lap < 3; ++lap) {
+    int value = 1;
+    ASSERT_TRUE(ring.TryPush(&value));
+    value = 2;
+    ASSERT_TRUE(ring.TryPush(&value));
+    value = 3;
+    ASSERT_FALSE(ring.TryPush(&value));
+    ASSERT_TRUE(ring.TryPop(&value));
+    ASSERT_EQ(value, 1);
+    ASSERT_TRUE(ring.TryPop(&value));
+    ASSERT_EQ(value, 2);
+    ASSERT_FALSE(ring.TryPop(&value));
+  }
+}
+
+TEST(MpmcRing, ReadAfterClose) {
+  MpmcRing<int> ring(8);
+  std::vector<int> in = {1, 2, 3};
+  ASSERT_EQ(ring.Write(in.size(), in.data()), 3UL);
+  ring.Close();
+  ASSERT_EQ(ring.Write(in.size(), in.data()), 0UL);
+  std::vector<int> out(5);
+  ASSERT_EQ(ring.Read(out.size(), out.data()), 3UL);
+  ASSERT_EQ(out[2], 3);
+  ASSERT_EQ(ring.Read(out.size(), out.data()), 0UL);
+}
+
+TEST(MpmcRing, MultiProducerMultiConsumer) {
+  // A small ring, so both sides block on each other.
+  MpmcRing<uint64_t> ring(16);
+  const int kThreads = 4;
+  const uint64_t kItems = 100000;
+  std::vector<std::thread> producers;
+  for (int t = 0; t < kThreads; ++t) {
+    producers.emplace_back([&ring, t]() {
+      std::vector<uint64_t> block(7);
+      for (uint64_t i = 0; i < kItems; i += block.size()) {
+        size_t n = std::min<uint64_t>(block.size(), kItems - i);
+        for (size_t j = 0; j < n; ++j) block[j] = t * kItems + i + j;
+        ASSERT_EQ(ring.WriteMove(n, block.data()), n);
+      }
+    });
+  }
+  std::atomic<uint64_t> sum{0};
+  std::atomic<uint64_t> count{0};
+  std::vector<std::thread> consumers;
+  for (int t = 0; t < kThreads; ++t) {
+    consumers.emplace_back([&]() {
+      std::vector<uint64_t> block(5);
+      size_t n = 0;
+      while ((n = ring.Read(block.size(), block.data())) != 0) {
+        for (size_t j = 0; j < n; ++j) sum += block[j];
+        count += n;
+      }
+    });
+  }
+  for (auto& thread : producers) thread.join();
+  ring.Close();
+  for (auto& thread : consumers) thread.join();
+  uint64_t total = kThreads * kItems;
+  ASSERT_EQ(count.load(), total);
+  ASSERT_EQ(sum.load(), total * (total - 1) / 2);
+}
+
+TEST(ChannelObject, SetLockFree) {
+  auto channel = MakeChannel<int>();
+  channel->Write(std::vector<int>({1, 2, 3}));
+  channel->SetLockFree(4);
+  ASSERT_TRUE(channel->LockFree());
+  ASSERT_EQ(channel->Size(), 3UL);
+  int value = 0;
+  ASSERT_TRUE(channel->Get(value));
+  ASSERT_EQ(value, 1);
+  ASSERT_TRUE(channel->Put(4));
+  channel->Close();
+  channel->SetLockFree(0);
+  ASSERT_FALSE(channel->LockFree());
+  ASSERT_TRUE(channel->Closed());
+  std::vector<int> out;
+  channel->ReadAll(out);
+  ASSERT_EQ(out, std::vector<int>({2, 3, 4}));
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -12,18 +12,27 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <limits>
+#include <set>
 #include <memory>
+#include <numeric>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "paddle/fluid/framework/feed_fetch_method.h"
+#include "paddle/fluid/framework/ir/graph.h"
+#include "paddle/fluid/framework/ir/graph_helper.h"
 #include "paddle/fluid/framework/lod_rank_table.h"
 #include "paddle/fluid/framework/lod_tensor_array.h"
 #include "paddle/fluid/framework/naive_executor.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/reader.h"
 #include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/memory/malloc.h"
 #include "paddle/fluid/string/pretty_log.h"
 
 namespace paddle {
@@ -36,17 +45,757 @@ void NaiveExecutor::Prepare(Scope *scope, const ProgramDesc &program_desc,
     scope_ = scope;
   }
 
+  block_id_ = block_id;
   VLOG(3) << "NaiveExecutor init with scope " << scope;
   CreateOps(program_desc, block_id, with_feed_fetch_ops);
 }
 
 void NaiveExecutor::Run() {
-  for (auto &op : ops_) {
-    VLOG(4) << std::this_thread::get_id() << " run "
-            << op->DebugStringEx(scope_) << " on scope " << scope_;
-    op->SetIsCalledByExecutor(false);
+  if (op_counters_) {
+    num_profiled_runs_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (shape_cache_capacity_ > 0 || memory_plan_enabled_) {
+    UpdateSignature();
+  }
+  if (shape_cache_capacity_ > 0) {
+    auto bucket_iter = shape_buckets_.find(signature_);
+    if (bucket_iter == shape_buckets_.end()) {
+      if (shape_buckets_.size() >= shape_cache_capacity_) {
+        VLOG(3) << "NaiveExecutor shape cache is full, clear it.";
+        shape_buckets_.clear();
+      }
+      bucket_iter =
+          shape_buckets_
+              .emplace(signature_, std::vector<OpShapeRecord>(ops_.size()))
+              .first;
+    }
+    shape_records_ = &bucket_iter->second;
+  }
+  if (memory_plan_enabled_) {
+    if (memory_plans_.count(signature_)) {
+      BindMemoryPlan();
+    } else {
+      BeginMemoryRecord();
+    }
+  }
+
+  if (inter_op_pool_) {
+    RunInterOpParallel();
+    return;
+  }
+
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    RunOp(i);
+    if (recording_memory_) {
+      RecordMemoryAfterOp(i);
+    }
+  }
+
+  if (recording_memory_) {
+    BuildMemoryPlan();
+  }
+}
+
+void NaiveExecutor::RunOp(size_t op_idx) {
+  auto &op = ops_[op_idx];
+  VLOG(4) << std::this_thread::get_id() << " run "
+          << op->DebugStringEx(scope_) << " on scope " << scope_;
+  op->SetIsCalledByExecutor(false);
+  std::chrono::steady_clock::time_point start;
+  if (op_counters_) {
+    auto &holders = op_profile_holders_[op_idx];
+    auto &outputs = op_profile_outputs_[op_idx];
+    for (size_t k = 0; k < outputs.size(); ++k) {
+      holders[k] = outputs[k]->IsType<LoDTensor>()
+                       ? outputs[k]->Get<LoDTensor>().Holder().get()
+                       : nullptr;
+    }
+    start = std::chrono::steady_clock::now();
+  }
+  if (shape_records_ != nullptr && runtime_ctxs_[op_idx]) {
+    RunOpWithShapeCache(op_idx);
+  } else if (frame_) {
+    frame_->RunOp(op_idx, place_);
+  } else {
     op->Run(*scope_, place_);
   }
+  if (op_counters_) {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    RecordOpProfile(
+        op_idx,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+  }
+}
+
+bool NaiveExecutor::EnableExecutionFrame(const ProgramDesc &program) {
+  PADDLE_ENFORCE_NOT_NULL(
+      scope_, platform::errors::PreconditionNotMet(
+                  "NaiveExecutor::Prepare should be called before enabling "
+                  "the execution frame."));
+  auto &block = program.Block(block_id_);
+  if (!ExecutionFrame::IsSupported(block)) {
+    frame_.reset();
+    return false;
+  }
+  frame_.reset(new ExecutionFrame(block, ops_));
+  frame_->Bind(*scope_);
+  VLOG(3) << "NaiveExecutor enables the execution frame, "
+          << frame_->num_bound_ops() << " of " << ops_.size()
+          << " operators are bound to " << frame_->num_slots() << " slots.";
+  return true;
+}
+
+const std::vector<int64_t> &NaiveExecutor::OpProfileBucketBounds() {
+  static const std::vector<int64_t> bounds = [] {
+    std::vector<int64_t> bounds;
+    for (int i = 0; i + 1 < kNumOpProfileBuckets; ++i) {
+      bounds.push_back((int64_t{1} << i) * 1000);
+    }
+    return bounds;
+  }();
+  return bounds;
+}
+
+void NaiveExecutor::EnableOpProfile() {
+  PADDLE_ENFORCE_NOT_NULL(
+      scope_, platform::errors::PreconditionNotMet(
+                  "NaiveExecutor::Prepare should be called before enabling "
+                  "the operator profile."));
+  op_counters_.reset(new OpCounters[ops_.size()]);
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    for (auto &count : op_counters_[i].histogram) {
+      count = 0;
+    }
+  }
+  num_profiled_runs_ = 0;
+  op_profile_outputs_.assign(ops_.size(), {});
+  op_profile_holders_.assign(ops_.size(), {});
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    for (auto &name : ops_[i]->OutputVars(true)) {
+      auto *var = scope_->FindVar(name);
+      if (var != nullptr) op_profile_outputs_[i].push_back(var);
+    }
+    op_profile_holders_[i].resize(op_profile_outputs_[i].size());
+  }
+}
+
+void NaiveExecutor::RecordOpProfile(size_t op_idx, int64_t elapsed_ns) {
+  auto &counters = op_counters_[op_idx];
+  counters.calls.fetch_add(1, std::memory_order_relaxed);
+  counters.total_ns.fetch_add(elapsed_ns, std::memory_order_relaxed);
+  // Only the thread running the operator writes them, a plain store is
+  // enough. A concurrent reset might be lost, which only widens the range.
+  if (elapsed_ns < counters.min_ns.load(std::memory_order_relaxed)) {
+    counters.min_ns.store(elapsed_ns, std::memory_order_relaxed);
+  }
+  if (elapsed_ns > counters.max_ns.load(std::memory_order_relaxed)) {
+    counters.max_ns.store(elapsed_ns, std::memory_order_relaxed);
+  }
+  auto &bounds = OpProfileBucketBounds();
+  size_t bucket =
+      std::upper_bound(bounds.begin(), bounds.end(), elapsed_ns) -
+      bounds.begin();
+  counters.histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+
+  int64_t alloc_bytes = 0;
+  auto &outputs = op_profile_outputs_[op_idx];
+  auto &holders = op_profile_holders_[op_idx];
+  for (size_t k = 0; k < outputs.size(); ++k) {
+    if (!outputs[k]->IsType<LoDTensor>()) continue;
+    auto &holder = outputs[k]->Get<LoDTensor>().Holder();
+    if (holder && holder.get() != holders[k]) {
+      alloc_bytes += holder->size();
+    }
+  }
+  if (alloc_bytes > 0) {
+    counters.alloc_bytes.fetch_add(alloc_bytes, std::memory_order_relaxed);
+  }
+}
+
+std::vector<OpProfileRecord> NaiveExecutor::GetOpProfile(bool reset,
+                                                         int64_t *num_runs) {
+  std::vector<OpProfileRecord> records;
+  if (!op_counters_) {
+    if (num_runs) *num_runs = 0;
+    return records;
+  }
+  auto read = [reset](std::atomic<int64_t> *counter, int64_t initial) {
+    return reset ? counter->exchange(initial, std::memory_order_relaxed)
+                 : counter->load(std::memory_order_relaxed);
+  };
+  if (num_runs) *num_runs = read(&num_profiled_runs_, 0);
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    auto &counters = op_counters_[i];
+    OpProfileRecord record;
+    record.type = ops_[i]->Type();
+    record.calls = read(&counters.calls, 0);
+    record.total_ns = read(&counters.total_ns, 0);
+    record.min_ns =
+        read(&counters.min_ns, std::numeric_limits<int64_t>::max());
+    record.max_ns = read(&counters.max_ns, 0);
+    record.alloc_bytes = read(&counters.alloc_bytes, 0);
+    for (auto &count : counters.histogram) {
+      record.histogram.push_back(read(&count, 0));
+    }
+    if (record.calls == 0) record.min_ns = 0;
+    records.emplace_back(std::move(record));
+  }
+  return records;
+}
+
+void NaiveExecutor::EnableInterOpParallel(
+    const ProgramDesc &program, int num_threads,
+    std::function<void()> thread_init) {
+  PADDLE_ENFORCE_NOT_NULL(
+      scope_, platform::errors::PreconditionNotMet(
+                  "NaiveExecutor::Prepare should be called before enabling "
+                  "the inter-op parallelism."));
+  PADDLE_ENFORCE_GT(num_threads, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of inter-op threads should be greater "
+                        "than 0, but got %d.",
+                        num_threads));
+  PADDLE_ENFORCE_EQ(platform::is_cpu_place(place_), true,
+                    platform::errors::Unimplemented(
+                        "The inter-op parallelism is only supported on CPU."));
+  PADDLE_ENFORCE_EQ(memory_plan_enabled_, false,
+                    platform::errors::PreconditionNotMet(
+                        "The inter-op parallelism cannot be enabled with the "
+                        "memory plan, which assumes the program order."));
+  PADDLE_ENFORCE_EQ(block_id_, 0,
+                    platform::errors::Unimplemented(
+                        "The inter-op parallelism only supports the global "
+                        "block, but the executor runs block %d.",
+                        block_id_));
+
+  // The op nodes are created in the program order.
+  ir::Graph graph(program);
+  std::vector<ir::Node *> op_nodes;
+  for (auto *node : graph.Nodes()) {
+    if (node->IsOp()) op_nodes.push_back(node);
+  }
+  std::sort(op_nodes.begin(), op_nodes.end(),
+            [](ir::Node *a, ir::Node *b) { return a->id() < b->id(); });
+  auto op_descs = program.Block(0).AllOps();
+  PADDLE_ENFORCE_EQ(op_nodes.size(), op_descs.size(),
+                    platform::errors::InvalidArgument(
+                        "The graph of the program has %d operators, but its "
+                        "global block has %d.",
+                        op_nodes.size(), op_descs.size()));
+  std::unordered_map<ir::Node *, size_t> node_ids;
+  for (size_t j = 0; j < op_nodes.size(); ++j) {
+    node_ids.emplace(op_nodes[j], j);
+  }
+
+  // ops_ is the program without the feed and fetch operators.
+  std::vector<int> desc_to_op(op_descs.size(), -1);
+  size_t num_matched = 0;
+  for (size_t j = 0; j < op_descs.size(); ++j) {
+    if (num_matched < ops_.size() &&
+        ops_[num_matched]->Type() == op_descs[j]->Type() &&
+        ops_[num_matched]->Outputs() == op_descs[j]->Outputs()) {
+      desc_to_op[j] = static_cast<int>(num_matched++);
+    }
+  }
+  PADDLE_ENFORCE_EQ(num_matched, ops_.size(),
+                    platform::errors::InvalidArgument(
+                        "The program does not match the operators of the "
+                        "executor."));
+
+  // The dependencies of a dropped operator are passed on to the operators
+  // depending on it.
+  auto adj_list = ir::BuildOperationAdjList(graph);
+  std::vector<std::set<int>> desc_deps(op_descs.size());
+  std::vector<std::set<int>> deps(ops_.size());
+  int barrier = -1;
+  for (size_t j = 0; j < op_descs.size(); ++j) {
+    auto &op_deps = desc_deps[j];
+    for (auto *pred : adj_list.at(op_nodes[j])) {
+      size_t pred_id = node_ids.at(pred);
+      if (desc_to_op[pred_id] >= 0) {
+        op_deps.insert(desc_to_op[pred_id]);
+      } else {
+        op_deps.insert(desc_deps[pred_id].begin(), desc_deps[pred_id].end());
+      }
+    }
+    int op_id = desc_to_op[j];
+    if (op_id < 0) continue;
+    // An operator without kernel might use the variables of its sub-blocks,
+    // so it waits for all the operators before it and blocks all the
+    // operators after it.
+    if (dynamic_cast<OperatorWithKernel *>(ops_[op_id].get()) == nullptr) {
+      for (int k = std::max(barrier, 0); k < op_id; ++k) {
+        op_deps.insert(k);
+      }
+      barrier = op_id;
+    } else if (barrier >= 0) {
+      op_deps.insert(barrier);
+    }
+    deps[op_id] = op_deps;
+  }
+
+  op_num_deps_.assign(ops_.size(), 0);
+  op_successors_.assign(ops_.size(), {});
+  root_ops_.clear();
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    op_num_deps_[i] = static_cast<int>(deps[i].size());
+    for (int dep : deps[i]) {
+      op_successors_[dep].push_back(static_cast<int>(i));
+    }
+    if (deps[i].empty()) root_ops_.push_back(static_cast<int>(i));
+  }
+  op_pending_deps_.reset(new std::atomic<int>[ops_.size()]);
+  inter_op_pool_.reset(new WorkStealingPool(num_threads, thread_init));
+  VLOG(3) << "NaiveExecutor enables inter-op parallelism of " << num_threads
+          << " threads, " << root_ops_.size() << " of " << ops_.size()
+          << " operators are ready at the beginning.";
+}
+
+void NaiveExecutor::RunInterOpParallel() {
+  if (ops_.empty()) return;
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    op_pending_deps_[i] = op_num_deps_[i];
+  }
+  num_unfinished_ops_ = ops_.size();
+  run_failed_ = false;
+  run_exception_ = nullptr;
+  for (int op_idx : root_ops_) {
+    inter_op_pool_->Run([this, op_idx] { RunOpAndSuccessors(op_idx); });
+  }
+
+  std::unique_lock<std::mutex> lock(run_mutex_);
+  run_cv_.wait(lock, [this] { return num_unfinished_ops_ == 0; });
+  if (run_exception_) {
+    std::rethrow_exception(run_exception_);
+  }
+}
+
+void NaiveExecutor::RunOpAndSuccessors(size_t op_idx) {
+  // The first successor made ready runs next on this thread, the others are
+  // submitted to the pool. After a failure, the remaining operators are
+  // only marked as finished.
+  while (true) {
+    if (!run_failed_) {
+      try {
+        RunOp(op_idx);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(run_mutex_);
+        if (!run_exception_) run_exception_ = std::current_exception();
+        run_failed_ = true;
+      }
+    }
+    int next = -1;
+    for (int succ : op_successors_[op_idx]) {
+      if (--op_pending_deps_[succ] > 0) continue;
+      if (next < 0) {
+        next = succ;
+      } else {
+        inter_op_pool_->Run([this, succ] { RunOpAndSuccessors(succ); });
+      }
+    }
+    if (--num_unfinished_ops_ == 0) {
+      std::lock_guard<std::mutex> lock(run_mutex_);
+      run_cv_.notify_all();
+    }
+    if (next < 0) return;
+    op_idx = next;
+  }
+}
+
+// Collect the LoDTensors of the variables in `vars`, returns false if any
+// of them is missing or holds another type.
+static bool CollectLoDTensors(const VariableNameMap &names,
+                              const VariableValueMap &vars,
+                              std::vector<LoDTensor *> *tensors) {
+  for (auto &pair : vars) {
+    auto &var_names = names.at(pair.first);
+    for (size_t i = 0; i < pair.second.size(); ++i) {
+      auto *var = pair.second[i];
+      if (var == nullptr) {
+        if (var_names[i] == kEmptyVarName) continue;
+        return false;
+      }
+      if (!var->IsType<LoDTensor>()) return false;
+      tensors->push_back(var->GetMutable<LoDTensor>());
+    }
+  }
+  return true;
+}
+
+void NaiveExecutor::CollectFeedTensors() {
+  feed_tensors_.clear();
+  std::unordered_set<std::string> seen;
+  for (auto &op : ops_) {
+    for (auto &name : op->InputVars()) {
+      if (seen.count(name)) continue;
+      seen.insert(name);
+      // Parameters live in the ancestor scopes, only the local variables of
+      // the executor are fed.
+      auto *var = scope_->FindLocalVar(name);
+      if (var != nullptr && var->IsType<LoDTensor>()) {
+        feed_tensors_.push_back(&var->Get<LoDTensor>());
+      }
+    }
+    for (auto &name : op->OutputVars(true)) {
+      seen.insert(name);
+    }
+  }
+}
+
+void NaiveExecutor::EnableShapeCache(size_t capacity) {
+  PADDLE_ENFORCE_NOT_NULL(
+      scope_, platform::errors::PreconditionNotMet(
+                  "NaiveExecutor::Prepare should be called before enabling "
+                  "the shape cache."));
+  shape_cache_capacity_ = capacity;
+  shape_buckets_.clear();
+  shape_records_ = nullptr;
+  runtime_ctxs_.clear();
+  runtime_inputs_.assign(ops_.size(), {});
+  op_inputs_.assign(ops_.size(), {});
+  op_outputs_.assign(ops_.size(), {});
+  CollectFeedTensors();
+
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    auto &op = ops_[i];
+    std::unique_ptr<RuntimeContext> ctx;
+    if (auto *kernel_op = dynamic_cast<OperatorWithKernel *>(op.get())) {
+      kernel_op->PrepareRunWithContext();
+      ctx.reset(new RuntimeContext(op->Inputs(), op->Outputs(), *scope_));
+      if (!CollectLoDTensors(op->Inputs(), ctx->inputs, &op_inputs_[i]) ||
+          !CollectLoDTensors(op->Outputs(), ctx->outputs, &op_outputs_[i])) {
+        VLOG(3) << "Operator " << op->Type() << " is not shape cacheable.";
+        ctx.reset();
+      } else {
+        runtime_inputs_[i] = ctx->inputs;
+      }
+    }
+    runtime_ctxs_.emplace_back(std::move(ctx));
+  }
+  VLOG(3) << "NaiveExecutor enables shape cache of " << capacity
+          << " signatures, " << feed_tensors_.size() << " feed tensors.";
+}
+
+void NaiveExecutor::UpdateSignature() {
+  signature_.clear();
+  for (auto *tensor : feed_tensors_) {
+    auto &dims = tensor->dims();
+    signature_.push_back(dims.size());
+    for (int i = 0; i < dims.size(); ++i) {
+      signature_.push_back(dims[i]);
+    }
+    auto &lod = tensor->lod();
+    signature_.push_back(lod.size());
+    for (auto &level : lod) {
+      signature_.push_back(level.size());
+      signature_.insert(signature_.end(), level.begin(), level.end());
+    }
+  }
+}
+
+void NaiveExecutor::RunOpWithShapeCache(size_t op_idx) {
+  // The recorded shapes are only replayed if the inputs of this operator
+  // match exactly, so the ops whose output shapes depend on the data are
+  // still correct.
+  auto &record = (*shape_records_)[op_idx];
+  auto &inputs = op_inputs_[op_idx];
+  auto &outputs = op_outputs_[op_idx];
+  bool hit = record.valid;
+  for (size_t k = 0; hit && k < inputs.size(); ++k) {
+    hit = inputs[k]->dims() == record.input_dims[k] &&
+          inputs[k]->lod() == record.input_lods[k];
+  }
+  if (hit) {
+    for (size_t k = 0; k < outputs.size(); ++k) {
+      outputs[k]->Resize(record.output_dims[k]);
+      outputs[k]->set_lod(record.output_lods[k]);
+    }
+  } else {
+    record.input_dims.clear();
+    record.input_lods.clear();
+    for (auto *tensor : inputs) {
+      record.input_dims.push_back(tensor->dims());
+      record.input_lods.push_back(tensor->lod());
+    }
+  }
+
+  // Point the inputs back to the variables in the scope.
+  auto *ctx = runtime_ctxs_[op_idx].get();
+  auto origin_iter = runtime_inputs_[op_idx].begin();
+  for (auto &item : ctx->inputs) {
+    std::copy(origin_iter->second.begin(), origin_iter->second.end(),
+              item.second.begin());
+    ++origin_iter;
+  }
+  static_cast<OperatorWithKernel *>(ops_[op_idx].get())
+      ->RunWithPreparedContext(*scope_, place_, ctx, hit);
+
+  if (!hit) {
+    record.output_dims.clear();
+    record.output_lods.clear();
+    for (auto *tensor : outputs) {
+      record.output_dims.push_back(tensor->dims());
+      record.output_lods.push_back(tensor->lod());
+    }
+    record.valid = true;
+  }
+}
+
+namespace {
+
+constexpr size_t kMaxMemoryPlans = 16;
+constexpr size_t kArenaAlignment = 64;
+
+// A slice of the arena, it keeps the arena alive while any tensor holds it.
+class ArenaSlot : public memory::Allocation {
+ public:
+  ArenaSlot(const std::shared_ptr<memory::Allocation> &arena, size_t offset,
+            size_t size)
+      : Allocation(reinterpret_cast<uint8_t *>(arena->ptr()) + offset, size,
+                   arena->place()),
+        arena_(arena) {}
+
+ private:
+  std::shared_ptr<memory::Allocation> arena_;
+};
+
+// Assign an offset to every block so that the blocks alive at the same time
+// never overlap, i.e. color the interval graph of the lifetimes with address
+// ranges. The larger blocks are placed first, each one into the smallest gap
+// left by the placed blocks it conflicts with. Returns the arena size.
+size_t AssignOffsets(const std::vector<size_t> &sizes,
+                     const std::vector<size_t> &begins,
+                     const std::vector<size_t> &ends,
+                     std::vector<size_t> *offsets) {
+  std::vector<int> order(sizes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return sizes[a] > sizes[b]; });
+
+  offsets->assign(sizes.size(), 0);
+  size_t arena_size = 0;
+  std::vector<int> placed;
+  std::vector<int> conflicts;
+  for (int id : order) {
+    conflicts.clear();
+    for (int other : placed) {
+      if (begins[other] <= ends[id] && begins[id] <= ends[other]) {
+        conflicts.push_back(other);
+      }
+    }
+    std::sort(conflicts.begin(), conflicts.end(),
+              [&](int a, int b) { return (*offsets)[a] < (*offsets)[b]; });
+
+    size_t best_offset = 0;
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t cursor = 0;
+    for (int other : conflicts) {
+      size_t other_offset = (*offsets)[other];
+      if (other_offset >= cursor + sizes[id] &&
+          other_offset - cursor < best_gap) {
+        best_gap = other_offset - cursor;
+        best_offset = cursor;
+      }
+      cursor = std::max(cursor, other_offset + sizes[other]);
+    }
+    if (best_gap == std::numeric_limits<size_t>::max()) {
+      best_offset = cursor;
+    }
+    (*offsets)[id] = best_offset;
+    arena_size = std::max(arena_size, best_offset + sizes[id]);
+    placed.push_back(id);
+  }
+  return arena_size;
+}
+
+}  // namespace
+
+void NaiveExecutor::EnableMemoryPlan(
+    const std::unordered_set<std::string> &skip_vars) {
+  PADDLE_ENFORCE_NOT_NULL(
+      scope_, platform::errors::PreconditionNotMet(
+                  "NaiveExecutor::Prepare should be called before enabling "
+                  "the memory plan."));
+  PADDLE_ENFORCE_EQ(inter_op_pool_ == nullptr, true,
+                    platform::errors::PreconditionNotMet(
+                        "The memory plan cannot be enabled with the inter-op "
+                        "parallelism, it assumes the program order."));
+  memory_plan_enabled_ = true;
+  memory_plans_.clear();
+  arena_.reset();
+  memory_plan_stats_ = MemoryPlanStats();
+  plan_tensors_.clear();
+  plan_begins_.clear();
+  plan_ends_.clear();
+  plan_skipped_.clear();
+  op_plan_outputs_.assign(ops_.size(), {});
+  CollectFeedTensors();
+
+  std::unordered_map<std::string, int> tensor_ids;
+  for (size_t i = 0; i < ops_.size(); ++i) {
+    auto &op = ops_[i];
+    // The operators without kernel, e.g. the control flow ops, might use
+    // the variables in their sub-blocks, their lifetimes are unknown.
+    bool has_kernel = dynamic_cast<OperatorWithKernel *>(op.get()) != nullptr;
+    auto visit = [&](const std::string &name, bool is_output) -> int {
+      auto *var = scope_->FindLocalVar(name);
+      if (var == nullptr || !var->IsType<LoDTensor>()) return -1;
+      int id;
+      auto iter = tensor_ids.find(name);
+      if (iter == tensor_ids.end()) {
+        id = static_cast<int>(plan_tensors_.size());
+        tensor_ids.emplace(name, id);
+        plan_tensors_.push_back(var->GetMutable<LoDTensor>());
+        plan_begins_.push_back(i);
+        plan_ends_.push_back(i);
+        // Read before written, it is fed by the user.
+        plan_skipped_.push_back(!is_output || skip_vars.count(name));
+      } else {
+        id = iter->second;
+        plan_ends_[id] = i;
+      }
+      if (!has_kernel) plan_skipped_[id] = true;
+      return id;
+    };
+    for (auto &name : op->InputVars()) {
+      visit(name, false);
+    }
+    for (auto &name : op->OutputVars(true)) {
+      int id = visit(name, true);
+      if (id >= 0) op_plan_outputs_[i].push_back(id);
+    }
+  }
+  VLOG(3) << "NaiveExecutor enables memory plan of " << plan_tensors_.size()
+          << " tensors.";
+}
+
+void NaiveExecutor::BindMemoryPlan() {
+  auto &plan = memory_plans_.at(signature_);
+  for (size_t i = 0; i < plan.tensor_ids.size(); ++i) {
+    auto *tensor = plan_tensors_[plan.tensor_ids[i]];
+    tensor->clear();
+    tensor->ResetHolder(plan.slots[plan.tensor_slots[i]]);
+  }
+}
+
+void NaiveExecutor::BeginMemoryRecord() {
+  recording_memory_ = true;
+  holder_owners_.clear();
+  alias_parents_.resize(plan_tensors_.size());
+  std::iota(alias_parents_.begin(), alias_parents_.end(), 0);
+  for (size_t id = 0; id < plan_tensors_.size(); ++id) {
+    auto *tensor = plan_tensors_[id];
+    if (!plan_skipped_[id]) {
+      // Drop the memory of the previous runs, so that the sizes recorded are
+      // the ones this signature needs.
+      tensor->clear();
+    } else if (tensor->IsInitialized()) {
+      holder_owners_.emplace(tensor->Holder().get(), id);
+    }
+  }
+}
+
+int NaiveExecutor::FindAliasRoot(int tensor_id) {
+  while (alias_parents_[tensor_id] != tensor_id) {
+    alias_parents_[tensor_id] = alias_parents_[alias_parents_[tensor_id]];
+    tensor_id = alias_parents_[tensor_id];
+  }
+  return tensor_id;
+}
+
+void NaiveExecutor::RecordMemoryAfterOp(size_t op_idx) {
+  // An output sharing the allocation of another tensor (e.g. the output of
+  // reshape2) is placed together with it. A new allocation reusing a freed
+  // address is unioned as well, which only loses some reuse.
+  for (int id : op_plan_outputs_[op_idx]) {
+    auto *tensor = plan_tensors_[id];
+    if (!tensor->IsInitialized()) continue;
+    auto iter = holder_owners_.emplace(tensor->Holder().get(), id).first;
+    int root = FindAliasRoot(iter->second);
+    int self = FindAliasRoot(id);
+    if (root != self) {
+      alias_parents_[self] = root;
+    }
+  }
+}
+
+void NaiveExecutor::BuildMemoryPlan() {
+  recording_memory_ = false;
+  holder_owners_.clear();
+
+  // Merge every alias group into one block, a group with any skipped tensor
+  // is skipped as a whole.
+  size_t num_tensors = plan_tensors_.size();
+  std::vector<int> group_blocks(num_tensors, -1);
+  std::vector<bool> group_skipped(num_tensors, false);
+  std::vector<size_t> sizes, begins, ends;
+  for (size_t id = 0; id < num_tensors; ++id) {
+    int root = FindAliasRoot(id);
+    if (plan_skipped_[id]) group_skipped[root] = true;
+  }
+  for (size_t id = 0; id < num_tensors; ++id) {
+    int root = FindAliasRoot(id);
+    auto *tensor = plan_tensors_[id];
+    if (group_skipped[root] || !tensor->IsInitialized()) continue;
+    size_t size = tensor->Holder()->size();
+    size = (size + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+    int &block = group_blocks[root];
+    if (block < 0) {
+      block = static_cast<int>(sizes.size());
+      sizes.push_back(size);
+      begins.push_back(plan_begins_[id]);
+      ends.push_back(plan_ends_[id]);
+    } else {
+      sizes[block] = std::max(sizes[block], size);
+      begins[block] = std::min(begins[block], plan_begins_[id]);
+      ends[block] = std::max(ends[block], plan_ends_[id]);
+    }
+  }
+
+  if (memory_plans_.size() >= kMaxMemoryPlans) {
+    VLOG(3) << "NaiveExecutor memory plans are full, clear them.";
+    memory_plans_.clear();
+    arena_.reset();
+  }
+  auto &plan = memory_plans_[signature_];
+  plan.sizes = sizes;
+  plan.arena_size = AssignOffsets(sizes, begins, ends, &plan.offsets);
+  for (size_t id = 0; id < num_tensors; ++id) {
+    int block = group_blocks[FindAliasRoot(id)];
+    if (block >= 0 && plan_tensors_[id]->IsInitialized()) {
+      plan.tensor_ids.push_back(id);
+      plan.tensor_slots.push_back(block);
+    }
+  }
+
+  // The arena only grows, all the plans are re-sliced from the new one. The
+  // tensors still holding the old slices keep the old arena alive until
+  // they are bound again.
+  bool grow = !arena_ || arena_->size() < plan.arena_size;
+  if (grow) {
+    arena_ = memory::AllocShared(place_, std::max<size_t>(plan.arena_size, 1));
+  }
+  size_t peak = 0;
+  for (auto &pair : memory_plans_) {
+    auto &each = pair.second;
+    peak = std::max(peak, each.arena_size);
+    if (!grow && &each != &plan) continue;
+    each.slots.clear();
+    for (size_t k = 0; k < each.sizes.size(); ++k) {
+      each.slots.emplace_back(
+          new ArenaSlot(arena_, each.offsets[k], each.sizes[k]));
+    }
+  }
+
+  memory_plan_stats_.num_plans = memory_plans_.size();
+  memory_plan_stats_.num_tensors = plan.tensor_ids.size();
+  memory_plan_stats_.tensor_bytes =
+      std::accumulate(sizes.begin(), sizes.end(), static_cast<size_t>(0));
+  memory_plan_stats_.arena_bytes = peak;
+  VLOG(3) << "NaiveExecutor memory plan: " << plan.tensor_ids.size()
+          << " tensors in " << sizes.size() << " blocks, "
+          << memory_plan_stats_.tensor_bytes << " bytes are planned into "
+          << plan.arena_size << " bytes.";
 }
 
 void NaiveExecutor::CreateVariables(const ProgramDesc &desc, int block_id,
@@ -116,6 +865,10 @@ void NaiveExecutor::CleanFeedFetchOps() {
     }
   }
   ops_.swap(ops);
+  if (frame_) {
+    frame_.reset(new ExecutionFrame(frame_->block(), ops_));
+    frame_->Bind(*scope_);
+  }
 }
 
 }  // namespace framework
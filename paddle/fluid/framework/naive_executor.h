@@ -14,19 +14,60 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <exception>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
+#include "paddle/fluid/framework/execution_frame.h"
+#include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/work_stealing_pool.h"
 #include "paddle/fluid/platform/device_context.h"
 
 namespace paddle {
 namespace framework {
 
+struct MemoryPlanStats {
+  // Number of input shape signatures planned.
+  size_t num_plans{0};
+  // Number of tensors backed by the arena in the latest plan.
+  size_t num_tensors{0};
+  // Total bytes of these tensors if each one had its own allocation.
+  size_t tensor_bytes{0};
+  // Size of the arena, i.e. the peak memory of the intermediate tensors.
+  size_t arena_bytes{0};
+};
+
+// The statistics of one operator collected by the executor since the last
+// reset.
+struct OpProfileRecord {
+  std::string type;
+  int64_t calls{0};
+  int64_t total_ns{0};
+  int64_t min_ns{0};
+  int64_t max_ns{0};
+  // Bytes of the new allocations of the outputs, the outputs reusing their
+  // memory of the previous runs count nothing.
+  int64_t alloc_bytes{0};
+  // Number of the calls in each latency bucket, see
+  // NaiveExecutor::OpProfileBucketBounds.
+  std::vector<int64_t> histogram;
+};
+
 /*
- * Simple, intuitive and effective. Only single thread is supported, and
- * currently designed for inference.
+ * Simple, intuitive and effective. The operators run in the program order
+ * on the calling thread, or concurrently on CPU if the inter-op parallelism
+ * is enabled. Currently designed for inference.
  */
 class NaiveExecutor {
  public:
@@ -47,6 +88,65 @@ class NaiveExecutor {
   // Run all the operators.
   void Run();
 
+  // Cache the output dims and LoD of every operator for each distinct shape
+  // signature of the inputs. A run with a known signature replays them
+  // instead of calling InferShape, and reuses the RuntimeContext of every
+  // operator. At most `capacity` signatures are kept. Call after Prepare.
+  void EnableShapeCache(size_t capacity);
+
+  // Back the intermediate tensors with slices of one pre-allocated arena.
+  // The first run of each shape signature of the inputs allocates normally
+  // and records the size, lifetime and aliasing of every tensor, then an
+  // offset in the arena is assigned to each of them so that the tensors
+  // alive at the same time never overlap. The later runs with that signature
+  // bind the tensors to their slices before running, and the kernels find
+  // their outputs already allocated. The variables in `skip_vars` (e.g. the
+  // fetch targets read after the run) always own their memory. Call after
+  // Prepare.
+  void EnableMemoryPlan(const std::unordered_set<std::string>& skip_vars);
+
+  const MemoryPlanStats& memory_plan_stats() const {
+    return memory_plan_stats_;
+  }
+
+  // Run the independent operators concurrently on a work-stealing pool of
+  // `num_threads` threads. The dependencies come from the SSA graph built
+  // from `program`, which also orders the reads and writes of a reused
+  // variable. An operator is dispatched once all the operators it depends on
+  // are finished; the operators without kernel, e.g. the control flow ops,
+  // run alone. Every thread of the pool runs `thread_init` once when it
+  // starts. Run still returns after all the operators are finished. Only
+  // supported on CPU and not with the memory plan. Call after Prepare, with
+  // the program passed to it.
+  void EnableInterOpParallel(const ProgramDesc& program, int num_threads,
+                             std::function<void()> thread_init = nullptr);
+
+  // Bind the operators to the variable slots of an ExecutionFrame, so that
+  // running them looks up no variable by name. The variables are resolved in
+  // the scope once, they must all be created before and never erased. The
+  // operators cached by the shape cache keep running with their own contexts.
+  // Call after Prepare, with the program passed to it. Returns false if the
+  // block can not run in a frame.
+  bool EnableExecutionFrame(const ProgramDesc& program);
+  const ExecutionFrame* execution_frame() const { return frame_.get(); }
+
+  // Collect the call count, the latency histogram and the bytes allocated
+  // for the outputs of every operator. The counters are relaxed atomics
+  // updated by the thread running the operator, so the profile can be read
+  // and reset from another thread while running. Call after Prepare.
+  void EnableOpProfile();
+  bool op_profile_enabled() const { return op_counters_ != nullptr; }
+
+  // The exclusive upper bounds of the latency buckets in nanoseconds, they
+  // are powers of 2 microseconds. The last bucket has no upper bound.
+  static const std::vector<int64_t>& OpProfileBucketBounds();
+
+  // The profile of every operator in the program order, and the number of
+  // runs profiled. The counters are set to zero after being read if `reset`
+  // is true, so each call returns the statistics of one window.
+  std::vector<OpProfileRecord> GetOpProfile(bool reset,
+                                            int64_t* num_runs = nullptr);
+
   // Get an tensor to operating directly, without the need for feed_ops.
   LoDTensor* FindTensor(const std::string& name);
 
@@ -58,11 +158,113 @@ class NaiveExecutor {
   void CreateOps(const ProgramDesc& desc, int block_id,
                  bool with_feed_fetch_ops);
 
+  void CollectFeedTensors();
+  void UpdateSignature();
+  void RunOp(size_t op_idx);
+  void RecordOpProfile(size_t op_idx, int64_t elapsed_ns);
+  void RunOpWithShapeCache(size_t op_idx);
+
+  void RunInterOpParallel();
+  void RunOpAndSuccessors(size_t op_idx);
+
+  void BindMemoryPlan();
+  void BeginMemoryRecord();
+  void RecordMemoryAfterOp(size_t op_idx);
+  void BuildMemoryPlan();
+  int FindAliasRoot(int tensor_id);
+
  private:
   const platform::Place place_;
   // Catch the required resource to avoid recreate.
   std::vector<std::unique_ptr<OperatorBase>> ops_;
-  Scope* scope_;
+  Scope* scope_{nullptr};
+  int block_id_{0};
+
+  // The shapes of one operator recorded under one input signature.
+  struct OpShapeRecord {
+    bool valid{false};
+    std::vector<DDim> input_dims;
+    std::vector<LoD> input_lods;
+    std::vector<DDim> output_dims;
+    std::vector<LoD> output_lods;
+  };
+
+  size_t shape_cache_capacity_{0};
+  // Indexed by the operator, a null RuntimeContext means the operator is not
+  // cacheable and always runs through OperatorBase::Run.
+  std::vector<std::unique_ptr<RuntimeContext>> runtime_ctxs_;
+  // The inputs of runtime_ctxs_ when created. PrepareData points the inputs
+  // to the transferred variables, which may be deleted after the operator
+  // runs, so they are restored before every run.
+  std::vector<VariableValueMap> runtime_inputs_;
+  std::vector<std::vector<LoDTensor*>> op_inputs_;
+  std::vector<std::vector<LoDTensor*>> op_outputs_;
+  // The tensors read before written in the block, their dims and LoD make up
+  // the signature.
+  std::vector<const LoDTensor*> feed_tensors_;
+  std::vector<int64_t> signature_;
+  std::map<std::vector<int64_t>, std::vector<OpShapeRecord>> shape_buckets_;
+  std::vector<OpShapeRecord>* shape_records_{nullptr};
+
+  // The arena slices of one input signature, the tensor plan_tensors_[i]
+  // is bound to slots[tensor_slots[i]].
+  struct MemoryPlan {
+    std::vector<size_t> offsets;
+    std::vector<size_t> sizes;
+    std::vector<std::shared_ptr<memory::Allocation>> slots;
+    std::vector<int> tensor_ids;
+    std::vector<int> tensor_slots;
+    size_t arena_size{0};
+  };
+
+  bool memory_plan_enabled_{false};
+  // The local LoDTensors used by the operators, with the index of the first
+  // and the last operator using them. The skipped ones are read before
+  // written, used by an operator without kernel, or in the skip_vars.
+  std::vector<LoDTensor*> plan_tensors_;
+  std::vector<size_t> plan_begins_;
+  std::vector<size_t> plan_ends_;
+  std::vector<bool> plan_skipped_;
+  std::vector<std::vector<int>> op_plan_outputs_;
+  // Recording state, the tensors sharing one allocation are unioned.
+  std::unordered_map<const memory::Allocation*, int> holder_owners_;
+  std::vector<int> alias_parents_;
+  bool recording_memory_{false};
+
+  std::shared_ptr<memory::Allocation> arena_;
+  std::map<std::vector<int64_t>, MemoryPlan> memory_plans_;
+  MemoryPlanStats memory_plan_stats_;
+
+  std::unique_ptr<ExecutionFrame> frame_;
+
+  std::unique_ptr<WorkStealingPool> inter_op_pool_;
+  // The dependency graph of the operators.
+  std::vector<int> op_num_deps_;
+  std::vector<std::vector<int>> op_successors_;
+  std::vector<int> root_ops_;
+  // The state of a parallel run.
+  std::unique_ptr<std::atomic<int>[]> op_pending_deps_;
+  std::atomic<size_t> num_unfinished_ops_{0};
+  std::atomic<bool> run_failed_{false};
+  std::exception_ptr run_exception_;
+  std::mutex run_mutex_;
+  std::condition_variable run_cv_;
+
+  static constexpr int kNumOpProfileBuckets = 22;
+  struct OpCounters {
+    std::atomic<int64_t> calls{0};
+    std::atomic<int64_t> total_ns{0};
+    std::atomic<int64_t> min_ns{std::numeric_limits<int64_t>::max()};
+    std::atomic<int64_t> max_ns{0};
+    std::atomic<int64_t> alloc_bytes{0};
+    std::atomic<int64_t> histogram[kNumOpProfileBuckets];
+  };
+  std::unique_ptr<OpCounters[]> op_counters_;
+  std::atomic<int64_t> num_profiled_runs_{0};
+  // The output variables of every operator and their holders before it
+  // runs, only touched by the thread running the operator.
+  std::vector<std::vector<Variable*>> op_profile_outputs_;
+  std::vector<std::vector<const void*>> op_profile_holders_;
 };
 
 }  // namespace framework
@@ -15,12 +15,52 @@
 #include "paddle/fluid/framework/naive_executor.h"
 #include <gtest/gtest.h>
 #include <algorithm>
+#include <numeric>
+#include <string>
+#include <vector>
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/program_desc.h"
 
 namespace paddle {
 namespace framework {
 
+// Out = 2 * X in float, X of another data type is transformed by PrepareData
+// into a variable of the transfer scope.
+class FloatKernelTestOp : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(InferShapeContext* ctx) const override {
+    ctx->SetOutputDim("Out", ctx->GetInputDim("X"));
+  }
+  OpKernelType GetExpectedKernelType(
+      const ExecutionContext& ctx) const override {
+    return OpKernelType(proto::VarType::FP32, ctx.GetPlace());
+  }
+};
+
+class FloatKernelTestOpMaker : public OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("X", "The input of any float data type.");
+    AddOutput("Out", "2 * X in float.");
+    AddComment("This Op is only for the data transform test.");
+  }
+};
+
+template <typename T>
+class FloatKernelTestKernel : public OpKernel<T> {
+ public:
+  void Compute(const ExecutionContext& ctx) const {
+    auto* x = ctx.Input<Tensor>("X");
+    auto* out = ctx.Output<Tensor>("Out");
+    const T* x_data = x->data<T>();
+    T* out_data = out->mutable_data<T>(ctx.GetPlace());
+    for (int64_t i = 0; i < x->numel(); ++i) out_data[i] = 2 * x_data[i];
+  }
+};
+
 TEST(NaiveExecutor, Basic) {
   ProgramDesc program;
   auto* main_block = program.MutableBlock(0);
@@ -64,7 +104,349 @@ TEST(NaiveExecutor, Basic) {
   }
 }
 
+TEST(NaiveExecutor, ShapeCache) {
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  for (auto name : {"a", "b", "c", "d"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+
+  auto* add0 = main_block->AppendOp();
+  add0->SetType("elementwise_add");
+  add0->SetInput("X", {"a"});
+  add0->SetInput("Y", {"b"});
+  add0->SetOutput("Out", {"c"});
+  auto* add1 = main_block->AppendOp();
+  add1->SetType("elementwise_add");
+  add1->SetInput("X", {"c"});
+  add1->SetInput("Y", {"b"});
+  add1->SetOutput("Out", {"d"});
+
+  auto place = platform::CPUPlace();
+  Scope scope;
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, &scope);
+  exe.Prepare(&scope, program, 0, false);
+  exe.EnableShapeCache(2);
+
+  auto* a_tensor = exe.FindTensor("a");
+  auto* b_tensor = exe.FindTensor("b");
+  auto* d_tensor = exe.FindTensor("d");
+  // Alternate between two batch sizes, the later runs replay the shapes.
+  for (int batch_size : {1, 2, 2, 1, 3, 1}) {
+    a_tensor->Resize({batch_size, 4});
+    b_tensor->Resize({batch_size, 4});
+    auto* a_data = a_tensor->mutable_data<float>(place);
+    auto* b_data = b_tensor->mutable_data<float>(place);
+    for (int i = 0; i < batch_size * 4; ++i) {
+      a_data[i] = i;
+      b_data[i] = 0.1 * i;
+    }
+
+    exe.Run();
+
+    EXPECT_EQ(d_tensor->dims(), make_ddim({batch_size, 4}));
+    auto* d_data = d_tensor->data<float>();
+    for (int i = 0; i < batch_size * 4; ++i) {
+      EXPECT_NEAR(d_data[i], 1.2 * i, 1e-3);
+    }
+  }
+}
+
+TEST(NaiveExecutor, ShapeCacheDataTransform) {
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  for (auto name : {"a", "b"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  auto* op = main_block->AppendOp();
+  op->SetType("float_kernel_test");
+  op->SetInput("X", {"a"});
+  op->SetOutput("Out", {"b"});
+
+  auto place = platform::CPUPlace();
+  Scope scope;
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, &scope);
+  exe.Prepare(&scope, program, 0, false);
+  exe.EnableShapeCache(2);
+
+  // a is double, every run transforms it into a float variable that is
+  // deleted after the operator, the later runs must not read it.
+  auto* a_tensor = exe.FindTensor("a");
+  auto* b_tensor = exe.FindTensor("b");
+  for (int run = 0; run < 4; ++run) {
+    a_tensor->Resize({2, 4});
+    auto* a_data = a_tensor->mutable_data<double>(place);
+    for (int i = 0; i < 8; ++i) a_data[i] = run + i;
+
+    exe.Run();
+
+    ASSERT_EQ(b_tensor->type(), proto::VarType::FP32);
+    EXPECT_EQ(b_tensor->dims(), make_ddim({2, 4}));
+    auto* b_data = b_tensor->data<float>();
+    for (int i = 0; i < 8; ++i) {
+      EXPECT_NEAR(b_data[i], 2.0 * (run + i), 1e-5);
+    }
+  }
+}
+
+TEST(NaiveExecutor, MemoryPlan) {
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  std::vector<std::string> names = {"a", "b", "c", "d", "e", "f"};
+  for (auto& name : names) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  // c = a + b, d = c + b, e = d + b, f = e + b. c and e are never alive at
+  // the same time.
+  for (size_t i = 2; i < names.size(); ++i) {
+    auto* add = main_block->AppendOp();
+    add->SetType("elementwise_add");
+    add->SetInput("X", {i == 2 ? "a" : names[i - 1]});
+    add->SetInput("Y", {"b"});
+    add->SetOutput("Out", {names[i]});
+  }
+
+  auto place = platform::CPUPlace();
+  Scope scope;
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, &scope);
+  exe.Prepare(&scope, program, 0, false);
+  exe.EnableMemoryPlan({"f"});
+
+  auto* a_tensor = exe.FindTensor("a");
+  auto* b_tensor = exe.FindTensor("b");
+  auto* f_tensor = exe.FindTensor("f");
+  for (int batch_size : {1, 1, 4, 1, 4}) {
+    a_tensor->Resize({batch_size, 4});
+    b_tensor->Resize({batch_size, 4});
+    auto* a_data = a_tensor->mutable_data<float>(place);
+    auto* b_data = b_tensor->mutable_data<float>(place);
+    for (int i = 0; i < batch_size * 4; ++i) {
+      a_data[i] = i;
+      b_data[i] = 0.1 * i;
+    }
+
+    exe.Run();
+
+    EXPECT_EQ(f_tensor->dims(), make_ddim({batch_size, 4}));
+    auto* f_data = f_tensor->data<float>();
+    for (int i = 0; i < batch_size * 4; ++i) {
+      EXPECT_NEAR(f_data[i], 1.4 * i, 1e-3);
+    }
+  }
+
+  auto& stats = exe.memory_plan_stats();
+  EXPECT_EQ(stats.num_plans, 2UL);
+  EXPECT_EQ(stats.num_tensors, 3UL);
+  EXPECT_LT(stats.arena_bytes, stats.tensor_bytes);
+}
+
+TEST(NaiveExecutor, InterOpParallel) {
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  for (auto name : {"a", "b", "c", "d", "e", "f"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  // c = a + b and d = a + a are independent, e = c + d joins them. c is
+  // then written again, which should wait for the read of e = c + d.
+  std::vector<std::vector<std::string>> adds = {{"a", "b", "c"},
+                                                {"a", "a", "d"},
+                                                {"c", "d", "e"},
+                                                {"e", "b", "c"},
+                                                {"c", "d", "f"}};
+  for (auto& args : adds) {
+    auto* add = main_block->AppendOp();
+    add->SetType("elementwise_add");
+    add->SetInput("X", {args[0]});
+    add->SetInput("Y", {args[1]});
+    add->SetOutput("Out", {args[2]});
+  }
+
+  auto place = platform::CPUPlace();
+  Scope scope;
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, &scope);
+  exe.Prepare(&scope, program, 0, false);
+  exe.EnableInterOpParallel(program, 2);
+
+  auto* a_tensor = exe.FindTensor("a");
+  auto* b_tensor = exe.FindTensor("b");
+  auto* f_tensor = exe.FindTensor("f");
+  for (int run = 0; run < 20; ++run) {
+    a_tensor->Resize({2, 4});
+    b_tensor->Resize({2, 4});
+    auto* a_data = a_tensor->mutable_data<float>(place);
+    auto* b_data = b_tensor->mutable_data<float>(place);
+    for (int i = 0; i < 8; ++i) {
+      a_data[i] = i;
+      b_data[i] = 0.1 * i;
+    }
+
+    exe.Run();
+
+    auto* f_data = f_tensor->data<float>();
+    for (int i = 0; i < 8; ++i) {
+      EXPECT_NEAR(f_data[i], 5.2 * i, 1e-3);
+    }
+  }
+}
+
+TEST(NaiveExecutor, OpProfile) {
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  for (auto name : {"a", "b", "c", "d"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  for (auto out : {"c", "d"}) {
+    auto* add = main_block->AppendOp();
+    add->SetType("elementwise_add");
+    add->SetInput("X", {"a"});
+    add->SetInput("Y", {"b"});
+    add->SetOutput("Out", {out});
+  }
+
+  auto place = platform::CPUPlace();
+  Scope scope;
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, &scope);
+  exe.Prepare(&scope, program, 0, false);
+  exe.EnableOpProfile();
+
+  auto* a_tensor = exe.FindTensor("a");
+  auto* b_tensor = exe.FindTensor("b");
+  a_tensor->Resize({2, 4});
+  b_tensor->Resize({2, 4});
+  std::fill_n(a_tensor->mutable_data<float>(place), 8, 1.f);
+  std::fill_n(b_tensor->mutable_data<float>(place), 8, 2.f);
+  for (int run = 0; run < 3; ++run) {
+    exe.Run();
+  }
+
+  int64_t num_runs = 0;
+  auto records = exe.GetOpProfile(true, &num_runs);
+  EXPECT_EQ(num_runs, 3);
+  ASSERT_EQ(records.size(), 2UL);
+  for (auto& record : records) {
+    EXPECT_EQ(record.type, "elementwise_add");
+    EXPECT_EQ(record.calls, 3);
+    EXPECT_LE(record.min_ns, record.max_ns);
+    EXPECT_GE(record.total_ns, record.max_ns);
+    // Only the first run allocates the output.
+    EXPECT_EQ(record.alloc_bytes, static_cast<int64_t>(8 * sizeof(float)));
+    ASSERT_EQ(record.histogram.size(),
+              NaiveExecutor::OpProfileBucketBounds().size() + 1);
+    EXPECT_EQ(std::accumulate(record.histogram.begin(),
+                              record.histogram.end(), int64_t{0}),
+              3);
+  }
+
+  // A new window starts after the reset.
+  exe.Run();
+  records = exe.GetOpProfile(false, &num_runs);
+  EXPECT_EQ(num_runs, 1);
+  EXPECT_EQ(records[0].calls, 1);
+  EXPECT_EQ(records[0].alloc_bytes, 0);
+}
+
+TEST(NaiveExecutor, ExecutionFrame) {
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  for (auto name : {"a", "b", "c", "d"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  // c = a + b, d = c + b and e = d + b, e is not a variable of the block but
+  // is in the scope when the frame is bound.
+  std::vector<std::vector<std::string>> adds = {
+      {"a", "b", "c"}, {"c", "b", "d"}, {"d", "b", "e"}};
+  for (auto& args : adds) {
+    auto* add = main_block->AppendOp();
+    add->SetType("elementwise_add");
+    add->SetInput("X", {args[0]});
+    add->SetInput("Y", {args[1]});
+    add->SetOutput("Out", {args[2]});
+  }
+
+  auto place = platform::CPUPlace();
+  Scope scope;
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, &scope);
+  exe.Prepare(&scope, program, 0, false);
+  scope.Var("e")->GetMutable<LoDTensor>();
+  ASSERT_TRUE(exe.EnableExecutionFrame(program));
+  ASSERT_NE(exe.execution_frame(), nullptr);
+  EXPECT_EQ(exe.execution_frame()->num_slots(), 5UL);
+  EXPECT_EQ(exe.execution_frame()->num_bound_ops(), 3UL);
+
+  auto* a_tensor = exe.FindTensor("a");
+  auto* b_tensor = exe.FindTensor("b");
+  auto* e_tensor = exe.FindTensor("e");
+  for (int batch_size : {1, 3, 2}) {
+    a_tensor->Resize({batch_size, 4});
+    b_tensor->Resize({batch_size, 4});
+    auto* a_data = a_tensor->mutable_data<float>(place);
+    auto* b_data = b_tensor->mutable_data<float>(place);
+    for (int i = 0; i < batch_size * 4; ++i) {
+      a_data[i] = i;
+      b_data[i] = 0.1 * i;
+    }
+
+    exe.Run();
+
+    EXPECT_EQ(e_tensor->dims(), make_ddim({batch_size, 4}));
+    auto* e_data = e_tensor->data<float>();
+    for (int i = 0; i < batch_size * 4; ++i) {
+      EXPECT_NEAR(e_data[i], 1.3 * i, 1e-3);
+    }
+  }
+}
+
+TEST(NaiveExecutor, ExecutionFrameUnbound) {
+  ProgramDesc program;
+  auto* main_block = program.MutableBlock(0);
+  for (auto name : {"a", "b"}) {
+    main_block->Var(name)->SetType(proto::VarType::LOD_TENSOR);
+  }
+  auto* add = main_block->AppendOp();
+  add->SetType("elementwise_add");
+  add->SetInput("X", {"a"});
+  add->SetInput("Y", {"b"});
+  add->SetOutput("Out", {"c"});
+
+  auto place = platform::CPUPlace();
+  Scope scope;
+  NaiveExecutor exe(place);
+  exe.CreateVariables(program, 0, false, &scope);
+  exe.Prepare(&scope, program, 0, false);
+  // c is created after the frame is bound, so the operator runs through
+  // OperatorBase::Run.
+  ASSERT_TRUE(exe.EnableExecutionFrame(program));
+  EXPECT_EQ(exe.execution_frame()->num_bound_ops(), 0UL);
+  scope.Var("c")->GetMutable<LoDTensor>();
+
+  auto* a_tensor = exe.FindTensor("a");
+  auto* b_tensor = exe.FindTensor("b");
+  a_tensor->Resize({2, 4});
+  b_tensor->Resize({2, 4});
+  std::fill_n(a_tensor->mutable_data<float>(place), 8, 1.f);
+  std::fill_n(b_tensor->mutable_data<float>(place), 8, 2.f);
+  exe.Run();
+
+  auto* c_tensor = exe.FindTensor("c");
+  ASSERT_NE(c_tensor, nullptr);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_NEAR(c_tensor->data<float>()[i], 3.f, 1e-6);
+  }
+}
+
 }  // namespace framework
 }  // namespace paddle
 
 USE_OP(elementwise_add);
+
+REGISTER_OP_WITHOUT_GRADIENT(float_kernel_test,
+                             paddle::framework::FloatKernelTestOp,
+                             paddle::framework::FloatKernelTestOpMaker);
+REGISTER_OP_CPU_KERNEL(float_kernel_test,
+                       paddle::framework::FloatKernelTestKernel<float>);
@@ -931,9 +931,36 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   }
 }
 
+void OperatorWithKernel::PrepareRunWithContext() const {
+  // The attributes do not change after the operator is created, look it up
+  // once since RunWithPreparedContext runs in a loop without name lookups.
+  if (HasAttr(kAllKernelsMustComputeRuntimeShape)) {
+    all_kernels_must_compute_runtime_shape_ = true;
+  }
+}
+
+void OperatorWithKernel::RunWithPreparedContext(const Scope& scope,
+                                                const platform::Place& place,
+                                                RuntimeContext* runtime_ctx,
+                                                bool output_dims_ready) const {
+  try {
+    if (platform::is_gpu_place(place)) {
+#ifdef PADDLE_WITH_CUDA
+      platform::SetDeviceId(boost::get<platform::CUDAPlace>(place).device);
+#endif
+    }
+    platform::RecordEvent op_type_record_event(Type());
+    RunImpl(scope, place, runtime_ctx, output_dims_ready);
+  } catch (platform::EnforceNotMet& exception) {
+    framework::InsertCallStackInfo(Type(), Attrs(), &exception);
+    throw std::move(exception);
+  }
+}
+
 void OperatorWithKernel::RunImpl(const Scope& scope,
                                  const platform::Place& place,
-                                 RuntimeContext* runtime_ctx) const {
+                                 RuntimeContext* runtime_ctx,
+                                 bool output_dims_ready) const {
   platform::DeviceContextPool& pool = platform::DeviceContextPool::Instance();
   auto* dev_ctx = pool.Get(place);
 
@@ -960,7 +987,7 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
     dev_ctx = pool.Get(kernel_type_->place_);
   }
 
-  if (!all_kernels_must_compute_runtime_shape_) {
+  if (!all_kernels_must_compute_runtime_shape_ && !output_dims_ready) {
     platform::RecordEvent record_event("infer_shape",
                                        platform::EventRole::kInnerOp);
     RuntimeInferShapeContext infer_shape_ctx(*this, *runtime_ctx);
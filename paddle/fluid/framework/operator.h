@@ -489,6 +489,17 @@ class OperatorWithKernel : public OperatorBase {
     return kernel_type_->place_;
   }
 
+  // Run with a RuntimeContext owned by the caller. If `output_dims_ready` is
+  // true the caller has already set the dims and LoD of all the outputs, e.g.
+  // replayed from a previous run with the same input shapes, and InferShape is
+  // skipped. Used by NaiveExecutor's shape cache and ExecutionFrame, which
+  // call PrepareRunWithContext once when they bind the operator, before any
+  // run that may be concurrent.
+  void RunWithPreparedContext(const Scope& scope, const platform::Place& place,
+                              RuntimeContext* runtime_ctx,
+                              bool output_dims_ready) const;
+  void PrepareRunWithContext() const;
+
  private:
   void ParseInputDataType(const ExecutionContext& ctx, const std::string& name,
                           proto::VarType::Type* type) const;
@@ -497,7 +508,8 @@ class OperatorWithKernel : public OperatorBase {
   proto::VarType::Type IndicateDataType(const ExecutionContext& ctx) const;
   void RunImpl(const Scope& scope, const platform::Place& place) const final;
   void RunImpl(const Scope& scope, const platform::Place& place,
-               RuntimeContext* runtime_ctx) const;
+               RuntimeContext* runtime_ctx,
+               bool output_dims_ready = false) const;
 
   /**
    * Transfer data from scope to a transferred scope. If there is no data need
@@ -0,0 +1,110 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/record_arena.h"
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <new>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+// The header at the beginning of a chunk, the chunks are aligned to
+// kChunkSize so an allocation finds its chunk by masking its address.
+struct ChunkHeader {
+  // The live allocations, plus 1 while the chunk is a thread's current one.
+  std::atomic<int64_t> refs;
+};
+
+constexpr size_t kChunkSize = RecordArena::kChunkSize;
+constexpr size_t kAlignment = 8;
+constexpr size_t kHeaderSize =
+    (sizeof(ChunkHeader) + kAlignment - 1) / kAlignment * kAlignment;
+
+std::atomic<int64_t> num_chunks{0};
+
+void Release(ChunkHeader* chunk) {
+  if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    chunk->~ChunkHeader();
+    free(chunk);
+    --num_chunks;
+  }
+}
+
+struct ThreadChunk {
+  ~ThreadChunk() { Retire(); }
+
+  void Retire() {
+    if (chunk != nullptr) {
+      Release(chunk);
+      chunk = nullptr;
+    }
+  }
+
+  void* Allocate(size_t bytes) {
+    if (chunk == nullptr || offset + bytes > kChunkSize) {
+      Retire();
+      void* memory = nullptr;
+      PADDLE_ENFORCE_EQ(
+          posix_memalign(&memory, kChunkSize, kChunkSize), 0,
+          platform::errors::ResourceExhausted(
+              "Failed to allocate a record arena chunk of %d bytes.",
+              kChunkSize));
+      chunk = new (memory) ChunkHeader();
+      chunk->refs.store(1, std::memory_order_relaxed);
+      offset = kHeaderSize;
+      ++num_chunks;
+    }
+    chunk->refs.fetch_add(1, std::memory_order_relaxed);
+    void* p = reinterpret_cast<char*>(chunk) + offset;
+    offset += bytes;
+    return p;
+  }
+
+  ChunkHeader* chunk{nullptr};
+  size_t offset{0};
+};
+
+}  // namespace
+
+void* RecordArena::Allocate(size_t bytes) {
+  if (bytes > kMaxArenaBytes) {
+    void* p = malloc(bytes);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+  }
+  thread_local ThreadChunk current;
+  bytes = (bytes + kAlignment - 1) / kAlignment * kAlignment;
+  return current.Allocate(bytes == 0 ? kAlignment : bytes);
+}
+
+void RecordArena::Free(void* p, size_t bytes) {
+  if (bytes > kMaxArenaBytes) {
+    free(p);
+    return;
+  }
+  auto address = reinterpret_cast<uintptr_t>(p);
+  Release(reinterpret_cast<ChunkHeader*>(address & ~(kChunkSize - 1)));
+}
+
+int64_t RecordArena::NumChunks() { return num_chunks.load(); }
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,98 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// The storage of the feasigns and the strings of the Records. Each thread
+// bump allocates from its own chunk of kChunkSize bytes, so the instances
+// loaded by a reader are laid out one after another and a load does no
+// malloc per instance. A chunk counts its live allocations, and it is freed
+// by the thread releasing the last one after its owner moved to a new chunk.
+// The records can be moved and freed on any thread.
+class RecordArena {
+ public:
+  static constexpr size_t kChunkSize = 1 << 20;
+  // The larger allocations go to malloc, so that a chunk holds many records.
+  static constexpr size_t kMaxArenaBytes = kChunkSize / 16;
+
+  static void* Allocate(size_t bytes);
+  static void Free(void* p, size_t bytes);
+
+  // The number of the chunks allocated and not freed yet.
+  static int64_t NumChunks();
+};
+
+template <typename T>
+class RecordAllocator {
+ public:
+  using value_type = T;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using reference = T&;
+  using const_reference = const T&;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+
+  template <typename U>
+  struct rebind {
+    using other = RecordAllocator<U>;
+  };
+
+  RecordAllocator() = default;
+  template <typename U>
+  RecordAllocator(const RecordAllocator<U>&) {}  // NOLINT
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(RecordArena::Allocate(n * sizeof(T)));
+  }
+  void deallocate(T* p, size_t n) { RecordArena::Free(p, n * sizeof(T)); }
+};
+
+template <typename T, typename U>
+bool operator==(const RecordAllocator<T>&, const RecordAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const RecordAllocator<T>&, const RecordAllocator<U>&) {
+  return false;
+}
+
+template <typename T>
+using RecordVector = std::vector<T, RecordAllocator<T>>;
+
+using RecordString =
+    std::basic_string<char, std::char_traits<char>, RecordAllocator<char>>;
+
+// Copy the elements of c into the chunk of the calling thread and free its
+// old storage. A record outliving most of the others of its chunk, e.g. one
+// kept by a merge, keeps the whole chunk alive, together with the buffers
+// outgrown while building the record. Moving the survivors lets those
+// chunks be freed.
+template <typename Container>
+void MoveToThreadChunk(Container* c) {
+  Container copy(c->begin(), c->end());
+  c->swap(copy);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,107 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/record_arena.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/archive.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(RecordArena, Contiguous) {
+  RecordVector<int64_t> a(3, 1);
+  RecordVector<int64_t> b(5, 2);
+  // The second instance follows the first in the chunk of the thread.
+  ASSERT_EQ(b.data(), a.data() + 3);
+  RecordString s(100, 'x');
+  ASSERT_EQ(s, RecordString(100, 'x'));
+  // The allocations too large for a chunk go to malloc.
+  RecordVector<char> large(RecordArena::kMaxArenaBytes + 1);
+  large.back() = 1;
+}
+
+TEST(RecordArena, FreeOnOtherThreads) {
+  int64_t num_chunks = RecordArena::NumChunks();
+  std::vector<RecordVector<int64_t>> records;
+  // Fill several chunks on a loading thread, and free them on this one
+  // after the loading thread exits.
+  std::thread loader([&records] {
+    for (int i = 0; i < 100000; ++i) {
+      records.emplace_back(i % 7 + 1, i);
+    }
+  });
+  loader.join();
+  ASSERT_GT(RecordArena::NumChunks(), num_chunks + 1);
+  for (int i = 0; i < 100000; ++i) {
+    ASSERT_EQ(records[i].size(), static_cast<size_t>(i % 7 + 1));
+    ASSERT_EQ(records[i].back(), i);
+  }
+  std::vector<RecordVector<int64_t>>().swap(records);
+  ASSERT_EQ(RecordArena::NumChunks(), num_chunks);
+}
+
+TEST(RecordArena, RetainedAfterShuffle) {
+  int64_t num_chunks = RecordArena::NumChunks();
+  std::vector<RecordVector<int64_t>> records;
+  std::thread loader([&records] {
+    for (int i = 0; i < 200000; ++i) {
+      records.emplace_back(4, i);
+    }
+  });
+  loader.join();
+  int64_t loaded_chunks = RecordArena::NumChunks() - num_chunks;
+  ASSERT_GT(loaded_chunks, 4);
+
+  // Keep a quarter of the records in a random order, as a trainer does
+  // after sending the others away in a global shuffle. Every chunk still
+  // holds some of them.
+  std::mt19937 rng(0);
+  std::shuffle(records.begin(), records.end(), rng);
+  records.resize(records.size() / 4);
+  ASSERT_EQ(RecordArena::NumChunks() - num_chunks, loaded_chunks);
+
+  // Moved into new chunks, the survivors take a quarter of the memory.
+  for (auto& record : records) {
+    int64_t value = record[0];
+    MoveToThreadChunk(&record);
+    ASSERT_EQ(record.size(), 4UL);
+    ASSERT_EQ(record[3], value);
+  }
+  ASSERT_LE(RecordArena::NumChunks() - num_chunks, loaded_chunks / 4 + 2);
+  std::vector<RecordVector<int64_t>>().swap(records);
+  ASSERT_LE(RecordArena::NumChunks() - num_chunks, 1);
+}
+
+TEST(RecordArena, Archive) {
+  RecordVector<int> values = {1, 2, 3};
+  RecordString ins_id("ins_0000000000000000000000000001");
+  BinaryArchive ar;
+  ar << values << ins_id;
+  RecordVector<int> read_values;
+  RecordString read_ins_id;
+  ar >> read_values >> read_ins_id;
+  ASSERT_EQ(read_values, values);
+  ASSERT_EQ(read_ins_id, ins_id);
+}
+
+}  // namespace framework
+}  // namespace paddle
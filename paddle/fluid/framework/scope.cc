@@ -110,6 +110,31 @@ bool Scope::HasKid(const Scope* scope) const {
   return it != this->kids_.end();
 }
 
+std::unique_ptr<Scope> Scope::DetachKid(Scope* scope) const {
+  SCOPE_KIDS_WRITER_LOCK
+  auto it = std::find(this->kids_.begin(), this->kids_.end(), scope);
+  if (it == this->kids_.end()) return nullptr;
+  this->kids_.erase(it);
+  scope->parent_ = nullptr;
+  return std::unique_ptr<Scope>(scope);
+}
+
+Scope& Scope::AttachKid(std::unique_ptr<Scope>&& scope) const {
+  PADDLE_ENFORCE_NOT_NULL(scope, platform::errors::InvalidArgument(
+                                     "The scope to attach is nullptr."));
+  PADDLE_ENFORCE_EQ(scope->parent_, nullptr,
+                    platform::errors::PreconditionNotMet(
+                        "The scope %p to attach is a kid of scope %p.",
+                        scope.get(), scope->parent_));
+  Scope* child = scope.release();
+  child->parent_ = this;
+  {
+    SCOPE_KIDS_WRITER_LOCK
+    kids_.push_back(child);
+  }
+  return *child;
+}
+
 std::vector<std::string> Scope::LocalVarNames() const {
   std::vector<std::string> known_vars;
   {
@@ -122,6 +147,11 @@ std::vector<std::string> Scope::LocalVarNames() const {
   return known_vars;
 }
 
+size_t Scope::LocalVarSize() const {
+  SCOPE_VARS_READER_LOCK
+  return vars_.size();
+}
+
 void Scope::DeleteScope(Scope* scope) const {
   SCOPE_KIDS_WRITER_LOCK
   auto it = std::find(this->kids_.begin(), this->kids_.end(), scope);
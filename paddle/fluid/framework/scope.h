@@ -96,11 +96,22 @@ class Scope {
   /// Find if a scope exists in the kid scopes
   bool HasKid(const Scope* scope) const;
 
+  /// Remove a kid scope from the kids without deleting it, the caller owns
+  /// it then. Returns nullptr if the scope is not a kid of this scope.
+  std::unique_ptr<Scope> DetachKid(Scope* scope) const;
+
+  /// Make a detached scope a kid of this scope, as if it were created by
+  /// NewScope().
+  Scope& AttachKid(std::unique_ptr<Scope>&& scope) const;
+
   const std::list<Scope*>& kids() const { return kids_; }
 
   // enumerate all the variables current contains.
   std::vector<std::string> LocalVarNames() const;
 
+  // the number of the variables current contains.
+  size_t LocalVarSize() const;
+
   // Rename variable to a new name
   void Rename(const std::string& origin_name,
               const std::string& new_name) const;
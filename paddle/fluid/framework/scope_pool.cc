@@ -11,10 +11,21 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
+#include <atomic>
 #include <memory>
+#include <utility>
 
+#include "gflags/gflags.h"
+#include "paddle/fluid/framework/lod_tensor_array.h"
+#include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/scope_pool.h"
 #include "paddle/fluid/framework/threadpool.h"
+#include "paddle/fluid/framework/variable_helper.h"
+
+DEFINE_int32(step_scope_pool_size, 32,
+             "The max number of the step scopes of while_op and recurrent_op "
+             "kept for reuse for each block. 0 to delete the step scopes "
+             "after use.");
 
 namespace paddle {
 namespace framework {
@@ -55,5 +66,191 @@ void ScopePool::Clear() {
   scopes_.clear();
 }
 
+// Drop the contents of a variable, but keep the holder of the declared type
+// if it is cheap to reset, so that InitializeVariable does not allocate it
+// again.
+static void ResetVariable(Variable *var, proto::VarType::Type type) {
+  if (type == proto::VarType::LOD_TENSOR && var->IsType<LoDTensor>()) {
+    *var->GetMutable<LoDTensor>() = LoDTensor();
+  } else if (type == proto::VarType::LOD_TENSOR_ARRAY &&
+             var->IsType<LoDTensorArray>()) {
+    var->GetMutable<LoDTensorArray>()->clear();
+  } else {
+    var->Clear();
+  }
+}
+
+StepScopePool &StepScopePool::Instance() {  // NOLINT
+  static StepScopePool pool;
+  return pool;
+}
+
+// The pool to drop the scopes of the destroyed blocks from, nullptr once the
+// pool is destroyed at exit.
+static std::atomic<StepScopePool *> g_step_scope_pool{nullptr};
+
+static void EraseDestroyedBlock(const BlockDesc *block) {
+  auto *pool = g_step_scope_pool.load();
+  if (pool != nullptr) {
+    pool->Erase(block);
+  }
+}
+
+StepScopePool::StepScopePool() {
+  g_step_scope_pool = this;
+  BlockDesc::AddDestroyHook(&EraseDestroyedBlock);
+}
+
+bool StepScopePool::Match(const BlockVars &block_vars, const BlockDesc &block) {
+  size_t num_locals = 0;
+  size_t num_persistables = 0;
+  for (auto *var : block.AllVars()) {
+    if (var->Name() == kEmptyVarName) continue;
+    bool persistable = var->Persistable();
+    auto &infos = persistable ? block_vars.persistables : block_vars.locals;
+    size_t &idx = persistable ? num_persistables : num_locals;
+    if (idx >= infos.size() || infos[idx].name != var->Name() ||
+        infos[idx].type != var->GetType()) {
+      return false;
+    }
+    ++idx;
+  }
+  return num_locals == block_vars.locals.size() &&
+         num_persistables == block_vars.persistables.size();
+}
+
+std::shared_ptr<const StepScopePool::BlockVars> StepScopePool::GetBlockVars(
+    const BlockDesc &block, BlockPool *pool) {
+  if (pool->block_vars != nullptr && Match(*pool->block_vars, block)) {
+    return pool->block_vars;
+  }
+  auto block_vars = std::make_shared<BlockVars>();
+  for (auto *var : block.AllVars()) {
+    if (var->Name() == kEmptyVarName) continue;
+    auto &infos =
+        var->Persistable() ? block_vars->persistables : block_vars->locals;
+    infos.push_back(VarInfo{var->Name(), var->GetType()});
+  }
+  VLOG(3) << "Pool step scopes of block " << block.ID() << " with "
+          << block_vars->locals.size() << " local variables";
+  pool->block_vars = block_vars;
+  pool->scopes.clear();
+  return pool->block_vars;
+}
+
+Scope &StepScopePool::Acquire(const Scope &parent, const BlockDesc &block,
+                              std::vector<Variable *> *vars) {
+  std::shared_ptr<const BlockVars> block_vars;
+  PooledScope pooled;
+  {
+    std::lock_guard<std::mutex> guard(mtx_);
+    auto &pool = pools_[&block];
+    block_vars = GetBlockVars(block, &pool);
+    if (!pool.scopes.empty()) {
+      pooled = std::move(pool.scopes.back());
+      pool.scopes.pop_back();
+    }
+  }
+
+  auto &locals = block_vars->locals;
+  if (pooled.scope == nullptr) {
+    pooled.scope.reset(new Scope());
+    pooled.vars.reserve(locals.size());
+    for (auto &info : locals) {
+      pooled.vars.push_back(pooled.scope->Var(info.name));
+    }
+  }
+  for (size_t i = 0; i < locals.size(); ++i) {
+    InitializeVariable(pooled.vars[i], locals[i].type);
+  }
+
+  auto &scope = parent.AttachKid(std::move(pooled.scope));
+  if (!block_vars->persistables.empty()) {
+    const Scope *root = &scope;
+    while (root->parent()) root = root->parent();
+    for (auto &info : block_vars->persistables) {
+      InitializeVariable(const_cast<Scope *>(root)->Var(info.name), info.type);
+    }
+  }
+  if (vars != nullptr) *vars = std::move(pooled.vars);
+  return scope;
+}
+
+void StepScopePool::Release(const Scope &parent, const BlockDesc *block,
+                            Scope *scope) {
+  auto kid = parent.DetachKid(scope);
+  if (kid == nullptr || block == nullptr || FLAGS_step_scope_pool_size <= 0) {
+    return;
+  }
+  size_t capacity = static_cast<size_t>(FLAGS_step_scope_pool_size);
+
+  std::shared_ptr<const BlockVars> block_vars;
+  {
+    std::lock_guard<std::mutex> guard(mtx_);
+    auto &pool = pools_[block];
+    if (pool.scopes.size() < capacity) {
+      block_vars = GetBlockVars(*block, &pool);
+    }
+  }
+  if (block_vars == nullptr) return;
+
+  // Rebind the variables by name, since the ops may have renamed or erased
+  // some, and erase the ones created out of the block.
+  kid->DropKids();
+  PooledScope pooled;
+  pooled.vars.reserve(block_vars->locals.size());
+  for (auto &info : block_vars->locals) {
+    auto *var = kid->Var(info.name);
+    ResetVariable(var, info.type);
+    pooled.vars.push_back(var);
+  }
+  if (kid->LocalVarSize() != pooled.vars.size()) {
+    kid->EraseVarsExcept(
+        std::unordered_set<Variable *>(pooled.vars.begin(), pooled.vars.end()));
+  }
+  pooled.scope = std::move(kid);
+
+  std::lock_guard<std::mutex> guard(mtx_);
+  auto &pool = pools_[block];
+  // The block may be changed or the pool filled up by another thread.
+  if (pool.block_vars == block_vars && pool.scopes.size() < capacity) {
+    pool.scopes.push_back(std::move(pooled));
+  }
+}
+
+size_t StepScopePool::Size(const BlockDesc &block) {
+  std::lock_guard<std::mutex> guard(mtx_);
+  auto it = pools_.find(&block);
+  return it == pools_.end() ? 0 : it->second.scopes.size();
+}
+
+size_t StepScopePool::NumBlocks() {
+  std::lock_guard<std::mutex> guard(mtx_);
+  return pools_.size();
+}
+
+void StepScopePool::Erase(const BlockDesc *block) {
+  // Delete the scopes out of the lock.
+  BlockPool pool;
+  {
+    std::lock_guard<std::mutex> guard(mtx_);
+    auto it = pools_.find(block);
+    if (it == pools_.end()) return;
+    pool = std::move(it->second);
+    pools_.erase(it);
+  }
+  VLOG(3) << "Drop " << pool.scopes.size() << " pooled step scopes";
+}
+
+StepScopePool::~StepScopePool() {
+  g_step_scope_pool = nullptr;
+  Clear();
+}
+
+void StepScopePool::Clear() {
+  std::lock_guard<std::mutex> guard(mtx_);
+  pools_.clear();
+}
+
 }  // namespace framework
 }  // namespace paddle
@@ -14,8 +14,13 @@
 
 #pragma once
 
+#include <memory>
 #include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
+#include "paddle/fluid/framework/block_desc.h"
 #include "paddle/fluid/framework/scope.h"
 
 namespace paddle {
@@ -42,5 +47,85 @@ class ScopePool {
   std::mutex mtx_;
 };
 
+// StepScopePool recycles the step scopes of while_op and recurrent_op.
+//
+// A control flow op creates a kid scope and the variables of its block in
+// each step, and deletes them after the step or after the backward. With
+// StepScopePool, a released step scope is detached from its parent and kept
+// with its variables, whose contents are dropped. The next step of the same
+// block, of the same or a later run, takes it back instead of allocating the
+// scope, the variables and the hash nodes again. The variables of the block
+// are bound to the scope in the order of the block, so reinitializing them
+// hashes no names.
+//
+// The pooled scopes are keyed by the BlockDesc, and dropped when the
+// BlockDesc is destroyed with its program. The variables of the block are
+// checked each time, so a block that is changed never gets a scope of stale
+// variables. At most FLAGS_step_scope_pool_size scopes are kept for a block.
+class StepScopePool {
+ public:
+  static StepScopePool &Instance();  // NOLINT
+
+  // Get a kid scope of parent with the variables of block created, the same
+  // as parent.NewScope() followed by Executor::CreateVariables. If vars is
+  // not nullptr, it is set to the local variables of the scope.
+  Scope &Acquire(const Scope &parent, const BlockDesc &block,
+                 std::vector<Variable *> *vars = nullptr);
+
+  // Take back a kid scope of parent that was acquired for block, in place of
+  // parent.DeleteScope(scope). It is ignored if scope is not a kid of parent,
+  // e.g. it has been dropped with its parent. If block is nullptr, or the
+  // pool of block is full, the scope is deleted.
+  void Release(const Scope &parent, const BlockDesc *block, Scope *scope);
+
+  // The number of the scopes kept for block.
+  size_t Size(const BlockDesc &block);
+
+  // The number of the blocks with a pool.
+  size_t NumBlocks();
+
+  // Drop the scopes kept for block.
+  void Erase(const BlockDesc *block);
+
+  void Clear();
+
+  ~StepScopePool();
+
+ private:
+  StepScopePool();
+
+  struct VarInfo {
+    std::string name;
+    proto::VarType::Type type;
+  };
+
+  // The variables of a block, the local ones in the order to bind.
+  struct BlockVars {
+    std::vector<VarInfo> locals;
+    std::vector<VarInfo> persistables;
+  };
+
+  struct PooledScope {
+    std::unique_ptr<Scope> scope;
+    // Bound to BlockVars::locals.
+    std::vector<Variable *> vars;
+  };
+
+  struct BlockPool {
+    std::shared_ptr<const BlockVars> block_vars;
+    std::vector<PooledScope> scopes;
+  };
+
+  static bool Match(const BlockVars &block_vars, const BlockDesc &block);
+
+  // Get the variables of block, and drop the scopes pooled for its former
+  // variables if they are changed. Called with mtx_ held.
+  std::shared_ptr<const BlockVars> GetBlockVars(const BlockDesc &block,
+                                                BlockPool *pool);
+
+  std::unordered_map<const BlockDesc *, BlockPool> pools_;
+  std::mutex mtx_;
+};
+
 }  // namespace framework
 }  // namespace paddle
@@ -0,0 +1,180 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/scope_pool.h"
+
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/lod_tensor_array.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+DECLARE_int32(step_scope_pool_size);
+
+namespace paddle {
+namespace framework {
+
+static void AddVar(BlockDesc* block, const std::string& name,
+                   proto::VarType::Type type, bool persistable = false) {
+  auto* var = block->Var(name);
+  var->SetType(type);
+  var->SetPersistable(persistable);
+}
+
+static void PrepareBlock(BlockDesc* block) {
+  AddVar(block, "x", proto::VarType::LOD_TENSOR);
+  AddVar(block, "array", proto::VarType::LOD_TENSOR_ARRAY);
+  AddVar(block, "w", proto::VarType::LOD_TENSOR, true);
+}
+
+TEST(StepScopePool, Acquire) {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  PrepareBlock(block);
+  auto& pool = StepScopePool::Instance();
+
+  Scope root;
+  std::vector<Variable*> vars;
+  auto& scope = pool.Acquire(root, *block, &vars);
+  EXPECT_TRUE(root.HasKid(&scope));
+  EXPECT_EQ(&root, scope.parent());
+  EXPECT_EQ(2UL, scope.LocalVarSize());
+  EXPECT_EQ(2UL, vars.size());
+  EXPECT_TRUE(scope.FindLocalVar("x")->IsType<LoDTensor>());
+  EXPECT_TRUE(scope.FindLocalVar("array")->IsType<LoDTensorArray>());
+  EXPECT_EQ(nullptr, scope.FindLocalVar("w"));
+  ASSERT_NE(nullptr, root.FindLocalVar("w"));
+  EXPECT_TRUE(root.FindLocalVar("w")->IsType<LoDTensor>());
+  for (auto* var : vars) {
+    EXPECT_TRUE(var == scope.FindLocalVar("x") ||
+                var == scope.FindLocalVar("array"));
+  }
+  pool.Release(root, block, &scope);
+  pool.Clear();
+}
+
+TEST(StepScopePool, Reuse) {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  PrepareBlock(block);
+  auto& pool = StepScopePool::Instance();
+
+  Scope root1;
+  auto& scope1 = pool.Acquire(root1, *block);
+  auto* x = scope1.FindLocalVar("x");
+  x->GetMutable<LoDTensor>()->mutable_data<float>(make_ddim({2, 3}),
+                                                  platform::CPUPlace());
+  LoD lod{{0, 1, 2}};
+  x->GetMutable<LoDTensor>()->set_lod(lod);
+  auto* array = scope1.FindLocalVar("array");
+  array->GetMutable<LoDTensorArray>()->resize(4);
+  scope1.Var("tmp");
+  scope1.NewScope();
+
+  pool.Release(root1, block, &scope1);
+  EXPECT_FALSE(root1.HasKid(&scope1));
+  EXPECT_EQ(1UL, pool.Size(*block));
+
+  // The scope and the variables are reused, with the contents dropped.
+  Scope root2;
+  auto& scope2 = pool.Acquire(root2, *block);
+  EXPECT_EQ(&scope1, &scope2);
+  EXPECT_EQ(0UL, pool.Size(*block));
+  EXPECT_EQ(&root2, scope2.parent());
+  EXPECT_TRUE(root2.HasKid(&scope2));
+  EXPECT_EQ(x, scope2.FindLocalVar("x"));
+  EXPECT_FALSE(x->Get<LoDTensor>().IsInitialized());
+  EXPECT_TRUE(x->Get<LoDTensor>().lod().empty());
+  EXPECT_EQ(array, scope2.FindLocalVar("array"));
+  EXPECT_TRUE(array->Get<LoDTensorArray>().empty());
+  EXPECT_EQ(nullptr, scope2.FindLocalVar("tmp"));
+  EXPECT_EQ(2UL, scope2.LocalVarSize());
+  EXPECT_TRUE(scope2.kids().empty());
+
+  // A scope that is not a kid of the parent is ignored.
+  pool.Release(root1, block, &scope2);
+  EXPECT_TRUE(root2.HasKid(&scope2));
+  EXPECT_EQ(0UL, pool.Size(*block));
+
+  pool.Release(root2, block, &scope2);
+  EXPECT_EQ(1UL, pool.Size(*block));
+  pool.Clear();
+}
+
+TEST(StepScopePool, ChangedBlock) {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  PrepareBlock(block);
+  auto& pool = StepScopePool::Instance();
+
+  Scope root;
+  pool.Release(root, block, &pool.Acquire(root, *block));
+  EXPECT_EQ(1UL, pool.Size(*block));
+
+  AddVar(block, "y", proto::VarType::SELECTED_ROWS);
+  auto& scope = pool.Acquire(root, *block);
+  EXPECT_EQ(0UL, pool.Size(*block));
+  EXPECT_EQ(3UL, scope.LocalVarSize());
+  EXPECT_TRUE(scope.FindLocalVar("y")->IsType<SelectedRows>());
+  pool.Release(root, block, &scope);
+  EXPECT_EQ(1UL, pool.Size(*block));
+  pool.Clear();
+}
+
+TEST(StepScopePool, Capacity) {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  PrepareBlock(block);
+  auto& pool = StepScopePool::Instance();
+
+  Scope root;
+  int pool_size = FLAGS_step_scope_pool_size;
+  FLAGS_step_scope_pool_size = 1;
+  auto& scope1 = pool.Acquire(root, *block);
+  auto& scope2 = pool.Acquire(root, *block);
+  pool.Release(root, block, &scope1);
+  pool.Release(root, block, &scope2);
+  EXPECT_FALSE(root.HasKid(&scope2));
+  EXPECT_EQ(1UL, pool.Size(*block));
+
+  FLAGS_step_scope_pool_size = 0;
+  pool.Release(root, block, &pool.Acquire(root, *block));
+  EXPECT_EQ(0UL, pool.Size(*block));
+
+  // No pool without the block.
+  FLAGS_step_scope_pool_size = pool_size;
+  pool.Release(root, nullptr, &pool.Acquire(root, *block));
+  EXPECT_EQ(0UL, pool.Size(*block));
+  EXPECT_TRUE(root.kids().empty());
+  pool.Clear();
+}
+
+TEST(StepScopePool, DestroyedBlock) {
+  auto& pool = StepScopePool::Instance();
+  Scope root;
+  {
+    ProgramDesc program;
+    auto* block = program.MutableBlock(0);
+    PrepareBlock(block);
+    pool.Release(root, block, &pool.Acquire(root, *block));
+    EXPECT_EQ(1UL, pool.Size(*block));
+    EXPECT_EQ(1UL, pool.NumBlocks());
+  }
+  // The scopes are dropped with the program.
+  EXPECT_EQ(0UL, pool.NumBlocks());
+}
+
+}  // namespace framework
+}  // namespace paddle
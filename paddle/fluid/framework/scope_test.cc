@@ -71,3 +71,27 @@ TEST(Scope, GetAllNames) {
 
   EXPECT_STREQ("a", str.c_str());
 }
+
+TEST(Scope, DetachAndAttachKid) {
+  Scope s1;
+  Scope s2;
+  Scope& ss = s1.NewScope();
+  Variable* v = ss.Var("a");
+  s1.Var("b");
+
+  auto kid = s1.DetachKid(&ss);
+  EXPECT_EQ(&ss, kid.get());
+  EXPECT_FALSE(s1.HasKid(&ss));
+  EXPECT_EQ(nullptr, ss.parent());
+  EXPECT_EQ(nullptr, ss.FindVar("b"));
+  EXPECT_EQ(nullptr, s1.DetachKid(&ss));
+
+  s2.Var("b");
+  Scope& attached = s2.AttachKid(std::move(kid));
+  EXPECT_EQ(&ss, &attached);
+  EXPECT_TRUE(s2.HasKid(&ss));
+  EXPECT_EQ(&s2, ss.parent());
+  EXPECT_EQ(v, ss.FindVar("a"));
+  EXPECT_EQ(s2.FindVar("b"), ss.FindVar("b"));
+  EXPECT_EQ(1UL, ss.LocalVarSize());
+}
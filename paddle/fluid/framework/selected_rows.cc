@@ -14,6 +14,8 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/selected_rows.h"
 
+#include <random>
+
 namespace paddle {
 namespace framework {
 
@@ -83,10 +85,45 @@ struct TensorFillVisitor {
   int64_t size_;
 };
 
+struct TensorUniformVisitor {
+  TensorUniformVisitor(framework::Tensor* dst, int64_t dst_offset,
+                       int64_t size, float range, unsigned seed)
+      : dst_(dst),
+        dst_offset_(dst_offset),
+        size_(size),
+        range_(range),
+        seed_(seed) {}
+
+  template <typename T>
+  void apply() const {
+    platform::CPUPlace cpu;
+    auto* start = dst_->mutable_data<T>(cpu) + dst_offset_;
+    if (range_ == 0.0f) {
+      std::fill(start, start + size_, static_cast<T>(0));
+      return;
+    }
+    std::minstd_rand engine(seed_);
+    std::uniform_real_distribution<float> dist(-range_, range_);
+    for (int64_t i = 0; i < size_; ++i) {
+      start[i] = static_cast<T>(dist(engine));
+    }
+  }
+
+  framework::Tensor* dst_;
+  int64_t dst_offset_;
+  int64_t size_;
+  float range_;
+  unsigned seed_;
+};
+
 void SerializeToStream(std::ostream& os, const SelectedRows& selected_rows,
                        const platform::DeviceContext& dev_ctx) {
+  // Version 1 appends the statistics of the rows of a table with a policy.
+  auto* stats = selected_rows.row_stats_.load();
+  std::unique_ptr<AutoRDLock> lock;
+  if (stats != nullptr) lock.reset(new AutoRDLock(&stats->lock));
   {  // the 1st field, uint32_t version
-    constexpr uint32_t version = 0;
+    const uint32_t version = stats == nullptr ? 0 : 1;
     os.write(reinterpret_cast<const char*>(&version), sizeof(version));
   }
   {
@@ -105,15 +142,34 @@ void SerializeToStream(std::ostream& os, const SelectedRows& selected_rows,
   }
   // the 4st field, Tensor data
   TensorToStream(os, selected_rows.value(), dev_ctx);
+  if (stats != nullptr) {
+    // the 5th field, the step and the last seen steps and the hit counts of
+    // the rows
+    int64_t step = stats->step;
+    os.write(reinterpret_cast<const char*>(&step), sizeof(step));
+    uint64_t size = selected_rows.rows().size();
+    for (uint64_t i = 0; i < size; ++i) {
+      int64_t last_seen = stats->last_seen[i];
+      os.write(reinterpret_cast<const char*>(&last_seen), sizeof(last_seen));
+    }
+    for (uint64_t i = 0; i < size; ++i) {
+      int64_t hits = stats->hits[i];
+      os.write(reinterpret_cast<const char*>(&hits), sizeof(hits));
+    }
+  }
 }
 
 void DeserializeFromStream(std::istream& is, SelectedRows* selected_rows,
                            const platform::DeviceContext& dev_ctx) {
+  uint32_t version;
   {
     // the 1st field, unit32_t version for SelectedRows
-    uint32_t version;
     is.read(reinterpret_cast<char*>(&version), sizeof(version));
-    PADDLE_ENFORCE_EQ(version, 0U, "Only version 0 is supported");
+    PADDLE_ENFORCE_LE(version, 1U,
+                      platform::errors::InvalidArgument(
+                          "Only version 0 and 1 of SelectedRows are "
+                          "supported, but got %d.",
+                          version));
   }
   {
     // the 2st field, rows information
@@ -133,6 +189,33 @@ void DeserializeFromStream(std::istream& is, SelectedRows* selected_rows,
   }
   // the 4st field, tensor which contains the data
   TensorFromStream(is, selected_rows->mutable_value(), dev_ctx);
+  if (version == 1) {
+    // the 5th field, the statistics of the rows, kept with the default
+    // policy until the table sets its own
+    auto* stats = selected_rows->row_stats_.load();
+    if (stats == nullptr) {
+      stats = selected_rows->CreateRowStats(SparseTablePolicy());
+      selected_rows->row_stats_.store(stats);
+    }
+    int64_t step;
+    is.read(reinterpret_cast<char*>(&step), sizeof(step));
+    stats->step = step;
+    int64_t size = static_cast<int64_t>(selected_rows->rows().size());
+    PADDLE_ENFORCE_LE(size, stats->capacity,
+                      platform::errors::InvalidArgument(
+                          "The sparse table has %d rows, more than its "
+                          "capacity %d.",
+                          size, stats->capacity));
+    int64_t value;
+    for (int64_t i = 0; i < size; ++i) {
+      is.read(reinterpret_cast<char*>(&value), sizeof(value));
+      stats->last_seen[i] = value;
+    }
+    for (int64_t i = 0; i < size; ++i) {
+      is.read(reinterpret_cast<char*>(&value), sizeof(value));
+      stats->hits[i] = value;
+    }
+  }
 }
 
 bool SelectedRows::HasKey(int64_t key) const {
@@ -140,71 +223,232 @@ bool SelectedRows::HasKey(int64_t key) const {
                                                                    : true;
 }
 
-int64_t SelectedRows::AutoGrownIndex(int64_t key, bool auto_grown,
-                                     bool is_test) {
-  if (is_test) {
-    auto iter = id_to_index_.find(key);
-    if (iter == id_to_index_.end()) {
-      return -1;
-    } else {
-      return iter->second;
-    }
-  }
-
-  rwlock_->RDLock();
-  auto iter = id_to_index_.find(key);
-  if (iter == id_to_index_.end()) {
-    rwlock_->UNLock();
-    if (!auto_grown) {
-      PADDLE_THROW("key %d not found", key);
-    }
-    rwlock_->WRLock();
-    auto map_size = id_to_index_.size();
+int64_t SelectedRows::GrowIndex(int64_t key, int64_t capacity) {
+  // Only the shard of the key is locked for writing, the keys of the other
+  // shards are looked up and inserted concurrently.
+  return IdIndex()->FindOrInsert(key, [this, capacity](int64_t key) {
+    std::lock_guard<std::mutex> lock(*rows_mutex_);
+    auto map_size = num_indexed_rows_;
     auto vector_size = rows_.size();
     if (map_size != vector_size) {
-      rwlock_->UNLock();
       PADDLE_THROW(
           "id_to_index_ size %d should have the same size with rows_ %d",
           map_size, vector_size);
     }
-    auto write_iter = id_to_index_.find(key);
-    if (write_iter == id_to_index_.end()) {
-      int row_num = rows_.size();
-      if (row_num == value_->dims()[0]) {
-        rwlock_->UNLock();
-        PADDLE_THROW("selected rows is full, then length exceed %d", row_num);
-      }
-      // key logic to put a key into id_to_index_
-      rows_.push_back(key);
-      auto index = static_cast<int64_t>(rows_.size() - 1);
-      id_to_index_[key] = index;
-      rwlock_->UNLock();
-      return index;
-    } else {
-      auto index = write_iter->second;
-      rwlock_->UNLock();
-      return index;
+    int row_num = rows_.size();
+    if (capacity >= 0 && row_num >= capacity) {
+      VLOG(5) << "id " << key << " is not admitted, the table is full";
+      return static_cast<int64_t>(-1);
     }
-  } else {
-    auto index = iter->second;
-    rwlock_->UNLock();
+    if (row_num == value_->dims()[0]) {
+      PADDLE_THROW("selected rows is full, then length exceed %d", row_num);
+    }
+    // key logic to put a key into id_to_index_
+    rows_.push_back(key);
+    ++num_indexed_rows_;
+    return static_cast<int64_t>(rows_.size() - 1);
+  });
+}
+
+int64_t SelectedRows::PolicyIndex(int64_t key, int64_t index, bool auto_grown,
+                                  bool is_test) {
+  auto* stats = row_stats_.load();
+  if (index < 0) {
+    if (is_test || !auto_grown) return -1;
+    if (stats->policy.min_frequency > 1) {
+      std::lock_guard<std::mutex> lock(stats->pending_mutex);
+      auto& count = stats->pending[key];
+      if (++count < stats->policy.min_frequency) return -1;
+      stats->pending.erase(key);
+    }
+    // Checked under rows_mutex_ with the insertion, so the concurrent
+    // lookups of the last free row are refused instead of failing.
+    index = GrowIndex(key, stats->capacity);
+    if (index < 0) return -1;
+  }
+  if (!is_test) {
+    stats->last_seen[index].store(stats->step.load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+    stats->hits[index].fetch_add(1, std::memory_order_relaxed);
+  }
+  return index;
+}
+
+int64_t SelectedRows::AutoGrownIndex(int64_t key, bool auto_grown,
+                                     bool is_test) {
+  int64_t index = IdIndex()->Find(key);
+  if (has_policy()) {
+    return PolicyIndex(key, index, auto_grown, is_test);
+  }
+  if (index >= 0 || is_test) {
     return index;
   }
+  if (!auto_grown) {
+    PADDLE_THROW("key %d not found", key);
+  }
+  return GrowIndex(key);
+}
+
+void SelectedRows::AutoGrownIndex(const int64_t* keys, int64_t num,
+                                  int64_t* indices, bool auto_grown,
+                                  bool is_test) {
+  IdIndex()->Find(keys, static_cast<size_t>(num), indices);
+  bool policy = has_policy();
+  for (int64_t i = 0; i < num; ++i) {
+    if (policy) {
+      indices[i] = PolicyIndex(keys[i], indices[i], auto_grown, is_test);
+    } else if (indices[i] < 0 && !is_test) {
+      indices[i] = AutoGrownIndex(keys[i], auto_grown, is_test);
+    }
+  }
 }
 
 void SelectedRows::SyncIndex() {
-  rwlock_->WRLock();
-  id_to_index_.clear();
+  // Not thread safe against the lookups, rows_mutex_ is always taken after
+  // the lock of a shard.
+  auto* index = IdIndex();
+  index->Clear();
   for (size_t i = 0; i < rows_.size(); ++i) {
-    id_to_index_[rows_[i]] = i;
+    index->Set(rows_[i], i);
+  }
+  std::lock_guard<std::mutex> lock(*rows_mutex_);
+  num_indexed_rows_ = index->size();
+}
+
+ShardedIdIndex* SelectedRows::IdIndex() {
+  auto* index = id_to_index_.load(std::memory_order_acquire);
+  if (index != nullptr) return index;
+  std::lock_guard<std::mutex> lock(*rows_mutex_);
+  index = id_to_index_.load(std::memory_order_relaxed);
+  if (index == nullptr) {
+    index = new ShardedIdIndex;
+    id_to_index_.store(index, std::memory_order_release);
+  }
+  return index;
+}
+
+SelectedRows::RowStats* SelectedRows::CreateRowStats(
+    const SparseTablePolicy& policy) {
+  PADDLE_ENFORCE_EQ(value_->IsInitialized(), true,
+                    platform::errors::PreconditionNotMet(
+                        "The value of the sparse table should be initialized "
+                        "before setting its policy."));
+  std::unique_ptr<RowStats> stats(new RowStats);
+  stats->policy = policy;
+  stats->capacity = value_->dims()[0];
+  stats->last_seen.reset(new std::atomic<int64_t>[stats->capacity]);
+  stats->hits.reset(new std::atomic<int64_t>[stats->capacity]);
+  for (int64_t i = 0; i < stats->capacity; ++i) {
+    stats->last_seen[i] = 0;
+    stats->hits[i] = 0;
+  }
+  return stats.release();
+}
+
+static bool SamePolicy(const SparseTablePolicy& a,
+                       const SparseTablePolicy& b) {
+  return a.min_frequency == b.min_frequency && a.ttl_steps == b.ttl_steps &&
+         a.count_decay == b.count_decay && a.min_count == b.min_count &&
+         a.init_range == b.init_range;
+}
+
+void SelectedRows::SetPolicy(const SparseTablePolicy& policy) {
+  PADDLE_ENFORCE_GE(policy.ttl_steps, 0,
+                    platform::errors::InvalidArgument(
+                        "ttl_steps should not be negative, but got %d.",
+                        policy.ttl_steps));
+  PADDLE_ENFORCE_EQ(
+      policy.count_decay > 0.0f && policy.count_decay <= 1.0f, true,
+      platform::errors::InvalidArgument(
+          "count_decay should be in (0, 1], but got %f.", policy.count_decay));
+  PADDLE_ENFORCE_GE(policy.init_range, 0.0f,
+                    platform::errors::InvalidArgument(
+                        "init_range should not be negative, but got %f.",
+                        policy.init_range));
+  {
+    std::lock_guard<std::mutex> lock(*rows_mutex_);
+    if (row_stats_.load() == nullptr) {
+      row_stats_.store(CreateRowStats(policy));
+      return;
+    }
+  }
+  // Not under rows_mutex_, which is taken after the lock of the stats.
+  auto* stats = row_stats_.load();
+  {
+    // Setting the same policy on every step only takes the read lock.
+    AutoRDLock stats_lock(&stats->lock);
+    if (SamePolicy(stats->policy, policy)) return;
   }
-  rwlock_->UNLock();
+  AutoWRLock stats_lock(&stats->lock);
+  stats->policy = policy;
+}
+
+RWLock* SelectedRows::shrink_lock() const {
+  auto* stats = row_stats_.load();
+  PADDLE_ENFORCE_NOT_NULL(stats, platform::errors::PreconditionNotMet(
+                                     "The sparse table has no policy."));
+  return &stats->lock;
+}
+
+int64_t SelectedRows::step() const {
+  auto* stats = row_stats_.load();
+  return stats == nullptr ? 0 : stats->step.load();
 }
 
-void SelectedRows::Get(const framework::Tensor& ids, framework::Tensor* value,
-                       bool auto_grown, bool is_test) {
+int64_t SelectedRows::Shrink() {
+  auto* stats = row_stats_.load();
+  PADDLE_ENFORCE_NOT_NULL(stats, platform::errors::PreconditionNotMet(
+                                     "The sparse table has no policy."));
+  AutoWRLock lock(&stats->lock);
+  const auto& policy = stats->policy;
+  int64_t step = stats->step;
+  int64_t num_rows = static_cast<int64_t>(rows_.size());
+  int64_t width = value_->numel() / value_->dims()[0];
+  int64_t kept = 0;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    auto hits = static_cast<int64_t>(stats->hits[i] * policy.count_decay);
+    int64_t last_seen = stats->last_seen[i];
+    bool expired = policy.ttl_steps > 0 && step - last_seen > policy.ttl_steps;
+    if (expired || hits < policy.min_count) continue;
+    if (kept != i) {
+      framework::VisitDataType(
+          value_->type(), TensorCopyVisitor(value_.get(), kept * width,
+                                            *value_.get(), i * width, width));
+      rows_[kept] = rows_[i];
+      stats->last_seen[kept] = last_seen;
+    }
+    stats->hits[kept] = hits;
+    ++kept;
+  }
+  // The freed rows are given to the new keys.
+  for (int64_t i = kept; i < num_rows; ++i) {
+    stats->last_seen[i] = 0;
+    stats->hits[i] = 0;
+  }
+  if (num_rows > kept) {
+    framework::VisitDataType(
+        value_->type(),
+        TensorUniformVisitor(value_.get(), kept * width,
+                             (num_rows - kept) * width, policy.init_range,
+                             static_cast<unsigned>(step)));
+  }
+  rows_.resize(kept);
+  {
+    std::lock_guard<std::mutex> pending_lock(stats->pending_mutex);
+    stats->pending.clear();
+  }
+  SyncIndex();
+  VLOG(3) << "Shrink the sparse table at step " << step << ", evict "
+          << num_rows - kept << " of " << num_rows << " rows";
+  return num_rows - kept;
+}
+
+int64_t SelectedRows::Get(const framework::Tensor& ids,
+                          framework::Tensor* value, bool auto_grown,
+                          bool is_test) {
   PADDLE_ENFORCE(value->IsInitialized(),
                  "The value tensor should be initialized.");
+  int64_t step = 0;
   if (ids.numel() == 0) {
     VLOG(3) << "keys is empty, please check data!";
   } else {
@@ -212,9 +456,19 @@ void SelectedRows::Get(const framework::Tensor& ids, framework::Tensor* value,
     PADDLE_ENFORCE_EQ(value_width, value->numel() / value->dims()[0],
                       "output tensor should have the same shape with table "
                       "except the dims[0].");
+    // Shrink() does not move the rows during the lookup.
+    auto* stats = row_stats_.load();
+    std::unique_ptr<AutoRDLock> lock;
+    if (stats != nullptr) {
+      lock.reset(new AutoRDLock(&stats->lock));
+      if (!is_test) step = ++stats->step;
+    }
+    std::vector<int64_t> indices(ids.numel());
+    AutoGrownIndex(ids.data<int64_t>(), ids.numel(), indices.data(),
+                   auto_grown, is_test);
     for (int i = 0; i < ids.numel(); ++i) {
       auto id = ids.data<int64_t>()[i];
-      int64_t index = AutoGrownIndex(id, auto_grown, is_test);
+      int64_t index = indices[i];
       if (index < 0) {
         VLOG(5) << "id " << id << " not in the table, return 0";
         framework::VisitDataType(
@@ -228,6 +482,7 @@ void SelectedRows::Get(const framework::Tensor& ids, framework::Tensor* value,
       }
     }
   }
+  return step;
 }
 
 }  // namespace framework
@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <unordered_map>
@@ -22,13 +23,34 @@ limitations under the License. */
 #include <vector>
 
 #include "paddle/fluid/framework/lod_tensor.h"
-#include "paddle/fluid/framework/rw_lock.h"
+#include "paddle/fluid/framework/sharded_id_index.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/memory/memcpy.h"
 
 namespace paddle {
 namespace framework {
 
+/*
+ * @brief The admission and eviction policy of an auto-grown sparse table,
+ * see SelectedRows::SetPolicy. A step is a batch looked up by
+ * SelectedRows::Get.
+ */
+struct SparseTablePolicy {
+  // A new key gets a row when it is looked up this many times, the lookups
+  // before return zeros.
+  int64_t min_frequency{1};
+  // Shrink() evicts the rows not looked up in the last ttl_steps steps, 0
+  // never expires a row.
+  int64_t ttl_steps{0};
+  // Shrink() multiplies the hit counts of the rows by count_decay, then
+  // evicts the rows whose count is below min_count.
+  float count_decay{1.0f};
+  int64_t min_count{0};
+  // The rows freed by Shrink() are filled uniformly in
+  // [-init_range, init_range] for the new keys.
+  float init_range{0.0f};
+};
+
 class SelectedRows {
   /*
    * @brief We can use the SelectedRows structure to reproduce a sparse table.
@@ -49,13 +71,39 @@ class SelectedRows {
   SelectedRows(const std::vector<int64_t>& rows, const int64_t& height)
       : rows_(rows), height_(height) {
     value_.reset(new Tensor());
-    rwlock_.reset(new RWLock);
+    rows_mutex_.reset(new std::mutex);
   }
 
   SelectedRows() {
     height_ = 0;
     value_.reset(new Tensor());
-    rwlock_.reset(new RWLock);
+    rows_mutex_.reset(new std::mutex);
+  }
+
+  // Defined since id_to_index_ and row_stats_ are atomic, not thread safe.
+  SelectedRows(SelectedRows&& other)
+      : rows_(std::move(other.rows_)),
+        id_to_index_(other.id_to_index_.exchange(nullptr)),
+        value_(std::move(other.value_)),
+        height_(other.height_),
+        rows_mutex_(std::move(other.rows_mutex_)),
+        num_indexed_rows_(other.num_indexed_rows_),
+        row_stats_(other.row_stats_.exchange(nullptr)) {}
+
+  SelectedRows& operator=(SelectedRows&& other) {
+    rows_ = std::move(other.rows_);
+    delete id_to_index_.exchange(other.id_to_index_.exchange(nullptr));
+    value_ = std::move(other.value_);
+    height_ = other.height_;
+    rows_mutex_ = std::move(other.rows_mutex_);
+    num_indexed_rows_ = other.num_indexed_rows_;
+    delete row_stats_.exchange(other.row_stats_.exchange(nullptr));
+    return *this;
+  }
+
+  ~SelectedRows() {
+    delete id_to_index_.load();
+    delete row_stats_.load();
   }
 
   const platform::Place& place() const { return value_->place(); }
@@ -100,11 +148,11 @@ class SelectedRows {
    * parameters
    * for distribute lookup table.
    *
-   * @return a list of pair which contains the non-exists key and the index in
-   * the value
+   * @return the step this lookup advanced the table to with a policy, which
+   * is unique to the lookup, or 0 if the step is not advanced.
    */
-  void Get(const framework::Tensor& ids, framework::Tensor* value,
-           bool auto_grown = false, bool is_test = false);
+  int64_t Get(const framework::Tensor& ids, framework::Tensor* value,
+              bool auto_grown = false, bool is_test = false);
 
   /*
    * @brief Get the index of the key from id_to_index_ map. If the key not
@@ -119,19 +167,55 @@ class SelectedRows {
    */
   int64_t AutoGrownIndex(int64_t key, bool auto_grown, bool is_test = false);
 
+  /*
+   * @brief Get the indices of a batch of keys, the same as calling
+   * AutoGrownIndex on every key, but the shards of id_to_index_ are locked
+   * once per batch for the existing keys.
+   *
+   * Note!!! this interface is only used when selected_rows is used as
+   * parameters
+   * for distribute lookup table.
+   */
+  void AutoGrownIndex(const int64_t* keys, int64_t num, int64_t* indices,
+                      bool auto_grown, bool is_test = false);
+
   /*
    * @brief Get the index of the key from id_to_index_ map.
    */
-  inline int64_t GetIndexFromId(int64_t key) {
-    auto iter = id_to_index_.find(key);
-    if (iter == id_to_index_.end()) {
-      return -1;
-    } else {
-      return iter->second;
-    }
+  inline int64_t GetIndexFromId(int64_t key) const {
+    auto* index = id_to_index_.load(std::memory_order_acquire);
+    return index == nullptr ? -1 : index->Find(key);
   }
 
   void SyncIndex();
+
+  /*
+   * @brief Keep the last seen step and the hit count of every row, admit
+   * the new keys and evict the rows by the policy. Calling it again only
+   * updates the policy. The value tensor should be initialized.
+   *
+   * With a policy, a missing key is not an error, its index is -1, and the
+   * indices are only valid under the read lock of shrink_lock(), since
+   * Shrink() moves the rows. Get() takes the lock itself.
+   */
+  void SetPolicy(const SparseTablePolicy& policy);
+
+  bool has_policy() const { return row_stats_.load() != nullptr; }
+
+  RWLock* shrink_lock() const;
+
+  /*
+   * @brief Evict the expired and the infrequent rows by the policy, and
+   * compact the rest to the front of the value tensor. Thread safe.
+   *
+   * @return the number of the evicted rows.
+   */
+  int64_t Shrink();
+
+  /*
+   * @brief The number of the steps looked up with a policy.
+   */
+  int64_t step() const;
   /*
    * @brief Get complete Dims before
    */
@@ -146,11 +230,51 @@ class SelectedRows {
   // SelectedRows are simply concated when adding together. Until a
   // SelectedRows add a Tensor, will the duplicate rows be handled.
   Vector<int64_t> rows_;
-  std::unordered_map<int64_t, int64_t>
-      id_to_index_;  // should not be used when rows_ has duplicate member
+  // Should not be used when rows_ has duplicate member. Created by the first
+  // AutoGrownIndex() or SyncIndex(), the other SelectedRows, e.g. the
+  // sparse gradients, never have one.
+  std::atomic<ShardedIdIndex*> id_to_index_{nullptr};
   std::unique_ptr<Tensor> value_{nullptr};
   int64_t height_;  // height indicates the underline tensor's height
-  std::unique_ptr<RWLock> rwlock_{nullptr};
+  // Guards appending the new keys to rows_, the lookups of the existing keys
+  // only lock a shard of id_to_index_.
+  std::unique_ptr<std::mutex> rows_mutex_{nullptr};
+  // The number of rows put into id_to_index_, guarded by rows_mutex_.
+  size_t num_indexed_rows_{0};
+
+  // The statistics of the rows, only kept with a policy.
+  struct RowStats {
+    SparseTablePolicy policy;
+    // Shared by the lookups, exclusive for Shrink().
+    RWLock lock;
+    std::atomic<int64_t> step{0};
+    int64_t capacity{0};
+    std::unique_ptr<std::atomic<int64_t>[]> last_seen;
+    std::unique_ptr<std::atomic<int64_t>[]> hits;
+    // The lookup counts of the keys not admitted yet, cleared by Shrink().
+    std::mutex pending_mutex;
+    std::unordered_map<int64_t, int64_t> pending;
+  };
+
+  RowStats* CreateRowStats(const SparseTablePolicy& policy);
+  // id_to_index_, created under rows_mutex_ if there is none.
+  ShardedIdIndex* IdIndex();
+  // Insert the key, should be called after it is not found. With a capacity,
+  // the key is not inserted and -1 is returned if the table has that many
+  // rows, otherwise a full table is an error.
+  int64_t GrowIndex(int64_t key, int64_t capacity = -1);
+  // The index of the key by the policy, under the read lock of the stats.
+  int64_t PolicyIndex(int64_t key, int64_t index, bool auto_grown,
+                      bool is_test);
+
+  std::atomic<RowStats*> row_stats_{nullptr};
+
+  friend void SerializeToStream(std::ostream& os,
+                                const SelectedRows& selected_rows,
+                                const platform::DeviceContext& dev_ctx);
+  friend void DeserializeFromStream(std::istream& is,
+                                    SelectedRows* selected_rows,
+                                    const platform::DeviceContext& dev_ctx);
 };
 
 /*
@@ -10,7 +10,10 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include <time.h>
+#include <algorithm>
 #include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/selected_rows.h"
@@ -124,6 +127,151 @@ TEST(SelectedRows, SparseTable) {
   }
 }
 
+TEST(SelectedRows, SparseTablePolicy) {
+  platform::CPUPlace cpu;
+  platform::CPUDeviceContext cpu_ctx(cpu);
+  SelectedRows table;
+  int64_t embedding_width = 2;
+  auto* data = table.mutable_value()->mutable_data<float>(
+      framework::make_ddim({4, embedding_width}), cpu);
+  for (int64_t i = 0; i < 4 * embedding_width; ++i) {
+    data[i] = static_cast<float>(i / embedding_width);
+  }
+  SparseTablePolicy policy;
+  policy.min_frequency = 2;
+  policy.ttl_steps = 2;
+  table.SetPolicy(policy);
+
+  auto lookup = [&](const std::vector<int64_t>& keys) {
+    framework::Tensor ids;
+    auto* ids_data = ids.mutable_data<int64_t>(
+        framework::make_ddim({static_cast<int64_t>(keys.size())}), cpu);
+    std::copy(keys.begin(), keys.end(), ids_data);
+    framework::Tensor value;
+    value.mutable_data<float>(
+        framework::make_ddim({static_cast<int64_t>(keys.size()), 2}), cpu);
+    table.Get(ids, &value, true);
+    return value.data<float>()[(keys.size() - 1) * embedding_width];
+  };
+  // The keys are admitted on their second lookups.
+  lookup({1});
+  ASSERT_EQ(table.GetIndexFromId(1), -1);
+  lookup({2, 1});
+  ASSERT_EQ(table.GetIndexFromId(1), 0);
+  ASSERT_EQ(table.GetIndexFromId(2), -1);
+  ASSERT_EQ(lookup({2}), 1.0f);
+  ASSERT_EQ(lookup({2}), 1.0f);
+  lookup({2});
+  ASSERT_EQ(table.step(), 5);
+
+  // The key 1 is not seen since the step 2.
+  ASSERT_EQ(table.Shrink(), 1);
+  ASSERT_EQ(table.rows().size(), 1UL);
+  ASSERT_EQ(table.GetIndexFromId(1), -1);
+  ASSERT_EQ(table.GetIndexFromId(2), 0);
+  ASSERT_EQ(data[0], 1.0f);
+  ASSERT_EQ(data[1 * embedding_width], 0.0f);
+
+  std::ostringstream oss;
+  SerializeToStream(oss, table, cpu_ctx);
+  std::istringstream iss(oss.str());
+  SelectedRows dst_table;
+  DeserializeFromStream(iss, &dst_table, cpu_ctx);
+  dst_table.SyncIndex();
+  ASSERT_TRUE(dst_table.has_policy());
+  ASSERT_EQ(dst_table.step(), 5);
+  ASSERT_EQ(dst_table.GetIndexFromId(2), 0);
+
+  // The restored table takes a new policy and keeps its statistics.
+  policy.min_frequency = 3;
+  dst_table.SetPolicy(policy);
+  ASSERT_EQ(dst_table.step(), 5);
+  ASSERT_EQ(dst_table.AutoGrownIndex(7, true, false), -1);
+  ASSERT_EQ(dst_table.AutoGrownIndex(7, true, false), -1);
+  ASSERT_EQ(dst_table.AutoGrownIndex(7, true, false), 1);
+}
+
+TEST(SelectedRows, SparseTablePolicyFull) {
+  platform::CPUPlace cpu;
+  SelectedRows table;
+  int64_t capacity = 4;
+  table.mutable_value()->mutable_data<float>(
+      framework::make_ddim({capacity, 2}), cpu);
+  table.SetPolicy(SparseTablePolicy());
+
+  // The concurrent lookups racing for the last rows are refused, not failed.
+  int num_threads = 8;
+  std::vector<int64_t> admitted(num_threads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      for (int64_t key = t * 100; key < t * 100 + 100; ++key) {
+        if (table.AutoGrownIndex(key, true, false) >= 0) ++admitted[t];
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  int64_t total = 0;
+  for (auto num : admitted) total += num;
+  ASSERT_EQ(total, capacity);
+  ASSERT_EQ(static_cast<int64_t>(table.rows().size()), capacity);
+}
+
+TEST(SelectedRows, LazyIdIndex) {
+  // The index is only created for the lookups.
+  SelectedRows grad({3, 5}, 10);
+  ASSERT_EQ(grad.GetIndexFromId(5), -1);
+  grad.SyncIndex();
+  ASSERT_EQ(grad.GetIndexFromId(3), 0);
+  ASSERT_EQ(grad.GetIndexFromId(5), 1);
+  SelectedRows moved(std::move(grad));
+  ASSERT_EQ(moved.GetIndexFromId(5), 1);
+  ASSERT_EQ(grad.GetIndexFromId(5), -1);
+}
+
+TEST(SelectedRows, SparseTablePolicySteps) {
+  platform::CPUPlace cpu;
+  SelectedRows table;
+  table.mutable_value()->mutable_data<float>(framework::make_ddim({16, 2}),
+                                             cpu);
+  table.SetPolicy(SparseTablePolicy());
+
+  // Every step is returned to a single lookup, so a single one shrinks the
+  // table at the end of an interval.
+  int num_threads = 4;
+  int num_lookups = 100;
+  std::vector<std::vector<int64_t>> steps(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      framework::Tensor ids;
+      ids.mutable_data<int64_t>(framework::make_ddim({1}), cpu)[0] = t;
+      framework::Tensor value;
+      value.mutable_data<float>(framework::make_ddim({1, 2}), cpu);
+      for (int i = 0; i < num_lookups; ++i) {
+        steps[t].push_back(table.Get(ids, &value, true));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  std::vector<int64_t> all_steps;
+  for (auto& s : steps) all_steps.insert(all_steps.end(), s.begin(), s.end());
+  std::sort(all_steps.begin(), all_steps.end());
+  for (size_t i = 0; i < all_steps.size(); ++i) {
+    ASSERT_EQ(all_steps[i], static_cast<int64_t>(i + 1));
+  }
+
+  // The policy moves with the table.
+  SelectedRows moved(std::move(table));
+  ASSERT_TRUE(moved.has_policy());
+  ASSERT_EQ(moved.step(), num_threads * num_lookups);
+  ASSERT_FALSE(table.has_policy());
+  SelectedRows assigned;
+  assigned = std::move(moved);
+  ASSERT_TRUE(assigned.has_policy());
+  ASSERT_GE(assigned.GetIndexFromId(0), 0);
+}
+
 void f1(SelectedRows* table, int table_size) {
   for (int i = 1000000; i > 0; --i) {
     auto id = i % table_size;
@@ -0,0 +1,146 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/sharded_id_index.h"
+
+#include <algorithm>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+constexpr size_t kMinSlots = 16;
+
+}  // namespace
+
+ShardedIdIndex::ShardedIdIndex(int num_shards) {
+  PADDLE_ENFORCE_GT(num_shards, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of shards should be greater than 0, but "
+                        "got %d.",
+                        num_shards));
+  PADDLE_ENFORCE_EQ(num_shards & (num_shards - 1), 0,
+                    platform::errors::InvalidArgument(
+                        "The number of shards should be a power of 2, but "
+                        "got %d.",
+                        num_shards));
+  int shard_bits = 0;
+  while ((1 << shard_bits) < num_shards) ++shard_bits;
+  shard_mask_ = static_cast<uint64_t>(num_shards - 1);
+  shards_.reset(new Shard[num_shards]);
+  for (int s = 0; s < num_shards; ++s) {
+    shards_[s].shift = shard_bits;
+  }
+}
+
+int64_t ShardedIdIndex::Find(int64_t key) const {
+  uint64_t hash = Hash(key);
+  auto& shard = shards_[ShardOf(hash)];
+  AutoRDLock lock(&shard.lock);
+  return shard.Find(key, hash);
+}
+
+void ShardedIdIndex::Find(const int64_t* keys, size_t num,
+                          int64_t* indices) const {
+  size_t num_shards = shard_mask_ + 1;
+  // Counting sort the positions of the keys by their shards.
+  std::vector<uint64_t> hashes(num);
+  std::vector<size_t> offsets(num_shards + 1, 0);
+  for (size_t i = 0; i < num; ++i) {
+    hashes[i] = Hash(keys[i]);
+    ++offsets[ShardOf(hashes[i]) + 1];
+  }
+  for (size_t s = 0; s < num_shards; ++s) {
+    offsets[s + 1] += offsets[s];
+  }
+  std::vector<size_t> order(num);
+  std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < num; ++i) {
+    order[next[ShardOf(hashes[i])]++] = i;
+  }
+  for (size_t s = 0; s < num_shards; ++s) {
+    if (offsets[s] == offsets[s + 1]) continue;
+    auto& shard = shards_[s];
+    AutoRDLock lock(&shard.lock);
+    for (size_t k = offsets[s]; k < offsets[s + 1]; ++k) {
+      size_t i = order[k];
+      indices[i] = shard.Find(keys[i], hashes[i]);
+    }
+  }
+}
+
+void ShardedIdIndex::Set(int64_t key, int64_t index) {
+  uint64_t hash = Hash(key);
+  auto& shard = shards_[ShardOf(hash)];
+  AutoWRLock lock(&shard.lock);
+  if (shard.Insert(key, index, hash)) ++size_;
+}
+
+void ShardedIdIndex::Clear() {
+  for (size_t s = 0; s <= shard_mask_; ++s) {
+    auto& shard = shards_[s];
+    AutoWRLock lock(&shard.lock);
+    size_ -= shard.size;
+    std::vector<Slot>().swap(shard.slots);
+    shard.size = 0;
+  }
+}
+
+int64_t ShardedIdIndex::Shard::Find(int64_t key, uint64_t hash) const {
+  if (slots.empty()) return -1;
+  size_t mask = slots.size() - 1;
+  for (size_t i = (hash >> shift) & mask;; i = (i + 1) & mask) {
+    const Slot& s = slots[i];
+    if (s.index < 0) return -1;
+    if (s.key == key) return s.index;
+  }
+}
+
+bool ShardedIdIndex::Shard::Insert(int64_t key, int64_t index,
+                                   uint64_t hash) {
+  // Keep the load factor under 1/2 so that the probes stay short.
+  if ((size + 1) * 2 > slots.size()) Grow();
+  size_t mask = slots.size() - 1;
+  for (size_t i = (hash >> shift) & mask;; i = (i + 1) & mask) {
+    Slot& s = slots[i];
+    if (s.index < 0) {
+      s.key = key;
+      s.index = index;
+      ++size;
+      return true;
+    }
+    if (s.key == key) {
+      s.index = index;
+      return false;
+    }
+  }
+}
+
+void ShardedIdIndex::Shard::Grow() {
+  std::vector<Slot> old(std::max(kMinSlots, slots.size() * 2), Slot{0, -1});
+  old.swap(slots);
+  size_t mask = slots.size() - 1;
+  for (auto& s : old) {
+    if (s.index < 0) continue;
+    size_t i = (Hash(s.key) >> shift) & mask;
+    while (slots[i].index >= 0) i = (i + 1) & mask;
+    slots[i] = s;
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,130 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "paddle/fluid/framework/rw_lock.h"
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * @brief The id-to-row index of a sparse table.
+ *
+ *  The keys are spread over a fixed number of shards by their hash, each
+ *  shard is an open-addressing table with linear probing guarded by its own
+ *  RWLock. The lookups of different shards never contend, and a shard only
+ *  takes its write lock to insert a missing key. The slots are stored in a
+ *  flat array of (key, index) pairs, 16 bytes per slot instead of a heap node
+ *  per key as std::unordered_map does.
+ */
+class ShardedIdIndex {
+ public:
+  explicit ShardedIdIndex(int num_shards = 64);
+
+  /*
+   * @brief Get the index of the key.
+   *
+   * @return -1 if the key does not exist.
+   */
+  int64_t Find(int64_t key) const;
+
+  /*
+   * @brief Get the indices of a batch of keys, -1 for the missing ones. The
+   * keys are grouped by their shards, every shard is locked once.
+   */
+  void Find(const int64_t* keys, size_t num, int64_t* indices) const;
+
+  /*
+   * @brief Get the index of the key, insert the index returned by
+   * `new_index(key)` if the key does not exist. `new_index` is called under
+   * the write lock of the shard, at most once per key. A negative index from
+   * `new_index` is returned without inserting the key.
+   */
+  template <typename NewIndex>
+  int64_t FindOrInsert(int64_t key, NewIndex&& new_index) {
+    uint64_t hash = Hash(key);
+    auto& shard = shards_[ShardOf(hash)];
+    {
+      AutoRDLock lock(&shard.lock);
+      int64_t index = shard.Find(key, hash);
+      if (index >= 0) return index;
+    }
+    AutoWRLock lock(&shard.lock);
+    int64_t index = shard.Find(key, hash);
+    if (index >= 0) return index;
+    index = new_index(key);
+    if (index < 0) return index;
+    shard.Insert(key, index, hash);
+    ++size_;
+    return index;
+  }
+
+  /*
+   * @brief Set the index of the key, not thread safe against other writers
+   * of the same key.
+   */
+  void Set(int64_t key, int64_t index);
+
+  void Clear();
+
+  size_t size() const { return size_; }
+
+ private:
+  DISABLE_COPY_AND_ASSIGN(ShardedIdIndex);
+
+  struct Slot {
+    int64_t key;
+    int64_t index;  // -1 means empty
+  };
+
+  struct Shard {
+    int64_t Find(int64_t key, uint64_t hash) const;
+    // Return whether the key is new.
+    bool Insert(int64_t key, int64_t index, uint64_t hash);
+    void Grow();
+
+    mutable RWLock lock;
+    std::vector<Slot> slots;
+    size_t size{0};
+    // The low bits of the hash select the shard, the others the slot.
+    int shift{0};
+  };
+
+  static uint64_t Hash(int64_t key) {
+    // The finalizer of MurmurHash3, the ids are often consecutive.
+    uint64_t h = static_cast<uint64_t>(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+  size_t ShardOf(uint64_t hash) const { return hash & shard_mask_; }
+
+  std::unique_ptr<Shard[]> shards_;
+  uint64_t shard_mask_;
+  std::atomic<size_t> size_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,69 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/sharded_id_index.h"
+
+#include <atomic>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(ShardedIdIndex, FindAndSet) {
+  ShardedIdIndex index(4);
+  ASSERT_EQ(index.Find(7), -1);
+  for (int64_t i = 0; i < 1000; ++i) {
+    index.Set(i * 31, i);
+  }
+  ASSERT_EQ(index.size(), 1000UL);
+  index.Set(31, 5);
+  ASSERT_EQ(index.size(), 1000UL);
+  ASSERT_EQ(index.Find(31), 5);
+
+  std::vector<int64_t> keys = {0, 62, 1, 31 * 999, -1};
+  std::vector<int64_t> indices(keys.size());
+  index.Find(keys.data(), keys.size(), indices.data());
+  ASSERT_EQ(indices, std::vector<int64_t>({0, 2, -1, 999, -1}));
+
+  index.Clear();
+  ASSERT_EQ(index.size(), 0UL);
+  ASSERT_EQ(index.Find(62), -1);
+}
+
+TEST(ShardedIdIndex, ConcurrentFindOrInsert) {
+  ShardedIdIndex index;
+  std::atomic<int64_t> next_index(0);
+  const int64_t num_keys = 100000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t] {
+      for (int64_t i = 0; i < num_keys; ++i) {
+        int64_t key = (i * 7 + t) % num_keys;
+        int64_t value = index.FindOrInsert(
+            key, [&next_index](int64_t) { return next_index++; });
+        ASSERT_EQ(index.Find(key), value);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  // Every key is inserted once.
+  ASSERT_EQ(index.size(), static_cast<size_t>(num_keys));
+  ASSERT_EQ(next_index, num_keys);
+}
+
+}  // namespace framework
+}  // namespace paddle
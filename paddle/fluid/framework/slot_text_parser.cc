@@ -0,0 +1,220 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/slot_text_parser.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "paddle/fluid/platform/cpu_info.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    !defined(_WIN32)
+#define PADDLE_SLOT_TEXT_PARSER_AVX2
+#include <immintrin.h>
+#endif
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+inline bool IsDelimiter(char c) {
+  return static_cast<unsigned char>(c) <= static_cast<unsigned char>(' ');
+}
+
+inline bool IsDigit(char c) {
+  return static_cast<unsigned char>(c - '0') < 10;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+// Whether the 8 bytes loaded little-endian are all ASCII digits.
+inline bool AreEightDigits(uint64_t v) {
+  return ((v & 0xF0F0F0F0F0F0F0F0ULL) |
+          (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+         0x3333333333333333ULL;
+}
+
+// Convert the 8 digits loaded little-endian, the first digit is the lowest
+// byte, by adding the neighbouring lanes pairwise.
+inline uint64_t EightDigitsToInt(uint64_t v) {
+  v = (v & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+  v = (v & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+  return (v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32;
+}
+#define PADDLE_SLOT_TEXT_PARSER_SWAR
+#endif
+
+// The uint64 value of the digits in [begin, end), at most 19 of them.
+inline uint64_t DigitsToInt(const char* begin, const char* end) {
+  uint64_t value = 0;
+#ifdef PADDLE_SLOT_TEXT_PARSER_SWAR
+  while (end - begin >= 8) {
+    uint64_t chunk;
+    std::memcpy(&chunk, begin, sizeof(chunk));
+    value = value * 100000000ULL + EightDigitsToInt(chunk);
+    begin += 8;
+  }
+#endif
+  for (; begin < end; ++begin) {
+    value = value * 10 + static_cast<uint64_t>(*begin - '0');
+  }
+  return value;
+}
+
+// Whether [begin, end) are all digits.
+inline bool AllDigits(const char* begin, const char* end) {
+#ifdef PADDLE_SLOT_TEXT_PARSER_SWAR
+  while (end - begin >= 8) {
+    uint64_t chunk;
+    std::memcpy(&chunk, begin, sizeof(chunk));
+    if (!AreEightDigits(chunk)) return false;
+    begin += 8;
+  }
+#endif
+  for (; begin < end; ++begin) {
+    if (!IsDigit(*begin)) return false;
+  }
+  return true;
+}
+
+const double kPow10[] = {1e0, 1e1, 1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                         1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+
+constexpr int kMaxFastFloatDigits = 15;
+
+}  // namespace
+
+void SlotTextTokenizer::Split(const char* line, size_t size) {
+  line_ = line;
+  begins_.clear();
+  ends_.clear();
+#ifdef PADDLE_SLOT_TEXT_PARSER_AVX2
+  static const bool use_avx2 = platform::MayIUse(platform::avx2);
+  if (use_avx2) {
+    SplitAVX2(size);
+    return;
+  }
+#endif
+  SplitScalar(0, size, false);
+}
+
+void SlotTextTokenizer::SplitScalar(size_t from, size_t size, bool in_token) {
+  for (size_t i = from; i < size; ++i) {
+    bool delimiter = IsDelimiter(line_[i]);
+    if (in_token && delimiter) {
+      ends_.push_back(static_cast<uint32_t>(i));
+    } else if (!in_token && !delimiter) {
+      begins_.push_back(static_cast<uint32_t>(i));
+    }
+    in_token = !delimiter;
+  }
+  if (in_token) ends_.push_back(static_cast<uint32_t>(size));
+}
+
+#ifdef PADDLE_SLOT_TEXT_PARSER_AVX2
+__attribute__((target("avx2"))) void SlotTextTokenizer::SplitAVX2(
+    size_t size) {
+  const __m256i space = _mm256_set1_epi8(' ');
+  // Whether the byte before the current block belongs to a token.
+  uint32_t carry = 0;
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i bytes =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(line_ + i));
+    // max(b, ' ') == ' ' iff b <= ' ' as unsigned bytes.
+    uint32_t delimiters = static_cast<uint32_t>(_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(_mm256_max_epu8(bytes, space), space)));
+    uint32_t tokens = ~delimiters;
+    uint32_t previous = (tokens << 1) | carry;
+    uint32_t begins = tokens & ~previous;
+    uint32_t ends = ~tokens & previous;
+    carry = tokens >> 31;
+    // The begins and the ends alternate through the line, so each is
+    // appended in order on its own.
+    while (begins) {
+      begins_.push_back(static_cast<uint32_t>(i + __builtin_ctz(begins)));
+      begins &= begins - 1;
+    }
+    while (ends) {
+      ends_.push_back(static_cast<uint32_t>(i + __builtin_ctz(ends)));
+      ends &= ends - 1;
+    }
+  }
+  SplitScalar(i, size, carry != 0);
+}
+#endif
+
+bool ParseUint64(const char* begin, const char* end, uint64_t* value) {
+  size_t size = end - begin;
+  if (size > 0 && size <= 20 && AllDigits(begin, end)) {
+    if (size < 20) {
+      *value = DigitsToInt(begin, end);
+      return true;
+    }
+    uint64_t high = DigitsToInt(begin, end - 1);
+    uint64_t last = static_cast<uint64_t>(end[-1] - '0');
+    if (high > (std::numeric_limits<uint64_t>::max() - last) / 10) {
+      return false;
+    }
+    *value = high * 10 + last;
+    return true;
+  }
+  // The signs and the leading zeros beyond 20 digits are left to strtoull,
+  // the token is followed by a delimiter so it stops there.
+  if (size == 0) return false;
+  char* parsed = nullptr;
+  *value = strtoull(begin, &parsed, 10);
+  return parsed == end;
+}
+
+bool ParseFloat(const char* begin, const char* end, float* value) {
+  const char* p = begin;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  const char* int_end = p;
+  while (int_end < end && IsDigit(*int_end)) ++int_end;
+  const char* frac_begin = int_end;
+  const char* frac_end = int_end;
+  if (frac_begin < end && *frac_begin == '.') {
+    ++frac_begin;
+    frac_end = frac_begin;
+    while (frac_end < end && IsDigit(*frac_end)) ++frac_end;
+  }
+  int num_int = static_cast<int>(int_end - p);
+  int num_frac = static_cast<int>(frac_end - frac_begin);
+  if (frac_end == end && num_int + num_frac > 0 &&
+      num_int + num_frac <= kMaxFastFloatDigits) {
+    // The mantissa and the power of 10 are exact in a double, so the
+    // quotient is rounded once before the narrowing to float.
+    uint64_t mantissa = DigitsToInt(p, int_end);
+    for (const char* q = frac_begin; q < frac_end; ++q) {
+      mantissa = mantissa * 10 + static_cast<uint64_t>(*q - '0');
+    }
+    double result = static_cast<double>(mantissa) / kPow10[num_frac];
+    *value = static_cast<float>(negative ? -result : result);
+    return true;
+  }
+  if (begin == end) return false;
+  char* parsed = nullptr;
+  *value = strtof(begin, &parsed);
+  return parsed == end;
+}
+
+}  // namespace framework
+}  // namespace paddle
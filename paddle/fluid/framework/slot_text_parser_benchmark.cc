@@ -0,0 +1,142 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Compare the MultiSlot text parsing of the data feeds, strtoull/strtof over
+// the characters against SlotTextTokenizer with ParseUint64/ParseFloat, on
+// generated lines. Report the lines per second and the GB per second.
+
+#include <chrono>  // NOLINT
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/slot_text_parser.h"
+
+DEFINE_int32(lines, 100000, "The number of the generated lines.");
+DEFINE_int32(uint64_slots, 100, "The number of the uint64 slots.");
+DEFINE_int32(float_slots, 10, "The number of the float slots.");
+DEFINE_int32(feasigns, 3, "The max number of feasigns per slot.");
+DEFINE_int32(repeat, 5, "Repeat times.");
+
+namespace paddle {
+namespace framework {
+
+std::vector<std::string> GenerateLines() {
+  std::mt19937_64 rng(0);
+  std::vector<std::string> lines(FLAGS_lines);
+  for (auto& line : lines) {
+    for (int s = 0; s < FLAGS_uint64_slots + FLAGS_float_slots; ++s) {
+      int num = 1 + rng() % FLAGS_feasigns;
+      line += std::to_string(num);
+      for (int j = 0; j < num; ++j) {
+        line += ' ';
+        if (s < FLAGS_uint64_slots) {
+          line += std::to_string(rng() >> (rng() % 48));
+        } else {
+          line += std::to_string((rng() % 2000000) / 1000.0);
+        }
+      }
+      line += ' ';
+    }
+    line.pop_back();
+  }
+  return lines;
+}
+
+// The per line loop of MultiSlotDataFeed before the tokenizer.
+uint64_t ParseWithStrto(const std::string& line) {
+  const char* str = line.c_str();
+  char* endptr = const_cast<char*>(str);
+  uint64_t checksum = 0;
+  for (int s = 0; s < FLAGS_uint64_slots + FLAGS_float_slots; ++s) {
+    int num = strtol(endptr, &endptr, 10);
+    for (int j = 0; j < num; ++j) {
+      if (s < FLAGS_uint64_slots) {
+        checksum += strtoull(endptr, &endptr, 10);
+      } else {
+        checksum += static_cast<uint64_t>(strtof(endptr, &endptr));
+      }
+    }
+  }
+  return checksum;
+}
+
+uint64_t ParseWithTokenizer(const std::string& line,
+                            SlotTextTokenizer* tokenizer) {
+  tokenizer->Split(line.data(), line.size());
+  uint64_t checksum = 0;
+  size_t pos = 0;
+  for (int s = 0; s < FLAGS_uint64_slots + FLAGS_float_slots; ++s) {
+    uint64_t num = 0;
+    ParseUint64(tokenizer->begin(pos), tokenizer->end(pos), &num);
+    ++pos;
+    for (uint64_t j = 0; j < num; ++j, ++pos) {
+      if (s < FLAGS_uint64_slots) {
+        uint64_t value = 0;
+        ParseUint64(tokenizer->begin(pos), tokenizer->end(pos), &value);
+        checksum += value;
+      } else {
+        float value = 0;
+        ParseFloat(tokenizer->begin(pos), tokenizer->end(pos), &value);
+        checksum += static_cast<uint64_t>(value);
+      }
+    }
+  }
+  return checksum;
+}
+
+template <typename Parse>
+void Bench(const char* name, const std::vector<std::string>& lines,
+           size_t bytes, Parse parse) {
+  uint64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < FLAGS_repeat; ++r) {
+    for (auto& line : lines) {
+      checksum += parse(line);
+    }
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count() /
+                   FLAGS_repeat;
+  LOG(INFO) << name << ": " << lines.size() / seconds << " lines/s, "
+            << bytes / seconds / 1e9 << " GB/s, checksum " << checksum;
+}
+
+void RunBenchmark() {
+  auto lines = GenerateLines();
+  size_t bytes = 0;
+  for (auto& line : lines) bytes += line.size() + 1;
+  LOG(INFO) << lines.size() << " lines, " << bytes / lines.size()
+            << " bytes per line";
+  Bench("strtoull/strtof", lines, bytes,
+        [](const std::string& line) { return ParseWithStrto(line); });
+  SlotTextTokenizer tokenizer;
+  Bench("SlotTextTokenizer", lines, bytes, [&](const std::string& line) {
+    return ParseWithTokenizer(line, &tokenizer);
+  });
+}
+
+}  // namespace framework
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::framework::RunBenchmark();
+  return 0;
+}
@@ -0,0 +1,103 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/slot_text_parser.h"
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+
+TEST(SlotTextTokenizer, Split) {
+  std::mt19937 rng(0);
+  const char delimiters[] = {' ', '\t', '\n', '\0'};
+  SlotTextTokenizer tokenizer;
+  // Long lines, so the tokens cross the 32 bytes blocks of the AVX2 path.
+  for (int n = 0; n < 1000; ++n) {
+    std::string line;
+    std::vector<std::string> expected;
+    int num_tokens = rng() % 40;
+    for (int t = 0; t < num_tokens; ++t) {
+      int num_delimiters = (t == 0 ? 0 : 1) + rng() % 3;
+      for (int d = 0; d < num_delimiters; ++d) {
+        line += delimiters[rng() % 4];
+      }
+      std::string token;
+      int size = 1 + rng() % 40;
+      for (int c = 0; c < size; ++c) {
+        token += static_cast<char>('!' + rng() % 94);
+      }
+      expected.push_back(token);
+      line += token;
+    }
+    line += std::string(rng() % 3, ' ');
+    tokenizer.Split(line.data(), line.size());
+    ASSERT_EQ(tokenizer.size(), expected.size());
+    for (size_t t = 0; t < expected.size(); ++t) {
+      ASSERT_EQ(std::string(tokenizer.begin(t), tokenizer.end(t)),
+                expected[t]);
+    }
+  }
+}
+
+TEST(SlotTextParser, ParseUint64) {
+  std::mt19937_64 rng(0);
+  uint64_t value = 0;
+  for (int n = 0; n < 10000; ++n) {
+    uint64_t expected = rng() >> (rng() % 64);
+    std::string token = std::to_string(expected);
+    ASSERT_TRUE(ParseUint64(token.data(), token.data() + token.size(), &value));
+    ASSERT_EQ(value, expected);
+  }
+  std::string max = "18446744073709551615";
+  ASSERT_TRUE(ParseUint64(max.data(), max.data() + max.size(), &value));
+  ASSERT_EQ(value, 18446744073709551615ULL);
+  for (std::string token : {"18446744073709551616", "99999999999999999999",
+                            "12a", "1.5", ""}) {
+    ASSERT_FALSE(ParseUint64(token.data(), token.data() + token.size(), &value))
+        << token;
+  }
+}
+
+TEST(SlotTextParser, ParseFloat) {
+  std::mt19937 rng(0);
+  float value = 0;
+  char token[64];
+  for (int n = 0; n < 10000; ++n) {
+    double number = static_cast<double>(static_cast<int>(rng() % 2000001) -
+                                         1000000) /
+                    (1 + rng() % 1000);
+    int size = snprintf(token, sizeof(token), "%.*f",
+                        static_cast<int>(rng() % 8), number);
+    ASSERT_TRUE(ParseFloat(token, token + size, &value));
+    ASSERT_EQ(value, strtof(token, nullptr)) << token;
+  }
+  for (std::string token : {"1e-3", "-.5", "+2.", "inf", "0.000000000001"}) {
+    ASSERT_TRUE(ParseFloat(token.data(), token.data() + token.size(), &value))
+        << token;
+    ASSERT_EQ(value, strtof(token.c_str(), nullptr)) << token;
+  }
+  for (std::string token : {"abc", "1.5x", "-", ""}) {
+    ASSERT_FALSE(ParseFloat(token.data(), token.data() + token.size(), &value))
+        << token;
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
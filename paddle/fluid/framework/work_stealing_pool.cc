@@ -0,0 +1,124 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/work_stealing_pool.h"
+
+#include <utility>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+// The pool and the index of the worker running on this thread.
+struct CurrentWorker {
+  const WorkStealingPool* pool{nullptr};
+  int index{-1};
+};
+
+thread_local CurrentWorker current_worker;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(int num_threads,
+                                   std::function<void()> thread_init) {
+  PADDLE_ENFORCE_GT(num_threads, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of threads of WorkStealingPool should be "
+                        "greater than 0, but got %d.",
+                        num_threads));
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.emplace_back(new Worker);
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(&WorkStealingPool::Loop, this, i, thread_init);
+  }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingPool::Run(Task task) {
+  // Count the task before it is visible, so that a worker never sleeps while
+  // a task is queued.
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++num_tasks_;
+  }
+  if (current_worker.pool == this) {
+    auto& worker = *workers_[current_worker.index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.emplace_front(std::move(task));
+  } else {
+    auto& worker = *workers_[next_worker_++ % workers_.size()];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.emplace_back(std::move(task));
+  }
+  cv_.notify_one();
+}
+
+bool WorkStealingPool::Pop(int index, Task* task) {
+  auto& worker = *workers_[index];
+  std::lock_guard<std::mutex> lock(worker.mutex);
+  if (worker.tasks.empty()) return false;
+  *task = std::move(worker.tasks.front());
+  worker.tasks.pop_front();
+  return true;
+}
+
+bool WorkStealingPool::Steal(int index, Task* task) {
+  int num_workers = static_cast<int>(workers_.size());
+  for (int k = 1; k < num_workers; ++k) {
+    auto& victim = *workers_[(index + k) % num_workers];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (victim.tasks.empty()) continue;
+    *task = std::move(victim.tasks.back());
+    victim.tasks.pop_back();
+    return true;
+  }
+  return false;
+}
+
+void WorkStealingPool::Loop(int index,
+                            const std::function<void()>& thread_init) {
+  current_worker.pool = this;
+  current_worker.index = index;
+  if (thread_init) thread_init();
+  while (true) {
+    Task task;
+    if (Pop(index, &task) || Steal(index, &task)) {
+      --num_tasks_;
+      task();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return stop_ || num_tasks_ > 0; });
+    // The tasks queued before stopping are finished first.
+    if (stop_ && num_tasks_ == 0) break;
+  }
+  current_worker = CurrentWorker();
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,74 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+#include "paddle/fluid/platform/macros.h"  // for DISABLE_COPY_AND_ASSIGN
+
+namespace paddle {
+namespace framework {
+
+// WorkStealingPool runs tasks on a fixed number of threads, each of which
+// owns a deque of tasks. A task submitted by a worker goes to the front of
+// its own deque and is popped from there, so the successors of a task tend
+// to run on the thread that produced their inputs. An idle worker steals
+// from the back of the other deques. The tasks should not throw.
+class WorkStealingPool {
+ public:
+  using Task = std::function<void()>;
+
+  // `thread_init` is run once by every worker when it starts, e.g. to set
+  // the number of threads of the math library used inside the tasks.
+  explicit WorkStealingPool(int num_threads,
+                            std::function<void()> thread_init = nullptr);
+  ~WorkStealingPool();
+
+  // Submit a task, thread safe.
+  void Run(Task task);
+
+  int num_threads() const { return static_cast<int>(threads_.size()); }
+
+ private:
+  DISABLE_COPY_AND_ASSIGN(WorkStealingPool);
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void Loop(int index, const std::function<void()>& thread_init);
+  bool Pop(int index, Task* task);
+  bool Steal(int index, Task* task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> next_worker_{0};
+
+  // The number of the tasks in all the deques, the idle workers sleep on it.
+  std::atomic<int> num_tasks_{0};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_{false};
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,58 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <future>  // NOLINT
+
+#include "paddle/fluid/framework/work_stealing_pool.h"
+
+namespace framework = paddle::framework;
+
+// Every task spawns two children until the depth is reached, so most of the
+// tasks are submitted from inside the pool and stolen by the idle workers.
+void Spawn(framework::WorkStealingPool* pool, int depth,
+           std::atomic<int>* counter, std::promise<void>* done,
+           int num_tasks) {
+  if (++*counter == num_tasks) done->set_value();
+  if (depth == 0) return;
+  for (int i = 0; i < 2; ++i) {
+    pool->Run([=] { Spawn(pool, depth - 1, counter, done, num_tasks); });
+  }
+}
+
+TEST(WorkStealingPool, NestedTasks) {
+  const int depth = 12;
+  const int num_tasks = (1 << (depth + 1)) - 1;
+  std::atomic<int> counter(0);
+  std::promise<void> done;
+  std::atomic<int> num_inits(0);
+  framework::WorkStealingPool pool(4, [&num_inits] { ++num_inits; });
+  EXPECT_EQ(pool.num_threads(), 4);
+  pool.Run([&] { Spawn(&pool, depth, &counter, &done, num_tasks); });
+  done.get_future().wait();
+  EXPECT_EQ(counter, num_tasks);
+  EXPECT_EQ(num_inits, 4);
+}
+
+TEST(WorkStealingPool, DrainOnDestruction) {
+  std::atomic<int> counter(0);
+  {
+    framework::WorkStealingPool pool(2);
+    for (int i = 0; i < 1000; ++i) {
+      pool.Run([&counter] { ++counter; });
+    }
+  }
+  EXPECT_EQ(counter, 1000);
+}
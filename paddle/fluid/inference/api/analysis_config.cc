@@ -95,6 +95,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(model_dir_);
   CP_MEMBER(model_from_memory_);  // the memory model reuses prog_file_ and
                                   // params_file_ fields.
+  CP_MEMBER(params_sharing_enabled_);
+  CP_MEMBER(optim_program_cache_enabled_);
 
   CP_MEMBER(opt_cache_dir_);
   prog_file_ = std::move(other.prog_file_);
@@ -108,6 +110,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(memory_pool_init_size_mb_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(enable_memory_plan_);
+  CP_MEMBER(shape_cache_capacity_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -135,6 +139,7 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
 
   // profile related.
   CP_MEMBER(with_profile_);
+  CP_MEMBER(op_profile_enabled_);
 
   // glog related.
   CP_MEMBER(with_glog_info_);
@@ -143,9 +148,12 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(enable_ir_optim_);
   CP_MEMBER(use_feed_fetch_ops_);
   CP_MEMBER(ir_debug_);
+  CP_MEMBER(zero_copy_staging_enabled_);
+  CP_MEMBER(zero_copy_staging_reserve_bytes_);
   CP_MEMBER(specify_input_name_);
 
   CP_MEMBER(cpu_math_library_num_threads_);
+  CP_MEMBER(inter_op_num_threads_);
 
   CP_MEMBER(serialized_info_cache_);
 
@@ -357,7 +365,12 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << model_dir_;
   ss << prog_file_;
   ss << params_file_;
+  ss << SerializeInfoCacheWithoutPaths();
+  return ss.str();
+}
 
+std::string AnalysisConfig::SerializeInfoCacheWithoutPaths() const {
+  std::stringstream ss;
   ss << use_gpu_;
   ss << use_fc_padding_;
   ss << device_id_;
@@ -369,6 +382,8 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << tensorrt_min_subgraph_size_;
 
   ss << enable_memory_optim_;
+  ss << enable_memory_plan_;
+  ss << shape_cache_capacity_;
 
   ss << use_mkldnn_;
   ss << mkldnn_cache_capacity_;
@@ -377,17 +392,23 @@ std::string AnalysisConfig::SerializeInfoCache() {
 
   ss << use_mkldnn_quantizer_;
   ss << model_from_memory_;
+  ss << params_sharing_enabled_;
+  ss << optim_program_cache_enabled_;
 
   ss << with_profile_;
+  ss << op_profile_enabled_;
 
   ss << with_glog_info_;
 
   ss << enable_ir_optim_;
   ss << use_feed_fetch_ops_;
   ss << ir_debug_;
+  ss << zero_copy_staging_enabled_;
+  ss << zero_copy_staging_reserve_bytes_;
 
   ss << specify_input_name_;
   ss << cpu_math_library_num_threads_;
+  ss << inter_op_num_threads_;
 
   ss << use_lite_;
 
@@ -403,6 +424,17 @@ void AnalysisConfig::SetCpuMathLibraryNumThreads(
   Update();
 }
 
+void AnalysisConfig::SetInterOpNumThreads(int inter_op_num_threads) {
+  PADDLE_ENFORCE_GT(inter_op_num_threads, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of inter-op threads should be greater "
+                        "than 0, but got %d.",
+                        inter_op_num_threads));
+  inter_op_num_threads_ = inter_op_num_threads;
+
+  Update();
+}
+
 float AnalysisConfig::fraction_of_gpu_memory_for_pool() const {
 #ifdef PADDLE_WITH_CUDA
   // Get the GPU memory details and calculate the fraction of memory for the
@@ -428,6 +460,21 @@ bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
 
+void AnalysisConfig::EnableMemoryPlan() {
+  enable_memory_plan_ = true;
+  Update();
+}
+
+void AnalysisConfig::EnableShapeCache(int capacity) {
+  PADDLE_ENFORCE_GT(capacity, 0,
+                    platform::errors::InvalidArgument(
+                        "The shape cache capacity should be greater than 0, "
+                        "but got %d.",
+                        capacity));
+  shape_cache_capacity_ = capacity;
+  Update();
+}
+
 void AnalysisConfig::SetModelBuffer(const char *prog_buffer,
                                     size_t prog_buffer_size,
                                     const char *param_buffer,
@@ -439,6 +486,16 @@ void AnalysisConfig::SetModelBuffer(const char *prog_buffer,
   Update();
 }
 
+void AnalysisConfig::EnableParamsSharing() {
+  params_sharing_enabled_ = true;
+  Update();
+}
+
+void AnalysisConfig::EnableOptimProgramCache() {
+  optim_program_cache_enabled_ = true;
+  Update();
+}
+
 NativeConfig AnalysisConfig::ToNativeConfig() const {
   NativeConfig config;
   config.model_dir = model_dir_;
@@ -461,6 +518,17 @@ void AnalysisConfig::EnableProfile() {
   Update();
 }
 
+void AnalysisConfig::EnableZeroCopyStaging(size_t reserve_bytes) {
+  zero_copy_staging_enabled_ = true;
+  zero_copy_staging_reserve_bytes_ = reserve_bytes;
+  Update();
+}
+
+void AnalysisConfig::EnableOpProfile() {
+  op_profile_enabled_ = true;
+  Update();
+}
+
 void AnalysisConfig::DisableGlogInfo() {
   with_glog_info_ = false;
   Update();
@@ -14,17 +14,28 @@
 
 #include "paddle/fluid/inference/api/analysis_predictor.h"
 #include <glog/logging.h>
+#include <sys/stat.h>
 #include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <functional>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <random>
 #include <set>
+#include <sstream>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 #include "paddle/fluid/framework/feed_fetch_method.h"
 #include "paddle/fluid/framework/feed_fetch_type.h"
 #include "paddle/fluid/framework/ir/fuse_pass_base.h"
 #include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/mapped_params.h"
 #include "paddle/fluid/framework/naive_executor.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/var_type_traits.h"
@@ -39,6 +50,7 @@
 #include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/gpu_info.h"
+#include "paddle/fluid/platform/intra_op_thread_pool.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler.h"
 
@@ -143,6 +155,10 @@ bool AnalysisPredictor::Init(
 
   // no matter with or without MKLDNN
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  // The intra-op thread pool is shared by all the predictors, grow it once
+  // here instead of resizing it around every run.
+  paddle::platform::IntraOpThreadPool::Instance()->EnsureNumThreads(
+      config_.cpu_math_library_num_threads());
 
   if (!PrepareScope(parent_scope)) {
     return false;
@@ -162,6 +178,326 @@ bool AnalysisPredictor::Init(
   // Get the feed_target_names and fetch_target_names
   PrepareFeedFetch();
 
+  if (config_.zero_copy_staging_enabled_ &&
+      config_.zero_copy_staging_reserve_bytes_ > 0) {
+    // Reserve the staging buffers of the inputs, the first runs need not
+    // allocate them.
+    for (auto &item : idx2feeds_) {
+      auto *var = executor_->scope()->FindVar(item.second);
+      auto *var_desc = inference_program_->Block(0).FindVar(item.second);
+      if (var == nullptr || var_desc == nullptr) continue;
+      auto *tensor = var->GetMutable<framework::LoDTensor>();
+      tensor->Resize({0});
+      tensor->mutable_data(place_, var_desc->GetDataType(),
+                           config_.zero_copy_staging_reserve_bytes_);
+    }
+  }
+
+  if (config_.enable_memory_plan_ && config_.inter_op_num_threads_ > 1 &&
+      platform::is_cpu_place(place_)) {
+    LOG(WARNING) << "The memory plan is disabled since the operators run "
+                    "concurrently with "
+                 << config_.inter_op_num_threads_ << " inter-op threads.";
+  } else if (config_.enable_memory_plan_) {
+    // The feeds are written and the fetches are read by the user out of the
+    // run, they keep their own memory.
+    std::unordered_set<std::string> skip_vars;
+    for (auto &item : idx2feeds_) skip_vars.insert(item.second);
+    for (auto &item : idx2fetches_) skip_vars.insert(item.second);
+    executor_->EnableMemoryPlan(skip_vars);
+  }
+
+  return true;
+}
+
+namespace {
+
+// The process-wide store of the parameters shared by the predictors. It only
+// keeps weak references, the scope and the program are owned by the
+// predictors using them.
+class SharedParamsStore {
+ public:
+  struct Entry {
+    // Held while the first predictor loads the model, so that the others
+    // created concurrently wait for it instead of loading another copy.
+    std::mutex mutex;
+    std::weak_ptr<framework::Scope> scope;
+    std::weak_ptr<framework::ProgramDesc> program;
+  };
+
+  static SharedParamsStore &Instance() {
+    static SharedParamsStore store;
+    return store;
+  }
+
+  std::shared_ptr<Entry> Get(const std::string &key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Drop the entries whose predictors are all destroyed.
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->first != key && it->second.use_count() == 1 &&
+          it->second->scope.expired()) {
+        it = entries_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    auto &entry = entries_[key];
+    if (!entry) entry.reset(new Entry);
+    return entry;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<Entry>> entries_;
+};
+
+std::string FileIdentity(const std::string &path) {
+  struct stat st;
+  PADDLE_ENFORCE_EQ(stat(path.c_str(), &st), 0,
+                    platform::errors::NotFound("Cannot stat file %s.", path));
+  std::stringstream ss;
+  ss << st.st_dev << ":" << st.st_ino << ":" << st.st_size << ":"
+     << st.st_mtime;
+#ifdef __linux__
+  // A rewrite within the same second.
+  ss << "." << st.st_mtim.tv_nsec;
+#endif
+  return ss.str();
+}
+
+std::string ReadFile(const std::string &path) {
+  std::ifstream fin(path, std::ios::in | std::ios::binary);
+  PADDLE_ENFORCE_EQ(
+      static_cast<bool>(fin.is_open()), true,
+      platform::errors::NotFound("Cannot open file %s.", path));
+  return std::string(std::istreambuf_iterator<char>(fin),
+                     std::istreambuf_iterator<char>());
+}
+
+}  // namespace
+
+std::string AnalysisPredictor::ModelConfigKey() {
+  std::hash<std::string> hasher;
+  std::stringstream ss;
+  if (config_.model_from_memory()) {
+    ss << hasher(config_.prog_file()) << ":" << hasher(config_.params_file());
+  } else {
+    // Hashing the program is cheap, the parameters are identified by their
+    // files instead so that the later predictors do not read them at all.
+    std::string prog_file = config_.prog_file().empty()
+                                ? config_.model_dir() + "/__model__"
+                                : config_.prog_file();
+    std::string program = ReadFile(prog_file);
+    ss << hasher(program);
+    if (!config_.params_file().empty()) {
+      ss << ":" << FileIdentity(config_.params_file());
+    } else {
+      // Every parameter has its own file in the model directory. The
+      // directory itself is not identified, rewriting a file in place does
+      // not change it, while creating the optimization cache in it does.
+      framework::proto::ProgramDesc proto;
+      PADDLE_ENFORCE_EQ(proto.ParseFromString(program), true,
+                        platform::errors::InvalidArgument(
+                            "Cannot parse the program %s.", prog_file));
+      framework::ProgramDesc desc(proto);
+      std::vector<std::string> params;
+      for (auto *var : desc.Block(0).AllVars()) {
+        if (IsPersistable(var)) params.push_back(var->Name());
+      }
+      std::sort(params.begin(), params.end());
+      std::stringstream identity;
+      for (auto &param : params) {
+        identity << param << "@"
+                 << FileIdentity(config_.model_dir() + "/" + param) << ";";
+      }
+      ss << ":" << hasher(identity.str());
+    }
+  }
+
+  // The paths are left out of the config fingerprint, the model is already
+  // identified above.
+  ss << ":" << hasher(config_.SerializeInfoCacheWithoutPaths());
+
+  // The passes can be edited through the pass builder, which is not part of
+  // the fingerprint.
+  std::stringstream passes;
+  for (auto &pass : config_.pass_builder()->AllPasses()) passes << pass << ",";
+  passes << ";";
+  for (auto &pass : config_.pass_builder()->AnalysisPasses()) {
+    passes << pass << ",";
+  }
+  ss << ":" << hasher(passes.str());
+  return ss.str();
+}
+
+std::string AnalysisPredictor::OptimProgramCachePath(const std::string &key) {
+  if (config_.tensorrt_engine_enabled() || config_.lite_engine_enabled() ||
+      config_.mkldnn_quantizer_enabled()) {
+    LOG(WARNING) << "The optimized program is not cached with the subgraph "
+                    "engines or the MKLDNN quantizer.";
+    return "";
+  }
+  // Nothing to skip without the IR passes.
+  if (!config_.ir_optim()) return "";
+
+  std::string dir = config_.opt_cache_dir_;
+  if (dir.empty()) {
+    if (config_.model_from_memory()) {
+      LOG(WARNING) << "The optimized program of a model loaded from memory "
+                      "is only cached in the directory set by "
+                      "SetOptimCacheDir.";
+      return "";
+    }
+    dir = inference::analysis::GetOrCreateModelOptCacheDir(
+        config_.model_dir().empty()
+            ? inference::analysis::GetDirRoot(config_.prog_file())
+            : config_.model_dir());
+  } else if (!inference::analysis::PathExists(dir)) {
+    PADDLE_ENFORCE_NE(MKDIR(dir.c_str()), -1,
+                      platform::errors::Unavailable(
+                          "Cannot create the optimization cache directory %s, "
+                          "make sure you have the permission to write.",
+                          dir));
+  }
+  std::stringstream ss;
+  ss << dir << "/optim_" << std::hex << std::hash<std::string>()(key);
+  return ss.str();
+}
+
+bool AnalysisPredictor::LoadOptimProgramCache(const std::string &path,
+                                              const std::string &key) {
+  std::ifstream key_file(path + ".key", std::ios::in | std::ios::binary);
+  if (!key_file.is_open()) return false;
+  std::string cached_key((std::istreambuf_iterator<char>(key_file)),
+                         std::istreambuf_iterator<char>());
+  if (cached_key != key) {
+    LOG(WARNING) << "The optimized program cache " << path
+                 << " belongs to another model or config, ignore it.";
+    return false;
+  }
+
+  // Check the cache before touching the scope, a corrupt or truncated cache
+  // falls back to the cold start.
+  std::shared_ptr<framework::ProgramDesc> program;
+  try {
+    framework::proto::ProgramDesc proto;
+    PADDLE_ENFORCE_EQ(proto.ParseFromString(ReadFile(path + ".pdmodel")),
+                      true, platform::errors::InvalidArgument(
+                                "Cannot parse the cached program."));
+    program.reset(new framework::ProgramDesc(proto));
+    PADDLE_ENFORCE_EQ(
+        framework::IsMappedParamsFile(path + ".pdiparams"), true,
+        platform::errors::InvalidArgument(
+            "The cached parameters are not in the mapped params layout."));
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Ignore the optimized program cache " << path << ": "
+                 << e.what();
+    return false;
+  }
+
+  inference_program_ = program;
+  executor_->CreateVariables(*inference_program_, 0, true, sub_scope_);
+  try {
+    LoadParameters(path + ".pdiparams");
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Ignore the optimized program cache " << path << ": "
+                 << e.what();
+    // Drop the persistable variables of the cached program, the cold start
+    // creates and loads its own.
+    std::vector<std::string> names;
+    for (auto *var : inference_program_->Block(0).AllVars()) {
+      if (var->Persistable()) names.push_back(var->Name());
+    }
+    scope_->EraseVars(names);
+    inference_program_.reset();
+    return false;
+  }
+  config_.PartiallyRelease();
+  return true;
+}
+
+void AnalysisPredictor::SaveOptimProgramCache(const std::string &path,
+                                              const std::string &key) {
+  // Every file is written under a temporary name and renamed, the key file
+  // last, so a concurrent or an interrupted start never sees a partial
+  // cache.
+  std::string tmp_suffix = ".tmp" + std::to_string(std::random_device()());
+  auto write_file = [&](const std::string &name, const std::string &content) {
+    std::ofstream fout(path + name + tmp_suffix,
+                       std::ios::out | std::ios::binary);
+    fout << content;
+    fout.close();
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                      platform::errors::Unavailable(
+                          "Cannot write the cache file %s.", path + name));
+  };
+  auto commit_file = [&](const std::string &name) {
+    PADDLE_ENFORCE_EQ(
+        std::rename((path + name + tmp_suffix).c_str(), (path + name).c_str()),
+        0, platform::errors::Unavailable("Cannot rename the cache file %s.",
+                                         path + name));
+  };
+
+  try {
+    framework::ProgramDesc save_program;
+    auto *save_block = save_program.MutableBlock(0);
+    std::vector<std::string> save_var_list;
+    for (auto *var : inference_program_->Block(0).AllVars()) {
+      if (IsPersistable(var)) {
+        auto *new_var = save_block->Var(var->Name());
+        new_var->SetShape(var->GetShape());
+        new_var->SetDataType(var->GetDataType());
+        new_var->SetType(var->GetType());
+        new_var->SetLoDLevel(var->GetLoDLevel());
+        new_var->SetPersistable(true);
+        save_var_list.push_back(var->Name());
+      }
+    }
+    std::sort(save_var_list.begin(), save_var_list.end());
+    auto *op = save_block->AppendOp();
+    op->SetType("save_combine");
+    op->SetInput("X", save_var_list);
+    op->SetAttr("file_path", path + ".pdiparams" + tmp_suffix);
+    op->SetAttr("save_as_mapped", true);
+    op->CheckAttrs();
+    platform::CPUPlace place;
+    framework::Executor exe(place);
+    exe.Run(save_program, scope(), 0, true, true);
+
+    write_file(".pdmodel", GetSerializedProgram());
+    write_file(".key", key);
+    commit_file(".pdiparams");
+    commit_file(".pdmodel");
+    commit_file(".key");
+    LOG(INFO) << "Save the optimized program to the cache " << path;
+  } catch (const std::exception &e) {
+    LOG(WARNING) << "Failed to save the optimized program cache " << path
+                 << ": " << e.what();
+    for (auto name : {".pdiparams", ".pdmodel", ".key"}) {
+      std::remove((path + name + tmp_suffix).c_str());
+    }
+  }
+}
+
+bool AnalysisPredictor::InitWithSharedParams() {
+  if (config_.mkldnn_quantizer_enabled()) {
+    LOG(WARNING) << "The parameters quantized by the MKLDNN quantizer are "
+                    "not shared.";
+    return Init(nullptr);
+  }
+  auto entry = SharedParamsStore::Instance().Get(ModelConfigKey());
+  std::lock_guard<std::mutex> lock(entry->mutex);
+  auto scope = entry->scope.lock();
+  auto program = entry->program.lock();
+  if (scope && program) {
+    VLOG(3) << "Predictor " << predictor_id_ << " shares the parameters.";
+    return Init(scope, program);
+  }
+  if (!Init(nullptr)) {
+    return false;
+  }
+  entry->scope = scope_;
+  entry->program = inference_program_;
   return true;
 }
 
@@ -183,7 +519,16 @@ bool AnalysisPredictor::PrepareScope(
 }
 bool AnalysisPredictor::PrepareProgram(
     const std::shared_ptr<framework::ProgramDesc> &program) {
-  if (!program) {
+  std::string cache_key, cache_path;
+  if (!program && config_.optim_program_cache_enabled_) {
+    cache_key = ModelConfigKey();
+    cache_path = OptimProgramCachePath(cache_key);
+  }
+  if (!cache_path.empty() && LoadOptimProgramCache(cache_path, cache_key)) {
+    // The program and parameters are already optimized.
+    status_optim_program_cache_hit_ = true;
+    LOG(INFO) << "Load the optimized program from the cache " << cache_path;
+  } else if (!program) {
     if (!LoadProgramDesc()) return false;
     // If not cloned, the parameters should be loaded.
     // If config_.ir_optim() is True, parameters is loaded in
@@ -203,6 +548,9 @@ bool AnalysisPredictor::PrepareProgram(
     // the analysis pass(op fuse, graph analysis, trt subgraph, mkldnn etc) will
     // not be executed.
     OptimizeInferenceProgram();
+    if (!cache_path.empty()) {
+      SaveOptimProgramCache(cache_path, cache_key);
+    }
   } else {
     // If the program is passed from external, no need to optimize it, this
     // logic is used in the clone scenario.
@@ -238,6 +586,28 @@ bool AnalysisPredictor::PrepareExecutor() {
 
   PADDLE_ENFORCE_NOT_NULL(sub_scope_);
 
+  if (config_.shape_cache_capacity_ > 0) {
+    executor_->EnableShapeCache(config_.shape_cache_capacity_);
+  }
+
+  if (config_.op_profile_enabled_) {
+    executor_->EnableOpProfile();
+  }
+
+  if (config_.inter_op_num_threads_ > 1) {
+    if (platform::is_cpu_place(place_)) {
+      int intra_op_num_threads = config_.cpu_math_library_num_threads();
+      executor_->EnableInterOpParallel(
+          *inference_program_, config_.inter_op_num_threads_,
+          [intra_op_num_threads] {
+            paddle::platform::SetNumThreads(intra_op_num_threads);
+          });
+    } else {
+      LOG(WARNING) << "The inter-op parallelism is only supported on CPU, "
+                      "the operators run one by one.";
+    }
+  }
+
   return true;
 }
 
@@ -585,7 +955,10 @@ std::unique_ptr<PaddlePredictor> CreatePaddlePredictor<
   config.SetInValid();
   auto predictor_p = dynamic_cast<AnalysisPredictor *>(predictor.get());
 
-  if (!predictor_p->Init(nullptr)) {
+  bool init_ok = config.params_sharing_enabled()
+                     ? predictor_p->InitWithSharedParams()
+                     : predictor_p->Init(nullptr);
+  if (!init_ok) {
     return nullptr;
   }
 
@@ -673,6 +1046,7 @@ std::unique_ptr<ZeroCopyTensor> AnalysisPredictor::GetInputTensor(
   std::unique_ptr<ZeroCopyTensor> res(
       new ZeroCopyTensor(static_cast<void *>(executor_->scope())));
   res->input_or_output_ = true;
+  res->staging_ = config_.zero_copy_staging_enabled_;
   res->SetName(name);
   if (platform::is_cpu_place(place_)) {
     res->SetPlace(PaddlePlace::kCPU);
@@ -765,7 +1139,7 @@ bool AnalysisPredictor::LoadProgramDesc() {
   return true;
 }
 
-bool AnalysisPredictor::LoadParameters() {
+bool AnalysisPredictor::LoadParameters(const std::string &params_file) {
   PADDLE_ENFORCE_NOT_NULL(inference_program_.get(),
                           "The inference program should be loaded first.");
 
@@ -789,7 +1163,7 @@ bool AnalysisPredictor::LoadParameters() {
       new_var->SetLoDLevel(var->GetLoDLevel());
       new_var->SetPersistable(true);
 
-      if (!config_.params_file().empty()) {
+      if (!params_file.empty()) {
         params.push_back(new_var->Name());
       } else {
         // append_op
@@ -802,14 +1176,14 @@ bool AnalysisPredictor::LoadParameters() {
     }
   }
 
-  if (!config_.params_file().empty()) {
+  if (!params_file.empty()) {
     // sort paramlist to have consistent ordering
     std::sort(params.begin(), params.end());
     // append just the load_combine op
     framework::OpDesc *op = load_block->AppendOp();
     op->SetType("load_combine");
     op->SetOutput("Out", params);
-    op->SetAttr("file_path", {config_.params_file()});
+    op->SetAttr("file_path", {params_file});
     op->CheckAttrs();
   }
 
@@ -906,6 +1280,53 @@ std::unique_ptr<PaddlePredictor> AnalysisPredictor::Clone() {
   return std::unique_ptr<PaddlePredictor>(x);
 }
 
+bool AnalysisPredictor::GetOpProfile(PaddleProfile *profile, bool reset) {
+  PADDLE_ENFORCE_NOT_NULL(profile, platform::errors::InvalidArgument(
+                                       "The profile should not be null."));
+  *profile = PaddleProfile();
+  if (!executor_->op_profile_enabled()) return false;
+
+  auto records = executor_->GetOpProfile(reset, &profile->num_runs);
+  for (auto bound : framework::NaiveExecutor::OpProfileBucketBounds()) {
+    profile->bucket_bounds_us.push_back(bound / 1000.);
+  }
+  std::map<std::string, size_t> type_ids;
+  for (size_t i = 0; i < records.size(); ++i) {
+    auto &record = records[i];
+    PaddleOpProfile op;
+    op.type = record.type;
+    op.index = static_cast<int>(i);
+    op.calls = record.calls;
+    op.total_us = record.total_ns / 1000.;
+    op.min_us = record.min_ns / 1000.;
+    op.max_us = record.max_ns / 1000.;
+    op.alloc_bytes = record.alloc_bytes;
+    op.latency_histogram = record.histogram;
+
+    auto iter = type_ids.find(op.type);
+    if (iter == type_ids.end()) {
+      type_ids.emplace(op.type, profile->op_types.size());
+      profile->op_types.push_back(op);
+      profile->op_types.back().index = -1;
+    } else {
+      auto &type = profile->op_types[iter->second];
+      if (op.calls > 0) {
+        type.min_us = type.calls > 0 ? std::min(type.min_us, op.min_us)
+                                     : op.min_us;
+      }
+      type.calls += op.calls;
+      type.total_us += op.total_us;
+      type.max_us = std::max(type.max_us, op.max_us);
+      type.alloc_bytes += op.alloc_bytes;
+      for (size_t k = 0; k < op.latency_histogram.size(); ++k) {
+        type.latency_histogram[k] += op.latency_histogram[k];
+      }
+    }
+    profile->op_instances.emplace_back(std::move(op));
+  }
+  return true;
+}
+
 std::string AnalysisPredictor::GetSerializedProgram() const {
   return inference_program_->Proto()->SerializeAsString();
 }
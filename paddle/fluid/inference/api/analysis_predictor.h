@@ -108,6 +108,15 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   bool Init(const std::shared_ptr<framework::Scope> &parent_scope,
             const std::shared_ptr<framework::ProgramDesc> &program = nullptr);
+  ///
+  /// \brief Initialize predictor with the parameters shared by the other
+  /// predictors of the same model and config in this process, see
+  /// AnalysisConfig::EnableParamsSharing. The first one loads the model and
+  /// the later ones are initialized like clones of it.
+  ///
+  /// \return Whether the init function executed successfully
+  ///
+  bool InitWithSharedParams();
 
   ///
   /// \brief Run the prediction engine. Deprecated. Please refer to ZeroCopyRun
@@ -212,6 +221,26 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   framework::ProgramDesc &program() { return *inference_program_; }
 
+  ///
+  /// \brief Get the statistics of the static memory plan, enabled by
+  /// AnalysisConfig::EnableMemoryPlan
+  ///
+  /// \return the arena size and the tensor bytes planned into it
+  ///
+  const framework::MemoryPlanStats &memory_plan_stats() const {
+    return executor_->memory_plan_stats();
+  }
+
+  ///
+  /// \brief Get the operator profile, enabled by
+  /// AnalysisConfig::EnableOpProfile
+  ///
+  /// \param[out] profile the profile since the last reset
+  /// \param[in] reset whether to start a new window
+  /// \return whether the operator profile is enabled
+  ///
+  bool GetOpProfile(PaddleProfile *profile, bool reset = false) override;
+
   ///
   /// \brief Get the serialized program
   ///
@@ -262,6 +291,39 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   bool PrepareExecutor();
 
+  ///
+  /// \brief The key of the optimized model of this predictor, made of the
+  /// model program content, the identity of the parameter files, the pass
+  /// list and the config fingerprint. It keys the shared parameters and the
+  /// optimized program cache.
+  ///
+  /// \return the key
+  ///
+  std::string ModelConfigKey();
+  ///
+  /// \brief The path prefix of the optimized program cache files of this
+  /// predictor.
+  ///
+  /// \param[in] key the model config key
+  /// \return the path prefix, empty if the cache does not apply
+  ///
+  std::string OptimProgramCachePath(const std::string &key);
+  ///
+  /// \brief Load the optimized program and parameters from the cache.
+  ///
+  /// \param[in] path the path prefix of the cache files
+  /// \param[in] key the model config key stored in the cache
+  /// \return Whether the cache is hit and loaded
+  ///
+  bool LoadOptimProgramCache(const std::string &path, const std::string &key);
+  ///
+  /// \brief Save the optimized program and parameters to the cache.
+  ///
+  /// \param[in] path the path prefix of the cache files
+  /// \param[in] key the model config key stored in the cache
+  ///
+  void SaveOptimProgramCache(const std::string &path, const std::string &key);
+
   ///
   /// \brief Load model program.
   ///
@@ -269,11 +331,13 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   bool LoadProgramDesc();
   ///
-  /// \brief Load model parameters.
+  /// \brief Load the persistable variables of the inference program.
   ///
+  /// \param[in] params_file the combined parameter file, or empty to load
+  /// the separate files in the model directory
   /// \return Whether the function executed successfully
   ///
-  bool LoadParameters();
+  bool LoadParameters(const std::string &params_file);
 
   ///
   /// \brief Prepare input data, only used in Run()
@@ -350,6 +414,7 @@ class AnalysisPredictor : public PaddlePredictor {
   FRIEND_TEST(AnalysisPredictor, analysis_off);
   FRIEND_TEST(AnalysisPredictor, analysis_on);
   FRIEND_TEST(AnalysisPredictor, with_gpu);
+  FRIEND_TEST(AnalysisPredictor, OptimProgramCache);
 #endif
 
  private:
@@ -395,6 +460,7 @@ class AnalysisPredictor : public PaddlePredictor {
   // Some status here that help to determine the status inside the predictor.
   bool status_is_cloned_{false};
   bool status_use_gpu_{false};
+  bool status_optim_program_cache_hit_{false};
 };
 
 }  // namespace paddle
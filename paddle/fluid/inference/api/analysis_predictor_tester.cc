@@ -15,6 +15,8 @@
 #include "paddle/fluid/inference/api/analysis_predictor.h"
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <cstdlib>
+#include <future>  // NOLINT
 #include <thread>  // NOLINT
 #include "paddle/fluid/framework/ir/pass.h"
 #include "paddle/fluid/framework/tensor.h"
@@ -137,6 +139,60 @@ TEST(AnalysisPredictor, ZeroCopy) {
   LOG(INFO) << "output_data: " << out_data;
 }
 
+TEST(AnalysisPredictor, ZeroCopyStaging) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.SwitchUseFeedFetchOps(false);
+  config.EnableZeroCopyStaging(8 * sizeof(int64_t));
+  auto predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  std::vector<std::string> names = {"firstw", "secondw", "thirdw", "forthw"};
+
+  // The reserved buffers are reused by the batches fitting them.
+  std::vector<int64_t*> buffers;
+  for (int batch : {4, 8, 2}) {
+    for (size_t i = 0; i < names.size(); ++i) {
+      auto input = predictor->GetInputTensor(names[i]);
+      input->Reshape({batch, 1});
+      auto* data = input->mutable_data<int64_t>(PaddlePlace::kCPU);
+      for (int j = 0; j < batch; ++j) data[j] = j;
+      if (buffers.size() < names.size()) buffers.push_back(data);
+      ASSERT_EQ(data, buffers[i]);
+    }
+    ASSERT_TRUE(predictor->ZeroCopyRun());
+  }
+
+  // A bigger batch grows the buffers, the smaller ones reuse them.
+  std::vector<int64_t> host(32, 1);
+  for (int batch : {32, 16}) {
+    for (size_t i = 0; i < names.size(); ++i) {
+      auto input = predictor->GetInputTensor(names[i]);
+      input->Reshape({batch, 1});
+      input->copy_from_cpu(host.data());
+    }
+    ASSERT_TRUE(predictor->ZeroCopyRun());
+  }
+
+  // The external buffers are released when they are replaced.
+  int num_deleted = 0;
+  for (auto& name : names) {
+    auto input = predictor->GetInputTensor(name);
+    auto* data = new int64_t[4]{0, 1, 2, 3};
+    input->ShareExternalData(data, {4, 1}, [&num_deleted](void* ptr) {
+      delete[] static_cast<int64_t*>(ptr);
+      ++num_deleted;
+    });
+  }
+  ASSERT_TRUE(predictor->ZeroCopyRun());
+  ASSERT_EQ(num_deleted, 0);
+  for (auto& name : names) {
+    auto input = predictor->GetInputTensor(name);
+    input->Reshape({4, 1});
+    input->copy_from_cpu(host.data());
+  }
+  ASSERT_EQ(num_deleted, 4);
+  ASSERT_TRUE(predictor->ZeroCopyRun());
+}
+
 TEST(AnalysisPredictor, Clone) {
   AnalysisConfig config;
   config.SetModel(FLAGS_dirname);
@@ -193,6 +249,175 @@ TEST(AnalysisPredictor, Clone) {
   }
 }
 
+TEST(AnalysisPredictor, ParamsSharing) {
+  AnalysisConfig config0, config1, config2;
+  for (auto* config : {&config0, &config1, &config2}) {
+    config->SetModel(FLAGS_dirname);
+    config->EnableParamsSharing();
+  }
+  config2.SwitchIrOptim(false);
+
+  auto predictor0 = CreatePaddlePredictor(config0);
+  auto predictor1 = CreatePaddlePredictor(config1);
+  auto predictor2 = CreatePaddlePredictor(config2);
+  auto* scope0 = static_cast<AnalysisPredictor*>(predictor0.get())->scope();
+  auto* scope1 = static_cast<AnalysisPredictor*>(predictor1.get())->scope();
+  auto* scope2 = static_cast<AnalysisPredictor*>(predictor2.get())->scope();
+  // The same model and config share one parameter scope, a different config
+  // is optimized by other passes and loads its own.
+  ASSERT_EQ(scope0, scope1);
+  ASSERT_NE(scope0, scope2);
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+
+  std::vector<PaddleTensor> inputs(4, tensor);
+  std::vector<PaddleTensor> outputs0, outputs1;
+  ASSERT_TRUE(predictor0->Run(inputs, &outputs0));
+  predictor0.reset();
+  // The parameters outlive the predictor which loaded them.
+  ASSERT_TRUE(predictor1->Run(inputs, &outputs1));
+  inference::CompareResult(outputs0, outputs1);
+}
+
+TEST(AnalysisPredictor, OptimProgramCache) {
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+
+  // The first predictor optimizes the model and fills the cache, the second
+  // one loads the optimized program and parameters from it.
+  const std::string cache_dir = "./optim_program_cache";
+  ASSERT_EQ(std::system(("rm -rf " + cache_dir).c_str()), 0);
+  std::vector<std::string> programs;
+  std::vector<std::vector<PaddleTensor>> outputs(2);
+  for (int i = 0; i < 2; ++i) {
+    AnalysisConfig config;
+    config.SetModel(FLAGS_dirname);
+    config.DisableGpu();
+    config.SetOptimCacheDir(cache_dir);
+    config.EnableOptimProgramCache();
+    auto predictor = CreatePaddlePredictor(config);
+    auto* analysis_predictor = static_cast<AnalysisPredictor*>(predictor.get());
+    ASSERT_EQ(analysis_predictor->status_optim_program_cache_hit_, i == 1);
+    programs.push_back(predictor->GetSerializedProgram());
+    ASSERT_TRUE(predictor->Run(inputs, &outputs[i]));
+  }
+  ASSERT_EQ(programs[0], programs[1]);
+  inference::CompareResult(outputs[0], outputs[1]);
+
+  // A truncated cache falls back to the cold start.
+  ASSERT_EQ(std::system(("for f in " + cache_dir + "/*.pdiparams; do "
+                         "truncate -s 64 $f; done")
+                            .c_str()),
+            0);
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  config.SetOptimCacheDir(cache_dir);
+  config.EnableOptimProgramCache();
+  auto predictor = CreatePaddlePredictor(config);
+  ASSERT_FALSE(static_cast<AnalysisPredictor*>(predictor.get())
+                   ->status_optim_program_cache_hit_);
+  std::vector<PaddleTensor> cold_outputs;
+  ASSERT_TRUE(predictor->Run(inputs, &cold_outputs));
+  inference::CompareResult(outputs[0], cold_outputs);
+}
+
+TEST(AnalysisPredictor, OpProfile) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  config.EnableOpProfile();
+  auto predictor = CreatePaddlePredictor(config);
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+  std::vector<PaddleTensor> outputs;
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(predictor->Run(inputs, &outputs));
+  }
+
+  PaddleProfile profile;
+  ASSERT_TRUE(predictor->GetOpProfile(&profile, true));
+  EXPECT_EQ(profile.num_runs, 3);
+  ASSERT_FALSE(profile.op_instances.empty());
+  ASSERT_FALSE(profile.op_types.empty());
+  int64_t instance_calls = 0;
+  for (auto& op : profile.op_instances) {
+    EXPECT_EQ(op.calls, 3);
+    EXPECT_EQ(op.latency_histogram.size(),
+              profile.bucket_bounds_us.size() + 1);
+    instance_calls += op.calls;
+  }
+  int64_t type_calls = 0;
+  for (auto& op : profile.op_types) {
+    EXPECT_EQ(op.index, -1);
+    type_calls += op.calls;
+  }
+  EXPECT_EQ(type_calls, instance_calls);
+
+  ASSERT_TRUE(predictor->GetOpProfile(&profile));
+  EXPECT_EQ(profile.num_runs, 0);
+  EXPECT_EQ(profile.op_instances.front().calls, 0);
+}
+
+TEST(AnalysisPredictor, AsyncRun) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  auto predictor = CreatePaddlePredictor(config);
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+  std::vector<PaddleTensor> ref_outputs;
+  ASSERT_TRUE(predictor->Run(inputs, &ref_outputs));
+
+  AsyncPredictor async_predictor(std::move(predictor), 2);
+  ASSERT_EQ(async_predictor.num_workers(), 2);
+  const int num_requests = 8;
+  std::vector<std::vector<PaddleTensor>> outputs(num_requests);
+  std::vector<std::future<bool>> futures;
+  for (int i = 0; i < num_requests; ++i) {
+    futures.emplace_back(async_predictor.RunAsync(inputs, &outputs[i]));
+  }
+  for (int i = 0; i < num_requests; ++i) {
+    ASSERT_TRUE(futures[i].get());
+    inference::CompareResult(outputs[i], ref_outputs);
+  }
+
+  std::promise<std::vector<PaddleTensor>> callback_outputs;
+  async_predictor.RunAsync(
+      inputs, [&](bool success, std::vector<PaddleTensor>* outputs) {
+        EXPECT_TRUE(success);
+        callback_outputs.set_value(std::move(*outputs));
+      });
+  inference::CompareResult(callback_outputs.get_future().get(), ref_outputs);
+
+  // A failed task is reported through the future, the worker goes on.
+  auto failed = async_predictor.Submit([](PaddlePredictor* predictor) {
+    predictor->GetInputTensor("not_exist_input");
+    return true;
+  });
+  ASSERT_FALSE(failed.get());
+  std::vector<PaddleTensor> last_outputs;
+  ASSERT_TRUE(async_predictor.RunAsync(inputs, &last_outputs).get());
+}
+
 // This function is not released yet, will fail on some machine.
 // TODO(Superjomn) Turn on it latter.
 /*
@@ -27,6 +27,7 @@ limitations under the License. */
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/memory/memcpy.h"
 #include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/intra_op_thread_pool.h"
 #include "paddle/fluid/platform/profiler.h"
 
 DEFINE_bool(profile, false, "Turn on profiler for fluid");
@@ -76,6 +77,10 @@ bool NativePaddlePredictor::Init(
 
   // no matter with or without MKLDNN
   paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  // The intra-op thread pool is shared by all the predictors, grow it once
+  // here instead of resizing it around every run.
+  paddle::platform::IntraOpThreadPool::Instance()->EnsureNumThreads(
+      config_.cpu_math_library_num_threads());
 
   if (config_.use_gpu) {
     place_ = paddle::platform::CUDAPlace(config_.device);
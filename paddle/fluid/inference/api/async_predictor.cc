@@ -0,0 +1,126 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <utility>
+
+#include "paddle/fluid/inference/api/paddle_async_predictor.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+
+AsyncPredictor::AsyncPredictor(std::unique_ptr<PaddlePredictor> predictor,
+                               int num_workers) {
+  PADDLE_ENFORCE_NOT_NULL(predictor,
+                          platform::errors::InvalidArgument(
+                              "The predictor of AsyncPredictor is null."));
+  PADDLE_ENFORCE_GT(num_workers, 0,
+                    platform::errors::InvalidArgument(
+                        "num_workers should be greater than 0, but got %d.",
+                        num_workers));
+  predictors_.emplace_back(std::move(predictor));
+  for (int i = 1; i < num_workers; ++i) {
+    predictors_.emplace_back(predictors_.front()->Clone());
+  }
+  for (auto &p : predictors_) {
+    workers_.emplace_back(&AsyncPredictor::WorkerLoop, this, p.get());
+  }
+}
+
+AsyncPredictor::~AsyncPredictor() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+std::future<bool> AsyncPredictor::Submit(Task task) {
+  PADDLE_ENFORCE_EQ(static_cast<bool>(task), true,
+                    platform::errors::InvalidArgument(
+                        "The task submitted to AsyncPredictor is empty."));
+  auto done = std::make_shared<std::promise<bool>>();
+  auto future = done->get_future();
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    PADDLE_ENFORCE_EQ(stop_, false,
+                      platform::errors::PreconditionNotMet(
+                          "AsyncPredictor is stopped."));
+    queue_.emplace_back([task, done](PaddlePredictor *predictor) {
+      bool success = false;
+      try {
+        success = task(predictor);
+      } catch (const std::exception &e) {
+        LOG(ERROR) << "AsyncPredictor failed to run a task: " << e.what();
+      }
+      done->set_value(success);
+    });
+  }
+  queue_cv_.notify_one();
+  return future;
+}
+
+std::future<bool> AsyncPredictor::RunAsync(
+    const std::vector<PaddleTensor> &inputs,
+    std::vector<PaddleTensor> *outputs) {
+  PADDLE_ENFORCE_NOT_NULL(outputs, platform::errors::InvalidArgument(
+                                       "The outputs should not be null."));
+  return Submit([inputs, outputs](PaddlePredictor *predictor) {
+    return predictor->Run(inputs, outputs);
+  });
+}
+
+void AsyncPredictor::RunAsync(const std::vector<PaddleTensor> &inputs,
+                              Callback done) {
+  PADDLE_ENFORCE_EQ(static_cast<bool>(done), true,
+                    platform::errors::InvalidArgument(
+                        "The callback of AsyncPredictor should be set."));
+  // The callback is invoked inside the task, the future is not needed.
+  Submit([inputs, done](PaddlePredictor *predictor) {
+    std::vector<PaddleTensor> outputs;
+    bool success = false;
+    try {
+      success = predictor->Run(inputs, &outputs);
+    } catch (const std::exception &e) {
+      LOG(ERROR) << "AsyncPredictor failed to run a request: " << e.what();
+    }
+    done(success, &outputs);
+    return success;
+  });
+}
+
+size_t AsyncPredictor::num_pending() const {
+  std::lock_guard<std::mutex> lock(queue_mutex_);
+  return queue_.size();
+}
+
+void AsyncPredictor::WorkerLoop(PaddlePredictor *predictor) {
+  while (true) {
+    std::function<void(PaddlePredictor *)> task;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      // Finish the submitted requests before stopping.
+      if (queue_.empty()) return;
+      task = std::move(queue_.front());
+      queue_.pop_front();
+    }
+    task(predictor);
+  }
+}
+
+}  // namespace paddle
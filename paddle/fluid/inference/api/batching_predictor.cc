@@ -0,0 +1,381 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <future>  // NOLINT
+#include <utility>
+
+#include "paddle/fluid/inference/api/paddle_batching_predictor.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+
+struct BatchingPredictor::Request {
+  const std::vector<PaddleTensor> *inputs{nullptr};
+  std::vector<PaddleTensor> *outputs{nullptr};
+  // Number of sequences for LoD inputs, number of rows otherwise.
+  size_t batch_size{0};
+  // Number of rows of the first input.
+  size_t num_rows{0};
+  std::chrono::steady_clock::time_point arrive_time;
+  std::promise<bool> done;
+};
+
+namespace {
+
+bool HasLoD(const PaddleTensor &tensor) {
+  return !tensor.lod.empty() && !tensor.lod[0].empty();
+}
+
+size_t NumRows(const PaddleTensor &tensor) {
+  return tensor.shape.empty() ? 0 : static_cast<size_t>(tensor.shape[0]);
+}
+
+size_t BatchSizeOf(const PaddleTensor &tensor) {
+  return HasLoD(tensor) ? tensor.lod[0].size() - 1 : NumRows(tensor);
+}
+
+// Two requests can be merged if every input only differs in the batch dim.
+bool CanMerge(const std::vector<PaddleTensor> &a,
+              const std::vector<PaddleTensor> &b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].name != b[i].name || a[i].dtype != b[i].dtype ||
+        a[i].shape.size() != b[i].shape.size() ||
+        a[i].lod.size() != b[i].lod.size() || a[i].shape.empty()) {
+      return false;
+    }
+    for (size_t d = 1; d < a[i].shape.size(); ++d) {
+      if (a[i].shape[d] != b[i].shape[d]) return false;
+    }
+  }
+  return true;
+}
+
+void CopyFromCpu(ZeroCopyTensor *tensor, PaddleDType dtype, const void *data) {
+  switch (dtype) {
+    case PaddleDType::FLOAT32:
+      tensor->copy_from_cpu(static_cast<const float *>(data));
+      break;
+    case PaddleDType::INT64:
+      tensor->copy_from_cpu(static_cast<const int64_t *>(data));
+      break;
+    case PaddleDType::INT32:
+      tensor->copy_from_cpu(static_cast<const int32_t *>(data));
+      break;
+    case PaddleDType::UINT8:
+      tensor->copy_from_cpu(static_cast<const uint8_t *>(data));
+      break;
+    default:
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Unsupported data type %d in BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+void CopyToCpu(ZeroCopyTensor *tensor, PaddleDType dtype, void *data) {
+  switch (dtype) {
+    case PaddleDType::FLOAT32:
+      tensor->copy_to_cpu(static_cast<float *>(data));
+      break;
+    case PaddleDType::INT64:
+      tensor->copy_to_cpu(static_cast<int64_t *>(data));
+      break;
+    case PaddleDType::INT32:
+      tensor->copy_to_cpu(static_cast<int32_t *>(data));
+      break;
+    case PaddleDType::UINT8:
+      tensor->copy_to_cpu(static_cast<uint8_t *>(data));
+      break;
+    default:
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Unsupported data type %d in BatchingPredictor.",
+          static_cast<int>(dtype)));
+  }
+}
+
+void SliceOutput(const std::string &name, const std::vector<int> &shape,
+                 PaddleDType dtype, const char *data, size_t row_bytes,
+                 size_t num_rows, std::vector<std::vector<size_t>> lod,
+                 PaddleTensor *out) {
+  out->name = name;
+  out->shape = shape;
+  out->shape[0] = static_cast<int>(num_rows);
+  out->dtype = dtype;
+  out->lod = std::move(lod);
+  out->data.Resize(num_rows * row_bytes);
+  if (num_rows * row_bytes > 0) {
+    std::memcpy(out->data.data(), data, num_rows * row_bytes);
+  }
+}
+
+}  // namespace
+
+BatchingPredictor::BatchingPredictor(std::unique_ptr<PaddlePredictor> predictor,
+                                     const BatchingConfig &config)
+    : config_(config) {
+  PADDLE_ENFORCE_NOT_NULL(predictor,
+                          platform::errors::InvalidArgument(
+                              "The predictor of BatchingPredictor is null."));
+  PADDLE_ENFORCE_GT(config_.max_batch_size, 0,
+                    platform::errors::InvalidArgument(
+                        "max_batch_size should be greater than 0, but got %d.",
+                        config_.max_batch_size));
+  PADDLE_ENFORCE_GT(config_.num_workers, 0,
+                    platform::errors::InvalidArgument(
+                        "num_workers should be greater than 0, but got %d.",
+                        config_.num_workers));
+  input_names_ = predictor->GetInputNames();
+  output_names_ = predictor->GetOutputNames();
+  predictors_.emplace_back(std::move(predictor));
+  for (int i = 1; i < config_.num_workers; ++i) {
+    predictors_.emplace_back(predictors_.front()->Clone());
+  }
+  for (auto &p : predictors_) {
+    workers_.emplace_back(&BatchingPredictor::WorkerLoop, this, p.get());
+  }
+}
+
+BatchingPredictor::~BatchingPredictor() {
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stop_ = true;
+  }
+  queue_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+bool BatchingPredictor::Run(const std::vector<PaddleTensor> &inputs,
+                            std::vector<PaddleTensor> *outputs) {
+  PADDLE_ENFORCE_NOT_NULL(outputs, platform::errors::InvalidArgument(
+                                       "The outputs should not be null."));
+  PADDLE_ENFORCE_EQ(
+      inputs.size(), input_names_.size(),
+      platform::errors::InvalidArgument(
+          "The model has %d inputs, but the request provides %d.",
+          input_names_.size(), inputs.size()));
+  // The requests are merged along the first dim of the inputs.
+  PADDLE_ENFORCE_EQ(inputs.empty(), false,
+                    platform::errors::InvalidArgument(
+                        "The BatchingPredictor needs a model with inputs, "
+                        "but the request has none."));
+  for (auto &input : inputs) {
+    PADDLE_ENFORCE_EQ(
+        input.shape.empty(), false,
+        platform::errors::InvalidArgument(
+            "The input %s of a request should have the batch dim, but its "
+            "shape is empty.",
+            input.name));
+  }
+  Request req;
+  req.inputs = &inputs;
+  req.outputs = outputs;
+  req.batch_size = BatchSizeOf(inputs.front());
+  req.num_rows = NumRows(inputs.front());
+  for (auto &input : inputs) {
+    PADDLE_ENFORCE_EQ(BatchSizeOf(input), req.batch_size,
+                      platform::errors::InvalidArgument(
+                          "All the inputs of a request should have the same "
+                          "batch size, but input %s has %d, expected %d.",
+                          input.name, BatchSizeOf(input), req.batch_size));
+  }
+  req.arrive_time = std::chrono::steady_clock::now();
+  auto done = req.done.get_future();
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    PADDLE_ENFORCE_EQ(stop_, false,
+                      platform::errors::PreconditionNotMet(
+                          "The BatchingPredictor has been stopped."));
+    queue_.push_back(&req);
+  }
+  queue_cv_.notify_one();
+  return done.get();
+}
+
+void BatchingPredictor::WorkerLoop(PaddlePredictor *predictor) {
+  std::vector<Request *> batch;
+  while (true) {
+    batch.clear();
+    CollectBatch(&batch);
+    if (batch.empty()) return;
+
+    bool success = false;
+    try {
+      success = RunBatch(predictor, batch);
+    } catch (const std::exception &e) {
+      LOG(ERROR) << "BatchingPredictor failed to run a batch of "
+                 << batch.size() << " requests: " << e.what();
+    }
+    ++num_batches_;
+    num_requests_ += batch.size();
+    for (auto *req : batch) {
+      req->done.set_value(success);
+    }
+  }
+}
+
+void BatchingPredictor::CollectBatch(std::vector<Request *> *batch) {
+  std::lock_guard<std::mutex> collect_guard(collect_mutex_);
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  queue_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+  if (queue_.empty()) return;
+
+  const size_t max_batch_size = static_cast<size_t>(config_.max_batch_size);
+  auto deadline = queue_.front()->arrive_time +
+                  std::chrono::microseconds(config_.batch_timeout_us);
+  size_t batch_size = 0;
+  while (true) {
+    while (!queue_.empty()) {
+      Request *req = queue_.front();
+      // Leave the request to the next batch if it overflows the current one
+      // or has a different shape.
+      if (!batch->empty() &&
+          (batch_size + req->batch_size > max_batch_size ||
+           !CanMerge(*batch->front()->inputs, *req->inputs))) {
+        return;
+      }
+      batch->push_back(req);
+      queue_.pop_front();
+      batch_size += req->batch_size;
+    }
+    if (batch_size >= max_batch_size || stop_) return;
+    if (!queue_cv_.wait_until(lock, deadline, [this] {
+          return stop_ || !queue_.empty();
+        })) {
+      return;
+    }
+  }
+}
+
+bool BatchingPredictor::RunBatch(PaddlePredictor *predictor,
+                                 const std::vector<Request *> &batch) {
+  const auto &first = *batch.front()->inputs;
+  std::vector<char> staging;
+  for (size_t i = 0; i < first.size(); ++i) {
+    const std::string &name =
+        first[i].name.empty() ? input_names_[i] : first[i].name;
+    std::vector<int> shape = first[i].shape;
+    shape[0] = 0;
+    std::vector<std::vector<size_t>> lod(first[i].lod.size(),
+                                         std::vector<size_t>(1, 0));
+    size_t bytes = 0;
+    for (auto *req : batch) {
+      const auto &input = (*req->inputs)[i];
+      shape[0] += input.shape[0];
+      bytes += input.data.length();
+      // The offsets of each level are shifted by the length of the level
+      // already merged.
+      for (size_t level = 0; level < lod.size(); ++level) {
+        size_t base = lod[level].back();
+        for (size_t k = 1; k < input.lod[level].size(); ++k) {
+          lod[level].push_back(base + input.lod[level][k]);
+        }
+      }
+    }
+
+    auto tensor = predictor->GetInputTensor(name);
+    tensor->Reshape(shape);
+    tensor->SetLoD(lod);
+    if (batch.size() == 1) {
+      CopyFromCpu(tensor.get(), first[i].dtype, first[i].data.data());
+      continue;
+    }
+    staging.resize(bytes);
+    size_t offset = 0;
+    for (auto *req : batch) {
+      const auto &data = (*req->inputs)[i].data;
+      std::memcpy(staging.data() + offset, data.data(), data.length());
+      offset += data.length();
+    }
+    CopyFromCpu(tensor.get(), first[i].dtype, staging.data());
+  }
+
+  if (!predictor->ZeroCopyRun()) return false;
+
+  size_t total_batch_size = 0;
+  size_t total_rows = 0;
+  for (auto *req : batch) {
+    total_batch_size += req->batch_size;
+    total_rows += req->num_rows;
+    req->outputs->clear();
+    req->outputs->resize(output_names_.size());
+  }
+
+  std::vector<char> buffer;
+  for (size_t o = 0; o < output_names_.size(); ++o) {
+    const std::string &name = output_names_[o];
+    auto tensor = predictor->GetOutputTensor(name);
+    std::vector<int> shape = tensor->shape();
+    std::vector<std::vector<size_t>> lod = tensor->lod();
+    PaddleDType dtype = tensor->type();
+    size_t numel = 1;
+    for (int d : shape) numel *= d;
+    buffer.resize(numel * PaddleDtypeSize(dtype));
+    CopyToCpu(tensor.get(), dtype, buffer.data());
+
+    size_t out_rows = shape.empty() ? 0 : static_cast<size_t>(shape[0]);
+    size_t row_bytes = out_rows == 0 ? 0 : buffer.size() / out_rows;
+    if (batch.size() == 1) {
+      SliceOutput(name, shape, dtype, buffer.data(), row_bytes, out_rows, lod,
+                  &(*batch.front()->outputs)[o]);
+      continue;
+    }
+
+    if (!lod.empty() && lod[0].size() == total_batch_size + 1) {
+      // Sequence outputs are split by the sequences of each request, the row
+      // range is found by walking down the LoD levels.
+      size_t seq_begin = 0;
+      for (auto *req : batch) {
+        size_t begin = seq_begin;
+        size_t end = seq_begin + req->batch_size;
+        std::vector<std::vector<size_t>> sub_lod(lod.size());
+        for (size_t level = 0; level < lod.size(); ++level) {
+          for (size_t k = begin; k <= end; ++k) {
+            sub_lod[level].push_back(lod[level][k] - lod[level][begin]);
+          }
+          size_t next_begin = lod[level][begin];
+          end = lod[level][end];
+          begin = next_begin;
+        }
+        SliceOutput(name, shape, dtype, buffer.data() + begin * row_bytes,
+                    row_bytes, end - begin, std::move(sub_lod),
+                    &(*req->outputs)[o]);
+        seq_begin += req->batch_size;
+      }
+      continue;
+    }
+
+    bool split_by_batch = out_rows == total_batch_size;
+    PADDLE_ENFORCE_EQ(
+        split_by_batch || out_rows == total_rows, true,
+        platform::errors::InvalidArgument(
+            "Can not split output %s of the merged batch: its first dim is %d, "
+            "but the merged batch has %d sequences and %d rows.",
+            name, out_rows, total_batch_size, total_rows));
+    size_t row_begin = 0;
+    for (auto *req : batch) {
+      size_t num_rows = split_by_batch ? req->batch_size : req->num_rows;
+      SliceOutput(name, shape, dtype, buffer.data() + row_begin * row_bytes,
+                  row_bytes, num_rows, {}, &(*req->outputs)[o]);
+      row_begin += num_rows;
+    }
+  }
+  return true;
+}
+
+}  // namespace paddle
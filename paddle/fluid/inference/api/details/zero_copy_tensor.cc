@@ -12,6 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <utility>
+
+#include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
@@ -20,6 +24,50 @@
 
 namespace paddle {
 
+namespace {
+
+// A user buffer handed over by ZeroCopyTensor::ShareExternalData.
+class ExternalAllocation : public memory::Allocation {
+ public:
+  ExternalAllocation(void *ptr, size_t size, const platform::Place &place,
+                     std::function<void(void *)> deleter)
+      : Allocation(ptr, size, place), deleter_(std::move(deleter)) {}
+
+  ~ExternalAllocation() {
+    if (deleter_) deleter_(ptr());
+  }
+
+ private:
+  std::function<void(void *)> deleter_;
+};
+
+// Get the buffer of `tensor` to write its data. A user buffer is never
+// written by the predictor, it is released first. In the staging mode, the
+// buffer grows at least twice as large and never shrinks, so the changing
+// batch sizes stop reallocating once the largest one is seen.
+void *MutableInputData(framework::LoDTensor *tensor,
+                       const platform::Place &place,
+                       framework::proto::VarType::Type type, bool staging) {
+  if (tensor->IsInitialized() &&
+      dynamic_cast<ExternalAllocation *>(tensor->Holder().get()) != nullptr) {
+    tensor->clear();
+  }
+  if (!staging) {
+    return tensor->mutable_data(place, type);
+  }
+  size_t size = tensor->numel() * framework::SizeOfType(type);
+  size_t capacity = 0;
+  if (tensor->IsInitialized() && tensor->Holder()->place() == place) {
+    capacity = tensor->Holder()->size();
+  }
+  if (size > capacity) {
+    capacity = std::max(size, capacity * 2);
+  }
+  return tensor->mutable_data(place, type, std::max<size_t>(capacity, 1));
+}
+
+}  // namespace
+
 void ZeroCopyTensor::Reshape(const std::vector<int> &shape) {
   PADDLE_ENFORCE(!name_.empty(),
                  "Need to SetName first, so that the corresponding tensor can "
@@ -47,12 +95,15 @@ T *ZeroCopyTensor::mutable_data(PaddlePlace place) {
       tensor->numel(), 0,
       "You should call ZeroCopyTensor::Reshape(const std::vector<int> &shape)"
       "function before retrieving mutable_data from input tensor.");
+  auto type = framework::DataTypeTrait<T>::DataType();
   switch (static_cast<int>(place)) {
     case static_cast<int>(PaddlePlace::kCPU): {
-      return tensor->mutable_data<T>(platform::CPUPlace());
+      return static_cast<T *>(
+          MutableInputData(tensor, platform::CPUPlace(), type, staging_));
     }
     case static_cast<int>(PaddlePlace::kGPU): {
-      return tensor->mutable_data<T>(platform::CUDAPlace(device_));
+      return static_cast<T *>(MutableInputData(
+          tensor, platform::CUDAPlace(device_), type, staging_));
     }
     default:
       PADDLE_THROW("Unsupported place: %d", static_cast<int>(place));
@@ -101,26 +152,59 @@ void ZeroCopyTensor::copy_from_cpu(const T *data) {
       "You should call ZeroCopyTensor::Reshape(const std::vector<int> &shape)"
       "function before copying data from cpu.");
   size_t ele_size = tensor->numel() * sizeof(T);
+  auto type = framework::DataTypeTrait<T>::DataType();
 
   if (place_ == PaddlePlace::kCPU) {
-    auto *t_data = tensor->mutable_data<T>(platform::CPUPlace());
-    std::memcpy(static_cast<void *>(t_data), data, ele_size);
+    auto *t_data =
+        MutableInputData(tensor, platform::CPUPlace(), type, staging_);
+    std::memcpy(t_data, data, ele_size);
   } else {
 #ifdef PADDLE_WITH_CUDA
     platform::DeviceContextPool &pool = platform::DeviceContextPool::Instance();
     platform::CUDAPlace gpu_place(device_);
-    auto *t_data = tensor->mutable_data<T>(gpu_place);
+    auto *t_data = MutableInputData(tensor, gpu_place, type, staging_);
     auto *dev_ctx =
         static_cast<const platform::CUDADeviceContext *>(pool.Get(gpu_place));
 
-    memory::Copy(gpu_place, static_cast<void *>(t_data), platform::CPUPlace(),
-                 data, ele_size, dev_ctx->stream());
+    memory::Copy(gpu_place, t_data, platform::CPUPlace(), data, ele_size,
+                 dev_ctx->stream());
 #else
     PADDLE_THROW("Not compiled with CUDA, should not reach here.");
 #endif
   }
 }
 
+template <typename T>
+void ZeroCopyTensor::ShareExternalData(T *data, const std::vector<int> &shape,
+                                       std::function<void(void *)> deleter) {
+  PADDLE_ENFORCE_EQ(input_or_output_, true,
+                    platform::errors::PermissionDenied(
+                        "Cannot share external data with the output tensor "
+                        "%s, it is readonly.",
+                        name_));
+  PADDLE_ENFORCE_NOT_NULL(
+      data, platform::errors::InvalidArgument(
+                "The external data of tensor %s is null.", name_));
+  EAGER_GET_TENSOR;
+  auto dims = framework::make_ddim(shape);
+  size_t size = framework::product(dims) * sizeof(T);
+  platform::Place place;
+  if (place_ == PaddlePlace::kCPU) {
+    place = platform::CPUPlace();
+  } else if (place_ == PaddlePlace::kGPU) {
+    place = platform::CUDAPlace(device_);
+  } else {
+    PADDLE_THROW(platform::errors::Unavailable(
+        "Unsupported place %d of tensor %s.", static_cast<int>(place_),
+        name_));
+  }
+  tensor->Resize(dims);
+  tensor->ResetHolderWithType(
+      std::make_shared<ExternalAllocation>(data, size, place,
+                                           std::move(deleter)),
+      framework::DataTypeTrait<T>::DataType());
+}
+
 template <typename T>
 void ZeroCopyTensor::copy_to_cpu(T *data) {
   EAGER_GET_TENSOR;
@@ -149,6 +233,18 @@ template void ZeroCopyTensor::copy_from_cpu<float>(const float *data);
 template void ZeroCopyTensor::copy_from_cpu<int64_t>(const int64_t *data);
 template void ZeroCopyTensor::copy_from_cpu<int32_t>(const int32_t *data);
 template void ZeroCopyTensor::copy_from_cpu<uint8_t>(const uint8_t *data);
+template void ZeroCopyTensor::ShareExternalData<float>(
+    float *data, const std::vector<int> &shape,
+    std::function<void(void *)> deleter);
+template void ZeroCopyTensor::ShareExternalData<int64_t>(
+    int64_t *data, const std::vector<int> &shape,
+    std::function<void(void *)> deleter);
+template void ZeroCopyTensor::ShareExternalData<int32_t>(
+    int32_t *data, const std::vector<int> &shape,
+    std::function<void(void *)> deleter);
+template void ZeroCopyTensor::ShareExternalData<uint8_t>(
+    uint8_t *data, const std::vector<int> &shape,
+    std::function<void(void *)> deleter);
 template void ZeroCopyTensor::copy_to_cpu<float>(float *data);
 template void ZeroCopyTensor::copy_to_cpu<int64_t>(int64_t *data);
 template void ZeroCopyTensor::copy_to_cpu<int32_t>(int32_t *data);
@@ -245,6 +245,32 @@ struct AnalysisConfig {
   /// \return bool Whether to use the feed and fetch operators.
   ///
   bool use_feed_fetch_ops_enabled() const { return use_feed_fetch_ops_; }
+  ///
+  /// \brief Turn on the staging mode of the ZeroCopy inputs.
+  /// The buffer of an input grows at least twice as large when a bigger
+  /// batch comes and never shrinks, so the inputs stop reallocating once
+  /// the largest batch is seen. Every predictor, and every clone, owns its
+  /// input buffers, so they are used by its thread without any lock. It
+  /// takes effect when the feed and fetch operators are not used.
+  ///
+  /// \param reserve_bytes The bytes reserved for every input at startup.
+  ///
+  void EnableZeroCopyStaging(size_t reserve_bytes = 0);
+  ///
+  /// \brief A boolean state telling whether the staging mode of the
+  /// ZeroCopy inputs is activated.
+  ///
+  /// \return bool Whether the staging mode is activated.
+  ///
+  bool zero_copy_staging_enabled() const { return zero_copy_staging_enabled_; }
+  ///
+  /// \brief The bytes reserved for every ZeroCopy input at startup.
+  ///
+  /// \return size_t The reserved bytes.
+  ///
+  size_t zero_copy_staging_reserve_bytes() const {
+    return zero_copy_staging_reserve_bytes_;
+  }
 
   ///
   /// \brief Control whether to specify the inputs' names.
@@ -375,6 +401,26 @@ struct AnalysisConfig {
     return cpu_math_library_num_threads_;
   }
 
+  ///
+  /// \brief Set the number of inter-op threads on CPU.
+  /// With more than one thread, the operators that do not depend on each
+  /// other (e.g. the towers of a multi-branch model) run concurrently. Each
+  /// inter-op thread uses cpu_math_library_num_threads() threads inside the
+  /// operators, so their product is the total CPU thread budget of a
+  /// predictor. It cannot be used together with EnableMemoryPlan().
+  ///
+  /// \param inter_op_num_threads The number of inter-op threads, 1 runs the
+  /// operators one by one in the program order.
+  ///
+  void SetInterOpNumThreads(int inter_op_num_threads);
+  ///
+  /// \brief An int state telling how many operators can run concurrently on
+  /// CPU.
+  ///
+  /// \return int The number of inter-op threads.
+  ///
+  int inter_op_num_threads() const { return inter_op_num_threads_; }
+
   ///
   /// \brief Transform the AnalysisConfig to NativeConfig.
   ///
@@ -437,6 +483,46 @@ struct AnalysisConfig {
   ///
   bool model_from_memory() const { return model_from_memory_; }
 
+  ///
+  /// \brief Share the parameters with the other predictors in this process
+  /// created from the same model and config.
+  /// The first predictor loads and optimizes the model, the later ones reuse
+  /// its parameter scope and optimized program read-only, just like the
+  /// clones of one predictor do, instead of loading their own copy. The
+  /// parameters are released with the last predictor using them. The model
+  /// program is identified by its content, the parameters by the identity of
+  /// their file (or directory) on disk, and the config by its fingerprint.
+  ///
+  void EnableParamsSharing();
+  ///
+  /// \brief A boolean state telling whether the parameters are shared among
+  /// the predictors of the same model.
+  ///
+  /// \return bool Whether the parameters are shared.
+  ///
+  bool params_sharing_enabled() const { return params_sharing_enabled_; }
+
+  ///
+  /// \brief Cache the optimized program and parameters on disk.
+  /// The first start saves the program and the parameters produced by the
+  /// IR passes to the optimization cache directory (SetOptimCacheDir, or
+  /// `_opt_cache` under the model directory by default), keyed by the model,
+  /// the pass list and the config fingerprint. A later start with the same
+  /// key loads them and skips the analysis entirely. The parameters are saved
+  /// in the mapped params layout, so they are mapped rather than read on CPU.
+  /// It is ignored with the TensorRT or Lite subgraph engines and with the
+  /// MKLDNN quantizer, whose state is not held by the program.
+  ///
+  void EnableOptimProgramCache();
+  ///
+  /// \brief A boolean state telling whether the optimized program is cached.
+  ///
+  /// \return bool Whether the optimized program is cached.
+  ///
+  bool optim_program_cache_enabled() const {
+    return optim_program_cache_enabled_;
+  }
+
   ///
   /// \brief Turn on memory optimize
   /// NOTE still in development.
@@ -450,6 +536,42 @@ struct AnalysisConfig {
   ///
   bool enable_memory_optim() const;
 
+  ///
+  /// \brief Turn on the static memory plan of the executor.
+  /// The intermediate tensors are backed by one pre-allocated arena, each of
+  /// them gets an offset computed from the tensor lifetimes recorded by the
+  /// first run of each input shape signature, so the later runs do no
+  /// allocation for them. It suits the models served with fixed or bucketed
+  /// input shapes. The plan statistics are reported by
+  /// AnalysisPredictor::memory_plan_stats().
+  ///
+  void EnableMemoryPlan();
+  ///
+  /// \brief A boolean state telling whether the static memory plan is
+  /// activated.
+  ///
+  /// \return bool Whether the static memory plan is activated.
+  ///
+  bool enable_memory_plan() const { return enable_memory_plan_; }
+
+  ///
+  /// \brief Turn on the shape cache of the executor.
+  /// The output dims of every operator are recorded for each distinct shape
+  /// signature of the inputs, the later runs with a known signature skip the
+  /// shape inference. It helps small models where the framework overhead
+  /// dominates the latency.
+  ///
+  /// \param capacity The max number of input shape signatures cached.
+  ///
+  void EnableShapeCache(int capacity = 16);
+  ///
+  /// \brief The max number of input shape signatures cached by the executor,
+  /// 0 means the shape cache is disabled.
+  ///
+  /// \return int The shape cache capacity.
+  ///
+  int shape_cache_capacity() const { return shape_cache_capacity_; }
+
   ///
   /// \brief Turn on profiling report.
   /// If not turned on, no profiling report will be generated.
@@ -462,6 +584,23 @@ struct AnalysisConfig {
   ///
   bool profile_enabled() const { return with_profile_; }
 
+  ///
+  /// \brief Turn on the operator profile of the predictor.
+  /// Unlike EnableProfile(), which reports the global profiler tables at
+  /// exit, it keeps a latency histogram, a call count and the allocated
+  /// bytes of every operator in lock-free counters, read and reset with
+  /// PaddlePredictor::GetOpProfile() at runtime. The overhead is two clock
+  /// reads per operator, cheap enough for a service in production.
+  ///
+  void EnableOpProfile();
+  ///
+  /// \brief A boolean state telling whether the operator profile is
+  /// activated.
+  ///
+  /// \return bool Whether the operator profile is activated.
+  ///
+  bool op_profile_enabled() const { return op_profile_enabled_; }
+
   ///
   /// \brief Mute all logs in Paddle inference.
   ///
@@ -508,6 +647,9 @@ struct AnalysisConfig {
   void Update();
 
   std::string SerializeInfoCache();
+  // The same without the model paths, for the callers identifying the model
+  // by its contents.
+  std::string SerializeInfoCacheWithoutPaths() const;
 
  protected:
   // Model pathes.
@@ -551,20 +693,32 @@ struct AnalysisConfig {
   // memory reuse related.
   bool enable_memory_optim_{false};
 
+  // static memory plan related.
+  bool enable_memory_plan_{false};
+
+  // executor shape cache related.
+  int shape_cache_capacity_{0};
+
   bool use_mkldnn_{false};
   std::unordered_set<std::string> mkldnn_enabled_op_types_;
 
   bool model_from_memory_{false};
+  bool params_sharing_enabled_{false};
+  bool optim_program_cache_enabled_{false};
 
   bool enable_ir_optim_{true};
   bool use_feed_fetch_ops_{true};
   bool ir_debug_{false};
+  bool zero_copy_staging_enabled_{false};
+  size_t zero_copy_staging_reserve_bytes_{0};
 
   bool specify_input_name_{false};
 
   int cpu_math_library_num_threads_{1};
+  int inter_op_num_threads_{1};
 
   bool with_profile_{false};
+  bool op_profile_enabled_{false};
 
   bool with_glog_info_{true};
 
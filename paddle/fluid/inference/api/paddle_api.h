@@ -23,6 +23,8 @@
  */
 
 #include <cassert>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -199,6 +201,19 @@ class ZeroCopyTensor {
   template <typename T>
   void copy_from_cpu(const T* data);
 
+  /// \brief Share a user buffer as the tensor data without a copy.
+  /// It's usually used to set the input tensor data. The tensor takes over
+  /// the buffer until it is replaced by a later ShareExternalData,
+  /// copy_from_cpu or mutable_data call, or the predictor is destroyed, then
+  /// `deleter` is called with `data`. Without a deleter, the buffer is only
+  /// borrowed and should be kept alive until then.
+  /// \param data The buffer, on the place of the tensor.
+  /// \param shape The shape of the tensor.
+  /// \param deleter Called to release the buffer.
+  template <typename T>
+  void ShareExternalData(T* data, const std::vector<int>& shape,
+                         std::function<void(void*)> deleter = nullptr);
+
   /// \brief Copy the tensor data to the host memory.
   /// It's usually used to get the output tensor data.
   /// \param[out] data The tensor will copy the data to the address.
@@ -243,6 +258,39 @@ class ZeroCopyTensor {
   PaddlePlace place_;
   PaddleDType dtype_;
   int device_;
+  // In the staging mode, the input buffer grows geometrically and never
+  // shrinks, see AnalysisConfig::EnableZeroCopyStaging.
+  bool staging_{false};
+};
+
+/// \brief The latency and memory statistics of one operator, or of all the
+/// operators of one type, collected by the predictor.
+struct PaddleOpProfile {
+  std::string type;  ///< The operator type.
+  /// The position of the operator in the optimized program, -1 for the
+  /// statistics of all the operators of the type.
+  int index{-1};
+  int64_t calls{0};
+  double total_us{0};
+  double min_us{0};
+  double max_us{0};
+  /// Bytes newly allocated for the outputs.
+  int64_t alloc_bytes{0};
+  /// Number of the calls in each bucket of PaddleProfile::bucket_bounds_us.
+  std::vector<int64_t> latency_histogram;
+};
+
+/// \brief The operator profile of a predictor over a window of runs.
+struct PaddleProfile {
+  int64_t num_runs{0};
+  /// The exclusive upper bounds of the latency buckets in microseconds, the
+  /// last bucket has no upper bound.
+  std::vector<double> bucket_bounds_us;
+  /// The statistics of every operator type, in the order of their first
+  /// appearance in the program.
+  std::vector<PaddleOpProfile> op_types;
+  /// The statistics of every operator, in the program order.
+  std::vector<PaddleOpProfile> op_instances;
 };
 
 /// \brief A Predictor for executing inference on a model.
@@ -318,6 +366,17 @@ class PaddlePredictor {
   /// \return unique_ptr which contains the pointer of predictor
   virtual std::unique_ptr<PaddlePredictor> Clone() = 0;
 
+  /// \brief Get the operator profile collected since the last reset.
+  /// Be inherited by AnalysisPredictor, the profile is only collected if
+  /// AnalysisConfig::EnableOpProfile() is called. It is thread safe with
+  /// the runs, so a metrics thread can export the profile periodically.
+  /// \param[out] profile The profile.
+  /// \param[in] reset Whether to start a new window after reading.
+  /// \return Whether the profile is collected by the predictor.
+  virtual bool GetOpProfile(PaddleProfile* profile, bool reset = false) {
+    return false;
+  }
+
   /// \brief Destroy the Predictor.
   virtual ~PaddlePredictor() = default;
 
@@ -0,0 +1,139 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+/*! \file paddle_async_predictor.h
+ */
+
+#include <condition_variable>  // NOLINT
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle_api.h"  // NOLINT
+
+namespace paddle {
+
+///
+/// \class AsyncPredictor
+///
+/// \brief An executor pool that runs the submitted requests on the predictor
+/// and its clones, one worker thread per predictor. The callers submit a
+/// request and get a future, or a callback invoked on the worker thread, so
+/// a few threads can keep many requests in flight and overlap the request
+/// decoding and the response encoding with the inference.
+///
+/// Usage:
+/// \code{cpp}
+///   AsyncPredictor predictor(CreatePaddlePredictor(config), 4);
+///   // With a future.
+///   std::vector<PaddleTensor> outputs;
+///   auto done = predictor.RunAsync(inputs, &outputs);
+///   ...
+///   bool success = done.get();
+///   // With a callback.
+///   predictor.RunAsync(inputs, [](bool success,
+///                                 std::vector<PaddleTensor>* outputs) {
+///     ...
+///   });
+/// \endcode
+///
+class AsyncPredictor {
+ public:
+  ///
+  /// \brief A task run on the predictor owned by a worker, it returns
+  /// whether it is successful.
+  ///
+  using Task = std::function<bool(PaddlePredictor*)>;
+  ///
+  /// \brief Invoked on the worker thread when a request is finished, the
+  /// outputs are only valid during the call.
+  ///
+  using Callback =
+      std::function<void(bool success, std::vector<PaddleTensor>* outputs)>;
+
+  ///
+  /// \brief Construct the pool and start the workers.
+  ///
+  /// \param[in] predictor the predictor used by the first worker, the other
+  /// workers run on its clones.
+  /// \param[in] num_workers number of worker threads.
+  ///
+  AsyncPredictor(std::unique_ptr<PaddlePredictor> predictor,
+                 int num_workers = 1);
+  AsyncPredictor(const AsyncPredictor&) = delete;
+  AsyncPredictor& operator=(const AsyncPredictor&) = delete;
+  ///
+  /// \brief Stop the workers after the submitted requests are finished.
+  ///
+  ~AsyncPredictor();
+
+  ///
+  /// \brief Submit a request, thread safe.
+  ///
+  /// The inputs are copied, but not the memory of their PaddleBuf, so the
+  /// data of the inputs not owned by their PaddleBuf should be kept alive
+  /// until the request is finished.
+  ///
+  /// \param[in] inputs input tensors.
+  /// \param[out] outputs output tensors, should be kept alive until the
+  /// request is finished.
+  /// \return a future telling whether the run is successful.
+  ///
+  std::future<bool> RunAsync(const std::vector<PaddleTensor>& inputs,
+                             std::vector<PaddleTensor>* outputs);
+  ///
+  /// \brief Submit a request with a completion callback, thread safe.
+  ///
+  /// \param[in] inputs input tensors.
+  /// \param[in] done invoked on the worker thread with the outputs.
+  ///
+  void RunAsync(const std::vector<PaddleTensor>& inputs, Callback done);
+  ///
+  /// \brief Submit a task run on the predictor of a worker, thread safe. It
+  /// gives the zero copy API of the predictor, e.g. set the inputs, call
+  /// ZeroCopyRun and copy the outputs out in the task.
+  ///
+  /// \param[in] task the task.
+  /// \return a future telling whether the task is successful.
+  ///
+  std::future<bool> Submit(Task task);
+
+  ///
+  /// \brief Number of the requests submitted but not started yet.
+  ///
+  size_t num_pending() const;
+  ///
+  /// \brief Number of the workers.
+  ///
+  int num_workers() const { return static_cast<int>(workers_.size()); }
+
+ private:
+  void WorkerLoop(PaddlePredictor* predictor);
+
+  std::vector<std::unique_ptr<PaddlePredictor>> predictors_;
+  std::vector<std::thread> workers_;
+
+  std::deque<std::function<void(PaddlePredictor*)>> queue_;
+  mutable std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  bool stop_{false};
+};
+
+}  // namespace paddle
@@ -0,0 +1,139 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+/*! \file paddle_batching_predictor.h
+ */
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle_api.h"  // NOLINT
+
+namespace paddle {
+
+///
+/// \brief Configuration of the dynamic batching front end.
+///
+struct BatchingConfig {
+  /// Upper bound of the merged batch. For dense inputs it counts rows (the
+  /// first dim), for LoD inputs it counts sequences (the level-0 LoD).
+  /// A single request larger than this is still run, but alone.
+  int max_batch_size{32};
+  /// The longest time (in microseconds) the first request of a batch waits
+  /// for other requests before the batch is run.
+  int batch_timeout_us{1000};
+  /// Number of predictor clones that run merged batches concurrently.
+  int num_workers{1};
+};
+
+///
+/// \class BatchingPredictor
+///
+/// \brief A thread-safe front end that queues concurrent requests, merges
+/// them along the batch dim (or concatenates their LoD for sequence models),
+/// runs the merged batch with ZeroCopyRun and splits the outputs back to each
+/// caller.
+///
+/// Small batch-1 requests waste most of the GEMM throughput on CPU, merging
+/// them trades a bounded latency (`batch_timeout_us`) for throughput.
+///
+/// The predictor must be created with `SwitchUseFeedFetchOps(false)`.
+///
+/// Usage:
+/// \code{cpp}
+///   AnalysisConfig config;
+///   config.SwitchUseFeedFetchOps(false);
+///   BatchingConfig batching;
+///   batching.max_batch_size = 16;
+///   BatchingPredictor predictor(CreatePaddlePredictor(config), batching);
+///   // Called concurrently by many threads.
+///   predictor.Run(inputs, &outputs);
+/// \endcode
+///
+class BatchingPredictor {
+ public:
+  ///
+  /// \brief Construct the front end and start the workers.
+  ///
+  /// \param[in] predictor the predictor used by the first worker, the other
+  /// workers run on its clones.
+  /// \param[in] config the batching config.
+  ///
+  BatchingPredictor(std::unique_ptr<PaddlePredictor> predictor,
+                    const BatchingConfig& config);
+  BatchingPredictor(const BatchingPredictor&) = delete;
+  BatchingPredictor& operator=(const BatchingPredictor&) = delete;
+  ///
+  /// \brief Stop the workers after the queued requests are finished.
+  ///
+  ~BatchingPredictor();
+
+  ///
+  /// \brief Enqueue one request and block until its outputs are ready.
+  /// Thread safe.
+  ///
+  /// All the inputs of a request must share the same batch dim. Inputs are
+  /// matched by name, or by position when the names are empty.
+  ///
+  /// \param[in] inputs input tensors of one request.
+  /// \param[out] outputs output tensors of this request.
+  /// \return Whether the run is successful
+  ///
+  bool Run(const std::vector<PaddleTensor>& inputs,
+           std::vector<PaddleTensor>* outputs);
+
+  ///
+  /// \brief Number of merged batches run so far.
+  ///
+  int64_t num_batches() const { return num_batches_; }
+  ///
+  /// \brief Number of requests served so far.
+  ///
+  int64_t num_requests() const { return num_requests_; }
+
+ private:
+  struct Request;
+
+  void WorkerLoop(PaddlePredictor* predictor);
+  void CollectBatch(std::vector<Request*>* batch);
+  bool RunBatch(PaddlePredictor* predictor,
+                const std::vector<Request*>& batch);
+
+  BatchingConfig config_;
+  std::vector<std::unique_ptr<PaddlePredictor>> predictors_;
+  std::vector<std::string> input_names_;
+  std::vector<std::string> output_names_;
+  std::vector<std::thread> workers_;
+
+  std::deque<Request*> queue_;
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  // Only one worker collects a batch at a time, so that new requests are
+  // merged into the pending batch instead of waking up an idle worker.
+  std::mutex collect_mutex_;
+  bool stop_{false};
+
+  std::atomic<int64_t> num_batches_{0};
+  std::atomic<int64_t> num_requests_{0};
+};
+
+}  // namespace paddle
@@ -26,5 +26,7 @@ limitations under the License. */
 #include <string>
 #include <vector>
 
-#include "paddle_analysis_config.h"  // NOLINT
-#include "paddle_api.h"              // NOLINT
+#include "paddle_analysis_config.h"     // NOLINT
+#include "paddle_api.h"                 // NOLINT
+#include "paddle_async_predictor.h"     // NOLINT
+#include "paddle_batching_predictor.h"  // NOLINT
@@ -17,6 +17,7 @@
 #include <memory>
 #include "paddle/fluid/inference/api/paddle_analysis_config.h"
 #include "paddle/fluid/inference/api/paddle_api.h"
+#include "paddle/fluid/inference/api/paddle_async_predictor.h"
 #include "paddle/fluid/inference/capi/paddle_c_api.h"
 #include "paddle/fluid/platform/enforce.h"
 
@@ -39,6 +40,10 @@ struct PD_Predictor {
   std::unique_ptr<paddle::PaddlePredictor> predictor;
 };
 
+struct PD_AsyncPredictor {
+  std::unique_ptr<paddle::AsyncPredictor> predictor;
+};
+
 namespace paddle {
 paddle::PaddleDType ConvertToPaddleDType(PD_DataType dtype);
 
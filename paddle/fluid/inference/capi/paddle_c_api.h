@@ -39,6 +39,7 @@ typedef enum PD_DataType PD_DataType;
 typedef struct PD_PaddleBuf PD_PaddleBuf;
 typedef struct PD_AnalysisConfig PD_AnalysisConfig;
 typedef struct PD_Predictor PD_Predictor;
+typedef struct PD_AsyncPredictor PD_AsyncPredictor;
 
 typedef struct PD_Buffer {
   void* data;
@@ -285,6 +286,23 @@ PADDLE_CAPI_EXPORT extern void PD_GetZeroCopyOutput(PD_Predictor* predictor,
 
 PADDLE_CAPI_EXPORT extern void PD_ZeroCopyRun(PD_Predictor* predictor);
 
+// AsyncPredictor
+// Invoked on a worker thread of the async predictor when a request is
+// finished. The outputs are released after the callback returns.
+typedef void (*PD_AsyncCallback)(bool success, PD_ZeroCopyData* outputs,
+                                 int out_size, void* user_data);
+
+PADDLE_CAPI_EXPORT extern PD_AsyncPredictor* PD_NewAsyncPredictor(
+    const PD_AnalysisConfig* config, int num_workers);
+
+PADDLE_CAPI_EXPORT extern void PD_DeleteAsyncPredictor(
+    PD_AsyncPredictor* predictor);
+
+// Submit a request and return at once, the inputs are copied.
+PADDLE_CAPI_EXPORT extern void PD_AsyncPredictorRun(
+    PD_AsyncPredictor* predictor, const PD_ZeroCopyData* inputs, int in_size,
+    PD_AsyncCallback callback, void* user_data);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -18,6 +18,7 @@
 #include <map>
 #include <memory>
 #include <numeric>
+#include <string>
 #include <vector>
 #include "paddle/fluid/inference/api/paddle_api.h"
 #include "paddle/fluid/inference/capi/c_api_internal.h"
@@ -75,50 +76,8 @@ struct PD_ZeroCopyFunctor {
   }
 };
 
-}  // namespace
-
-extern "C" {
-bool PD_PredictorRun(const PD_AnalysisConfig* config, PD_Tensor* inputs,
-                     int in_size, PD_Tensor** output_data, int* out_size,
-                     int batch_size) {
-  PADDLE_ENFORCE_NOT_NULL(config);
-  VLOG(3) << "Predoctor: PD_PredictorRun. ";
-  static std::map<std::string, std::unique_ptr<paddle::PaddlePredictor>>
-      predictors;
-  if (!predictors.count(config->config.model_dir())) {
-    predictors[config->config.model_dir()] =
-        paddle::CreatePaddlePredictor(config->config);
-  }
-  auto& predictor = predictors[config->config.model_dir()];
-  std::vector<paddle::PaddleTensor> in;
-  for (int i = 0; i < in_size; ++i) {
-    in.emplace_back(inputs->tensor);
-  }
-  std::vector<paddle::PaddleTensor> out;
-  VLOG(3) << "Run predictor in CAPI encapsulation. ";
-  if (predictor->Run(in, &out, batch_size)) {
-    int osize = out.size();
-    *output_data = new PD_Tensor[osize];
-    for (int i = 0; i < osize; ++i) {
-      output_data[i]->tensor = out[i];
-    }
-    *out_size = osize;
-    return true;
-  }
-  return false;
-}
-
-bool PD_PredictorZeroCopyRun(const PD_AnalysisConfig* config,
-                             PD_ZeroCopyData* inputs, int in_size,
-                             PD_ZeroCopyData** output, int* out_size) {
-  PADDLE_ENFORCE_NOT_NULL(config);
-  static std::map<std::string, std::unique_ptr<paddle::PaddlePredictor>>
-      predictors;
-  if (!predictors.count(config->config.model_dir())) {
-    predictors[config->config.model_dir()] =
-        paddle::CreatePaddlePredictor(config->config);
-  }
-  auto& predictor = predictors[config->config.model_dir()];
+void SetZeroCopyInputs(paddle::PaddlePredictor* predictor,
+                       const PD_ZeroCopyData* inputs, int in_size) {
   auto input_names = predictor->GetInputNames();
   VLOG(3) << "The inputs' size is " << input_names.size();
   PADDLE_ENFORCE_EQ(
@@ -148,8 +107,10 @@ bool PD_PredictorZeroCopyRun(const PD_AnalysisConfig* config,
         break;
     }
   }
-  VLOG(3) << "Run ZeroCopyRun() in CAPI encapsulation. ";
-  CHECK(predictor->ZeroCopyRun());
+}
+
+void GetZeroCopyOutputs(paddle::PaddlePredictor* predictor,
+                        PD_ZeroCopyData** output, int* out_size) {
   auto output_names = predictor->GetOutputNames();
   int osize = output_names.size();
   *out_size = osize;
@@ -170,6 +131,65 @@ bool PD_PredictorZeroCopyRun(const PD_AnalysisConfig* config,
     VisitDataType(output_i.dtype,
                   PD_ZeroCopyFunctor(&output_i, std::move(output_t.get())));
   }
+}
+
+void DeleteZeroCopyOutputs(PD_ZeroCopyData* outputs, int out_size) {
+  for (int i = 0; i < out_size; ++i) {
+    delete[] outputs[i].name;
+    delete[] outputs[i].shape;
+    free(outputs[i].data);
+  }
+  delete[] outputs;
+}
+
+}  // namespace
+
+extern "C" {
+bool PD_PredictorRun(const PD_AnalysisConfig* config, PD_Tensor* inputs,
+                     int in_size, PD_Tensor** output_data, int* out_size,
+                     int batch_size) {
+  PADDLE_ENFORCE_NOT_NULL(config);
+  VLOG(3) << "Predoctor: PD_PredictorRun. ";
+  static std::map<std::string, std::unique_ptr<paddle::PaddlePredictor>>
+      predictors;
+  if (!predictors.count(config->config.model_dir())) {
+    predictors[config->config.model_dir()] =
+        paddle::CreatePaddlePredictor(config->config);
+  }
+  auto& predictor = predictors[config->config.model_dir()];
+  std::vector<paddle::PaddleTensor> in;
+  for (int i = 0; i < in_size; ++i) {
+    in.emplace_back(inputs->tensor);
+  }
+  std::vector<paddle::PaddleTensor> out;
+  VLOG(3) << "Run predictor in CAPI encapsulation. ";
+  if (predictor->Run(in, &out, batch_size)) {
+    int osize = out.size();
+    *output_data = new PD_Tensor[osize];
+    for (int i = 0; i < osize; ++i) {
+      output_data[i]->tensor = out[i];
+    }
+    *out_size = osize;
+    return true;
+  }
+  return false;
+}
+
+bool PD_PredictorZeroCopyRun(const PD_AnalysisConfig* config,
+                             PD_ZeroCopyData* inputs, int in_size,
+                             PD_ZeroCopyData** output, int* out_size) {
+  PADDLE_ENFORCE_NOT_NULL(config);
+  static std::map<std::string, std::unique_ptr<paddle::PaddlePredictor>>
+      predictors;
+  if (!predictors.count(config->config.model_dir())) {
+    predictors[config->config.model_dir()] =
+        paddle::CreatePaddlePredictor(config->config);
+  }
+  auto& predictor = predictors[config->config.model_dir()];
+  SetZeroCopyInputs(predictor.get(), inputs, in_size);
+  VLOG(3) << "Run ZeroCopyRun() in CAPI encapsulation. ";
+  CHECK(predictor->ZeroCopyRun());
+  GetZeroCopyOutputs(predictor.get(), output, out_size);
   return true;
 }
 
@@ -302,4 +322,76 @@ void PD_GetZeroCopyOutput(PD_Predictor* predictor, PD_ZeroCopyTensor* tensor) {
 void PD_ZeroCopyRun(PD_Predictor* predictor) {
   predictor->predictor->ZeroCopyRun();
 }
+
+PD_AsyncPredictor* PD_NewAsyncPredictor(const PD_AnalysisConfig* config,
+                                        int num_workers) {
+  PADDLE_ENFORCE_NOT_NULL(config);
+  PD_AsyncPredictor* predictor = new PD_AsyncPredictor;
+  predictor->predictor.reset(new paddle::AsyncPredictor(
+      paddle::CreatePaddlePredictor(config->config), num_workers));
+  return predictor;
+}
+
+void PD_DeleteAsyncPredictor(PD_AsyncPredictor* predictor) {
+  if (predictor) {
+    predictor->predictor = nullptr;
+    delete predictor;
+    predictor = nullptr;
+  }
+}
+
+void PD_AsyncPredictorRun(PD_AsyncPredictor* predictor,
+                          const PD_ZeroCopyData* inputs, int in_size,
+                          PD_AsyncCallback callback, void* user_data) {
+  PADDLE_ENFORCE_NOT_NULL(predictor);
+  PADDLE_ENFORCE_NOT_NULL(callback);
+  // The inputs are copied, so the caller may release them once the request
+  // is submitted.
+  struct AsyncInput {
+    std::string name;
+    std::vector<int> shape;
+    PD_DataType dtype;
+    std::vector<char> data;
+  };
+  auto copied = std::make_shared<std::vector<AsyncInput>>(in_size);
+  for (int i = 0; i < in_size; ++i) {
+    auto& input = (*copied)[i];
+    input.name = inputs[i].name;
+    input.shape.assign(inputs[i].shape, inputs[i].shape + inputs[i].shape_size);
+    input.dtype = inputs[i].dtype;
+    size_t length = std::accumulate(input.shape.begin(), input.shape.end(), 1,
+                                    std::multiplies<int>()) *
+                    paddle::PaddleDtypeSize(ConvertToPaddleDType(input.dtype));
+    auto* data = static_cast<const char*>(inputs[i].data);
+    input.data.assign(data, data + length);
+  }
+
+  predictor->predictor->Submit(
+      [copied, callback, user_data](paddle::PaddlePredictor* predictor) {
+        std::vector<PD_ZeroCopyData> inputs(copied->size());
+        for (size_t i = 0; i < copied->size(); ++i) {
+          auto& input = (*copied)[i];
+          inputs[i].name = const_cast<char*>(input.name.c_str());
+          inputs[i].data = input.data.data();
+          inputs[i].dtype = input.dtype;
+          inputs[i].shape = input.shape.data();
+          inputs[i].shape_size = static_cast<int>(input.shape.size());
+        }
+        PD_ZeroCopyData* outputs = nullptr;
+        int out_size = 0;
+        bool success = false;
+        try {
+          SetZeroCopyInputs(predictor, inputs.data(),
+                            static_cast<int>(inputs.size()));
+          success = predictor->ZeroCopyRun();
+          if (success) GetZeroCopyOutputs(predictor, &outputs, &out_size);
+        } catch (const std::exception& e) {
+          LOG(ERROR) << "PD_AsyncPredictorRun failed: " << e.what();
+          success = false;
+        }
+        callback(success, outputs, out_size, user_data);
+        if (outputs) DeleteZeroCopyOutputs(outputs, out_size);
+        return success;
+      });
+}
 }  // extern "C"
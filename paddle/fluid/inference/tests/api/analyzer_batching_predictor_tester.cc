@@ -0,0 +1,170 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include "paddle/fluid/inference/tests/api/tester_helper.h"
+
+DEFINE_int32(num_requests_per_thread, 50,
+             "Number of requests sent by each client thread.");
+DEFINE_int32(batch_timeout_us, 2000,
+             "The longest time a request waits to be batched.");
+DEFINE_int32(num_batching_workers, 1,
+             "Number of predictor clones running the merged batches.");
+
+namespace paddle {
+namespace inference {
+namespace analysis {
+
+void SetConfig(AnalysisConfig *cfg) {
+  cfg->SetModel(FLAGS_infer_model + "/model", FLAGS_infer_model + "/params");
+  cfg->DisableGpu();
+  cfg->SwitchIrOptim();
+  cfg->SwitchUseFeedFetchOps(false);
+  cfg->SetCpuMathLibraryNumThreads(FLAGS_paddle_num_threads);
+}
+
+// Every request is a batch-1 fake image with a different content.
+void SetInputs(int num_inputs, std::vector<std::vector<PaddleTensor>> *inputs) {
+  for (int i = 0; i < num_inputs; ++i) {
+    SetFakeImageInput(inputs, FLAGS_infer_model, true, "model", "params",
+                      nullptr, i);
+  }
+}
+
+struct BatchingStat {
+  double qps{0};
+  double avg_latency{0};
+  double p50_latency{0};
+  double p99_latency{0};
+  double avg_batch_size{0};
+};
+
+// Send requests from FLAGS_num_threads client threads concurrently and
+// collect the latency of every request.
+BatchingStat RunClients(BatchingPredictor *predictor,
+                        const std::vector<std::vector<PaddleTensor>> &inputs) {
+  std::vector<std::vector<double>> latencies(FLAGS_num_threads);
+  std::vector<std::thread> threads;
+  Timer total_timer;
+  total_timer.tic();
+  for (int tid = 0; tid < FLAGS_num_threads; ++tid) {
+    threads.emplace_back([&, tid]() {
+      std::vector<PaddleTensor> outputs;
+      Timer timer;
+      for (int i = 0; i < FLAGS_num_requests_per_thread; ++i) {
+        auto &input = inputs[(tid + i) % inputs.size()];
+        timer.tic();
+        ASSERT_TRUE(predictor->Run(input, &outputs));
+        latencies[tid].push_back(timer.toc());
+      }
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  double total_time = total_timer.toc();
+
+  std::vector<double> all;
+  for (auto &l : latencies) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+  BatchingStat stat;
+  stat.qps = all.size() * 1000. / total_time;
+  stat.avg_latency = std::accumulate(all.begin(), all.end(), 0.) /
+                     std::max<size_t>(all.size(), 1);
+  stat.p50_latency = all[all.size() / 2];
+  stat.p99_latency = all[std::min(all.size() - 1, all.size() * 99 / 100)];
+  stat.avg_batch_size = static_cast<double>(predictor->num_requests()) /
+                        std::max<int64_t>(predictor->num_batches(), 1);
+  return stat;
+}
+
+// Merged batches should produce the same result as running every request
+// alone.
+TEST(Analyzer_batching_predictor, compare) {
+  AnalysisConfig cfg;
+  SetConfig(&cfg);
+  std::vector<std::vector<PaddleTensor>> inputs;
+  SetInputs(8, &inputs);
+
+  std::vector<std::vector<PaddleTensor>> ref_outputs(inputs.size());
+  {
+    BatchingConfig unbatched;
+    unbatched.max_batch_size = 1;
+    BatchingPredictor predictor(CreatePaddlePredictor(cfg), unbatched);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      ASSERT_TRUE(predictor.Run(inputs[i], &ref_outputs[i]));
+    }
+  }
+
+  BatchingConfig batching;
+  batching.max_batch_size = static_cast<int>(inputs.size());
+  batching.batch_timeout_us = 100000;
+  BatchingPredictor predictor(CreatePaddlePredictor(cfg), batching);
+  std::vector<std::vector<PaddleTensor>> outputs(inputs.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      ASSERT_TRUE(predictor.Run(inputs[i], &outputs[i]));
+    });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  LOG(INFO) << "Served " << predictor.num_requests() << " requests in "
+            << predictor.num_batches() << " batches.";
+  EXPECT_LT(predictor.num_batches(), predictor.num_requests());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    CompareResult(outputs[i], ref_outputs[i]);
+  }
+}
+
+// Throughput vs. p99 latency for increasing max batch sizes, the max batch
+// size 1 is the baseline of one request per ZeroCopyRun.
+TEST(Analyzer_batching_predictor, profile) {
+  AnalysisConfig cfg;
+  SetConfig(&cfg);
+  std::vector<std::vector<PaddleTensor>> inputs;
+  SetInputs(16, &inputs);
+
+  std::ostringstream os;
+  os << "\nclients: " << FLAGS_num_threads
+     << ", workers: " << FLAGS_num_batching_workers
+     << ", timeout(us): " << FLAGS_batch_timeout_us << "\n"
+     << "max_batch  avg_batch  qps  avg(ms)  p50(ms)  p99(ms)\n";
+  for (int max_batch_size : {1, 2, 4, 8, 16, 32}) {
+    BatchingConfig batching;
+    batching.max_batch_size = max_batch_size;
+    batching.batch_timeout_us =
+        max_batch_size == 1 ? 0 : FLAGS_batch_timeout_us;
+    batching.num_workers = FLAGS_num_batching_workers;
+    BatchingPredictor predictor(CreatePaddlePredictor(cfg), batching);
+    if (FLAGS_warmup) {
+      std::vector<PaddleTensor> outputs;
+      predictor.Run(inputs[0], &outputs);
+    }
+    auto stat = RunClients(&predictor, inputs);
+    os << max_batch_size << "  " << stat.avg_batch_size << "  " << stat.qps
+       << "  " << stat.avg_latency << "  " << stat.p50_latency << "  "
+       << stat.p99_latency << "\n";
+  }
+  LOG(INFO) << os.str();
+}
+
+}  // namespace analysis
+}  // namespace inference
+}  // namespace paddle
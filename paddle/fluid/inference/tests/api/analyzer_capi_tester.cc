@@ -15,6 +15,8 @@ limitations under the License. */
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
 #include <string>
 #include <vector>
 #include "paddle/fluid/inference/capi/paddle_c_api.h"
@@ -71,6 +73,59 @@ void zero_copy_run() {
 
 TEST(PD_PredictorZeroCopyRun, zero_copy_run) { zero_copy_run(); }
 
+struct AsyncResult {
+  std::mutex mutex;
+  std::condition_variable cv;
+  int num_done{0};
+  int num_success{0};
+};
+
+void AsyncCallback(bool success, PD_ZeroCopyData *outputs, int out_size,
+                   void *user_data) {
+  auto *result = static_cast<AsyncResult *>(user_data);
+  std::lock_guard<std::mutex> lock(result->mutex);
+  if (success && out_size > 0 && outputs[0].data != nullptr) {
+    ++result->num_success;
+  }
+  ++result->num_done;
+  result->cv.notify_all();
+}
+
+TEST(PD_AsyncPredictorRun, async_run) {
+  std::string model_dir = FLAGS_infer_model;
+  PD_AnalysisConfig *config = PD_NewAnalysisConfig();
+  PD_DisableGpu(config);
+  PD_SwitchUseFeedFetchOps(config, false);
+  PD_SwitchSpecifyInputNames(config, true);
+  PD_SetModel(config, (model_dir + "/model").c_str(),
+              (model_dir + "/params").c_str());
+  PD_AsyncPredictor *predictor = PD_NewAsyncPredictor(config, 2);
+
+  const int num_requests = 4;
+  AsyncResult result;
+  int shape[4] = {1, 3, 318, 318};
+  for (int i = 0; i < num_requests; ++i) {
+    // The inputs are copied, they are released right after the submission.
+    std::vector<float> input(1 * 3 * 318 * 318, static_cast<float>(i));
+    std::string name = "data";
+    PD_ZeroCopyData data;
+    data.name = const_cast<char *>(name.c_str());
+    data.data = static_cast<void *>(input.data());
+    data.dtype = PD_FLOAT32;
+    data.shape = shape;
+    data.shape_size = 4;
+    PD_AsyncPredictorRun(predictor, &data, 1, AsyncCallback, &result);
+  }
+  {
+    std::unique_lock<std::mutex> lock(result.mutex);
+    result.cv.wait(lock, [&] { return result.num_done == num_requests; });
+  }
+  EXPECT_EQ(result.num_success, num_requests);
+
+  PD_DeleteAsyncPredictor(predictor);
+  PD_DeleteAnalysisConfig(config);
+}
+
 #ifdef PADDLE_WITH_MKLDNN
 TEST(PD_AnalysisConfig, profile_mkldnn) {
   std::string model_dir = FLAGS_infer_model;
@@ -17,6 +17,8 @@ limitations under the License. */
 #include "paddle/fluid/inference/tests/api/tester_helper.h"
 
 DEFINE_bool(disable_mkldnn_fc, false, "Disable usage of MKL-DNN's FC op");
+DEFINE_int32(inter_op_threads, 4,
+             "Number of inter-op threads of the inter-op parallel tests.");
 
 namespace paddle {
 namespace inference {
@@ -98,6 +100,33 @@ TEST(Analyzer_resnet50, compare) { compare(); }
 TEST(Analyzer_resnet50, compare_mkldnn) { compare(true /* use_mkldnn */); }
 #endif
 
+// The branches of the inception blocks run concurrently, the results should
+// not change.
+TEST(Analyzer_resnet50, compare_inter_op_parallel) {
+  AnalysisConfig cfg;
+  SetConfig(&cfg);
+  cfg.SetInterOpNumThreads(FLAGS_inter_op_threads);
+
+  std::vector<std::vector<PaddleTensor>> input_slots_all;
+  SetInput(&input_slots_all);
+  CompareNativeAndAnalysis(
+      reinterpret_cast<const PaddlePredictor::Config *>(&cfg), input_slots_all);
+  CompareDeterministic(reinterpret_cast<const PaddlePredictor::Config *>(&cfg),
+                       input_slots_all);
+}
+
+TEST(Analyzer_resnet50, profile_inter_op_parallel) {
+  AnalysisConfig cfg;
+  SetConfig(&cfg);
+  cfg.SetInterOpNumThreads(FLAGS_inter_op_threads);
+
+  std::vector<std::vector<PaddleTensor>> outputs;
+  std::vector<std::vector<PaddleTensor>> input_slots_all;
+  SetInput(&input_slots_all);
+  TestPrediction(reinterpret_cast<const PaddlePredictor::Config *>(&cfg),
+                 input_slots_all, &outputs, FLAGS_num_threads);
+}
+
 // Compare Deterministic result
 TEST(Analyzer_resnet50, compare_determine) {
   AnalysisConfig cfg;
@@ -115,6 +115,20 @@ TEST(Analyzer_Text_Classification, compare) {
       reinterpret_cast<const PaddlePredictor::Config *>(&cfg), input_slots_all);
 }
 
+// The runs with a planned signature should match the native ones as well.
+TEST(Analyzer_Text_Classification, compare_with_memory_plan) {
+  AnalysisConfig cfg;
+  SetConfig(&cfg);
+  cfg.EnableMemoryPlan();
+
+  std::vector<std::vector<PaddleTensor>> input_slots_all;
+  SetInput(&input_slots_all);
+  CompareNativeAndAnalysis(
+      reinterpret_cast<const PaddlePredictor::Config *>(&cfg), input_slots_all);
+  CompareDeterministic(reinterpret_cast<const PaddlePredictor::Config *>(&cfg),
+                       input_slots_all);
+}
+
 // Compare Deterministic result
 TEST(Analyzer_Text_Classification, compare_determine) {
   AnalysisConfig cfg;
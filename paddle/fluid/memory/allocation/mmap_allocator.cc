@@ -51,6 +51,13 @@ MemoryMapReaderAllocation::~MemoryMapReaderAllocation() {
   VLOG(3) << "~MemoryMapReaderAllocation: " << this->ipc_name();
 }
 
+MemoryMapFileAllocation::~MemoryMapFileAllocation() {
+  if (this->size() == 0) return;
+  PADDLE_ENFORCE_NE(munmap(this->ptr(), this->size()), -1,
+                    platform::errors::Unavailable("could not unmap the file %s",
+                                                  this->filename()));
+}
+
 std::string GetIPCName() {
   static std::random_device rd;
   std::string handle = "/paddle_";
@@ -101,6 +108,29 @@ std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
   return std::make_shared<MemoryMapReaderAllocation>(ptr, size, ipc_name);
 }
 
+std::shared_ptr<MemoryMapFileAllocation> AllocateMemoryMapFileAllocation(
+    const std::string &filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(fd, -1, platform::errors::NotFound(
+                                "File %s open failed", filename.c_str()));
+  struct stat st;
+  PADDLE_ENFORCE_EQ(
+      fstat(fd, &st), 0,
+      platform::errors::Unavailable("Cannot stat file %s", filename.c_str()));
+  size_t size = static_cast<size_t>(st.st_size);
+  if (size == 0) {
+    close(fd);
+    return std::make_shared<MemoryMapFileAllocation>(nullptr, 0, filename);
+  }
+
+  void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  PADDLE_ENFORCE_NE(ptr, MAP_FAILED,
+                    platform::errors::Unavailable(
+                        "Memory map failed when mapping file %s.", filename));
+  close(fd);
+  return std::make_shared<MemoryMapFileAllocation>(ptr, size, filename);
+}
+
 MemoryMapFdSet &MemoryMapFdSet::Instance() {  // NOLINT
   static MemoryMapFdSet set;
   return set;
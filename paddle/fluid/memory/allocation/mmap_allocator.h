@@ -58,12 +58,32 @@ class MemoryMapReaderAllocation : public Allocation {
   std::string ipc_name_;
 };
 
+// A mapping of a whole regular file. The pages are mapped privately, so a
+// write only goes to a private copy of the page and never to the file.
+class MemoryMapFileAllocation : public Allocation {
+ public:
+  explicit MemoryMapFileAllocation(void *ptr, size_t size,
+                                   std::string filename)
+      : Allocation(ptr, size, platform::CPUPlace()),
+        filename_(std::move(filename)) {}
+
+  inline const std::string &filename() const { return filename_; }
+
+  ~MemoryMapFileAllocation() override;
+
+ private:
+  std::string filename_;
+};
+
 std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
     size_t size);
 
 std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
     const std::string &ipc_name, size_t size);
 
+std::shared_ptr<MemoryMapFileAllocation> AllocateMemoryMapFileAllocation(
+    const std::string &filename);
+
 class MemoryMapFdSet {
  public:
   static MemoryMapFdSet &Instance();  // NOLINT
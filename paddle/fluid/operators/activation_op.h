@@ -153,6 +153,42 @@ inline void ExtractActivationGradTensor(
   }
 }
 
+// Evaluate an activation functor on the Eigen device given by
+// platform::VisitEigenDevice.
+template <typename Functor, typename X, typename Out>
+struct ActivationEigenVisitor {
+  ActivationEigenVisitor(Functor* functor, const X& x, const Out& out)
+      : functor(functor), x(x), out(out) {}
+
+  template <typename Device>
+  void operator()(const Device& d) const {
+    (*functor)(d, x, out);
+  }
+
+  Functor* functor;
+  X x;
+  Out out;
+};
+
+template <typename Functor, typename X, typename Out, typename dOut,
+          typename dX>
+struct ActivationGradEigenVisitor {
+  ActivationGradEigenVisitor(Functor* functor, const X& x, const Out& out,
+                             const dOut& dout, const dX& dx)
+      : functor(functor), x(x), out(out), dout(dout), dx(dx) {}
+
+  template <typename Device>
+  void operator()(const Device& d) const {
+    (*functor)(d, x, out, dout, dx);
+  }
+
+  Functor* functor;
+  X x;
+  Out out;
+  dOut dout;
+  dX dx;
+};
+
 template <typename DeviceContext, typename Functor>
 class ActivationKernel
     : public framework::OpKernel<typename Functor::ELEMENT_TYPE> {
@@ -169,15 +205,17 @@ class ActivationKernel
         GET_DATA_SAFELY(X, "Input", "X", "Activation"));
     auto out = framework::EigenVector<T>::Flatten(
         GET_DATA_SAFELY(Out, "Output", "Out", "Activation"));
-    auto* place =
-        context.template device_context<DeviceContext>().eigen_device();
     Functor functor;
 
     auto attrs = functor.GetAttrs();
     for (auto& attr : attrs) {
       *attr.second = context.Attr<float>(attr.first);
     }
-    functor(*place, x, out);
+    ActivationEigenVisitor<Functor, decltype(x), decltype(out)> visitor(
+        &functor, x, out);
+    platform::VisitEigenDevice(
+        context.template device_context<DeviceContext>(), X->numel(),
+        &visitor);
   }
 };
 
@@ -201,14 +239,17 @@ class ActivationGradKernel
         GET_DATA_SAFELY(dX, "Input", "X@GRAD", "ActivationGrad"));
     auto x = framework::EigenVector<T>::Flatten(
         GET_DATA_SAFELY(X, "Input", "X", "ActivationGrad"));
-    auto* place =
-        context.template device_context<DeviceContext>().eigen_device();
     Functor functor;
     auto attrs = functor.GetAttrs();
     for (auto& attr : attrs) {
       *attr.second = context.Attr<float>(attr.first);
     }
-    functor(*place, x, out, dout, dx);
+    ActivationGradEigenVisitor<Functor, decltype(x), decltype(out),
+                               decltype(dout), decltype(dx)>
+        visitor(&functor, x, out, dout, dx);
+    platform::VisitEigenDevice(
+        context.template device_context<DeviceContext>(), dX->numel(),
+        &visitor);
   }
 };
 
@@ -19,7 +19,9 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_info.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/platform/cpu_helper.h"
 #include "paddle/fluid/platform/init.h"
+#include "paddle/fluid/platform/intra_op_thread_pool.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/timer.h"
 #include "paddle/fluid/pybind/pybind.h"
@@ -68,6 +70,11 @@ void OpTester::Run() {
     LOG(INFO) << DebugString();
   }
 
+  if (config_.num_threads > 0) {
+    platform::SetNumThreads(config_.num_threads);
+    platform::IntraOpThreadPool::Instance()->SetNumThreads(config_.num_threads);
+  }
+
   // Warm up
   RunImpl();
 
@@ -99,8 +106,9 @@ void OpTester::Run() {
     timer.Pause();
   }
   config_.runtime = timer.ElapsedMS() / config_.repeat;
-  LOG(INFO) << "=== Run " << config_.repeat
-            << " times, latency: " << config_.runtime << " ms ===";
+  LOG(INFO) << "=== Run " << config_.repeat << " times with "
+            << platform::IntraOpThreadPool::Instance()->NumThreads()
+            << " threads, latency: " << config_.runtime << " ms ===";
 }
 
 void OpTester::RunImpl() {
@@ -171,6 +171,8 @@ bool OpTesterConfig::Init(std::istream& is) {
         is >> device_id;
       } else if (sep == "repeat" || sep == "repeat:") {
         is >> repeat;
+      } else if (sep == "num_threads" || sep == "num_threads:") {
+        is >> num_threads;
       } else if (sep == "profile" || sep == "profile:") {
         is >> profile;
       } else if (sep == "print_debug_string" || sep == "print_debug_string:") {
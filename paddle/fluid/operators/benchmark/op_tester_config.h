@@ -56,6 +56,7 @@ struct OpTesterConfig {
   std::unordered_map<std::string, std::string> attrs;
   int device_id{-1};  // CPU: -1
   int repeat{1};
+  int num_threads{0};  // 0: keep the number set by paddle_num_threads
   int profile{0};
   int print_debug_string{0};
   double runtime{0.0};
@@ -17,6 +17,7 @@
 #include "paddle/fluid/framework/lod_tensor_array.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/scope_pool.h"
 #include "paddle/fluid/framework/var_type.h"
 #include "paddle/fluid/operators/controlflow/while_op_helper.h"
 
@@ -69,12 +70,11 @@ class WhileOp : public framework::OperatorBase {
     auto step_scopes =
         scope.FindVar(Output(kStepScopes))->GetMutable<StepScopeVar>();
 
+    auto &scope_pool = framework::StepScopePool::Instance();
     if (step_scopes->size() > 0) {
       platform::DeviceContextPool::Instance().Get(dev_place)->Wait();
       for (auto &s : *step_scopes) {
-        if (scope.HasKid(s)) {
-          scope.DeleteScope(s);
-        }
+        scope_pool.Release(scope, block, s);
       }
       step_scopes->clear();
     }
@@ -91,19 +91,18 @@ class WhileOp : public framework::OperatorBase {
     auto ctx = executor.Prepare(*program, block->ID(), skip_vars);
     if (!is_test) {
       while (cond_data) {
-        auto &current_scope = scope.NewScope();
+        auto &current_scope = scope_pool.Acquire(scope, *block);
         step_scopes->push_back(&current_scope);
-        executor.RunPreparedContext(ctx.get(), &current_scope, false, true,
+        executor.RunPreparedContext(ctx.get(), &current_scope, false, false,
                                     true);
         cond_data =
             GetCondData(scope.FindVar(Input(kCondition))->Get<LoDTensor>());
       }
     } else {
-      auto &current_scope = scope.NewScope();
-      executor.CreateVariables(*program, &current_scope, block->ID());
+      std::vector<framework::Variable *> vars;
+      auto &current_scope = scope_pool.Acquire(scope, *block, &vars);
       while (cond_data) {
-        for (auto &name : current_scope.LocalVarNames()) {
-          auto *var = current_scope.Var(name);
+        for (auto *var : vars) {
           if (var->IsType<framework::LoDTensor>()) {
             // Clear all lod information for all lod_tensors.
             auto *t = var->GetMutable<framework::LoDTensor>();
@@ -120,7 +119,7 @@ class WhileOp : public framework::OperatorBase {
         cond_data =
             GetCondData(scope.FindVar(Input(kCondition))->Get<LoDTensor>());
       }
-      scope.DeleteScope(&current_scope);
+      scope_pool.Release(scope, block, &current_scope);
     }
   }
 };
@@ -179,6 +178,9 @@ class WhileGradOp : public framework::OperatorBase {
     framework::Executor executor(dev_place);
     auto *block = Attr<framework::BlockDesc *>(kStepBlock);
     auto *program = block->Program();
+    // The step scopes were acquired for the forward block.
+    auto *forward_block =
+        block->ForwardBlockID() >= 0 ? block->ForwardBlock() : nullptr;
 
     auto &skip_vars = Attr<std::vector<std::string>>(kSkipEagerDeletionVars);
     VLOG(2) << GetSkipEagerDeletionVarsDebugString(skip_vars);
@@ -347,7 +349,8 @@ class WhileGradOp : public framework::OperatorBase {
         cur_scope.Rename(new_inside_name, inside_grad_name);
       }
       dev_ctx.Wait();
-      const_cast<framework::Scope &>(scope).DeleteScope(&cur_scope);
+      framework::StepScopePool::Instance().Release(scope, forward_block,
+                                                   &cur_scope);
     }
     step_scopes->clear();
   }
@@ -18,7 +18,10 @@ limitations under the License. */
 #include <sys/time.h>
 #include <limits>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <thread>  // NOLINT
+#include <unordered_map>
+#include <utility>
 
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/operators/distributed/brpc/brpc_rdma_pool.h"
@@ -31,6 +34,41 @@ namespace paddle {
 namespace operators {
 namespace distributed {
 
+// The user data of the memory attached to the IOBufs by their address, as
+// IOBuf::append_user_data passes only the address to the deleter. The user
+// data of the same address hold the same memory, so any of them is freed.
+class UserData {
+ public:
+  static void Add(const void* data, void (*destroy)(void*), void* user_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    user_data_.emplace(data, std::make_pair(destroy, user_data));
+  }
+
+  static void Release(void* data) {
+    std::pair<void (*)(void*), void*> entry;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = user_data_.find(data);
+      if (it == user_data_.end()) {
+        LOG(FATAL) << "No user data is attached to the IOBuf data " << data;
+      }
+      entry = it->second;
+      user_data_.erase(it);
+    }
+    entry.first(entry.second);
+  }
+
+ private:
+  static std::mutex mutex_;
+  static std::unordered_multimap<const void*,
+                                 std::pair<void (*)(void*), void*>>
+      user_data_;
+};
+
+std::mutex UserData::mutex_;
+std::unordered_multimap<const void*, std::pair<void (*)(void*), void*>>
+    UserData::user_data_;
+
 class IOBufWriter {
  public:
   static void Append(const std::string& varname, butil::IOBuf* iobuf, int k,
@@ -55,16 +93,17 @@ class IOBufWriter {
     iobuf->append(reinterpret_cast<char*>(&k), 4);
     iobuf->append(reinterpret_cast<char*>(&vlen), 8);
 
-    // FIXME(gongwb): use append_zerocopy
-    /*
-    if (in_cuda_pinned) {
-      iobuf->append_zerocopy(v, vlen, IOBufWriter::FreeMemory);
-    } else {
-      iobuf->append_zerocopy(v, vlen, nullptr);
+    if (vlen == 0) {
+      destroy(user_data);
+      return;
     }
-    */
-    iobuf->append(v, vlen);
-    destroy(user_data);
+    // The IOBuf references the data, and frees user_data with destroy once
+    // the data is sent.
+    UserData::Add(v, destroy, user_data);
+    PADDLE_ENFORCE_EQ(iobuf->append_user_data(const_cast<char*>(v), vlen,
+                                              &UserData::Release),
+                      0, platform::errors::Fatal(
+                             "Failed to append %d bytes to the IOBuf.", vlen));
   }
 
 #ifdef PADDLE_WITH_BRPC_RDMA
@@ -113,82 +152,38 @@ void SerializeToIOBuf(const std::string& name, framework::Variable* var,
                       butil::IOBuf* iobuf, const std::string& out_varname,
                       bool var_is_not_stable, int trainer_id,
                       const std::string& table_name) {
-  std::unique_ptr<TensorPayload> payload;
-
-  request->set_varname(name);
-  request->set_trainer_id(trainer_id);
-  // Note: normally the profiler is enabled in 1 trainer, hence only
-  // 1 trainer returns true for ShouldSendProfileState(). It tells PS
-  // servers the trainer's profiling state so that PS can follow the
-  // trainer.
-  if (platform::ShouldSendProfileState()) {
-    if (platform::IsProfileEnabled()) {
-      request->set_profile(platform::kEnableProfiler);
-    } else {
-      request->set_profile(platform::kDisableProfiler);
-    }
-  }
-  if (!out_varname.empty()) {
-    request->set_out_varname(out_varname);
-  }
-  if (!table_name.empty()) {
-    request->set_table_name(table_name);
-  }
-  if (var->IsType<framework::LoDTensor>()) {
-    request->set_type(::sendrecv::LOD_TENSOR);
-    payload.reset(new TensorPayload(GetTensorPayload(var, ctx, request)));
-  } else if (var->IsType<framework::SelectedRows>()) {
-    request->set_type(::sendrecv::SELECTED_ROWS);
-    payload.reset(new TensorPayload(GetSelectedRowsPayload(var, ctx, request)));
+  VarPayloads payloads = GetVarPayloads(name, var, ctx, request, out_varname,
+                                        trainer_id, table_name);
 #ifdef PADDLE_WITH_NCCL
-  } else if (var->IsType<ncclUniqueId>()) {
-    request->set_type(::sendrecv::NCCL_ID);
+  if (var->IsType<ncclUniqueId>()) {
     const ncclUniqueId& uid = var->Get<ncclUniqueId>();
-    // TODO(gongwb): use append_zero to avoid data copy.
     IOBufWriter::Append(name, iobuf,
                         sendrecv::VariableMessage::kSerializedFieldNumber,
                         uid.internal, NCCL_UNIQUE_ID_BYTES);
     return;
-#endif
-  } else {
-    PADDLE_THROW("Serialize does not support type: %s",
-                 typeid(var->Type()).name());
   }
+#endif
+  PADDLE_ENFORCE_NOT_NULL(payloads.tensor);
+  auto& payload = payloads.tensor;
 
-  PADDLE_ENFORCE_NOT_NULL(payload);
-
-  // FIXME(gongwb): it seems that can use zero copy.
   if (var_is_not_stable) {
     IOBufWriter::Append(
         name, iobuf, ::sendrecv::VariableMessage::kSerializedFieldNumber,
         static_cast<const char*>(payload->ptr()), payload->memory_size());
   } else {
-    if (platform::is_gpu_place(ctx.GetPlace())) {
-#ifdef PADDLE_WITH_CUDA
-      IOBufWriter::AppendZeroCopy(
-          name, iobuf, ::sendrecv::VariableMessage::kSerializedFieldNumber,
-          static_cast<const char*>(payload->ptr()), payload->memory_size(),
-          true, SerializeDestroyCallback, static_cast<void*>(payload.get()));
-      payload.release();
-#endif
-    } else {
-      IOBufWriter::AppendZeroCopy(
-          name, iobuf, ::sendrecv::VariableMessage::kSerializedFieldNumber,
-          static_cast<const char*>(payload->ptr()), payload->memory_size(),
-          false, SerializeDestroyCallback, static_cast<void*>(payload.get()));
-      payload.release();
-    }
+    IOBufWriter::AppendZeroCopy(
+        name, iobuf, ::sendrecv::VariableMessage::kSerializedFieldNumber,
+        static_cast<const char*>(payload->ptr()), payload->memory_size(),
+        platform::is_gpu_place(ctx.GetPlace()), SerializeDestroyCallback,
+        static_cast<void*>(payload.get()));
+    payload.release();
   }
 
   if (var->IsType<framework::SelectedRows>()) {
-    auto* slr = var->GetMutable<framework::SelectedRows>();
-    PADDLE_ENFORCE(VectorElemName(slr->rows()) == typeid(int64_t).name());
-    size_t rows_memory_size = slr->rows().size() * sizeof(int64_t);
-
     IOBufWriter::Append(name, iobuf,
                         ::sendrecv::VariableMessage::kRowsFieldNumber,
-                        reinterpret_cast<const char*>(slr->rows().data()),
-                        static_cast<int64_t>(rows_memory_size));
+                        payloads.rows,
+                        static_cast<int64_t>(payloads.rows_size));
   }
 }
 
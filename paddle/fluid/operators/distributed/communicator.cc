@@ -25,6 +25,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/threadpool.h"
 #include "paddle/fluid/framework/variable_helper.h"
 #include "paddle/fluid/operators/distributed/distributed.h"
+#include "paddle/fluid/operators/distributed/gradient_compression.h"
 #include "paddle/fluid/operators/distributed/parameter_recv.h"
 #include "paddle/fluid/operators/distributed/parameter_send.h"
 #include "paddle/fluid/string/printf.h"
@@ -59,6 +60,32 @@ Communicator::Communicator(const std::map<std::string, std::string> &envs_) {
   }
 }
 
+void Communicator::InitGradientCompression(
+    const RpcCtxMap &send_varname_to_ctx) {
+  auto env = [this](const std::string &key, const std::string &value) {
+    auto it = envs.find(key);
+    return it == envs.end() ? value : it->second;
+  };
+  GradientCompressConfig config;
+  config.type =
+      ParseGradientCompressType(env("communicator_grad_compress_type", ""));
+  config.topk_ratio =
+      std::stof(env("communicator_grad_compress_ratio", "0.01"));
+  config.int8_block_size =
+      std::stoi(env("communicator_grad_compress_block_size", "256"));
+  if (config.type == kNoCompress) {
+    return;
+  }
+  auto *compressor = GradientCompressor::GetInstance();
+  for (auto &iter : send_varname_to_ctx) {
+    for (auto &splited_var_name : iter.second.splited_var_names) {
+      VLOG(1) << "compress " << splited_var_name << " with type "
+              << config.type;
+      compressor->SetConfig(splited_var_name, config);
+    }
+  }
+}
+
 std::once_flag Communicator::init_flag_;
 std::shared_ptr<Communicator> Communicator::communicator_(nullptr);
 
@@ -68,6 +95,7 @@ void AsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
   send_varname_to_ctx_ = std::move(send_varname_to_ctx);
   recv_varname_to_ctx_ = std::move(recv_varname_to_ctx);
   recv_scope_ = std::move(recv_scope);
+  InitGradientCompression(send_varname_to_ctx_);
 
   if (send_varname_to_ctx.size() == 0) {
     VLOG(0) << "nothing need to be send, will not start send_thread";
@@ -952,6 +980,7 @@ void HalfAsyncCommunicator::InitImpl(const RpcCtxMap &send_varname_to_ctx,
   send_varname_to_ctx_ = std::move(send_varname_to_ctx);
   recv_varname_to_ctx_ = std::move(recv_varname_to_ctx);
   recv_scope_ = std::move(recv_scope);
+  InitGradientCompression(send_varname_to_ctx_);
 
   if (send_varname_to_ctx.size() == 0) {
     VLOG(0) << "nothing need to be send, will not start send_thread";
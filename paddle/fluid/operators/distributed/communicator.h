@@ -225,6 +225,10 @@ class Communicator {
   }
 
  protected:
+  // Configure the GradientCompressor for the sent variables with the
+  // communicator_grad_compress_* envs, by default nothing is compressed.
+  void InitGradientCompression(const RpcCtxMap& send_varname_to_ctx);
+
   bool running_ = false;
   static std::shared_ptr<Communicator> communicator_;
   static std::once_flag init_flag_;
@@ -0,0 +1,258 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/distributed/gradient_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+namespace {
+
+uint8_t* ResizeBytes(int64_t bytes, framework::Tensor* dst) {
+  dst->Resize(framework::make_ddim({bytes}));
+  return dst->mutable_data<uint8_t>(platform::CPUPlace());
+}
+
+int64_t TensorBytes(const framework::Tensor& tensor) {
+  return tensor.numel() * framework::SizeOfType(tensor.type());
+}
+
+int64_t NumBlocks(int64_t numel, int64_t block_size) {
+  return (numel + block_size - 1) / block_size;
+}
+
+}  // namespace
+
+GradientCompressType ParseGradientCompressType(const std::string& name) {
+  if (name.empty() || name == "none") {
+    return kNoCompress;
+  } else if (name == "fp16") {
+    return kFP16Compress;
+  } else if (name == "topk") {
+    return kTopKCompress;
+  } else if (name == "int8") {
+    return kInt8Compress;
+  }
+  PADDLE_THROW(platform::errors::InvalidArgument(
+      "Unknown gradient compress type %s, expected none, fp16, topk or int8.",
+      name));
+}
+
+void EncodeFP16(const float* src, int64_t numel, framework::Tensor* dst) {
+  auto* out = reinterpret_cast<platform::float16*>(
+      ResizeBytes(numel * sizeof(platform::float16), dst));
+  for (int64_t i = 0; i < numel; ++i) {
+    out[i] = static_cast<platform::float16>(src[i]);
+  }
+}
+
+void EncodeInt8(const float* src, int64_t numel, int block_size,
+                framework::Tensor* dst) {
+  PADDLE_ENFORCE_GT(block_size, 0,
+                    platform::errors::InvalidArgument(
+                        "The int8 block size should be positive."));
+  int64_t num_blocks = NumBlocks(numel, block_size);
+  uint8_t* out = ResizeBytes(
+      sizeof(uint32_t) + num_blocks * sizeof(float) + numel, dst);
+  uint32_t header = static_cast<uint32_t>(block_size);
+  memcpy(out, &header, sizeof(header));
+  auto* scales = reinterpret_cast<float*>(out + sizeof(uint32_t));
+  auto* values = reinterpret_cast<int8_t*>(scales + num_blocks);
+  for (int64_t b = 0; b < num_blocks; ++b) {
+    int64_t begin = b * block_size;
+    int64_t end = std::min(numel, begin + block_size);
+    float max_abs = 0;
+    for (int64_t i = begin; i < end; ++i) {
+      max_abs = std::max(max_abs, std::fabs(src[i]));
+    }
+    float scale = max_abs / 127.0f;
+    scales[b] = scale;
+    float inv_scale = scale > 0 ? 1.0f / scale : 0.0f;
+    for (int64_t i = begin; i < end; ++i) {
+      float q = std::round(src[i] * inv_scale);
+      values[i] = static_cast<int8_t>(std::max(-127.0f, std::min(127.0f, q)));
+    }
+  }
+}
+
+void EncodeTopK(const float* src, int64_t numel, int64_t k,
+                std::vector<float>* residual, framework::Tensor* dst) {
+  PADDLE_ENFORCE_GT(k, 0, platform::errors::InvalidArgument(
+                              "The top-k compression should send at least "
+                              "one element."));
+  k = std::min(k, numel);
+  std::vector<float> acc(src, src + numel);
+  if (residual != nullptr) {
+    if (residual->size() != static_cast<size_t>(numel)) {
+      residual->assign(numel, 0.0f);
+    }
+    for (int64_t i = 0; i < numel; ++i) {
+      acc[i] += (*residual)[i];
+    }
+  }
+  std::vector<uint32_t> indices(numel);
+  for (int64_t i = 0; i < numel; ++i) {
+    indices[i] = static_cast<uint32_t>(i);
+  }
+  std::nth_element(indices.begin(), indices.begin() + (k - 1), indices.end(),
+                   [&acc](uint32_t a, uint32_t b) {
+                     return std::fabs(acc[a]) > std::fabs(acc[b]);
+                   });
+  indices.resize(k);
+  // The ascending indices make the decoding, and the tests, sequential.
+  std::sort(indices.begin(), indices.end());
+  uint8_t* out = ResizeBytes(k * (sizeof(uint32_t) + sizeof(float)), dst);
+  auto* values = reinterpret_cast<float*>(out + k * sizeof(uint32_t));
+  memcpy(out, indices.data(), k * sizeof(uint32_t));
+  for (int64_t i = 0; i < k; ++i) {
+    values[i] = acc[indices[i]];
+    acc[indices[i]] = 0;
+  }
+  if (residual != nullptr) {
+    residual->swap(acc);
+  }
+}
+
+bool DecodeGradient(GradientCompressType type, const char* src, size_t size,
+                    int64_t numel, float* dst) {
+  switch (type) {
+    case kNoCompress: {
+      if (size != numel * sizeof(float)) return false;
+      memcpy(dst, src, size);
+      return true;
+    }
+    case kFP16Compress: {
+      if (size != numel * sizeof(platform::float16)) return false;
+      auto* in = reinterpret_cast<const platform::float16*>(src);
+      for (int64_t i = 0; i < numel; ++i) {
+        dst[i] = static_cast<float>(in[i]);
+      }
+      return true;
+    }
+    case kTopKCompress: {
+      size_t item = sizeof(uint32_t) + sizeof(float);
+      if (size % item != 0) return false;
+      int64_t k = size / item;
+      std::vector<uint32_t> indices(k);
+      std::vector<float> values(k);
+      memcpy(indices.data(), src, k * sizeof(uint32_t));
+      memcpy(values.data(), src + k * sizeof(uint32_t), k * sizeof(float));
+      std::fill(dst, dst + numel, 0.0f);
+      for (int64_t i = 0; i < k; ++i) {
+        if (indices[i] >= numel) return false;
+        dst[indices[i]] = values[i];
+      }
+      return true;
+    }
+    case kInt8Compress: {
+      if (size < sizeof(uint32_t)) return false;
+      uint32_t block_size = 0;
+      memcpy(&block_size, src, sizeof(block_size));
+      if (block_size == 0) return false;
+      int64_t num_blocks = NumBlocks(numel, block_size);
+      if (size != sizeof(uint32_t) + num_blocks * sizeof(float) + numel) {
+        return false;
+      }
+      std::vector<float> scales(num_blocks);
+      memcpy(scales.data(), src + sizeof(uint32_t),
+             num_blocks * sizeof(float));
+      auto* values = reinterpret_cast<const int8_t*>(
+          src + sizeof(uint32_t) + num_blocks * sizeof(float));
+      for (int64_t i = 0; i < numel; ++i) {
+        dst[i] = values[i] * scales[i / block_size];
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+GradientCompressor* GradientCompressor::GetInstance() {
+  static GradientCompressor instance;
+  return &instance;
+}
+
+void GradientCompressor::SetConfig(const std::string& varname,
+                                   const GradientCompressConfig& config) {
+  auto state = std::make_shared<State>();
+  state->config = config;
+  std::lock_guard<std::mutex> lock(mutex_);
+  states_[varname] = state;
+}
+
+void GradientCompressor::ClearConfigs() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  states_.clear();
+}
+
+GradientCompressType GradientCompressor::Compress(
+    const std::string& varname, const framework::Tensor& src, bool dense,
+    framework::Tensor* dst) {
+  std::shared_ptr<State> state;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = states_.find(varname);
+    if (it != states_.end()) {
+      state = it->second;
+    }
+  }
+  int64_t raw_bytes = TensorBytes(src);
+  raw_bytes_ += raw_bytes;
+  GradientCompressType type =
+      state == nullptr ? kNoCompress : state->config.type;
+  if (type == kTopKCompress && !dense) {
+    type = kNoCompress;
+  }
+  if (type == kNoCompress || !platform::is_cpu_place(src.place()) ||
+      src.type() != framework::proto::VarType::FP32 ||
+      src.numel() < state->config.min_numel) {
+    sent_bytes_ += raw_bytes;
+    return kNoCompress;
+  }
+  const float* data = src.data<float>();
+  int64_t numel = src.numel();
+  switch (type) {
+    case kFP16Compress:
+      EncodeFP16(data, numel, dst);
+      break;
+    case kTopKCompress: {
+      int64_t k = std::llround(state->config.topk_ratio *
+                               static_cast<double>(numel));
+      std::lock_guard<std::mutex> lock(state->mutex);
+      EncodeTopK(data, numel, std::max<int64_t>(k, 1), &state->residual,
+                 dst);
+      break;
+    }
+    case kInt8Compress:
+      EncodeInt8(data, numel, state->config.int8_block_size, dst);
+      break;
+    default:
+      break;
+  }
+  sent_bytes_ += TensorBytes(*dst);
+  return type;
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
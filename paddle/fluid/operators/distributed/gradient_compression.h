@@ -0,0 +1,110 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "paddle/fluid/framework/tensor.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+// The compression of the serialized field of a VariableMessage, the values
+// are the same as sendrecv::CompressType.
+enum GradientCompressType {
+  kNoCompress = 0,
+  // the fp32 values cast to fp16
+  kFP16Compress = 1,
+  // the uint32 indices, then the fp32 values, of the elements with the
+  // largest magnitude, the others are 0
+  kTopKCompress = 2,
+  // the uint32 block size, the fp32 scale of each block, then the int8
+  // values, each value is its int8 times the scale of its block
+  kInt8Compress = 3,
+};
+
+GradientCompressType ParseGradientCompressType(const std::string& name);
+
+struct GradientCompressConfig {
+  GradientCompressType type = kNoCompress;
+  // kTopKCompress sends this part of the elements
+  float topk_ratio = 0.01f;
+  // kInt8Compress quantizes blocks of this many elements
+  int int8_block_size = 256;
+  // the smaller tensors are sent as they are
+  int64_t min_numel = 1024;
+};
+
+// Encode numel floats into dst, an uint8 tensor on CPU.
+void EncodeFP16(const float* src, int64_t numel, framework::Tensor* dst);
+void EncodeInt8(const float* src, int64_t numel, int block_size,
+                framework::Tensor* dst);
+// Select the k elements of src with the largest magnitude and encode them.
+// The residual, the error feedback, is added to src before the selection,
+// then keeps the values not sent. The residual may be nullptr.
+void EncodeTopK(const float* src, int64_t numel, int64_t k,
+                std::vector<float>* residual, framework::Tensor* dst);
+
+// Decode the size bytes of src, compressed with type, into numel floats.
+// Return false if the bytes do not match numel.
+bool DecodeGradient(GradientCompressType type, const char* src, size_t size,
+                    int64_t numel, float* dst);
+
+// The compression of the gradients a trainer sends, configured per
+// variable name. The top-k compression keeps the residual of each variable
+// between the sends.
+class GradientCompressor {
+ public:
+  static GradientCompressor* GetInstance();
+
+  void SetConfig(const std::string& varname,
+                 const GradientCompressConfig& config);
+  void ClearConfigs();
+
+  // Compress the fp32 CPU tensor sent as varname into dst, an uint8 tensor
+  // on CPU. Return kNoCompress, and leave dst alone, if the variable is not
+  // configured or the tensor is not compressible. The top-k compression
+  // needs the same elements in every send, so it is only applied to dense
+  // tensors.
+  GradientCompressType Compress(const std::string& varname,
+                                const framework::Tensor& src, bool dense,
+                                framework::Tensor* dst);
+
+  // The bytes of the tensors given to Compress(), and the bytes sent.
+  int64_t RawBytes() const { return raw_bytes_; }
+  int64_t SentBytes() const { return sent_bytes_; }
+
+ private:
+  struct State {
+    GradientCompressConfig config;
+    std::mutex mutex;
+    std::vector<float> residual;
+  };
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<State>> states_;
+  std::atomic<int64_t> raw_bytes_{0};
+  std::atomic<int64_t> sent_bytes_{0};
+};
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
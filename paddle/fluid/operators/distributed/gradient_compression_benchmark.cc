@@ -0,0 +1,124 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Train a linear regression with SGD, sending the gradient through the
+// GradientCompressor and decoding it as the parameter server does, in
+// one process. Report the bytes sent per step and the loss at the end for
+// each compression.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/operators/distributed/gradient_compression.h"
+
+DEFINE_int32(dim, 1024, "The number of the weights.");
+DEFINE_int32(batch_size, 32, "The number of the samples per step.");
+DEFINE_int32(steps, 2000, "The number of the steps.");
+DEFINE_double(lr, 0.02, "The learning rate.");
+DEFINE_double(topk_ratio, 0.01, "The ratio of the top-k compression.");
+DEFINE_int32(int8_block_size, 256, "The block size of the int8 compression.");
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+class Problem {
+ public:
+  Problem() : rng_(0) {
+    std::normal_distribution<float> normal;
+    target_.resize(FLAGS_dim);
+    for (auto& w : target_) w = normal(rng_);
+  }
+
+  // Sample a batch, and return its loss and the gradient of w.
+  float Gradient(const std::vector<float>& w, float* grad) {
+    std::normal_distribution<float> normal;
+    std::vector<float> x(FLAGS_dim);
+    std::fill(grad, grad + FLAGS_dim, 0.0f);
+    float loss = 0;
+    for (int b = 0; b < FLAGS_batch_size; ++b) {
+      float err = 0;
+      for (int i = 0; i < FLAGS_dim; ++i) {
+        x[i] = normal(rng_);
+        err += x[i] * (w[i] - target_[i]);
+      }
+      loss += err * err / 2;
+      for (int i = 0; i < FLAGS_dim; ++i) {
+        grad[i] += err * x[i] / FLAGS_batch_size;
+      }
+    }
+    return loss / FLAGS_batch_size;
+  }
+
+ private:
+  std::mt19937 rng_;
+  std::vector<float> target_;
+};
+
+void Train(const std::string& name) {
+  auto* compressor = GradientCompressor::GetInstance();
+  compressor->ClearConfigs();
+  GradientCompressConfig config;
+  config.type = ParseGradientCompressType(name);
+  config.topk_ratio = FLAGS_topk_ratio;
+  config.int8_block_size = FLAGS_int8_block_size;
+  compressor->SetConfig("w@GRAD", config);
+  int64_t sent_before = compressor->SentBytes();
+
+  Problem problem;
+  std::vector<float> w(FLAGS_dim, 0.0f);
+  std::vector<float> decoded(FLAGS_dim);
+  framework::Tensor grad;
+  grad.Resize(framework::make_ddim({FLAGS_dim}));
+  float* grad_data = grad.mutable_data<float>(platform::CPUPlace());
+  framework::Tensor encoded;
+  float loss = 0;
+  for (int step = 0; step < FLAGS_steps; ++step) {
+    loss = problem.Gradient(w, grad_data);
+    auto type = compressor->Compress("w@GRAD", grad, true, &encoded);
+    const framework::Tensor& sent = type == kNoCompress ? grad : encoded;
+    CHECK(DecodeGradient(type,
+                         reinterpret_cast<const char*>(sent.data<void>()),
+                         sent.numel() * framework::SizeOfType(sent.type()),
+                         FLAGS_dim, decoded.data()));
+    for (int i = 0; i < FLAGS_dim; ++i) {
+      w[i] -= FLAGS_lr * decoded[i];
+    }
+  }
+  LOG(INFO) << name << ": "
+            << (compressor->SentBytes() - sent_before) / FLAGS_steps
+            << " bytes/step, loss " << loss;
+}
+
+void RunBenchmark() {
+  LOG(INFO) << "dim " << FLAGS_dim << ", initial loss about "
+            << FLAGS_dim / 2;
+  for (auto name : {"none", "fp16", "topk", "int8"}) {
+    Train(name);
+  }
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::operators::distributed::RunBenchmark();
+  return 0;
+}
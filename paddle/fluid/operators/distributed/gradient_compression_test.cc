@@ -0,0 +1,127 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/distributed/gradient_compression.h"
+
+#include <cmath>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace operators {
+namespace distributed {
+
+namespace {
+
+std::vector<float> MakeGradient(int64_t numel) {
+  std::vector<float> grad(numel);
+  for (int64_t i = 0; i < numel; ++i) {
+    grad[i] = std::sin(static_cast<float>(i)) * (1 + i % 7);
+  }
+  return grad;
+}
+
+std::vector<float> Decode(GradientCompressType type,
+                          const framework::Tensor& tensor, int64_t numel) {
+  std::vector<float> out(numel, -1);
+  EXPECT_TRUE(DecodeGradient(
+      type, reinterpret_cast<const char*>(tensor.data<uint8_t>()),
+      tensor.numel(), numel, out.data()));
+  return out;
+}
+
+}  // namespace
+
+TEST(GradientCompression, FP16) {
+  auto grad = MakeGradient(1000);
+  framework::Tensor encoded;
+  EncodeFP16(grad.data(), grad.size(), &encoded);
+  ASSERT_EQ(encoded.numel(), 1000 * 2);
+  auto out = Decode(kFP16Compress, encoded, grad.size());
+  for (size_t i = 0; i < grad.size(); ++i) {
+    ASSERT_NEAR(out[i], grad[i], 1e-2);
+  }
+}
+
+TEST(GradientCompression, Int8) {
+  auto grad = MakeGradient(1000);
+  framework::Tensor encoded;
+  EncodeInt8(grad.data(), grad.size(), 64, &encoded);
+  // the block size, 16 scales and the values
+  ASSERT_EQ(encoded.numel(), 4 + 16 * 4 + 1000);
+  auto out = Decode(kInt8Compress, encoded, grad.size());
+  for (size_t i = 0; i < grad.size(); ++i) {
+    // half a step of the largest scale
+    ASSERT_NEAR(out[i], grad[i], 7.0 / 127 / 2 + 1e-5);
+  }
+  std::vector<float> wrong(grad.size() + 1);
+  ASSERT_FALSE(DecodeGradient(
+      kInt8Compress, reinterpret_cast<const char*>(encoded.data<uint8_t>()),
+      encoded.numel(), wrong.size(), wrong.data()));
+}
+
+TEST(GradientCompression, TopKErrorFeedback) {
+  std::vector<float> grad = {0.1f, -3.0f, 0.5f, 2.0f, -0.2f};
+  std::vector<float> residual;
+  framework::Tensor encoded;
+  EncodeTopK(grad.data(), grad.size(), 2, &residual, &encoded);
+  auto out = Decode(kTopKCompress, encoded, grad.size());
+  ASSERT_EQ(out, std::vector<float>({0, -3.0f, 0, 2.0f, 0}));
+  ASSERT_EQ(residual, std::vector<float>({0.1f, 0, 0.5f, 0, -0.2f}));
+
+  // The residual is sent once it grows larger than the new gradient.
+  std::vector<float> zero(grad.size(), 0);
+  EncodeTopK(zero.data(), zero.size(), 1, &residual, &encoded);
+  out = Decode(kTopKCompress, encoded, grad.size());
+  ASSERT_EQ(out, std::vector<float>({0, 0, 0.5f, 0, 0}));
+  ASSERT_EQ(residual, std::vector<float>({0.1f, 0, 0, 0, -0.2f}));
+}
+
+TEST(GradientCompressor, PerVariable) {
+  auto* compressor = GradientCompressor::GetInstance();
+  compressor->ClearConfigs();
+  GradientCompressConfig config;
+  config.type = kTopKCompress;
+  config.topk_ratio = 0.1f;
+  config.min_numel = 100;
+  compressor->SetConfig("w@GRAD", config);
+  config.type = kFP16Compress;
+  compressor->SetConfig("b@GRAD", config);
+
+  auto grad = MakeGradient(1000);
+  framework::Tensor src;
+  src.Resize(framework::make_ddim({10, 100}));
+  std::copy(grad.begin(), grad.end(),
+            src.mutable_data<float>(platform::CPUPlace()));
+  framework::Tensor dst;
+  ASSERT_EQ(compressor->Compress("w@GRAD", src, true, &dst), kTopKCompress);
+  ASSERT_EQ(dst.numel(), 100 * 8);
+  // The rows of a SelectedRows change in every send, so no top-k.
+  ASSERT_EQ(compressor->Compress("w@GRAD", src, false, &dst), kNoCompress);
+  ASSERT_EQ(compressor->Compress("b@GRAD", src, true, &dst), kFP16Compress);
+  ASSERT_EQ(dst.numel(), 1000 * 2);
+  ASSERT_EQ(compressor->Compress("x@GRAD", src, true, &dst), kNoCompress);
+
+  src.Resize(framework::make_ddim({10}));
+  ASSERT_EQ(compressor->Compress("b@GRAD", src, true, &dst), kNoCompress);
+  compressor->ClearConfigs();
+
+  ASSERT_EQ(ParseGradientCompressType("int8"), kInt8Compress);
+  ASSERT_EQ(ParseGradientCompressType(""), kNoCompress);
+}
+
+}  // namespace distributed
+}  // namespace operators
+}  // namespace paddle
@@ -34,6 +34,32 @@ namespace paddle {
 namespace operators {
 namespace distributed {
 
+// The size of the tag and the length of a length delimited field.
+static size_t VarlengthBeginningSize(int tag, size_t length) {
+  return VarintLength((tag << 3) | 2) + VarintLength(length);
+}
+
+// A slice of the meta followed by the beginning of the field tag, or by the
+// whole field if data is not nullptr.
+static ::grpc::Slice EncodeMetaSlice(const VarMsg& request, int tag,
+                                     size_t length,
+                                     const char* data = nullptr) {
+  size_t meta_size = request.ByteSizeLong();
+  size_t size = meta_size + VarlengthBeginningSize(tag, length);
+  if (data != nullptr) {
+    size += length;
+  }
+  ::grpc::Slice slice(size);
+  char* buf = reinterpret_cast<char*>(const_cast<uint8_t*>(slice.begin()));
+  request.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(buf));
+  ProtoEncodeHelper e(buf + meta_size, size - meta_size);
+  e.WriteVarlengthBeginning(tag, length);
+  if (data != nullptr) {
+    memcpy(buf + meta_size + e.size(), data, length);
+  }
+  return slice;
+}
+
 void SerializeToByteBuffer(const std::string& name, framework::Variable* var,
                            const platform::DeviceContext& ctx,
                            ::grpc::ByteBuffer* msg, const std::string& out_name,
@@ -41,105 +67,55 @@ void SerializeToByteBuffer(const std::string& name, framework::Variable* var,
                            const std::string& table_name) {
   platform::RecordRPCEvent record_event("serial");
   VarMsg request;
-  TensorPayload* payload = nullptr;
-
-  request.set_varname(name);
-  request.set_trainer_id(trainer_id);
-  // Note: normally the profiler is enabled in 1 trainer, hence only
-  // 1 trainer returns true for ShouldSendProfileState(). It tells PS
-  // servers the trainer's profiling state so that PS can follow the
-  // trainer.
-  if (platform::ShouldSendProfileState()) {
-    if (platform::IsProfileEnabled()) {
-      request.set_profile(platform::kEnableProfiler);
-    } else {
-      request.set_profile(platform::kDisableProfiler);
-    }
-  }
-  if (!out_name.empty()) {
-    request.set_out_varname(out_name);
-  }
-  if (!table_name.empty()) {
-    request.set_table_name(table_name);
-  }
-  if (var->IsType<framework::LoDTensor>()) {
-    request.set_type(::sendrecv::LOD_TENSOR);
-    payload = new TensorPayload(GetTensorPayload(var, ctx, &request));
-  } else if (var->IsType<framework::SelectedRows>()) {
-    request.set_type(::sendrecv::SELECTED_ROWS);
-    payload = new TensorPayload(GetSelectedRowsPayload(var, ctx, &request));
-#ifdef PADDLE_WITH_NCCL
-  } else if (var->IsType<ncclUniqueId>()) {
-    request.set_type(::sendrecv::NCCL_ID);
-#endif
-  } else {
-    PADDLE_THROW("Serialize does not support type: %s",
-                 typeid(var->Type()).name());
-  }
+  VarPayloads payloads = GetVarPayloads(name, var, ctx, &request, out_name,
+                                        trainer_id, table_name);
 
-  std::string header;
-  request.AppendToString(&header);
-  auto buffer = std::unique_ptr<char[]>(new char[1024]);
-  void* buf = buffer.get();
-  ProtoEncodeHelper e(static_cast<char*>(buf), 1024);
-  e.WriteRawBytes(std::string(header.data(), header.size()));
 // NCCLID is copied directly to the message, return bytebuffer
 // with only one slice if serializing NCCLID.
 #ifdef PADDLE_WITH_NCCL
   if (var->IsType<ncclUniqueId>()) {
-    e.WriteVarlengthBeginning(VarMsg::kSerializedFieldNumber,
-                              NCCL_UNIQUE_ID_BYTES);
     const ncclUniqueId& uid = var->Get<ncclUniqueId>();
-    e.WriteRawBytes(std::string(uid.internal, NCCL_UNIQUE_ID_BYTES));
-
-    // for serialize NCCL_ID
-    ::grpc::Slice slices(e.size());
-    memcpy(const_cast<uint8_t*>(slices.begin()), e.data(), e.size());
-    ::grpc::ByteBuffer tmp(&slices, 1);
+    ::grpc::Slice slice =
+        EncodeMetaSlice(request, VarMsg::kSerializedFieldNumber,
+                        NCCL_UNIQUE_ID_BYTES, uid.internal);
+    ::grpc::ByteBuffer tmp(&slice, 1);
     msg->Swap(&tmp);
     return;
   }
 #endif
-  PADDLE_ENFORCE_NOT_NULL(payload);
-
-  e.WriteVarlengthBeginning(VarMsg::kSerializedFieldNumber,
-                            payload->memory_size());
+  PADDLE_ENFORCE_NOT_NULL(payloads.tensor);
+  TensorPayload* payload = payloads.tensor.release();
   if (payload->memory_size() >= std::numeric_limits<int>::max()) {
     LOG(FATAL) << "FATAL error: varname:" << name
                << ", vlen:" << payload->memory_size()
                << " >= std::numeric_limits<int>::max():"
                << std::numeric_limits<int>::max() << ", so exit!";
   }
-  // steal reference of tensor data
-  ::grpc::Slice slices[4];  // metadata, tensor, rows meta, rows
+  // The meta and the beginning of the tensor data are encoded into a small
+  // slice, the slice of the tensor data references the memory of the
+  // variable.
+  ::grpc::Slice slices[3];  // metadata, tensor, rows
   int num_slices = 2;       // only SelectedRows have rows buffer
-  slices[0] = ::grpc::Slice(e.size());
-  memcpy(const_cast<uint8_t*>(slices[0].begin()), e.data(), e.size());
+  slices[0] = EncodeMetaSlice(request, VarMsg::kSerializedFieldNumber,
+                              payload->memory_size());
   slices[1] = ::grpc::Slice(
       grpc_slice_new_with_user_data(payload->ptr(), payload->memory_size(),
                                     SerializeDestroyCallback, payload),
       ::grpc::Slice::STEAL_REF);
 
   if (var->IsType<framework::SelectedRows>()) {
-    auto* slr = var->GetMutable<framework::SelectedRows>();
-    ProtoEncodeHelper e2(static_cast<char*>(buf), 128);
-
-    PADDLE_ENFORCE(VectorElemName(slr->rows()) == typeid(int64_t).name());
-    size_t rows_memory_size = slr->rows().size() * sizeof(int64_t);
-
-    e2.WriteVarlengthBeginning(VarMsg::kRowsFieldNumber, rows_memory_size);
-    slices[2] = ::grpc::Slice(e2.size());
-    memcpy(const_cast<uint8_t*>(slices[2].begin()), e2.data(), e2.size());
-
-    slices[3] = ::grpc::Slice(
-        grpc_slice_new_with_user_data(
-            const_cast<void*>(
-                reinterpret_cast<const void*>(slr->rows().data())),
-            rows_memory_size, [](void* backing) {},
-            const_cast<char*>(
-                reinterpret_cast<const char*>(slr->rows().data()))),
-        ::grpc::Slice::STEAL_REF);
-    num_slices = 4;
+    size_t rows_size = payloads.rows_size;
+    slices[2] = ::grpc::Slice(
+        VarlengthBeginningSize(VarMsg::kRowsFieldNumber, rows_size) +
+        rows_size);
+    char* buf =
+        reinterpret_cast<char*>(const_cast<uint8_t*>(slices[2].begin()));
+    ProtoEncodeHelper e(buf, slices[2].size());
+    e.WriteVarlengthBeginning(VarMsg::kRowsFieldNumber, rows_size);
+    if (rows_size > 0) {
+      memcpy(buf + e.size(), payloads.rows, rows_size);
+    }
+    num_slices = 3;
   }
 
   ::grpc::ByteBuffer tmp(&slices[0], num_slices);
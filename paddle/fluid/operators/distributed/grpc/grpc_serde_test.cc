@@ -22,6 +22,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/framework/variable.h"
 #include "paddle/fluid/operators/distributed/distributed.h"
+#include "paddle/fluid/operators/distributed/gradient_compression.h"
 #include "paddle/fluid/operators/distributed/grpc/grpc_serde.h"
 #include "paddle/fluid/operators/distributed/grpc/grpc_variable_response.h"
 #include "paddle/fluid/operators/distributed/sendrecvop_utils.h"
@@ -213,6 +214,52 @@ TEST(LodTensor, Run) {
 #endif
 }
 
+TEST(LodTensor, Compressed) {
+  platform::CPUPlace place;
+  platform::DeviceContextPool& pool = platform::DeviceContextPool::Instance();
+  auto& ctx = *pool.Get(place);
+  framework::Variable var;
+  auto* tensor = var.GetMutable<framework::LoDTensor>();
+  tensor->Resize(framework::make_ddim({512, 8}));
+  float* data = tensor->mutable_data<float>(place);
+  for (int i = 0; i < 512 * 8; ++i) {
+    data[i] = (i % 255 - 127) / 10.0f;
+  }
+
+  auto* compressor = operators::distributed::GradientCompressor::GetInstance();
+  operators::distributed::GradientCompressConfig config;
+  config.type = operators::distributed::kInt8Compress;
+  compressor->SetConfig("myvar", config);
+  ::grpc::ByteBuffer msg;
+  operators::distributed::SerializeToByteBuffer("myvar", &var, ctx, &msg);
+  compressor->ClearConfigs();
+
+  std::vector<::grpc::Slice> slices;
+  (void)msg.Dump(&slices);
+  std::string tmp;
+  for (const auto& s : slices) {
+    tmp.append(reinterpret_cast<const char*>(s.begin()), s.size());
+  }
+  sendrecv::VariableMessage varmsg;
+  EXPECT_TRUE(varmsg.ParseFromString(tmp));
+  EXPECT_EQ(varmsg.compress_type(), sendrecv::INT8_COMPRESS);
+  // the block size, 16 scales and the int8 values
+  EXPECT_EQ(varmsg.serialized().size(),
+            static_cast<size_t>(4 + 16 * 4 + 512 * 8));
+
+  framework::Scope scope;
+  scope.Var("myvar");
+  operators::distributed::GRPCVariableResponse resp(&scope, &ctx);
+  EXPECT_EQ(resp.Parse(msg), 0);
+  auto tensor2 = resp.GetVar()->Get<framework::LoDTensor>();
+  EXPECT_EQ(tensor2.dims(), tensor->dims());
+  const float* data2 = tensor2.data<float>();
+  for (int i = 0; i < 512 * 8; ++i) {
+    // the values are multiples of the scale 12.7 / 127
+    EXPECT_NEAR(data2[i], data[i], 1e-5);
+  }
+}
+
 TEST(SelectedRows, Run) {
   platform::CPUPlace place;
   RunSerdeTestSelectedRows(place);
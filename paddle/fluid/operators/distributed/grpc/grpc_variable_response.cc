@@ -315,6 +315,15 @@ int GRPCVariableResponse::Parse(Source* source) {
         meta_.set_table_name(temp);
         break;
       }
+      case sendrecv::VariableMessage::kCompressTypeFieldNumber: {
+        uint32_t v = 0;
+        if ((wt != WIRETYPE_VARINT) || !input.ReadVarint32(&v)) {
+          return tag;
+        }
+
+        meta_.set_compress_type(static_cast<::sendrecv::CompressType>(v));
+        break;
+      }
       default: {
         // Unknown tag, return unknown error.
         return -1;
@@ -0,0 +1,122 @@
+// Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Send a LoDTensor, or a SelectedRows, from a client to a server in the
+// same process over the loopback, as rpc_server_test does, and report the
+// GB/s of the serialization, the transport and the deserialization into
+// the server's variable.
+
+#include <stdlib.h>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/operators/distributed/distributed.h"
+#include "paddle/fluid/operators/distributed/request_handler_impl.h"
+#include "paddle/fluid/operators/distributed/rpc_client.h"
+#include "paddle/fluid/operators/distributed/rpc_server.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/string/printf.h"
+
+DEFINE_int64(mbytes, 64, "The size of the sent variable in MB.");
+DEFINE_int32(iters, 50, "The number of the sends.");
+DEFINE_bool(selected_rows, false, "Send a SelectedRows of 128 wide rows.");
+
+namespace framework = paddle::framework;
+namespace platform = paddle::platform;
+namespace distributed = paddle::operators::distributed;
+
+namespace {
+
+constexpr int64_t kWidth = 128;
+
+void InitVar(framework::Scope* scope, const platform::CPUPlace& place) {
+  int64_t numel = FLAGS_mbytes * (1 << 20) / sizeof(float);
+  auto* var = scope->Var("x");
+  framework::Tensor* tensor = nullptr;
+  if (FLAGS_selected_rows) {
+    auto* slr = var->GetMutable<framework::SelectedRows>();
+    int64_t rows = numel / kWidth;
+    slr->set_height(rows);
+    for (int64_t i = 0; i < rows; ++i) {
+      slr->mutable_rows()->push_back(i);
+    }
+    tensor = slr->mutable_value();
+    tensor->Resize(framework::make_ddim({rows, kWidth}));
+  } else {
+    tensor = var->GetMutable<framework::LoDTensor>();
+    tensor->Resize(framework::make_ddim({numel}));
+  }
+  float* data = tensor->mutable_data<float>(place);
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = static_cast<float>(i % 1024);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  setenv("http_proxy", "", 1);
+  setenv("https_proxy", "", 1);
+
+  platform::CPUPlace place;
+  platform::CPUDeviceContext ctx(place);
+
+  // The server receives into the pre-allocated variable of its scope.
+  framework::Scope server_scope;
+  InitVar(&server_scope, place);
+  std::unique_ptr<distributed::RequestHandler> handler(
+      new distributed::RequestSendHandler(distributed::DistributedMode::kSync));
+  std::unique_ptr<distributed::RPCServer> server(
+      new RPCSERVER_T("127.0.0.1:0", 1));
+  handler->SetDevCtx(&ctx);
+  handler->SetScope(&server_scope);
+  handler->SetRPCServer(server.get());
+  server->RegisterRPC(distributed::kRequestSend, handler.get());
+  std::thread server_thread(
+      std::bind(&distributed::RPCServer::StartServer, server.get()));
+  server->WaitServerReady();
+  std::string ep =
+      paddle::string::Sprintf("127.0.0.1:%d", server->GetSelectedPort());
+
+  framework::Scope scope;
+  InitVar(&scope, place);
+  distributed::RPCClient* client =
+      distributed::RPCClient::GetInstance<RPCCLIENT_T>(0);
+  // Warm up the connection and the server's allocation.
+  client->AsyncSendVar(ep, ctx, scope, "x");
+  client->Wait();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_iters; ++i) {
+    client->AsyncSendVar(ep, ctx, scope, "x");
+    client->Wait();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  LOG(INFO) << (FLAGS_selected_rows ? "SelectedRows" : "LoDTensor") << " of "
+            << FLAGS_mbytes << " MB: "
+            << FLAGS_mbytes * FLAGS_iters / 1024.0 / seconds << " GB/s";
+
+  server->ShutDown();
+  server_thread.join();
+  return 0;
+}
@@ -19,9 +19,11 @@ limitations under the License. */
 #include <thread>  // NOLINT
 
 #include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/operators/distributed/gradient_compression.h"
 #include "paddle/fluid/operators/distributed/sendrecvop_utils.h"
 #include "paddle/fluid/operators/distributed/variable_response.h"
 #include "paddle/fluid/platform/port.h"
+#include "paddle/fluid/platform/profiler.h"
 
 DEFINE_bool(rpc_disable_reuse_port, false, "Disable SO_REUSEPORT or not.");
 DEFINE_int32(rpc_retry_bind_port, 3,
@@ -56,6 +58,21 @@ static TensorPayload GetCommunicationAllocationFromTensor(
     return TensorPayload(tensor);
   }
 }
+
+// Compress the tensor if the communicator configured its variable, the
+// receiver decodes it in VariableResponse.
+static TensorPayload GetCompressedOrPlainPayload(
+    const platform::DeviceContext& ctx, const framework::Tensor& tensor,
+    bool dense, VarMsg* request) {
+  framework::Tensor compressed;
+  auto type = GradientCompressor::GetInstance()->Compress(
+      request->varname(), tensor, dense, &compressed);
+  if (type == kNoCompress) {
+    return GetCommunicationAllocationFromTensor(ctx, tensor);
+  }
+  request->set_compress_type(static_cast<sendrecv::CompressType>(type));
+  return TensorPayload(compressed);
+}
 TensorPayload GetTensorPayload(framework::Variable* var,
                                const platform::DeviceContext& ctx,
                                VarMsg* request) {
@@ -76,7 +93,7 @@ TensorPayload GetTensorPayload(framework::Variable* var,
       }
     }
   }
-  return GetCommunicationAllocationFromTensor(ctx, tensor);
+  return GetCompressedOrPlainPayload(ctx, tensor, true, request);
 }
 
 TensorPayload GetSelectedRowsPayload(framework::Variable* var,
@@ -92,7 +109,54 @@ TensorPayload GetSelectedRowsPayload(framework::Variable* var,
   }
 
   auto* tensor = slr->mutable_value();
-  return GetCommunicationAllocationFromTensor(ctx, *tensor);
+  return GetCompressedOrPlainPayload(ctx, *tensor, false, request);
+}
+
+VarPayloads GetVarPayloads(const std::string& name, framework::Variable* var,
+                           const platform::DeviceContext& ctx, VarMsg* request,
+                           const std::string& out_varname, int trainer_id,
+                           const std::string& table_name) {
+  VarPayloads payloads;
+  request->set_varname(name);
+  request->set_trainer_id(trainer_id);
+  // Note: normally the profiler is enabled in 1 trainer, hence only
+  // 1 trainer returns true for ShouldSendProfileState(). It tells PS
+  // servers the trainer's profiling state so that PS can follow the
+  // trainer.
+  if (platform::ShouldSendProfileState()) {
+    if (platform::IsProfileEnabled()) {
+      request->set_profile(platform::kEnableProfiler);
+    } else {
+      request->set_profile(platform::kDisableProfiler);
+    }
+  }
+  if (!out_varname.empty()) {
+    request->set_out_varname(out_varname);
+  }
+  if (!table_name.empty()) {
+    request->set_table_name(table_name);
+  }
+  if (var->IsType<framework::LoDTensor>()) {
+    request->set_type(::sendrecv::LOD_TENSOR);
+    payloads.tensor.reset(
+        new TensorPayload(GetTensorPayload(var, ctx, request)));
+  } else if (var->IsType<framework::SelectedRows>()) {
+    request->set_type(::sendrecv::SELECTED_ROWS);
+    payloads.tensor.reset(
+        new TensorPayload(GetSelectedRowsPayload(var, ctx, request)));
+    auto* slr = var->GetMutable<framework::SelectedRows>();
+    PADDLE_ENFORCE(VectorElemName(slr->rows()) == typeid(int64_t).name());
+    payloads.rows = reinterpret_cast<const char*>(slr->rows().data());
+    payloads.rows_size = slr->rows().size() * sizeof(int64_t);
+#ifdef PADDLE_WITH_NCCL
+  } else if (var->IsType<ncclUniqueId>()) {
+    request->set_type(::sendrecv::NCCL_ID);
+#endif
+  } else {
+    PADDLE_THROW("Serialize does not support type: %s",
+                 typeid(var->Type()).name());
+  }
+  return payloads;
 }
 
 TensorPayload::TensorPayload(std::shared_ptr<memory::Allocation> allocation)
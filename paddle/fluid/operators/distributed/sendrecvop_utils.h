@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 #include <iostream>
+#include <memory>
 #include <string>
 #include <typeindex>
 #include <vector>
@@ -57,6 +58,25 @@ inline void SerializeDestroyCallback(void* payload) {
   }
 }
 
+// The payloads of a variable message. The RPC backends send the tensor
+// payload from the memory of the variable without copying it, the payload
+// holds its allocation until the backend frees it. The rows of a
+// SelectedRows are only valid during serialization, the backends copy them
+// into the message since they are small and the variable may reallocate
+// them before the send completes.
+struct VarPayloads {
+  std::unique_ptr<TensorPayload> tensor;
+  const char* rows = nullptr;
+  size_t rows_size = 0;
+};
+
+// Fill the meta of request for var and return its payloads. An NCCL_ID
+// variable has no payloads, the backends copy the id.
+VarPayloads GetVarPayloads(const std::string& name, framework::Variable* var,
+                           const platform::DeviceContext& ctx, VarMsg* request,
+                           const std::string& out_varname, int trainer_id,
+                           const std::string& table_name);
+
 TensorPayload GetTensorPayload(framework::Variable* var,
                                const platform::DeviceContext& ctx,
                                VarMsg* request);
@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/operators/distributed/variable_response.h"
 #include <vector>
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/operators/distributed/gradient_compression.h"
 #include "paddle/fluid/operators/distributed/sendrecvop_utils.h"
 
 DEFINE_string(rpc_server_profile_path, "./profile_ps",
@@ -113,6 +115,10 @@ bool VariableResponse::CopyLodTensorData(
   }
   tensor->set_lod(lod);
 
+  if (meta_.compress_type() != sendrecv::NO_COMPRESS) {
+    return DecodeTensorData(input, ctx, length, tensor);
+  }
+
   void* tensor_data =
       tensor->mutable_data(ctx.GetPlace(), ToVarType(meta_.data_type()));
 
@@ -140,6 +146,9 @@ bool VariableResponse::CopySelectRowsTensorData(
   slr->set_height(meta_.slr_height());
   auto* tensor = slr->mutable_value();
   tensor->Resize(dims);
+  if (meta_.compress_type() != sendrecv::NO_COMPRESS) {
+    return DecodeTensorData(input, ctx, length, tensor);
+  }
   PADDLE_ENFORCE_EQ(
       static_cast<size_t>(tensor->numel()),
       length / framework::SizeOfType(paddle::operators::distributed::ToVarType(
@@ -155,6 +164,34 @@ bool VariableResponse::CopySelectRowsTensorData(
   return true;
 }
 
+bool VariableResponse::DecodeTensorData(
+    ::google::protobuf::io::CodedInputStream* input,
+    const platform::DeviceContext& ctx, int length, framework::Tensor* tensor) {
+  PADDLE_ENFORCE_EQ(meta_.data_type(), sendrecv::VariableMessage::FP32,
+                    platform::errors::InvalidArgument(
+                        "Only the FP32 variables are compressed, but %s is %d.",
+                        meta_.varname(), meta_.data_type()));
+  std::vector<char> buffer(length);
+  if (!ReadRaw(input, ctx, platform::CPUPlace(), buffer.data(), length)) {
+    return false;
+  }
+  auto type = static_cast<GradientCompressType>(meta_.compress_type());
+  if (platform::is_cpu_place(ctx.GetPlace())) {
+    float* data = tensor->mutable_data<float>(ctx.GetPlace());
+    return DecodeGradient(type, buffer.data(), length, tensor->numel(), data);
+  }
+  // Decode on CPU, then copy to the device.
+  framework::Tensor cpu_tensor;
+  cpu_tensor.Resize(tensor->dims());
+  float* data = cpu_tensor.mutable_data<float>(platform::CPUPlace());
+  if (!DecodeGradient(type, buffer.data(), length, cpu_tensor.numel(),
+                      data)) {
+    return false;
+  }
+  framework::TensorCopySync(cpu_tensor, ctx.GetPlace(), tensor);
+  return true;
+}
+
 bool VariableResponse::CopySelectRowsData(
     ::google::protobuf::io::CodedInputStream* input,
     const platform::DeviceContext& ctx, int length) {
@@ -114,6 +114,11 @@ class VariableResponse {
                          const platform::DeviceContext& ctx,
                          const framework::DDim& dims, int length);
 
+  // Decode the compressed data of length bytes into the resized tensor.
+  bool DecodeTensorData(::google::protobuf::io::CodedInputStream* input,
+                        const platform::DeviceContext& ctx, int length,
+                        framework::Tensor* tensor);
+
   bool ProcSerializedField(int tag,
                            ::google::protobuf::io::CodedInputStream* input,
                            int64_t num_bytes);
@@ -0,0 +1,212 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+// Time the broadcast of elementwise_add and elementwise_mul on CPU, forward
+// and backward, with the row-wise, mid-wise and common kernels that the
+// ops used before and with the N-D kernels of elementwise_broadcast_cpu.h.
+// Report the time of both and the speedup for each shape.
+
+#include <chrono>  // NOLINT
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/operators/elementwise/elementwise_op_function.h"
+#include "paddle/fluid/platform/cpu_helper.h"
+
+DEFINE_int32(repeat, 20, "The number of the runs of each kernel.");
+DEFINE_int32(num_threads, 1, "The number of the intra-op threads.");
+
+namespace paddle {
+namespace operators {
+
+using framework::DDim;
+using framework::Tensor;
+
+struct MulGradDX {
+  float operator()(float x, float y, float out, float dout) const {
+    return dout * y;
+  }
+};
+
+struct MulGradDY {
+  float operator()(float x, float y, float out, float dout) const {
+    return dout * x;
+  }
+};
+
+static double TimeMs(const std::function<void()> &fn) {
+  fn();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < FLAGS_repeat; ++i) fn();
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / FLAGS_repeat;
+}
+
+static void RandomTensor(const DDim &dims, Tensor *t) {
+  static std::mt19937 rng(0);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  float *data = t->mutable_data<float>(dims, platform::CPUPlace());
+  for (int64_t i = 0; i < t->numel(); ++i) data[i] = dist(rng);
+}
+
+class Case {
+ public:
+  Case(const DDim &x_dims, const DDim &y_dims)
+      : x_dims_(x_dims), y_dims_(y_dims) {
+    int max_dim = x_dims.size();
+    int axis = x_dims.size() - y_dims.size();
+    auto y_dims_trimed = trim_trailing_singular_dims(y_dims);
+    int axis_trim = (y_dims_trimed.size() == 0) ? x_dims.size() : axis;
+    get_mid_dims(x_dims, y_dims_trimed, axis_trim, &pre_, &n_, &post_,
+                 &is_run_common_broadcast_);
+    x_dims_array_.resize(max_dim);
+    y_dims_array_.resize(max_dim);
+    out_dims_array_.resize(max_dim);
+    GetBroadcastDimsArrays(x_dims, y_dims, x_dims_array_.data(),
+                           y_dims_array_.data(), out_dims_array_.data(),
+                           max_dim, axis);
+    PADDLE_ENFORCE_EQ(
+        GetCPUBroadcastShape(x_dims, y_dims, axis, false, &shape_), true,
+        platform::errors::InvalidArgument("Unsupported shape."));
+
+    auto out_dims = framework::make_ddim(out_dims_array_);
+    RandomTensor(x_dims, &x_);
+    RandomTensor(y_dims, &y_);
+    RandomTensor(out_dims, &dout_);
+    out_.mutable_data<float>(out_dims, platform::CPUPlace());
+    dx_.mutable_data<float>(x_dims, platform::CPUPlace());
+    dy_.mutable_data<float>(y_dims, platform::CPUPlace());
+  }
+
+  std::string Kernel() const {
+    if (is_run_common_broadcast_) return "common";
+    return post_ == 1 ? "rowwise" : "midwise";
+  }
+
+  template <typename Functor>
+  void OldForward(Functor func) {
+    const float *x = x_.data<float>();
+    const float *y = y_.data<float>();
+    float *out = out_.data<float>();
+    if (is_run_common_broadcast_) {
+      CommonForwardBroadcastCPU<Functor, float>(
+          &x_, &y_, &out_, x_dims_array_.data(), y_dims_array_.data(),
+          out_dims_array_.data(), x_dims_array_.size(), ctx_, func);
+    } else if (post_ == 1) {
+      platform::Transform<platform::CPUDeviceContext> trans;
+      trans(ctx_, x, x + out_.numel(),
+            RowwiseTransformIterator<float, platform::CPUDeviceContext>(y, n_),
+            out, func);
+    } else {
+      platform::Transform<platform::CPUDeviceContext> trans;
+      trans(ctx_, x, x + out_.numel(),
+            MidWiseTransformIterator<float, platform::CPUDeviceContext>(
+                y, n_, post_),
+            out, func);
+    }
+  }
+
+  template <typename Functor>
+  void NewForward(Functor func) {
+    CPUBroadcastForward(ctx_, shape_, x_.data<float>(), y_.data<float>(),
+                        out_.data<float>(), func);
+  }
+
+  void OldGrad() {
+    if (is_run_common_broadcast_) {
+      CommonGradBroadcastCPU<float>(
+          x_, y_, out_, dout_, &dx_, &dy_, x_dims_array_.data(),
+          y_dims_array_.data(), out_dims_array_.data(), x_dims_array_.size(),
+          ctx_, MulGradDX(), MulGradDY());
+    } else if (post_ == 1) {
+      ElemwiseGradBroadcast1CPU(x_.data<float>(), y_.data<float>(),
+                                out_.data<float>(), dout_.data<float>(), pre_,
+                                n_, true, MulGradDX(), MulGradDY(),
+                                dx_.data<float>(), dy_.data<float>());
+    } else {
+      ElemwiseGradBroadcast2CPU(x_.data<float>(), y_.data<float>(),
+                                out_.data<float>(), dout_.data<float>(), pre_,
+                                n_, post_, true, MulGradDX(), MulGradDY(),
+                                dx_.data<float>(), dy_.data<float>());
+    }
+  }
+
+  void NewGrad() {
+    CPUBroadcastGrad<float>(ctx_, shape_, x_.data<float>(), y_.data<float>(),
+                            out_.data<float>(), dout_.data<float>(),
+                            MulGradDX(), MulGradDY(), dx_.numel(),
+                            dx_.data<float>(), dy_.numel(), dy_.data<float>());
+  }
+
+  void Report(const std::string &name, const std::function<void()> &old_fn,
+              const std::function<void()> &new_fn) {
+    double old_ms = TimeMs(old_fn);
+    double new_ms = TimeMs(new_fn);
+    LOG(INFO) << name << " x=[" << x_dims_ << "] y=[" << y_dims_ << "] "
+              << Kernel() << " " << old_ms << " ms, nd " << new_ms
+              << " ms, speedup " << old_ms / new_ms;
+  }
+
+ private:
+  DDim x_dims_;
+  DDim y_dims_;
+  int pre_, n_, post_, is_run_common_broadcast_;
+  std::vector<int> x_dims_array_;
+  std::vector<int> y_dims_array_;
+  std::vector<int> out_dims_array_;
+  CPUBroadcastShape shape_;
+  platform::CPUDeviceContext ctx_;
+  Tensor x_, y_, out_, dout_, dx_, dy_;
+};
+
+void RunBenchmark() {
+  platform::SetNumThreads(FLAGS_num_threads);
+  LOG(INFO) << "num_threads " << FLAGS_num_threads << ", repeat "
+            << FLAGS_repeat;
+  std::vector<std::pair<DDim, DDim>> shapes = {
+      {framework::make_ddim({1024, 4096}), framework::make_ddim({4096})},
+      {framework::make_ddim({32, 64, 56, 56}),
+       framework::make_ddim({64, 1, 1})},
+      {framework::make_ddim({4096, 1024}), framework::make_ddim({4096, 1})},
+      {framework::make_ddim({512, 512}), framework::make_ddim({1})},
+      {framework::make_ddim({64, 128, 256}),
+       framework::make_ddim({64, 1, 256})},
+      {framework::make_ddim({128, 1, 256}),
+       framework::make_ddim({1, 128, 256})},
+      {framework::make_ddim({8, 128, 1, 64}),
+       framework::make_ddim({8, 1, 128, 64})}};
+  for (auto &dims : shapes) {
+    Case c(dims.first, dims.second);
+    c.Report("add", [&] { c.OldForward(AddFunctor<float>()); },
+             [&] { c.NewForward(AddFunctor<float>()); });
+    c.Report("mul", [&] { c.OldForward(MulFunctor<float>()); },
+             [&] { c.NewForward(MulFunctor<float>()); });
+    c.Report("mul_grad", [&] { c.OldGrad(); }, [&] { c.NewGrad(); });
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
+
+int main(int argc, char *argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  paddle::operators::RunBenchmark();
+  return 0;
+}
@@ -0,0 +1,415 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "paddle/fluid/operators/elementwise/elementwise_op_function.cu.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/enforce.h"
+#ifndef __NVCC__
+#include "paddle/fluid/operators/jit/kernels.h"
+#endif
+
+namespace paddle {
+namespace operators {
+
+/*
+ * The broadcast of a binary element-wise op on CPU. The dimensions of Out
+ * of size 1 are dropped, and the adjacent dimensions that X and Y both
+ * broadcast, or both do not, are merged. For example:
+ *   X = (2, 3, 4, 5), Y = (1, 3, 4, 1), Out = (2, 3, 4, 5)
+ * becomes
+ *   dims = (2, 12, 5), x_strides = (60, 5, 1), y_strides = (0, 1, 0)
+ * so that the innermost dimension is a contiguous run of X and Y, or of one
+ * of them against a single element of the other.
+ */
+struct CPUBroadcastShape {
+  std::vector<int64_t> dims;
+  // the strides of X and Y in each merged dimension, 0 where broadcast
+  std::vector<int64_t> x_strides;
+  std::vector<int64_t> y_strides;
+  int64_t numel{1};
+
+  int64_t inner() const { return dims.back(); }
+  // the number of the runs of the innermost dimension
+  int64_t rows() const { return numel / dims.back(); }
+};
+
+// x_dims, y_dims and out_dims are max_dim long, as GetBroadcastDimsArrays
+// gives them.
+inline CPUBroadcastShape MakeCPUBroadcastShape(const int *x_dims,
+                                               const int *y_dims,
+                                               const int *out_dims,
+                                               int max_dim) {
+  CPUBroadcastShape shape;
+  std::vector<bool> x_bcast;
+  std::vector<bool> y_bcast;
+  for (int i = 0; i < max_dim; ++i) {
+    PADDLE_ENFORCE_GT(out_dims[i], 0,
+                      platform::errors::InvalidArgument(
+                          "The broadcast dimension %d of Out is %d.", i,
+                          out_dims[i]));
+    if (out_dims[i] == 1) continue;
+    bool xb = x_dims[i] == 1;
+    bool yb = y_dims[i] == 1;
+    if (!shape.dims.empty() && x_bcast.back() == xb && y_bcast.back() == yb) {
+      shape.dims.back() *= out_dims[i];
+    } else {
+      shape.dims.push_back(out_dims[i]);
+      x_bcast.push_back(xb);
+      y_bcast.push_back(yb);
+    }
+  }
+  if (shape.dims.empty()) {
+    shape.dims.push_back(1);
+    x_bcast.push_back(false);
+    y_bcast.push_back(false);
+  }
+  int rank = shape.dims.size();
+  shape.x_strides.resize(rank);
+  shape.y_strides.resize(rank);
+  int64_t x_stride = 1;
+  int64_t y_stride = 1;
+  for (int i = rank - 1; i >= 0; --i) {
+    shape.x_strides[i] = x_bcast[i] ? 0 : x_stride;
+    shape.y_strides[i] = y_bcast[i] ? 0 : y_stride;
+    if (!x_bcast[i]) x_stride *= shape.dims[i];
+    if (!y_bcast[i]) y_stride *= shape.dims[i];
+    shape.numel *= shape.dims[i];
+  }
+  return shape;
+}
+
+// Walks the rows of a CPUBroadcastShape, the runs of its innermost
+// dimension, from a given row on, tracking the offsets of X and Y.
+class CPUBroadcastRowIterator {
+ public:
+  CPUBroadcastRowIterator(const CPUBroadcastShape &shape, int64_t row)
+      : shape_(shape), index_(shape.dims.size(), 0) {
+    int outer = static_cast<int>(shape.dims.size()) - 1;
+    for (int i = outer - 1; i >= 0; --i) {
+      index_[i] = row % shape.dims[i];
+      row /= shape.dims[i];
+      x_offset_ += index_[i] * shape.x_strides[i];
+      y_offset_ += index_[i] * shape.y_strides[i];
+    }
+  }
+
+  int64_t x_offset() const { return x_offset_; }
+  int64_t y_offset() const { return y_offset_; }
+
+  void Next() {
+    for (int i = static_cast<int>(shape_.dims.size()) - 2; i >= 0; --i) {
+      x_offset_ += shape_.x_strides[i];
+      y_offset_ += shape_.y_strides[i];
+      if (++index_[i] < shape_.dims[i]) return;
+      x_offset_ -= index_[i] * shape_.x_strides[i];
+      y_offset_ -= index_[i] * shape_.y_strides[i];
+      index_[i] = 0;
+    }
+  }
+
+ private:
+  const CPUBroadcastShape &shape_;
+  std::vector<int64_t> index_;
+  int64_t x_offset_{0};
+  int64_t y_offset_{0};
+};
+
+// The jit kernels computing a run of Out = Functor(A, B), nullptr if the
+// functor has none. vector computes out = f(a, b) of two runs, b_scalar
+// out = f(a, *b) and a_scalar out = f(*a, b), the kernels of AXYNTuple
+// taking the scalar first. swap_vector tells to pass b before a.
+template <typename T>
+struct CPUBroadcastJitKernels {
+  typedef void (*VectorFunc)(const T *, const T *, T *, int);
+  VectorFunc vector{nullptr};
+  bool swap_vector{false};
+  VectorFunc b_scalar{nullptr};
+  VectorFunc a_scalar{nullptr};
+};
+
+template <typename Functor, typename T, typename Enable = void>
+struct GetCPUBroadcastJitKernels {
+  CPUBroadcastJitKernels<T> operator()(int n) const {
+    return CPUBroadcastJitKernels<T>();
+  }
+};
+
+#ifndef __NVCC__
+template <typename T>
+using EnableIfJitType = typename std::enable_if<
+    std::is_same<T, float>::value || std::is_same<T, double>::value>::type;
+
+template <typename T>
+struct GetCPUBroadcastJitKernels<AddFunctor<T>, T, EnableIfJitType<T>> {
+  CPUBroadcastJitKernels<T> operator()(int n) const {
+    CPUBroadcastJitKernels<T> kernels;
+    kernels.vector =
+        jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache().At(n);
+    kernels.b_scalar =
+        jit::KernelFuncs<jit::VAddBiasTuple<T>, platform::CPUPlace>::Cache()
+            .At(n);
+    kernels.a_scalar = kernels.b_scalar;
+    return kernels;
+  }
+};
+
+template <typename T>
+struct GetCPUBroadcastJitKernels<InverseAddFunctor<T>, T, EnableIfJitType<T>>
+    : public GetCPUBroadcastJitKernels<AddFunctor<T>, T> {};
+
+template <typename T>
+struct GetCPUBroadcastJitKernels<MulFunctor<T>, T, EnableIfJitType<T>> {
+  CPUBroadcastJitKernels<T> operator()(int n) const {
+    CPUBroadcastJitKernels<T> kernels;
+    kernels.vector =
+        jit::KernelFuncs<jit::VMulTuple<T>, platform::CPUPlace>::Cache().At(n);
+    kernels.b_scalar =
+        jit::KernelFuncs<jit::VScalTuple<T>, platform::CPUPlace>::Cache().At(
+            n);
+    kernels.a_scalar = kernels.b_scalar;
+    return kernels;
+  }
+};
+
+template <typename T>
+struct GetCPUBroadcastJitKernels<InverseMulFunctor<T>, T, EnableIfJitType<T>>
+    : public GetCPUBroadcastJitKernels<MulFunctor<T>, T> {};
+
+template <typename T>
+struct GetCPUBroadcastJitKernels<SubFunctor<T>, T, EnableIfJitType<T>> {
+  CPUBroadcastJitKernels<T> operator()(int n) const {
+    CPUBroadcastJitKernels<T> kernels;
+    kernels.vector =
+        jit::KernelFuncs<jit::VSubTuple<T>, platform::CPUPlace>::Cache().At(n);
+    return kernels;
+  }
+};
+
+template <typename T>
+struct GetCPUBroadcastJitKernels<InverseSubFunctor<T>, T, EnableIfJitType<T>> {
+  CPUBroadcastJitKernels<T> operator()(int n) const {
+    CPUBroadcastJitKernels<T> kernels;
+    kernels.vector =
+        jit::KernelFuncs<jit::VSubTuple<T>, platform::CPUPlace>::Cache().At(n);
+    kernels.swap_vector = true;
+    return kernels;
+  }
+};
+#endif  // __NVCC__
+
+// out[i] = func(a[i * AS], b[i * BS]), the strides are 0 or 1
+template <int AS, int BS, typename Functor, typename T, typename OutType>
+void CPUBroadcastForwardLoop(const T *a, const T *b, OutType *out, int64_t n,
+                             Functor func) {
+  for (int64_t i = 0; i < n; ++i) {
+    out[i] = func(a[i * AS], b[i * BS]);
+  }
+}
+
+// Computes the runs of n elements of out = func(a, b).
+template <typename Functor, typename T, typename OutType>
+class CPUBroadcastForwardRun {
+ public:
+  explicit CPUBroadcastForwardRun(int64_t n) : n_(n) {}
+
+  void operator()(const T *a, const T *b, OutType *out, int64_t a_stride,
+                  int64_t b_stride, Functor func) const {
+    if (a_stride != 0 && b_stride != 0) {
+      CPUBroadcastForwardLoop<1, 1>(a, b, out, n_, func);
+    } else if (a_stride != 0) {
+      CPUBroadcastForwardLoop<1, 0>(a, b, out, n_, func);
+    } else {
+      CPUBroadcastForwardLoop<0, 1>(a, b, out, n_, func);
+    }
+  }
+
+ private:
+  int64_t n_;
+};
+
+template <typename Functor, typename T>
+class CPUBroadcastForwardRun<Functor, T, T> {
+ public:
+  explicit CPUBroadcastForwardRun(int64_t n) : n_(n) {
+    if (n <= std::numeric_limits<int>::max()) {
+      kernels_ = GetCPUBroadcastJitKernels<Functor, T>()(static_cast<int>(n));
+    }
+  }
+
+  void operator()(const T *a, const T *b, T *out, int64_t a_stride,
+                  int64_t b_stride, Functor func) const {
+    int n = static_cast<int>(n_);
+    if (a_stride != 0 && b_stride != 0) {
+      if (kernels_.vector == nullptr) {
+        CPUBroadcastForwardLoop<1, 1>(a, b, out, n_, func);
+      } else if (kernels_.swap_vector) {
+        kernels_.vector(b, a, out, n);
+      } else {
+        kernels_.vector(a, b, out, n);
+      }
+    } else if (a_stride != 0) {
+      if (kernels_.b_scalar == nullptr) {
+        CPUBroadcastForwardLoop<1, 0>(a, b, out, n_, func);
+      } else {
+        kernels_.b_scalar(b, a, out, n);
+      }
+    } else {
+      if (kernels_.a_scalar == nullptr) {
+        CPUBroadcastForwardLoop<0, 1>(a, b, out, n_, func);
+      } else {
+        kernels_.a_scalar(a, b, out, n);
+      }
+    }
+  }
+
+ private:
+  int64_t n_;
+  CPUBroadcastJitKernels<T> kernels_;
+};
+
+// out = func(a, b) for the a and b of shape, a is X and b is Y of the
+// shape. The rows are split onto the intra-op thread pool, and the runs of
+// float and double go to the jit kernels of Add, Sub and Mul.
+template <typename Functor, typename T, typename OutType = T>
+void CPUBroadcastForward(const platform::CPUDeviceContext &ctx,
+                         const CPUBroadcastShape &shape, const T *a,
+                         const T *b, OutType *out, Functor func) {
+  int64_t n = shape.inner();
+  int64_t a_stride = shape.x_strides.back();
+  int64_t b_stride = shape.y_strides.back();
+  CPUBroadcastForwardRun<Functor, T, OutType> run(n);
+  int64_t grain_size = std::max<int64_t>(1, platform::kIntraOpGrainSize / n);
+  ctx.ParallelFor(0, shape.rows(), grain_size, [&](int64_t begin,
+                                                   int64_t end) {
+    CPUBroadcastRowIterator it(shape, begin);
+    for (int64_t row = begin; row < end; ++row, it.Next()) {
+      run(a + it.x_offset(), b + it.y_offset(), out + row * n, a_stride,
+          b_stride, func);
+    }
+  });
+}
+
+template <typename T, typename OP, bool kForX>
+struct CPUBroadcastGradRun {
+  // The d of the operand of kForX, for the run of x[i * XS], y[i * YS].
+  // The run of d is contiguous if the operand is, otherwise the run sums
+  // into its single element.
+  template <int XS, int YS>
+  static void Loop(const T *x, const T *y, const T *out, const T *dout,
+                   int64_t n, bool accumulate, OP op, T *d) {
+    constexpr int DS = kForX ? XS : YS;
+    if (DS == 0) {
+      T sum = static_cast<T>(0);
+      for (int64_t i = 0; i < n; ++i) {
+        sum += op(x[i * XS], y[i * YS], out[i], dout[i]);
+      }
+      *d += sum;
+    } else if (accumulate) {
+      for (int64_t i = 0; i < n; ++i) {
+        d[i * DS] += op(x[i * XS], y[i * YS], out[i], dout[i]);
+      }
+    } else {
+      for (int64_t i = 0; i < n; ++i) {
+        d[i * DS] = op(x[i * XS], y[i * YS], out[i], dout[i]);
+      }
+    }
+  }
+
+  static void Run(const T *x, const T *y, const T *out, const T *dout,
+                  int64_t n, int64_t x_stride, int64_t y_stride,
+                  bool accumulate, OP op, T *d) {
+    if (x_stride != 0 && y_stride != 0) {
+      Loop<1, 1>(x, y, out, dout, n, accumulate, op, d);
+    } else if (x_stride != 0) {
+      Loop<1, 0>(x, y, out, dout, n, accumulate, op, d);
+    } else {
+      Loop<0, 1>(x, y, out, dout, n, accumulate, op, d);
+    }
+  }
+};
+
+// Compute the d of X, or of Y, of shape. A d of the size of Out is written
+// once per element and split onto the intra-op thread pool, as well as a
+// broadcast d whose rows do not overlap. The others are zeroed and summed
+// into by a single thread.
+template <typename T, typename OP, bool kForX>
+void CPUBroadcastGradOne(const platform::CPUDeviceContext &ctx,
+                         const CPUBroadcastShape &shape, const T *x,
+                         const T *y, const T *out, const T *dout, OP op,
+                         int64_t d_numel, T *d) {
+  const auto &d_strides = kForX ? shape.x_strides : shape.y_strides;
+  bool accumulate = d_numel != shape.numel;
+  bool disjoint_rows = true;
+  for (size_t i = 0; i + 1 < d_strides.size(); ++i) {
+    if (d_strides[i] == 0) disjoint_rows = false;
+  }
+  if (accumulate) {
+    std::memset(d, 0, d_numel * sizeof(T));
+  }
+  int64_t n = shape.inner();
+  int64_t x_stride = shape.x_strides.back();
+  int64_t y_stride = shape.y_strides.back();
+  auto run_rows = [&](int64_t begin, int64_t end) {
+    CPUBroadcastRowIterator it(shape, begin);
+    for (int64_t row = begin; row < end; ++row, it.Next()) {
+      int64_t offset = row * n;
+      CPUBroadcastGradRun<T, OP, kForX>::Run(
+          x + it.x_offset(), y + it.y_offset(), out + offset, dout + offset,
+          n, x_stride, y_stride, accumulate, op,
+          d + (kForX ? it.x_offset() : it.y_offset()));
+    }
+  };
+  if (disjoint_rows) {
+    int64_t grain_size =
+        std::max<int64_t>(1, platform::kIntraOpGrainSize / n);
+    ctx.ParallelFor(0, shape.rows(), grain_size, run_rows);
+  } else {
+    run_rows(0, shape.rows());
+  }
+}
+
+// dx and dy of shape, each may be nullptr. A dx or dy smaller than Out
+// must not share the buffer of dout, it is zeroed first.
+template <typename T, typename DX_OP, typename DY_OP>
+void CPUBroadcastGrad(const platform::CPUDeviceContext &ctx,
+                      const CPUBroadcastShape &shape, const T *x, const T *y,
+                      const T *out, const T *dout, DX_OP dx_op, DY_OP dy_op,
+                      int64_t dx_numel, T *dx, int64_t dy_numel, T *dy) {
+  // dx is computed after dy if it shares the buffer of dout.
+  bool dx_last = dx != nullptr && dx == dout;
+  if (dx != nullptr && !dx_last) {
+    CPUBroadcastGradOne<T, DX_OP, true>(ctx, shape, x, y, out, dout, dx_op,
+                                        dx_numel, dx);
+  }
+  if (dy != nullptr) {
+    CPUBroadcastGradOne<T, DY_OP, false>(ctx, shape, x, y, out, dout, dy_op,
+                                         dy_numel, dy);
+  }
+  if (dx_last) {
+    CPUBroadcastGradOne<T, DX_OP, true>(ctx, shape, x, y, out, dout, dx_op,
+                                        dx_numel, dx);
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -23,6 +23,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/memory/malloc.h"
+#include "paddle/fluid/operators/elementwise/elementwise_broadcast_cpu.h"
 #include "paddle/fluid/operators/elementwise/elementwise_op_function.cu.h"
 #include "paddle/fluid/platform/gpu_info.h"
 #include "paddle/fluid/platform/transform.h"
@@ -1194,6 +1195,52 @@ inline framework::DDim trim_trailing_singular_dims(
   return actual_dims;
 }
 
+/*
+ * Get the broadcast of x_dims and y_dims, with the trailing dimensions of
+ * size 1 of the smaller one trimmed as get_mid_dims takes it, for the CPU
+ * kernels. X of the shape is y_dims if swap_xy, otherwise x_dims. Returns
+ * false if Out is empty or the smaller one does not fit at axis, which are
+ * left to the older kernels.
+ */
+inline bool GetCPUBroadcastShape(const framework::DDim &x_dims,
+                                 const framework::DDim &y_dims, int axis,
+                                 bool swap_xy, CPUBroadcastShape *shape) {
+  int max_dim = std::max(x_dims.size(), y_dims.size());
+  bool is_xsize_larger = x_dims.size() >= y_dims.size();
+  auto smaller_dims = trim_trailing_singular_dims(
+      is_xsize_larger ? y_dims : x_dims);
+  if (smaller_dims.size() == 0) {
+    smaller_dims = framework::make_ddim({1});
+    axis = max_dim - 1;
+  }
+  if (axis + smaller_dims.size() > max_dim) return false;
+  const auto &larger_dims = is_xsize_larger ? x_dims : y_dims;
+
+  std::vector<int> x_dims_array(max_dim);
+  std::vector<int> y_dims_array(max_dim);
+  std::vector<int> out_dims_array(max_dim);
+  if (is_xsize_larger) {
+    GetBroadcastDimsArrays(larger_dims, smaller_dims, x_dims_array.data(),
+                           y_dims_array.data(), out_dims_array.data(),
+                           max_dim, axis);
+  } else {
+    GetBroadcastDimsArrays(smaller_dims, larger_dims, x_dims_array.data(),
+                           y_dims_array.data(), out_dims_array.data(),
+                           max_dim, axis);
+  }
+  for (int i = 0; i < max_dim; ++i) {
+    if (out_dims_array[i] <= 0) return false;
+  }
+  if (swap_xy) {
+    *shape = MakeCPUBroadcastShape(y_dims_array.data(), x_dims_array.data(),
+                                   out_dims_array.data(), max_dim);
+  } else {
+    *shape = MakeCPUBroadcastShape(x_dims_array.data(), y_dims_array.data(),
+                                   out_dims_array.data(), max_dim);
+  }
+  return true;
+}
+
 template <typename T, typename DeviceContext>
 class RowwiseTransformIterator;
 
@@ -1710,6 +1757,31 @@ void ElemwiseGradComputeWithBroadcast(
                         "Axis should be less than %d, but received axis is %d.",
                         max_dim, axis));
 
+  CPUBroadcastShape cpu_shape;
+  if (platform::is_cpu_place(ctx.GetPlace()) &&
+      GetCPUBroadcastShape(x_dims, y_dims, axis, false, &cpu_shape)) {
+    // A dx or dy smaller than Out is zeroed before it sums dout, so it can
+    // not be inplace with dout.
+    int64_t dx_numel = framework::product(x_dims);
+    int64_t dy_numel = framework::product(y_dims);
+    if (dx && dx_numel != cpu_shape.numel && dx->IsSharedBufferWith(dout)) {
+      dx->clear();
+      dx->mutable_data<T>(x_dims, ctx.GetPlace());
+    }
+    if (dy && dy_numel != cpu_shape.numel && dy->IsSharedBufferWith(dout)) {
+      dy->clear();
+      dy->mutable_data<T>(y_dims, ctx.GetPlace());
+    }
+    CPUBroadcastGrad<T, DX_OP, DY_OP>(
+        ctx.template device_context<platform::CPUDeviceContext>(), cpu_shape,
+        x.data<T>(), y.data<T>(), out.data<T>(), dout.data<T>(), dx_op, dy_op,
+        dx_numel,
+        dx == nullptr ? nullptr : dx->mutable_data<T>(ctx.GetPlace()),
+        dy_numel,
+        dy == nullptr ? nullptr : dy->mutable_data<T>(ctx.GetPlace()));
+    return;
+  }
+
   int pre, n, post, is_run_common_broadcast, axis_trim = 0;
   if (is_xsize_larger) {
     auto y_dims_trimed = trim_trailing_singular_dims(y_dims);
@@ -1882,6 +1954,19 @@ void ElementwiseComputeEx(const framework::ExecutionContext &ctx,
                         "Axis should be less than %d, but received axis is %d.",
                         max_dim, axis));
 
+  // The functor takes the larger one first, as TransformFunctor does.
+  CPUBroadcastShape cpu_shape;
+  if (platform::is_cpu_place(ctx.GetPlace()) &&
+      GetCPUBroadcastShape(x_dims, y_dims, axis, !is_xsize_larger,
+                           &cpu_shape)) {
+    const T *larger = is_xsize_larger ? x->data<T>() : y->data<T>();
+    const T *smaller = is_xsize_larger ? y->data<T>() : x->data<T>();
+    CPUBroadcastForward<Functor, T, OutType>(
+        ctx.template device_context<platform::CPUDeviceContext>(), cpu_shape,
+        larger, smaller, z->mutable_data<OutType>(ctx.GetPlace()), func);
+    return;
+  }
+
   int pre, n, post, is_run_common_broadcast, axis_trim = 0;
   if (is_xsize_larger) {
     auto y_dims_trimed = trim_trailing_singular_dims(y_dims);
@@ -0,0 +1,234 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/elementwise/elementwise_broadcast_cpu.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/intra_op_thread_pool.h"
+
+namespace paddle {
+namespace operators {
+
+// X and Y of the same rank, with 1 where broadcast.
+struct BroadcastCase {
+  std::vector<int> x_dims;
+  std::vector<int> y_dims;
+};
+
+static std::vector<BroadcastCase> BroadcastCases() {
+  return {{{2, 3, 4, 5}, {1, 3, 4, 1}},   {{2, 3, 4, 5}, {1, 1, 1, 5}},
+          {{2, 3, 4, 5}, {2, 3, 1, 1}},   {{2, 3, 4, 5}, {1, 1, 1, 1}},
+          {{2, 1, 4}, {1, 3, 1}},         {{3, 1}, {1, 4}},
+          {{1, 5}, {4, 5}},               {{2, 3, 1, 5}, {2, 1, 4, 1}},
+          {{6, 1, 7}, {6, 8, 7}},         {{1, 1, 3}, {2, 4, 1}},
+          {{64, 1, 512}, {1, 64, 512}},   {{128, 256}, {128, 1}},
+          {{7, 1, 1, 9}, {1, 5, 6, 1}}};
+}
+
+static std::vector<int> OutDims(const BroadcastCase &c) {
+  std::vector<int> out(c.x_dims.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i] = std::max(c.x_dims[i], c.y_dims[i]);
+  }
+  return out;
+}
+
+static int64_t Numel(const std::vector<int> &dims) {
+  int64_t numel = 1;
+  for (int d : dims) numel *= d;
+  return numel;
+}
+
+// The offsets into X and Y of each element of Out.
+static void ReferenceOffsets(const BroadcastCase &c, std::vector<int64_t> *xs,
+                             std::vector<int64_t> *ys) {
+  auto out_dims = OutDims(c);
+  int rank = out_dims.size();
+  std::vector<int> index(rank, 0);
+  int64_t numel = Numel(out_dims);
+  for (int64_t i = 0; i < numel; ++i) {
+    int64_t x = 0;
+    int64_t y = 0;
+    for (int d = 0; d < rank; ++d) {
+      x = x * c.x_dims[d] + (c.x_dims[d] == 1 ? 0 : index[d]);
+      y = y * c.y_dims[d] + (c.y_dims[d] == 1 ? 0 : index[d]);
+    }
+    xs->push_back(x);
+    ys->push_back(y);
+    for (int d = rank - 1; d >= 0; --d) {
+      if (++index[d] < out_dims[d]) break;
+      index[d] = 0;
+    }
+  }
+}
+
+static CPUBroadcastShape MakeShape(const BroadcastCase &c) {
+  auto out_dims = OutDims(c);
+  return MakeCPUBroadcastShape(c.x_dims.data(), c.y_dims.data(),
+                               out_dims.data(), out_dims.size());
+}
+
+static std::vector<float> RandomVector(int64_t numel, std::mt19937 *rng) {
+  std::uniform_real_distribution<float> dist(0.5f, 2.0f);
+  std::vector<float> v(numel);
+  for (auto &e : v) e = dist(*rng);
+  return v;
+}
+
+TEST(CPUBroadcastShape, MergeDims) {
+  BroadcastCase c{{2, 3, 4, 5}, {1, 3, 4, 1}};
+  auto shape = MakeShape(c);
+  EXPECT_EQ(shape.dims, std::vector<int64_t>({2, 12, 5}));
+  EXPECT_EQ(shape.x_strides, std::vector<int64_t>({60, 5, 1}));
+  EXPECT_EQ(shape.y_strides, std::vector<int64_t>({0, 1, 0}));
+  EXPECT_EQ(shape.numel, 120);
+  EXPECT_EQ(shape.rows(), 24);
+
+  BroadcastCase scalar{{1, 1}, {1, 1}};
+  shape = MakeShape(scalar);
+  EXPECT_EQ(shape.dims, std::vector<int64_t>({1}));
+  EXPECT_EQ(shape.numel, 1);
+}
+
+template <typename Functor>
+static void TestForward(Functor func) {
+  std::mt19937 rng(0);
+  platform::CPUDeviceContext ctx;
+  for (int num_threads : {1, 4}) {
+    platform::IntraOpThreadPool::Instance()->SetNumThreads(num_threads);
+    for (auto &c : BroadcastCases()) {
+      auto x = RandomVector(Numel(c.x_dims), &rng);
+      auto y = RandomVector(Numel(c.y_dims), &rng);
+      std::vector<int64_t> xs, ys;
+      ReferenceOffsets(c, &xs, &ys);
+      std::vector<float> out(xs.size());
+      CPUBroadcastForward(ctx, MakeShape(c), x.data(), y.data(), out.data(),
+                          func);
+      for (size_t i = 0; i < out.size(); ++i) {
+        ASSERT_FLOAT_EQ(out[i], func(x[xs[i]], y[ys[i]]));
+      }
+    }
+  }
+  platform::IntraOpThreadPool::Instance()->SetNumThreads(1);
+}
+
+TEST(CPUBroadcastForward, Functors) {
+  TestForward(AddFunctor<float>());
+  TestForward(InverseAddFunctor<float>());
+  TestForward(SubFunctor<float>());
+  TestForward(InverseSubFunctor<float>());
+  TestForward(MulFunctor<float>());
+  TestForward(InverseMulFunctor<float>());
+  TestForward(DivFunctor<float>());
+  TestForward(InverseDivFunctor<float>());
+}
+
+TEST(CPUBroadcastForward, CompareOutType) {
+  platform::CPUDeviceContext ctx;
+  BroadcastCase c{{3, 1}, {1, 4}};
+  std::vector<int> x = {1, 2, 3};
+  std::vector<int> y = {0, 1, 2, 3};
+  std::vector<int64_t> xs, ys;
+  ReferenceOffsets(c, &xs, &ys);
+  bool out[12];
+  CPUBroadcastForward<std::less<int>, int, bool>(
+      ctx, MakeShape(c), x.data(), y.data(), out, std::less<int>());
+  for (size_t i = 0; i < xs.size(); ++i) {
+    EXPECT_EQ(out[i], x[xs[i]] < y[ys[i]]);
+  }
+}
+
+struct MulGradX {
+  float operator()(float x, float y, float out, float dout) const {
+    return dout * y;
+  }
+};
+
+struct MulGradY {
+  float operator()(float x, float y, float out, float dout) const {
+    return dout * x;
+  }
+};
+
+TEST(CPUBroadcastGrad, Mul) {
+  std::mt19937 rng(0);
+  platform::CPUDeviceContext ctx;
+  for (int num_threads : {1, 4}) {
+    platform::IntraOpThreadPool::Instance()->SetNumThreads(num_threads);
+    for (auto &c : BroadcastCases()) {
+      auto x = RandomVector(Numel(c.x_dims), &rng);
+      auto y = RandomVector(Numel(c.y_dims), &rng);
+      std::vector<int64_t> xs, ys;
+      ReferenceOffsets(c, &xs, &ys);
+      auto dout = RandomVector(xs.size(), &rng);
+      std::vector<float> out(xs.size(), 0.0f);
+      std::vector<double> dx_ref(x.size(), 0.0);
+      std::vector<double> dy_ref(y.size(), 0.0);
+      for (size_t i = 0; i < xs.size(); ++i) {
+        dx_ref[xs[i]] += dout[i] * y[ys[i]];
+        dy_ref[ys[i]] += dout[i] * x[xs[i]];
+      }
+      // Filled with garbage, the grad must not depend on it.
+      std::vector<float> dx(x.size(), 7.0f);
+      std::vector<float> dy(y.size(), 7.0f);
+      CPUBroadcastGrad(ctx, MakeShape(c), x.data(), y.data(), out.data(),
+                       dout.data(), MulGradX(), MulGradY(), dx.size(),
+                       dx.data(), dy.size(), dy.data());
+      for (size_t i = 0; i < dx.size(); ++i) {
+        ASSERT_NEAR(dx[i], dx_ref[i], 1e-4 * std::abs(dx_ref[i]) + 1e-5);
+      }
+      for (size_t i = 0; i < dy.size(); ++i) {
+        ASSERT_NEAR(dy[i], dy_ref[i], 1e-4 * std::abs(dy_ref[i]) + 1e-5);
+      }
+    }
+  }
+  platform::IntraOpThreadPool::Instance()->SetNumThreads(1);
+}
+
+// dx of the size of Out may be inplace with dout.
+TEST(CPUBroadcastGrad, InplaceDX) {
+  std::mt19937 rng(0);
+  platform::CPUDeviceContext ctx;
+  BroadcastCase c{{2, 3, 4, 5}, {1, 3, 1, 5}};
+  auto x = RandomVector(Numel(c.x_dims), &rng);
+  auto y = RandomVector(Numel(c.y_dims), &rng);
+  std::vector<int64_t> xs, ys;
+  ReferenceOffsets(c, &xs, &ys);
+  auto dout = RandomVector(xs.size(), &rng);
+  std::vector<float> dy_ref(y.size(), 0.0f);
+  std::vector<float> dx_ref(x.size());
+  for (size_t i = 0; i < xs.size(); ++i) {
+    dx_ref[xs[i]] = dout[i] * y[ys[i]];
+    dy_ref[ys[i]] += dout[i] * x[xs[i]];
+  }
+  std::vector<float> dy(y.size());
+  CPUBroadcastGrad(ctx, MakeShape(c), x.data(), y.data(), dout.data(),
+                   dout.data(), MulGradX(), MulGradY(), x.size(), dout.data(),
+                   dy.size(), dy.data());
+  for (size_t i = 0; i < x.size(); ++i) {
+    ASSERT_FLOAT_EQ(dout[i], dx_ref[i]);
+  }
+  for (size_t i = 0; i < y.size(); ++i) {
+    ASSERT_NEAR(dy[i], dy_ref[i], 1e-4 * std::abs(dy_ref[i]));
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
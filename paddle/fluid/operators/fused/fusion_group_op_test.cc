@@ -87,13 +87,21 @@ framework::OpDesc* CreateFusionGroupOp(
 }
 
 void PrepareDeviceCode(platform::Place place, std::string func_name,
-                       std::string cuda_kernel_str) {
+                       std::string kernel_str) {
   paddle::platform::DeviceCodePool& pool =
       paddle::platform::DeviceCodePool::Init({place});
 
-  std::unique_ptr<paddle::platform::DeviceCode> code(
-      new paddle::platform::CUDADeviceCode(place, func_name, cuda_kernel_str));
-  code->Compile();
+  std::unique_ptr<paddle::platform::DeviceCode> code;
+  if (platform::is_gpu_place(place)) {
+#ifdef PADDLE_WITH_CUDA
+    code.reset(
+        new paddle::platform::CUDADeviceCode(place, func_name, kernel_str));
+#endif
+  } else {
+    code.reset(
+        new paddle::platform::CPUDeviceCode(place, func_name, kernel_str));
+  }
+  EXPECT_EQ(code->Compile(), true);
   pool.Set(std::move(code));
 }
 
@@ -135,12 +143,15 @@ void TestMain(const std::vector<std::string>& input_names,
               const std::vector<std::string>& output_names, int type,
               const std::vector<std::string>& inputs_data_type,
               const std::vector<std::string>& outs_data_type,
-              std::string func_name, std::string cuda_kernel_str,
-              CPUKernelFunc cpu_kernel_func) {
+              std::string func_name, const platform::Place& place,
+              std::string kernel_str, CPUKernelFunc cpu_kernel_func) {
   // Compile the device code
-  paddle::framework::InitDevices(false, {0});
-  platform::CUDAPlace place = platform::CUDAPlace(0);
-  PrepareDeviceCode(place, func_name, cuda_kernel_str);
+  if (platform::is_gpu_place(place)) {
+    paddle::framework::InitDevices(false, {0});
+  } else {
+    paddle::framework::InitDevices(false, {});
+  }
+  PrepareDeviceCode(place, func_name, kernel_str);
 
   // Create a ProgramDesc that has a fusion_group_op.
   framework::ProgramDesc program;
@@ -176,6 +187,20 @@ void TestMain(const std::vector<std::string>& input_names,
                cpu_kernel_func);
 }
 
+static void ElementwiseCPUKernel0(size_t n, std::vector<void*> args) {
+  float* x = static_cast<float*>(args[0]);
+  float* y = static_cast<float*>(args[1]);
+  float* z = static_cast<float*>(args[2]);
+  for (size_t i = 0; i < n; ++i) {
+    float tmp_0 = x[i];
+    float tmp_1 = y[i];
+    float tmp_2 = tmp_0 + tmp_1;
+    float tmp_3 = tmp_2 > 0 ? tmp_2 : 0;
+    z[i] = tmp_3;
+  }
+}
+
+#ifdef PADDLE_WITH_CUDA
 TEST(FusionGroupOp, elementwise) {
   if (!platform::dynload::HasNVRTC() || !platform::dynload::HasCUDADriver()) {
     return;
@@ -202,28 +227,41 @@ void elementwise_cuda_kernel_0(size_t n, float *x, float* y, float* z) {
   }
 })";
 
-  auto elementwise_cpu_kernel_0 = [](size_t n,
-                                     std::vector<void*> args) -> void {
-    float* x = static_cast<float*>(args[0]);
-    float* y = static_cast<float*>(args[1]);
-    float* z = static_cast<float*>(args[2]);
-    for (size_t i = 0; i < n; ++i) {
-      float tmp_0 = x[i];
-      float tmp_1 = y[i];
-      float tmp_2 = tmp_0 + tmp_1;
-      float tmp_3 = tmp_2 > 0 ? tmp_2 : 0;
-      z[i] = tmp_3;
-    }
-  };
+  std::vector<std::string> inputs_data_type(input_names.size(), "float");
+  std::vector<std::string> outs_data_type(output_names.size(), "float");
+  TestMain(input_names, input_shapes, output_names, 0, inputs_data_type,
+           outs_data_type, "elementwise_cuda_kernel_0",
+           platform::CUDAPlace(0), kernel, ElementwiseCPUKernel0);
+}
+#endif
+
+TEST(FusionGroupOp, elementwise_cpu) {
+  // z = relu(x + y), in the form of platform::CPUDeviceCode.
+  std::vector<std::string> input_names = {"x", "y"};
+  std::vector<std::string> output_names = {"z"};
+  std::vector<std::vector<int64_t>> input_shapes = {{256, 256}, {256, 256}};
+  constexpr auto kernel = R"(
+#include <stdint.h>
+
+extern "C" void elementwise_cpu_kernel_0(int64_t begin, int64_t end,
+                                         void** args) {
+  const float* x = *static_cast<const float* const*>(args[1]);
+  const float* y = *static_cast<const float* const*>(args[2]);
+  float* z = *static_cast<float* const*>(args[3]);
+  for (int64_t i = begin; i < end; ++i) {
+    float tmp_0 = x[i] + y[i];
+    z[i] = tmp_0 > 0 ? tmp_0 : 0;
+  }
+})";
 
   std::vector<std::string> inputs_data_type(input_names.size(), "float");
   std::vector<std::string> outs_data_type(output_names.size(), "float");
   TestMain(input_names, input_shapes, output_names, 0, inputs_data_type,
-           outs_data_type, "elementwise_cuda_kernel_0", kernel,
-           elementwise_cpu_kernel_0);
+           outs_data_type, "elementwise_cpu_kernel_0", platform::CPUPlace(),
+           kernel, ElementwiseCPUKernel0);
 }
 
 }  // namespace operators
 }  // namespace paddle
 
-USE_CUDA_ONLY_OP(fusion_group);
+USE_OP(fusion_group);
@@ -20,6 +20,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/data_type_transform.h"
+#include "paddle/fluid/framework/mapped_params.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/platform/device_context.h"
 
@@ -40,7 +41,14 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                           "The number of variables to be loaded is %d, expect "
                           "it to be greater than 0.",
                           out_var_names.size()));
-    if (!model_from_memory) {
+    bool is_mapped = model_from_memory
+                         ? framework::IsMappedParams(filename.data(),
+                                                     filename.size())
+                         : framework::IsMappedParamsFile(filename);
+    if (is_mapped) {
+      LoadMappedParams(ctx, place, filename, model_from_memory, load_as_fp16,
+                       out_var_names);
+    } else if (!model_from_memory) {
       std::ifstream fin(filename, std::ios::binary);
       PADDLE_ENFORCE_EQ(
           static_cast<bool>(fin), true,
@@ -86,27 +94,7 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
 
       // Get data from fin to tensor
       DeserializeFromStream(*buffer, tensor, dev_ctx);
-
-      auto in_dtype = tensor->type();
-      auto out_dtype =
-          load_as_fp16 ? framework::proto::VarType::FP16 : in_dtype;
-
-      if (in_dtype != out_dtype) {
-        // convert to float16 tensor
-        auto in_kernel_type = framework::OpKernelType(in_dtype, place);
-        auto out_kernel_type = framework::OpKernelType(out_dtype, place);
-        framework::LoDTensor fp16_tensor;
-        // copy LoD info to the new tensor
-        fp16_tensor.set_lod(tensor->lod());
-        framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
-                                 &fp16_tensor);
-
-        // reset output tensor
-        out_vars[i]->Clear();
-        tensor = out_vars[i]->GetMutable<framework::LoDTensor>();
-        tensor->set_lod(fp16_tensor.lod());
-        tensor->ShareDataWith(fp16_tensor);
-      }
+      ConvertToFP16IfNeeded(place, load_as_fp16, out_vars[i]);
     }
     buffer->peek();
     PADDLE_ENFORCE_EQ(buffer->eof(), true,
@@ -114,6 +102,57 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                           "Not allowed to load partial data via "
                           "load_combine_op, please use load_op instead."));
   }
+
+  // The mapped params layout is detected by its header, the CPU tensors
+  // share the file mapping instead of reading and copying it.
+  void LoadMappedParams(const framework::ExecutionContext &context,
+                        const platform::Place &place,
+                        const std::string &filename, bool model_from_memory,
+                        bool load_as_fp16,
+                        const std::vector<std::string> &out_var_names) const {
+    auto out_vars = context.MultiOutputVar("Out");
+    std::vector<framework::LoDTensor *> tensors;
+    for (size_t i = 0; i < out_var_names.size(); i++) {
+      PADDLE_ENFORCE_NOT_NULL(
+          out_vars[i], platform::errors::InvalidArgument(
+                           "The variable %s to be loaded cannot be found.",
+                           out_var_names[i]));
+      tensors.push_back(out_vars[i]->GetMutable<framework::LoDTensor>());
+    }
+    if (model_from_memory) {
+      framework::LoadMappedParamsBuffer(filename.data(), filename.size(),
+                                        tensors, place);
+    } else {
+      framework::LoadMappedParamsFile(filename, tensors, place);
+    }
+    for (auto *var : out_vars) {
+      ConvertToFP16IfNeeded(place, load_as_fp16, var);
+    }
+  }
+
+  void ConvertToFP16IfNeeded(const platform::Place &place, bool load_as_fp16,
+                             framework::Variable *var) const {
+    auto *tensor = var->GetMutable<framework::LoDTensor>();
+    auto in_dtype = tensor->type();
+    auto out_dtype = load_as_fp16 ? framework::proto::VarType::FP16 : in_dtype;
+
+    if (in_dtype != out_dtype) {
+      // convert to float16 tensor
+      auto in_kernel_type = framework::OpKernelType(in_dtype, place);
+      auto out_kernel_type = framework::OpKernelType(out_dtype, place);
+      framework::LoDTensor fp16_tensor;
+      // copy LoD info to the new tensor
+      fp16_tensor.set_lod(tensor->lod());
+      framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
+                               &fp16_tensor);
+
+      // reset output tensor
+      var->Clear();
+      tensor = var->GetMutable<framework::LoDTensor>();
+      tensor->set_lod(fp16_tensor.lod());
+      tensor->ShareDataWith(fp16_tensor);
+    }
+  }
 };
 
 }  // namespace operators
@@ -65,8 +65,25 @@ class LookupSparseTableOp : public framework::OperatorBase {
     out_t->mutable_data(cpu, w_t->value().type());
     PADDLE_ENFORCE_EQ(w_t->value().type(), framework::proto::VarType::FP32,
                       "The sparse table only support FP32");
-    w_t->Get(ids_t, out_t, true, is_test);
+    auto shrink_interval = Attr<int64_t>("shrink_interval");
+    // The policy is set on every lookup, a table restored from a checkpoint
+    // keeps its row statistics but takes the policy of the attributes.
+    if (shrink_interval > 0) {
+      framework::SparseTablePolicy policy;
+      policy.min_frequency = Attr<int64_t>("min_frequency");
+      policy.ttl_steps = Attr<int64_t>("ttl_steps");
+      policy.count_decay = Attr<float>("count_decay");
+      policy.min_count = Attr<int64_t>("min_count");
+      policy.init_range = Attr<float>("init_range");
+      w_t->SetPolicy(policy);
+    }
+    int64_t step = w_t->Get(ids_t, out_t, true, is_test);
     out_t->set_lod(ids_t.lod());
+    // Only the lookup advancing the table to the end of the interval
+    // shrinks it, each step is returned to a single lookup.
+    if (shrink_interval > 0 && step > 0 && step % shrink_interval == 0) {
+      w_t->Shrink();
+    }
   }
 };
 
@@ -96,6 +113,35 @@ class LookupSparseTableOpMaker : public framework::OpProtoAndCheckerMaker {
                   "In test mode, lookup_sparse_table will "
                   "return a 0 for unknown id")
         .SetDefault(false);
+    AddAttr<int64_t>("shrink_interval",
+                     "(int64, default 0) "
+                     "Shrink the table every shrink_interval lookups by the "
+                     "admission and eviction attributes below, 0 keeps every "
+                     "row and ignores them.")
+        .SetDefault(0);
+    AddAttr<int64_t>("min_frequency",
+                     "(int64, default 1) "
+                     "A new id gets a row when it is looked up this many "
+                     "times, the lookups before return 0.")
+        .SetDefault(1);
+    AddAttr<int64_t>("ttl_steps",
+                     "(int64, default 0) "
+                     "Evict the rows not looked up in the last ttl_steps "
+                     "lookups, 0 never expires a row.")
+        .SetDefault(0);
+    AddAttr<float>("count_decay",
+                   "(float, default 1.0) "
+                   "Multiply the hit counts of the rows by it on shrinking.")
+        .SetDefault(1.0f);
+    AddAttr<int64_t>("min_count",
+                     "(int64, default 0) "
+                     "Evict the rows whose decayed hit count is below it.")
+        .SetDefault(0);
+    AddAttr<float>("init_range",
+                   "(float, default 0.0) "
+                   "The freed rows are filled uniformly in "
+                   "[-init_range, init_range] for the new ids.")
+        .SetDefault(0.0f);
     AddComment(R"DOC(
 Lookup Sprase Tablel Operator.
 
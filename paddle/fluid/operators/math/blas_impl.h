@@ -482,12 +482,12 @@ void Blas<platform::CPUDeviceContext>::VADD(int n, const T *x, const T *y,
 #ifdef PADDLE_WITH_MKLML
   CBlas<T>::VADD(n, x, y, z);
 #else
-  if (x == z) {
-    this->template AXPY<T>(n, 1., y, z);
-  } else {
-    this->template VCOPY<T>(n, y, z);
-    this->template AXPY<T>(n, 1., x, z);
-  }
+  context_.ParallelFor(0, n, platform::kIntraOpGrainSize,
+                       [=](int64_t begin, int64_t end) {
+                         for (int64_t i = begin; i < end; ++i) {
+                           z[i] = x[i] + y[i];
+                         }
+                       });
 #endif
 }
 
@@ -499,9 +499,12 @@ void Blas<platform::CPUDeviceContext>::VSUB(int n, const T *x, const T *y,
   CBlas<T>::VSUB(n, x, y, z);
 #else
   // try to find if openblas support vsub
-  for (int i = 0; i < n; ++i) {
-    z[i] = x[i] - y[i];
-  }
+  context_.ParallelFor(0, n, platform::kIntraOpGrainSize,
+                       [=](int64_t begin, int64_t end) {
+                         for (int64_t i = begin; i < end; ++i) {
+                           z[i] = x[i] - y[i];
+                         }
+                       });
 #endif
 }
 
@@ -513,9 +516,12 @@ void Blas<platform::CPUDeviceContext>::VMUL(int n, const T *x, const T *y,
   CBlas<T>::VMUL(n, x, y, z);
 #else
   // try to find if openblas support vmul
-  for (int i = 0; i < n; ++i) {
-    z[i] = x[i] * y[i];
-  }
+  context_.ParallelFor(0, n, platform::kIntraOpGrainSize,
+                       [=](int64_t begin, int64_t end) {
+                         for (int64_t i = begin; i < end; ++i) {
+                           z[i] = x[i] * y[i];
+                         }
+                       });
 #endif
 }
 
@@ -527,9 +533,12 @@ void Blas<platform::CPUDeviceContext>::VDIV(int n, const T *x, const T *y,
   CBlas<T>::VDIV(n, x, y, z);
 #else
   // try to find if openblas support vdiv
-  for (int i = 0; i < n; ++i) {
-    z[i] = x[i] / y[i];
-  }
+  context_.ParallelFor(0, n, platform::kIntraOpGrainSize,
+                       [=](int64_t begin, int64_t end) {
+                         for (int64_t i = begin; i < end; ++i) {
+                           z[i] = x[i] / y[i];
+                         }
+                       });
 #endif
 }
 
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #pragma once
+#include <memory>
+
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/selected_rows.h"
@@ -122,8 +124,18 @@ class SGDOpKernel<platform::CPUDeviceContext, T>
       const auto *lr = learning_rate->data<T>();
       const auto *grad_data = grad.value().data<T>();
       auto *out_data = param_out->mutable_value()->data<T>();
+      // With a policy, the rows not admitted or evicted are skipped, and
+      // the rows are not moved by Shrink() during the update.
+      bool has_policy = param_out->has_policy();
+      std::unique_ptr<framework::AutoRDLock> lock;
+      if (has_policy) {
+        lock.reset(new framework::AutoRDLock(param_out->shrink_lock()));
+      }
       for (size_t i = 0; i < grad.rows().size(); i++) {
-        int64_t id_index = param_out->AutoGrownIndex(grad.rows()[i], false);
+        int64_t id_index =
+            has_policy ? param_out->GetIndexFromId(grad.rows()[i])
+                       : param_out->AutoGrownIndex(grad.rows()[i], false);
+        if (id_index < 0 && has_policy) continue;
         PADDLE_ENFORCE_GE(id_index, static_cast<int64_t>(0),
                           "id should be in the table");
         for (int64_t j = 0; j < grad_row_width; j++) {
@@ -15,6 +15,7 @@ limitations under the License. */
 #include "paddle/fluid/operators/recurrent_op.h"
 
 #include <algorithm>
+#include "paddle/fluid/framework/scope_pool.h"
 #include "paddle/fluid/string/string_helper.h"
 
 namespace paddle {
@@ -42,24 +43,26 @@ const char RecurrentBase::kInitStateGrads[] = "initial_states" GRAD_SUFFIX;
 
 static void ClearStepScopes(const platform::DeviceContext &dev_ctx,
                             framework::Scope *parent_scope,
+                            const framework::BlockDesc *block,
                             StepScopeVar *step_scopes) {
   if (step_scopes->empty()) return;
 
   dev_ctx.Wait();
 
+  auto &scope_pool = framework::StepScopePool::Instance();
   for (auto *sub_scope : *step_scopes) {
-    if (parent_scope->HasKid(sub_scope)) {
-      parent_scope->DeleteScope(sub_scope);
-    }
+    scope_pool.Release(*parent_scope, block, sub_scope);
   }
 
   step_scopes->clear();
 }
 
 StepScopes::StepScopes(const platform::DeviceContext &dev_ctx,
-                       const framework::Scope &parent, StepScopeVar *scopes,
+                       const framework::Scope &parent,
+                       const framework::BlockDesc *block, StepScopeVar *scopes,
                        bool is_train, size_t seq_len, bool is_backward)
     : counter_(is_backward ? seq_len - 1 : 0UL),
+      block_(block),
       scopes_(scopes),
       is_train_(is_train),
       is_backward_(is_backward) {
@@ -68,10 +71,15 @@ StepScopes::StepScopes(const platform::DeviceContext &dev_ctx,
                     platform::errors::PreconditionNotMet(
                         "Cannot backward when is not training"));
   if (!is_backward_) {
-    ClearStepScopes(dev_ctx, const_cast<framework::Scope *>(&parent), scopes);
+    PADDLE_ENFORCE_NOT_NULL(
+        block, platform::errors::InvalidArgument(
+                   "The step block of forward StepScopes is nullptr."));
+    ClearStepScopes(dev_ctx, const_cast<framework::Scope *>(&parent), block,
+                    scopes);
+    auto &scope_pool = framework::StepScopePool::Instance();
     scopes->reserve(static_cast<size_t>(num_step_scopes));
     for (size_t i = 0; i < num_step_scopes; ++i) {
-      scopes->emplace_back(&parent.NewScope());
+      scopes->emplace_back(&scope_pool.Acquire(parent, *block));
     }
   }
 }
@@ -89,7 +97,8 @@ void StepScopes::BackwardNext(const platform::DeviceContext &dev_ctx,
                     platform::errors::PreconditionNotMet(
                         "Cannot get backward next scope when is forward"));
   if (counter_ + 2 == scopes_->size()) {
-    parent_scope->DeleteScope((*scopes_)[counter_ + 1]);
+    framework::StepScopePool::Instance().Release(*parent_scope, block_,
+                                                 (*scopes_)[counter_ + 1]);
     scopes_->pop_back();
     VLOG(3) << "Deleted scope at " << counter_ + 1;
   }
@@ -241,7 +250,6 @@ void RecurrentOp::RunImpl(const framework::Scope &scope,
 
     // Link inside::output -> outside::output
     //   outside::output[seq_offset: seq_offset + 1] = inside::output
-    executor.CreateVariables(ctx->prog_, &cur_scope, ctx->block_id_);
     if (i > 0) {
       LinkTensorWithCallback(scope, Outputs(kOutputs), cur_scope,
                              Outputs(kOutputs),
@@ -283,8 +291,9 @@ StepScopes RecurrentOp::CreateStepScopes(const platform::DeviceContext &dev_ctx,
   auto *var = scope.FindVar(Output(kStepScopes));
   PADDLE_ENFORCE_NOT_NULL(var, platform::errors::InvalidArgument(
                                    "RecurrentOp gets empty StepScopes var"));
-  return StepScopes(dev_ctx, scope, var->GetMutable<StepScopeVar>(),
-                    Attr<bool>(kIsTrain), seq_len);
+  return StepScopes(dev_ctx, scope, Attr<framework::BlockDesc *>(kStepBlock),
+                    var->GetMutable<StepScopeVar>(), Attr<bool>(kIsTrain),
+                    seq_len);
 }
 
 RecurrentGradOp::RecurrentGradOp(const std::string &type,
@@ -493,7 +502,8 @@ void RecurrentGradOp::RunImpl(const framework::Scope &scope,
                           platform::errors::InvalidArgument(
                               "StepScopes var is empty in RecurrentGradOp"));
   auto *step_scopes = var->GetMutable<StepScopeVar>();
-  ClearStepScopes(dev_ctx, const_cast<framework::Scope *>(&scope), step_scopes);
+  ClearStepScopes(dev_ctx, const_cast<framework::Scope *>(&scope),
+                  ForwardStepBlock(), step_scopes);
 }
 
 StepScopes RecurrentGradOp::CreateStepScopes(
@@ -503,8 +513,14 @@ StepScopes RecurrentGradOp::CreateStepScopes(
   PADDLE_ENFORCE_NOT_NULL(var,
                           platform::errors::InvalidArgument(
                               "StepScopes var is empty in RecurrentGradOp"));
-  return StepScopes(dev_ctx, scope, var->GetMutable<StepScopeVar>(),
-                    Attr<bool>(kIsTrain), seq_len, true /*is_backward*/);
+  return StepScopes(dev_ctx, scope, ForwardStepBlock(),
+                    var->GetMutable<StepScopeVar>(), Attr<bool>(kIsTrain),
+                    seq_len, true /*is_backward*/);
+}
+
+const framework::BlockDesc *RecurrentGradOp::ForwardStepBlock() const {
+  auto *block = Attr<framework::BlockDesc *>(kStepBlock);
+  return block->ForwardBlockID() >= 0 ? block->ForwardBlock() : nullptr;
 }
 
 std::unordered_set<std::string> RecurrentGradOp::List2Set(
@@ -36,10 +36,14 @@ namespace operators {
 //   reversely access scopes, delete useless ex-scope
 // else
 //   access scopes from beginning to end
+//
+// The scopes are taken from and given back to framework::StepScopePool for
+// the step block of RecurrentOp.
 class StepScopes {
  public:
   StepScopes(const platform::DeviceContext &dev_ctx,
              const framework::Scope &parent,
+             const framework::BlockDesc *block,
              std::vector<framework::Scope *> *scopes, bool is_train,
              size_t seq_len, bool is_backward = false);
 
@@ -61,6 +65,7 @@ class StepScopes {
   framework::Scope &GetScope(size_t scope_id) const;
 
   size_t counter_;
+  const framework::BlockDesc *block_;
   std::vector<framework::Scope *> *scopes_;
   bool is_train_;
   bool is_backward_;
@@ -229,6 +234,9 @@ class RecurrentGradOp : public RecurrentBase {
                               const framework::Scope &scope,
                               size_t seq_len) const;
 
+  // The step block of RecurrentOp, for which the step scopes were acquired.
+  const framework::BlockDesc *ForwardStepBlock() const;
+
   std::unordered_set<std::string> List2Set(
       const std::vector<std::string> &list) const;
 
@@ -60,11 +60,10 @@ struct ReduceKernelFunctor {
       // Flatten and reduce 1-D tensor
       auto x = EigenVector<OutT>::Flatten(*input);
       auto out = EigenScalar<OutT>::From(*output);
-      auto& place =
-          *context.template device_context<DeviceContext>().eigen_device();
       auto reduce_dim = Eigen::array<int, 1>({{0}});
-      Functor functor;
-      functor(place, &x, &out, reduce_dim);
+      VisitReduceFunctor<Functor>(
+          context.template device_context<DeviceContext>(), input->numel(),
+          &x, &out, reduce_dim);
     } else {
       int ndim = input->dims().size();
       int rdim = dims.size();
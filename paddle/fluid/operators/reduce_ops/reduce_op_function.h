@@ -32,6 +32,51 @@ template <typename T, int MajorType = Eigen::RowMajor,
           typename IndexType = Eigen::DenseIndex>
 using EigenVector = framework::EigenVector<T, MajorType, IndexType>;
 
+// Evaluate a reduce functor on the Eigen device given by
+// platform::VisitEigenDevice.
+template <typename Functor, typename X, typename Y, typename Dim>
+struct ReduceEigenVisitor {
+  ReduceEigenVisitor(X* x, Y* y, const Dim& dim) : x(x), y(y), dim(dim) {}
+
+  template <typename Device>
+  void operator()(const Device& place) const {
+    Functor functor;
+    functor(place, x, y, dim);
+  }
+
+  X* x;
+  Y* y;
+  const Dim& dim;
+};
+
+template <typename Functor, typename X, typename Y, typename DX, typename DY,
+          typename Dim>
+struct ReduceGradEigenVisitor {
+  ReduceGradEigenVisitor(X* x, Y* y, DX* dx, DY* dy, const Dim& dim, int size)
+      : x(x), y(y), dx(dx), dy(dy), dim(dim), size(size) {}
+
+  template <typename Device>
+  void operator()(const Device& place) const {
+    Functor functor;
+    functor(place, x, y, dx, dy, dim, size);
+  }
+
+  X* x;
+  Y* y;
+  DX* dx;
+  DY* dy;
+  const Dim& dim;
+  int size;
+};
+
+template <typename Functor, typename DeviceContext, typename X, typename Y,
+          typename Dim>
+void VisitReduceFunctor(const DeviceContext& context, int64_t numel, X* x,
+                        Y* y, const Dim& dim) {
+  ReduceEigenVisitor<Functor, X, Y, Dim> visitor(x, y, dim);
+  platform::VisitEigenDevice(context, numel, &visitor);
+}
+
 template <typename DeviceContext, typename T, size_t D, size_t R_D,
           typename Functor>
 void ReduceFunctor(const DeviceContext& context, const framework::Tensor& input,
@@ -57,15 +102,12 @@ void ReduceFunctor(const DeviceContext& context, const framework::Tensor& input,
                       dims_vector.end());
     out_dims = framework::make_ddim(dims_vector);
   }
-  auto& place = *context.eigen_device();
-  Functor functor;
-
   if (D == 1) {
     auto out = EigenScalar<T>::From(*output);
-    functor(place, &x, &out, reduce_dim);
+    VisitReduceFunctor<Functor>(context, input.numel(), &x, &out, reduce_dim);
   } else {
     auto out = EigenTensor<T, (D - R_D)>::From(*output, out_dims);
-    functor(place, &x, &out, reduce_dim);
+    VisitReduceFunctor<Functor>(context, input.numel(), &x, &out, reduce_dim);
   }
 }
 
@@ -98,11 +140,12 @@ void ReduceGradFunctor(const DeviceContext& context,
   auto x_reduce = EigenTensor<T, D>::From(input1, reduced_dims);
   auto x_reduce_grad = EigenTensor<T, D>::From(input2, reduced_dims);
 
-  auto& place = *context.eigen_device();
-
-  Functor functor;
-  functor(place, &x, &x_reduce, &x_grad, &x_reduce_grad, broadcast_dim,
-          broad_cats_times);
+  ReduceGradEigenVisitor<Functor, decltype(x), decltype(x_reduce),
+                         decltype(x_grad), decltype(x_reduce_grad),
+                         decltype(broadcast_dim)>
+      visitor(&x, &x_reduce, &x_grad, &x_reduce_grad, broadcast_dim,
+              broad_cats_times);
+  platform::VisitEigenDevice(context, input0.numel(), &visitor);
 }
 
 }  // namespace operators
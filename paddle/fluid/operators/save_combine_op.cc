@@ -75,6 +75,12 @@ to a file on disk.
                   "(boolean, default false)"
                   "If true, the variables will be saved to binary strings.")
         .SetDefault(false);
+    AddAttr<bool>("save_as_mapped",
+                  "(boolean, default false)"
+                  "If true, the variables will be saved in the mapped params "
+                  "layout, whose aligned payloads are mapped by "
+                  "load_combine_op without copying.")
+        .SetDefault(false);
     AddOutput("Y",
               "(RAW, default empty)."
               "This output is used when saving variables to binary strings.")
@@ -15,15 +15,19 @@ limitations under the License. */
 #pragma once
 
 #include <stdint.h>
+#include <cstdio>
 #include <fstream>
 #include <numeric>
+#include <random>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/data_type_transform.h"
 #include "paddle/fluid/framework/framework.pb.h"
 #include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/mapped_params.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/port.h"
@@ -39,6 +43,7 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     auto overwrite = ctx.Attr<bool>("overwrite");
     auto save_as_fp16 = ctx.Attr<bool>("save_as_fp16");
     auto save_to_memory = ctx.Attr<bool>("save_to_memory");
+    auto save_as_mapped = ctx.Attr<bool>("save_as_mapped");
     auto output = ctx.Output<std::string>("Y");
 
     bool is_present = FileExists(filename);
@@ -62,6 +67,11 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     platform::DeviceContextPool &pool = platform::DeviceContextPool::Instance();
     auto &dev_ctx = *pool.Get(place);
 
+    // The converted fp16 tensors of the mapped params layout, which are
+    // written after all of them are collected.
+    std::vector<framework::LoDTensor> fp16_tensors(inp_var_names.size());
+    std::vector<const framework::LoDTensor *> mapped_tensors;
+
     for (size_t i = 0; i < inp_var_names.size(); i++) {
       PADDLE_ENFORCE_NOT_NULL(
           inp_vars[i],
@@ -84,15 +94,25 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
       if (in_dtype != out_dtype) {
         auto in_kernel_type = framework::OpKernelType(in_dtype, place);
         auto out_kernel_type = framework::OpKernelType(out_dtype, place);
-        framework::LoDTensor out;
+        framework::LoDTensor &out = fp16_tensors[i];
         // copy LoD info to the new tensor
         out.set_lod(tensor.lod());
         framework::TransDataType(in_kernel_type, out_kernel_type, tensor, &out);
-        framework::SerializeToStream(ss, out, dev_ctx);
+        if (save_as_mapped) {
+          mapped_tensors.push_back(&out);
+        } else {
+          framework::SerializeToStream(ss, out, dev_ctx);
+        }
+      } else if (save_as_mapped) {
+        mapped_tensors.push_back(&tensor);
       } else {
         framework::SerializeToStream(ss, tensor, dev_ctx);
       }
     }
+    if (save_as_mapped) {
+      framework::SerializeToMappedParams(ss, inp_var_names, mapped_tensors,
+                                         dev_ctx);
+    }
     if (save_to_memory) {
       PADDLE_ENFORCE_NE(output, nullptr,
                         platform::errors::InvalidArgument(
@@ -100,12 +120,31 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
       *output = ss.str();
     } else {
       MkDirRecursively(DirName(filename).c_str());
-      std::ofstream fout(filename, std::ios::binary);
+      // Write a new file and rename it into place. load_combine maps the
+      // file, and a mapping of a file truncated or overwritten in place
+      // faults, while the old file stays intact for its mappings.
+      std::string tmp_filename =
+          filename + ".tmp" + std::to_string(std::random_device()());
+      std::ofstream fout(tmp_filename, std::ios::binary);
       PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
                         platform::errors::Unavailable(
                             "Cannot open %s to save variables.", filename));
       fout << ss.str();
       fout.close();
+      if (!fout) {
+        std::remove(tmp_filename.c_str());
+        PADDLE_THROW(platform::errors::Unavailable(
+            "Cannot write the variables to %s.", filename));
+      }
+#ifdef _WIN32
+      // No mapping on Windows, and rename does not replace a file.
+      std::remove(filename.c_str());
+#endif
+      if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+        std::remove(tmp_filename.c_str());
+        PADDLE_THROW(platform::errors::Unavailable(
+            "Cannot rename the saved variables to %s.", filename));
+      }
     }
   }
 };
@@ -344,3 +344,63 @@ TEST(SaveLoadTestWithCombineOp, CPU) {
     }
   }
 }
+
+// Save in the mapped params layout, load_combine_op maps the payloads of the
+// file as the tensor holders.
+TEST(SaveLoadMappedCombineOp, CPU) {
+  paddle::framework::Scope scope;
+  paddle::platform::CPUPlace place;
+
+  std::vector<int> lod1 = {0, 1, 2, 3, 10};
+  int numel1 = 100;
+  paddle::framework::LoD expect_lod1;
+  int* expect1 = CreateForSaveCombineOp<int, int>(10, 10, lod1, "test_var1",
+                                                  place, &scope, &expect_lod1);
+
+  std::vector<int> lod2 = {0, 2, 5, 10};
+  int numel2 = 39;
+  paddle::framework::LoD expect_lod2;
+  float* expect2 = CreateForSaveCombineOp<float, float>(
+      13, 3, lod2, "test_var2", place, &scope, &expect_lod2);
+
+  paddle::framework::AttributeMap attrs;
+  attrs.insert({"file_path", std::string("check_mapped_tensor.ls")});
+  paddle::framework::AttributeMap save_attrs = attrs;
+  save_attrs.insert({"save_as_mapped", true});
+
+  auto save_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "save_combine", {{"X", {"test_var1", "test_var2"}}}, {}, save_attrs);
+  save_combine_op->Run(scope, place);
+
+  auto target1 = GeneratePlaceholderBeforeLoad("out_var1", &scope);
+  auto target2 = GeneratePlaceholderBeforeLoad("out_var2", &scope);
+  auto load_combine_op = paddle::framework::OpRegistry::CreateOp(
+      "load_combine", {}, {{"Out", {"out_var1", "out_var2"}}}, attrs);
+  load_combine_op->Run(scope, place);
+
+  paddle::framework::LoD actual_lod1, actual_lod2;
+  int* actual1 = GetValuesAfterLoadCombineOp<int>(target1, scope, &actual_lod1);
+  float* actual2 =
+      GetValuesAfterLoadCombineOp<float>(target2, scope, &actual_lod2);
+  CheckValues<int, int>(expect1, actual1, expect_lod1, actual_lod1, numel1);
+  CheckValues<float, float>(expect2, actual2, expect_lod2, actual_lod2,
+                            numel2);
+  // The payloads are aligned in the mapping.
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(actual1) % 64, 0UL);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(actual2) % 64, 0UL);
+
+  // Writing a mapped tensor only changes its private page.
+  actual1[0] = -1;
+  load_combine_op->Run(scope, place);
+  EXPECT_EQ(target1->data<int>()[0], expect1[0]);
+
+  // Saving to the file again replaces it, the loaded tensors still map the
+  // old one.
+  int old_value = expect1[0];
+  expect1[0] = old_value + 1;
+  save_combine_op->Run(scope, place);
+  EXPECT_EQ(target1->data<int>()[0], old_value);
+  EXPECT_EQ(target2->data<float>()[numel2 - 1], expect2[numel2 - 1]);
+  load_combine_op->Run(scope, place);
+  EXPECT_EQ(target1->data<int>()[0], old_value + 1);
+}
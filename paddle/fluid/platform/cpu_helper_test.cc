@@ -15,8 +15,16 @@ limitations under the License. */
 #include "paddle/fluid/platform/cpu_helper.h"
 
 #include "gtest/gtest.h"
+#include "paddle/fluid/platform/intra_op_thread_pool.h"
 
 TEST(CpuHelper, SetNumThread) {
+  // Only the math library is set, the intra-op thread pool is sized on its
+  // own.
+  auto* pool = paddle::platform::IntraOpThreadPool::Instance();
+  pool->SetNumThreads(2);
   paddle::platform::SetNumThreads(1);
+  EXPECT_EQ(pool->NumThreads(), 2);
   paddle::platform::SetNumThreads(4);
+  EXPECT_EQ(pool->NumThreads(), 2);
+  pool->SetNumThreads(1);
 }
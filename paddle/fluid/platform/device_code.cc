@@ -14,13 +14,37 @@ limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
 #include <sys/stat.h>
+#ifndef _WIN32
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
 #include <set>
 #include <utility>
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/intra_op_thread_pool.h"
 
 DECLARE_string(cuda_dir);
 
+DEFINE_string(cpu_device_code_compiler, "c++",
+              "The compiler of the generated CPU kernels, such as those of "
+              "fusion_group.");
+DEFINE_string(cpu_device_code_flags,
+              "-std=c++11 -O3 -march=native -fopenmp-simd -fPIC -shared",
+              "The compiling flags of the generated CPU kernels.");
+DEFINE_string(cpu_device_code_cache_dir, "",
+              "The directory caching the compiled CPU kernels, which can be "
+              "shared by the processes of the same user running the same "
+              "programs. It must be owned by the user and not writable by "
+              "the others. If empty, $XDG_CACHE_HOME/paddle_cpu_device_code "
+              "or $HOME/.cache/paddle_cpu_device_code is used, or a new "
+              "temporary directory of the process without them.");
+
 namespace paddle {
 namespace platform {
 
@@ -64,18 +88,30 @@ DeviceCodePool::DeviceCodePool(const std::vector<platform::Place>& places) {
       places.size(), 0,
       errors::InvalidArgument(
           "Expected the number of places >= 1. Expected %d.", places.size()));
+  AddPlaces(places);
+}
+
+void DeviceCodePool::AddPlaces(const std::vector<platform::Place>& places) {
   // Remove the duplicated places
   std::set<Place> set;
   for (auto& p : places) {
     set.insert(p);
   }
   for (auto& p : set) {
+    if (device_codes_.count(p)) continue;
     if (is_gpu_place(p)) {
 #ifdef PADDLE_WITH_CUDA
       device_codes_.emplace(p, DeviceCodeMap());
 #else
       PADDLE_THROW(platform::errors::PreconditionNotMet(
           "CUDAPlace is not supported, please re-compile with WITH_GPU=ON."));
+#endif
+    } else if (is_cpu_place(p)) {
+#ifndef _WIN32
+      device_codes_.emplace(p, DeviceCodeMap());
+#else
+      PADDLE_THROW(platform::errors::PreconditionNotMet(
+          "Runtime compiling for CPUPlace is not supported on Windows."));
 #endif
     }
   }
@@ -272,5 +308,190 @@ bool CUDADeviceCode::CheckCUDADriverResult(CUresult result,
 }
 #endif
 
+#ifndef _WIN32
+CPUDeviceCode::CPUDeviceCode(const Place& place, const std::string& name,
+                             const std::string& kernel) {
+  if (!is_cpu_place(place)) {
+    PADDLE_THROW(platform::errors::PermissionDenied(
+        "CPUDeviceCode can only launch on CPU place."));
+  }
+
+  place_ = place;
+  name_ = name;
+  kernel_ = kernel;
+}
+
+CPUDeviceCode::~CPUDeviceCode() {
+  if (handle_ != nullptr) {
+    dlclose(handle_);
+  }
+}
+
+// Run the command, and return its exit status and output.
+static int RunCommand(const std::string& command, std::string* output) {
+  FILE* pipe = popen((command + " 2>&1").c_str(), "r");
+  if (pipe == nullptr) {
+    return -1;
+  }
+  char buffer[256];
+  while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+    output->append(buffer);
+  }
+  return pclose(pipe);
+}
+
+// The cache directory of the user, or a new private one of the process.
+static std::string DefaultCacheDir() {
+  const char* xdg_cache_home = std::getenv("XDG_CACHE_HOME");
+  const char* home = std::getenv("HOME");
+  if (xdg_cache_home != nullptr && xdg_cache_home[0] == '/') {
+    return std::string(xdg_cache_home) + "/paddle_cpu_device_code";
+  }
+  if (home != nullptr && home[0] == '/') {
+    return std::string(home) + "/.cache/paddle_cpu_device_code";
+  }
+  static const std::string tmp_dir = [] {
+    char dir[] = "/tmp/paddle_cpu_device_code_XXXXXX";
+    return mkdtemp(dir) == nullptr ? std::string() : std::string(dir);
+  }();
+  return tmp_dir;
+}
+
+// Create the directory and its missing parents, accessible by the user only.
+static bool MakeDirs(const std::string& dir) {
+  for (size_t pos = dir.find('/', 1); pos != std::string::npos;
+       pos = dir.find('/', pos + 1)) {
+    std::string parent = dir.substr(0, pos);
+    if (mkdir(parent.c_str(), 0700) != 0 && errno != EEXIST) return false;
+  }
+  return mkdir(dir.c_str(), 0700) == 0 || errno == EEXIST;
+}
+
+// Whether path is a directory or a regular file, not a symbolic link, owned
+// by the user and not writable by the others, so that nobody else can plant
+// a library to be loaded.
+static bool IsPrivatePath(const std::string& path, bool is_dir) {
+  struct stat st;
+  if (lstat(path.c_str(), &st) != 0) return false;
+  bool type_ok = is_dir ? S_ISDIR(st.st_mode) : S_ISREG(st.st_mode);
+  if (!type_ok || st.st_uid != geteuid() ||
+      (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+    LOG(WARNING) << path << " is not a " << (is_dir ? "directory" : "file")
+                 << " owned by the user and writable only by the user, the "
+                    "CPU code is not loaded from it.";
+    return false;
+  }
+  return true;
+}
+
+// The CPU the libraries are compiled for, -march=native code can not run on
+// the other CPUs sharing the cache.
+static const std::string& TargetCpu() {
+  static const std::string cpu = [] {
+    std::string cpu;
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+      if (line.empty()) break;  // The end of the first processor.
+      if (line.compare(0, 10, "model name") == 0 ||
+          line.compare(0, 9, "vendor_id") == 0 ||
+          line.compare(0, 5, "flags") == 0 ||
+          line.compare(0, 8, "Features") == 0) {
+        cpu += line + "\n";
+      }
+    }
+    return cpu;
+  }();
+  return cpu;
+}
+
+bool CPUDeviceCode::Compile(bool include_path) {
+  if (is_compiled_) {
+    return true;
+  }
+
+  std::string dir = FLAGS_cpu_device_code_cache_dir.empty()
+                        ? DefaultCacheDir()
+                        : FLAGS_cpu_device_code_cache_dir;
+  if (dir.empty() || !MakeDirs(dir)) {
+    LOG(WARNING) << "Cannot create the cache directory " << dir
+                 << " for compiling of CPU code.";
+    return false;
+  }
+  if (!IsPrivatePath(dir, true)) {
+    return false;
+  }
+  std::string command =
+      FLAGS_cpu_device_code_compiler + " " + FLAGS_cpu_device_code_flags;
+  size_t hash =
+      std::hash<std::string>()(command + "\n" + TargetCpu() + kernel_);
+  std::string lib_path =
+      dir + "/" + name_ + "_" + std::to_string(hash) + ".so";
+
+  struct stat st;
+  if (stat(lib_path.c_str(), &st) != 0) {
+    // Build into the files of this process and rename the library into the
+    // cache, the processes sharing the cache never load a partial one.
+    std::string tmp_path = lib_path + "." + std::to_string(getpid());
+    std::string src_path = tmp_path + ".cc";
+    {
+      std::ofstream src(src_path);
+      src << kernel_;
+      if (!src) {
+        LOG(WARNING) << "Cannot write the CPU code to " << src_path;
+        return false;
+      }
+    }
+    command += " " + src_path + " -o " + tmp_path;
+    std::string log;
+    int status = RunCommand(command, &log);
+    std::remove(src_path.c_str());
+    // The library must not be writable by the others to be loaded, whatever
+    // the umask is.
+    if (status != 0 || chmod(tmp_path.c_str(), 0700) != 0 ||
+        std::rename(tmp_path.c_str(), lib_path.c_str()) != 0) {
+      LOG(WARNING) << "JIT compiling of CPU code failed:"
+                   << "\n  Kernel name: " << name_ << "\n  Kernel body:\n"
+                   << kernel_ << "\n  Command: " << command
+                   << "\n  Compiling log: " << log;
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+
+  if (!IsPrivatePath(lib_path, false)) {
+    return false;
+  }
+  handle_ = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle_ == nullptr) {
+    LOG(WARNING) << "Call dlopen failed: " << dlerror();
+    return false;
+  }
+  function_ = reinterpret_cast<KernelFunc>(dlsym(handle_, name_.c_str()));
+  if (function_ == nullptr) {
+    LOG(WARNING) << "Call dlsym failed: " << dlerror();
+    return false;
+  }
+
+  is_compiled_ = true;
+  return true;
+}
+
+void CPUDeviceCode::Launch(const size_t n, std::vector<void*>* args) const {
+  PADDLE_ENFORCE_EQ(
+      is_compiled_, true,
+      errors::PreconditionNotMet(
+          "Please compile the code before launching the kernel."));
+
+  KernelFunc function = function_;
+  void** data = args->data();
+  IntraOpThreadPool::Instance()->ParallelFor(
+      0, static_cast<int64_t>(n), kIntraOpGrainSize,
+      [function, data](int64_t begin, int64_t end) {
+        function(begin, end, data);
+      });
+}
+#endif
+
 }  // namespace platform
 }  // namespace paddle
@@ -70,6 +70,31 @@ class CUDADeviceCode : public DeviceCode {
 };
 #endif
 
+#ifndef _WIN32
+// Compiles the kernel for the host with the system compiler into a shared
+// library, cached in FLAGS_cpu_device_code_cache_dir by the hash of the code,
+// the compiling command and the host CPU. Only the libraries in a directory
+// private to the user are loaded. The kernel should be
+//   extern "C" void name(int64_t begin, int64_t end, void** args)
+// computing the elements [begin, end) of the args given to Launch, it is
+// called on the ranges of [0, n) on the intra-op thread pool.
+class CPUDeviceCode : public DeviceCode {
+ public:
+  explicit CPUDeviceCode(const Place& place, const std::string& name,
+                         const std::string& kernel);
+  ~CPUDeviceCode();
+  bool Compile(bool include_path = false) override;
+  void Launch(const size_t n, std::vector<void*>* args) const override;
+
+ private:
+  using KernelFunc = void (*)(int64_t, int64_t, void**);
+
+  bool is_compiled_{false};
+  void* handle_{nullptr};
+  KernelFunc function_{nullptr};
+};
+#endif
+
 class DeviceCodePool {
  public:
   using DeviceCodeMap =
@@ -88,6 +113,8 @@ class DeviceCodePool {
   static DeviceCodePool& Init(const std::vector<platform::Place>& places) {
     if (pool == nullptr) {
       pool = new DeviceCodePool(places);
+    } else {
+      pool->AddPlaces(places);
     }
     return *pool;
   }
@@ -106,6 +133,8 @@ class DeviceCodePool {
   }
 
  private:
+  void AddPlaces(const std::vector<platform::Place>& places);
+
   static DeviceCodePool* pool;
   std::map<Place, DeviceCodeMap> device_codes_;
   DISABLE_COPY_AND_ASSIGN(DeviceCodePool);
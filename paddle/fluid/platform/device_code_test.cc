@@ -13,11 +13,16 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
+#include <sys/stat.h>
+#include <cstdlib>
+#include <string>
 #include <utility>
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/platform/init.h"
 
+DECLARE_string(cpu_device_code_cache_dir);
+
 constexpr auto saxpy_code = R"(
 extern "C" __global__
 void saxpy_kernel(float a, float *x, float* y, float* z, size_t n) {
@@ -108,3 +113,90 @@ TEST(DeviceCodePool, cuda) {
   LOG(INFO) << "get ptr: " << code_get;
 }
 #endif
+
+constexpr auto cpu_saxpy_code = R"(
+#include <stdint.h>
+extern "C" void cpu_saxpy_kernel(int64_t begin, int64_t end, void** args) {
+  float a = *static_cast<float*>(args[0]);
+  const float* x = *static_cast<float**>(args[1]);
+  const float* y = *static_cast<float**>(args[2]);
+  float* z = *static_cast<float**>(args[3]);
+  for (int64_t i = begin; i < end; ++i) {
+    z[i] = a * x[i] + y[i];
+  }
+}
+)";
+
+TEST(DeviceCode, cpu) {
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceCode code(place, "cpu_saxpy_kernel",
+                                       cpu_saxpy_code);
+
+  float scale = 2;
+  auto dims = paddle::framework::make_ddim(
+      {static_cast<int64_t>(256), static_cast<int64_t>(1024)});
+  paddle::framework::Tensor x;
+  paddle::framework::Tensor y;
+  paddle::framework::Tensor z;
+  float* x_data = x.mutable_data<float>(dims, place);
+  float* y_data = y.mutable_data<float>(dims, place);
+  float* z_data = z.mutable_data<float>(dims, place);
+
+  size_t n = x.numel();
+  for (size_t i = 0; i < n; ++i) {
+    x_data[i] = static_cast<float>(i);
+    y_data[i] = static_cast<float>(0.5);
+  }
+
+  // Compiled again, the cached library is loaded.
+  EXPECT_EQ(code.Compile(), true);
+  paddle::platform::CPUDeviceCode cached_code(place, "cpu_saxpy_kernel",
+                                              cpu_saxpy_code);
+  EXPECT_EQ(cached_code.Compile(), true);
+
+  std::vector<void*> args = {&scale, &x_data, &y_data, &z_data};
+  cached_code.Launch(n, &args);
+  for (size_t i = 0; i < n; i++) {
+    EXPECT_EQ(z_data[i], static_cast<float>(i) * scale + 0.5);
+  }
+
+  paddle::platform::CPUDeviceCode wrong_code(place, "wrong_kernel",
+                                             "wrong code");
+  EXPECT_EQ(wrong_code.Compile(), false);
+}
+
+TEST(DeviceCode, cpu_cache_dir) {
+  paddle::platform::CPUPlace place;
+  char dir[] = "/tmp/device_code_test_XXXXXX";
+  ASSERT_NE(mkdtemp(dir), nullptr);
+  std::string cache_dir = FLAGS_cpu_device_code_cache_dir;
+  FLAGS_cpu_device_code_cache_dir = dir;
+
+  // Nothing is loaded from a directory writable by the others.
+  ASSERT_EQ(chmod(dir, 0777), 0);
+  paddle::platform::CPUDeviceCode shared_code(place, "cpu_saxpy_kernel",
+                                              cpu_saxpy_code);
+  EXPECT_EQ(shared_code.Compile(), false);
+
+  ASSERT_EQ(chmod(dir, 0700), 0);
+  paddle::platform::CPUDeviceCode code(place, "cpu_saxpy_kernel",
+                                       cpu_saxpy_code);
+  EXPECT_EQ(code.Compile(), true);
+
+  FLAGS_cpu_device_code_cache_dir = cache_dir;
+  EXPECT_EQ(std::system((std::string("rm -rf ") + dir).c_str()), 0);
+}
+
+TEST(DeviceCodePool, cpu) {
+  paddle::platform::CPUPlace place;
+  paddle::platform::DeviceCodePool& pool =
+      paddle::platform::DeviceCodePool::Init({place});
+  EXPECT_EQ(pool.size(place), 0UL);
+
+  std::unique_ptr<paddle::platform::DeviceCode> code(
+      new paddle::platform::CPUDeviceCode(place, "cpu_saxpy_kernel",
+                                          cpu_saxpy_code));
+  pool.Set(std::move(code));
+  EXPECT_EQ(pool.size(place), 1UL);
+  EXPECT_NE(pool.Get(place, "cpu_saxpy_kernel"), nullptr);
+}
@@ -129,6 +129,17 @@ Eigen::DefaultDevice* CPUDeviceContext::eigen_device() const {
   return eigen_device_.get();
 }
 
+std::shared_ptr<Eigen::ThreadPoolDevice> CPUDeviceContext::eigen_pool_device()
+    const {
+  return IntraOpThreadPool::Instance()->EigenDevice();
+}
+
+void CPUDeviceContext::ParallelFor(
+    int64_t begin, int64_t end, int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& fn) const {
+  IntraOpThreadPool::Instance()->ParallelFor(begin, end, grain_size, fn);
+}
+
 Place CPUDeviceContext::GetPlace() const { return place_; }
 
 #ifdef PADDLE_WITH_CUDA
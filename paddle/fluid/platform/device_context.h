@@ -10,6 +10,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 #pragma once
 
+#include <functional>
 #include <future>  // NOLINT
 #include <memory>
 #include <mutex>  // NOLINT
@@ -37,6 +38,7 @@ limitations under the License. */
 #include <map>
 #include "glog/logging.h"
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/intra_op_thread_pool.h"
 #include "paddle/fluid/platform/place.h"
 #ifdef PADDLE_WITH_CUDA
 #include "paddle/fluid/platform/stream/cuda_stream.h"
@@ -61,6 +63,15 @@ class CPUDeviceContext : public DeviceContext {
 
   Eigen::DefaultDevice* eigen_device() const;
 
+  // The Eigen device of the intra-op thread pool, or nullptr if the pool
+  // has a single thread. See IntraOpThreadPool.
+  std::shared_ptr<Eigen::ThreadPoolDevice> eigen_pool_device() const;
+
+  // Call fn on the ranges of [begin, end) on the intra-op thread pool, each
+  // range is at least grain_size long.
+  void ParallelFor(int64_t begin, int64_t end, int64_t grain_size,
+                   const std::function<void(int64_t, int64_t)>& fn) const;
+
   Place GetPlace() const override;
 
  private:
@@ -68,6 +79,29 @@ class CPUDeviceContext : public DeviceContext {
   std::unique_ptr<Eigen::DefaultDevice> eigen_device_;
 };
 
+// Call (*visitor)(device) with the Eigen device to evaluate an expression of
+// numel elements on. A CPUDeviceContext gives the device of its intra-op
+// thread pool if the expression is worth splitting.
+template <typename DeviceContext, typename Visitor>
+void VisitEigenDevice(const DeviceContext& ctx, int64_t numel,
+                      Visitor* visitor) {
+  (*visitor)(*ctx.eigen_device());
+}
+
+template <typename Visitor>
+void VisitEigenDevice(const CPUDeviceContext& ctx, int64_t numel,
+                      Visitor* visitor) {
+  std::shared_ptr<Eigen::ThreadPoolDevice> pool_device;
+  if (numel > kIntraOpGrainSize) {
+    pool_device = ctx.eigen_pool_device();
+  }
+  if (pool_device != nullptr) {
+    (*visitor)(*pool_device);
+  } else {
+    (*visitor)(*ctx.eigen_device());
+  }
+}
+
 template <typename Place>
 struct DefaultDeviceContextType;
 
@@ -30,6 +30,7 @@ limitations under the License. */
 #endif
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/init.h"
+#include "paddle/fluid/platform/intra_op_thread_pool.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/string/piece.h"
 
@@ -162,6 +163,8 @@ void InitDevices(bool init_p2p, const std::vector<int> devices) {
 #ifndef PADDLE_WITH_MKLDNN
   platform::SetNumThreads(FLAGS_paddle_num_threads);
 #endif
+  platform::IntraOpThreadPool::Instance()->SetNumThreads(
+      FLAGS_paddle_num_threads);
 
 #if !defined(_WIN32) && !defined(__APPLE__) && !defined(__OSX__)
   if (platform::MayIUse(platform::avx)) {
@@ -0,0 +1,168 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/intra_op_thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#include "paddle/fluid/platform/dynload/mklml.h"
+#endif
+
+namespace paddle {
+namespace platform {
+
+namespace {
+
+thread_local bool in_parallel_for = false;
+
+class ParallelForGuard {
+ public:
+  ParallelForGuard() : prev_(in_parallel_for) { in_parallel_for = true; }
+  ~ParallelForGuard() { in_parallel_for = prev_; }
+
+ private:
+  bool prev_;
+};
+
+// Run the math library single-threaded in the threads of the pool, the
+// pool already uses the cores it was given.
+void LimitMathLibraryThreads() {
+  static thread_local bool limited = false;
+  if (limited) return;
+  limited = true;
+#ifdef PADDLE_WITH_MKLML
+  platform::dynload::MKL_Set_Num_Threads_Local(1);
+  omp_set_num_threads(1);
+#endif
+}
+
+}  // namespace
+
+struct IntraOpThreadPool::Pool {
+  explicit Pool(int num_threads)
+      : num_threads(num_threads),
+        threads(num_threads - 1),
+        device(&threads, num_threads) {}
+
+  int num_threads;
+  Eigen::ThreadPool threads;
+  Eigen::ThreadPoolDevice device;
+};
+
+IntraOpThreadPool* IntraOpThreadPool::Instance() {
+  static IntraOpThreadPool instance;
+  return &instance;
+}
+
+void IntraOpThreadPool::SetNumThreads(int num_threads) {
+  num_threads = std::max(num_threads, 1);
+  std::shared_ptr<Pool> old;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (num_threads == NumThreadsLocked()) return;
+  old = std::move(pool_);
+  if (num_threads > 1) {
+    pool_ = std::make_shared<Pool>(num_threads);
+  }
+}
+
+void IntraOpThreadPool::EnsureNumThreads(int num_threads) {
+  std::shared_ptr<Pool> old;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (num_threads <= NumThreadsLocked()) return;
+  old = std::move(pool_);
+  pool_ = std::make_shared<Pool>(num_threads);
+}
+
+int IntraOpThreadPool::NumThreads() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return NumThreadsLocked();
+}
+
+int IntraOpThreadPool::NumThreadsLocked() const {
+  return pool_ == nullptr ? 1 : pool_->num_threads;
+}
+
+std::shared_ptr<IntraOpThreadPool::Pool> IntraOpThreadPool::GetPool() const {
+  if (InParallelRegion()) return nullptr;
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pool_;
+}
+
+std::shared_ptr<Eigen::ThreadPoolDevice> IntraOpThreadPool::EigenDevice()
+    const {
+  auto pool = GetPool();
+  if (pool == nullptr) return nullptr;
+  return std::shared_ptr<Eigen::ThreadPoolDevice>(pool, &pool->device);
+}
+
+void IntraOpThreadPool::ParallelFor(
+    int64_t begin, int64_t end, int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& fn) const {
+  if (begin >= end) return;
+  int64_t numel = end - begin;
+  grain_size = std::max<int64_t>(grain_size, 1);
+  std::shared_ptr<Pool> pool;
+  if (numel > grain_size) {
+    pool = GetPool();
+  }
+  int64_t num_tasks =
+      pool == nullptr
+          ? 1
+          : std::min<int64_t>(pool->num_threads, numel / grain_size);
+  if (num_tasks <= 1) {
+    ParallelForGuard guard;
+    fn(begin, end);
+    return;
+  }
+
+  std::vector<std::exception_ptr> errors(num_tasks);
+  auto run = [&](int64_t task) {
+    ParallelForGuard guard;
+    try {
+      fn(begin + numel * task / num_tasks,
+         begin + numel * (task + 1) / num_tasks);
+    } catch (...) {
+      errors[task] = std::current_exception();
+    }
+  };
+  Eigen::Barrier barrier(static_cast<unsigned int>(num_tasks - 1));
+  for (int64_t task = 1; task < num_tasks; ++task) {
+    pool->threads.Schedule([&run, &barrier, task] {
+      LimitMathLibraryThreads();
+      run(task);
+      barrier.Notify();
+    });
+  }
+  run(0);
+  barrier.Wait();
+  for (auto& error : errors) {
+    if (error != nullptr) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+bool IntraOpThreadPool::InParallelRegion() {
+#ifdef PADDLE_WITH_MKLML
+  if (omp_in_parallel()) return true;
+#endif
+  return in_parallel_for;
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -0,0 +1,84 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+
+// EIGEN_USE_THREADS is defined for the whole build in configure.cmake, the
+// ThreadPoolDevice is only declared with it.
+#include "unsupported/Eigen/CXX11/Tensor"
+
+namespace paddle {
+namespace platform {
+
+// The CPU kernels of an op split the loops over the elements of a
+// tensor shorter than this into no more parts.
+constexpr int64_t kIntraOpGrainSize = 1 << 14;
+
+// The threads that the CPU kernels split their element-wise loops and their
+// Eigen expressions onto, shared by the whole process. It is sized once,
+// from FLAGS_paddle_num_threads by InitDevices() or from the config of the
+// inference predictors, and not by platform::SetNumThreads(), which only
+// sets the threads of the math library of the calling thread and is called
+// around every inference run. The threads of the pool run the math library
+// with a single thread, and the pool runs everything in the calling thread
+// inside an OpenMP parallel region, so the two never multiply. The pool has
+// a single thread, the caller, until it is sized with more.
+class IntraOpThreadPool {
+ public:
+  static IntraOpThreadPool* Instance();
+
+  // The calling thread counts as one of the num_threads. A new pool is
+  // started if the number changes, the running ParallelFor() finish on the
+  // old one.
+  void SetNumThreads(int num_threads);
+  // Grow the pool to num_threads if it has fewer, so that the predictors
+  // sharing the pool never shrink it under each other.
+  void EnsureNumThreads(int num_threads);
+  int NumThreads() const;
+
+  // The Eigen device evaluating on the pool, kept alive by the returned
+  // pointer. nullptr if the pool has a single thread, or the caller already
+  // runs in a parallel region.
+  std::shared_ptr<Eigen::ThreadPoolDevice> EigenDevice() const;
+
+  // Split [begin, end) into at most NumThreads() ranges of at least
+  // grain_size elements, and call fn(range_begin, range_end) for each of
+  // them on the pool. Block until all the calls return, and rethrow the
+  // first exception thrown by them. The calls made inside fn run in the
+  // calling thread.
+  void ParallelFor(int64_t begin, int64_t end, int64_t grain_size,
+                   const std::function<void(int64_t, int64_t)>& fn) const;
+
+  // Whether the calling thread runs a part of a ParallelFor(), or in an
+  // OpenMP parallel region.
+  static bool InParallelRegion();
+
+ private:
+  struct Pool;
+
+  IntraOpThreadPool() = default;
+  int NumThreadsLocked() const;
+  std::shared_ptr<Pool> GetPool() const;
+
+  mutable std::mutex mutex_;
+  std::shared_ptr<Pool> pool_;
+};
+
+}  // namespace platform
+}  // namespace paddle
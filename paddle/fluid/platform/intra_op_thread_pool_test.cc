@@ -0,0 +1,130 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/intra_op_thread_pool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace platform {
+
+TEST(IntraOpThreadPool, SingleThread) {
+  auto* pool = IntraOpThreadPool::Instance();
+  pool->SetNumThreads(1);
+  EXPECT_EQ(pool->EigenDevice(), nullptr);
+  auto caller = std::this_thread::get_id();
+  int calls = 0;
+  pool->ParallelFor(0, 1000, 1, [&](int64_t begin, int64_t end) {
+    EXPECT_EQ(std::this_thread::get_id(), caller);
+    EXPECT_EQ(begin, 0);
+    EXPECT_EQ(end, 1000);
+    EXPECT_TRUE(IntraOpThreadPool::InParallelRegion());
+    ++calls;
+  });
+  EXPECT_EQ(calls, 1);
+  EXPECT_FALSE(IntraOpThreadPool::InParallelRegion());
+}
+
+TEST(IntraOpThreadPool, ParallelFor) {
+  auto* pool = IntraOpThreadPool::Instance();
+  pool->SetNumThreads(4);
+  EXPECT_EQ(pool->NumThreads(), 4);
+
+  std::vector<std::atomic<int>> visits(1003);
+  for (auto& v : visits) v = 0;
+  std::atomic<int> calls{0};
+  pool->ParallelFor(3, 1003, 100, [&](int64_t begin, int64_t end) {
+    EXPECT_GE(end - begin, 100);
+    for (int64_t i = begin; i < end; ++i) ++visits[i];
+    ++calls;
+  });
+  for (int i = 0; i < 3; ++i) EXPECT_EQ(visits[i], 0);
+  for (int i = 3; i < 1003; ++i) EXPECT_EQ(visits[i], 1);
+  EXPECT_EQ(calls, 4);
+
+  // The grain size limits the number of the ranges.
+  calls = 0;
+  pool->ParallelFor(0, 250, 100, [&](int64_t, int64_t) { ++calls; });
+  EXPECT_EQ(calls, 2);
+
+  // The nested calls run in the calling thread.
+  calls = 0;
+  pool->ParallelFor(0, 4, 1, [&](int64_t begin, int64_t end) {
+    EXPECT_EQ(pool->EigenDevice(), nullptr);
+    auto caller = std::this_thread::get_id();
+    pool->ParallelFor(0, 1000, 1, [&](int64_t, int64_t) {
+      EXPECT_EQ(std::this_thread::get_id(), caller);
+      ++calls;
+    });
+  });
+  EXPECT_EQ(calls, 4);
+  pool->SetNumThreads(1);
+}
+
+TEST(IntraOpThreadPool, EnsureNumThreads) {
+  auto* pool = IntraOpThreadPool::Instance();
+  pool->SetNumThreads(1);
+  pool->EnsureNumThreads(3);
+  EXPECT_EQ(pool->NumThreads(), 3);
+  auto device = pool->EigenDevice();
+  // A smaller number keeps the pool.
+  pool->EnsureNumThreads(2);
+  pool->EnsureNumThreads(0);
+  EXPECT_EQ(pool->NumThreads(), 3);
+  EXPECT_EQ(pool->EigenDevice(), device);
+  pool->SetNumThreads(1);
+}
+
+TEST(IntraOpThreadPool, Exception) {
+  auto* pool = IntraOpThreadPool::Instance();
+  pool->SetNumThreads(4);
+  EXPECT_THROW(pool->ParallelFor(0, 4, 1,
+                                 [](int64_t begin, int64_t end) {
+                                   if (begin == 2) {
+                                     throw std::runtime_error("range 2");
+                                   }
+                                 }),
+               std::runtime_error);
+  // The pool still works.
+  std::atomic<int> calls{0};
+  pool->ParallelFor(0, 4, 1, [&](int64_t, int64_t) { ++calls; });
+  EXPECT_EQ(calls, 4);
+  pool->SetNumThreads(1);
+}
+
+TEST(IntraOpThreadPool, EigenDevice) {
+  auto* pool = IntraOpThreadPool::Instance();
+  pool->SetNumThreads(3);
+  auto device = pool->EigenDevice();
+  ASSERT_NE(device, nullptr);
+  // The device outlives a resize of the pool.
+  pool->SetNumThreads(2);
+
+  Eigen::Tensor<float, 1> x(100000);
+  Eigen::Tensor<float, 1> y(100000);
+  x.setConstant(2.0f);
+  y.device(*device) = x * x + 1.0f;
+  Eigen::Tensor<float, 0> sum;
+  sum.device(*device) = y.sum();
+  EXPECT_FLOAT_EQ(sum(), 500000.0f);
+  pool->SetNumThreads(1);
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -34,7 +34,8 @@ namespace platform {
 // Transform applys a unary or a binary functor on each element in a
 // range defined by a pair of iterators.
 //
-// - The specialization for CPU calls std::transform.
+// - The specialization for CPU calls std::transform, on the intra-op thread
+//   pool for the ranges of plain pointers.
 // - The specialization for CUDA calls thrust::tranform.
 //
 // NOTE: We need to define InputIter and OutputIter defined as
@@ -74,6 +75,30 @@ struct Transform<platform::CPUDeviceContext> {
                   BinaryOperation op) {
     std::transform(first1, last1, first2, result, op);
   }
+
+  // The ranges of plain pointers are split onto the intra-op thread pool.
+  template <typename InputType, typename OutputType, typename UnaryOperation>
+  void operator()(const platform::CPUDeviceContext& context,
+                  InputType* first, InputType* last, OutputType* result,
+                  UnaryOperation op) {
+    context.ParallelFor(0, last - first, kIntraOpGrainSize,
+                        [&](int64_t begin, int64_t end) {
+                          std::transform(first + begin, first + end,
+                                         result + begin, op);
+                        });
+  }
+
+  template <typename InputType1, typename InputType2, typename OutputType,
+            typename BinaryOperation>
+  void operator()(const platform::CPUDeviceContext& context,
+                  InputType1* first1, InputType1* last1, InputType2* first2,
+                  OutputType* result, BinaryOperation op) {
+    context.ParallelFor(0, last1 - first1, kIntraOpGrainSize,
+                        [&](int64_t begin, int64_t end) {
+                          std::transform(first1 + begin, first1 + end,
+                                         first2 + begin, result + begin, op);
+                        });
+  }
 };
 
 #ifdef __NVCC__
@@ -181,6 +181,14 @@ class IterableDatasetWrapper {
 };
 
 void BindDataset(py::module *m) {
+  py::class_<framework::FileReadStats>(*m, "FileReadStats")
+      .def_readonly("path", &framework::FileReadStats::path)
+      .def_readonly("bytes", &framework::FileReadStats::bytes)
+      .def_readonly("open_seconds", &framework::FileReadStats::open_seconds)
+      .def_readonly("read_seconds", &framework::FileReadStats::read_seconds)
+      .def_readonly("stall_seconds", &framework::FileReadStats::stall_seconds)
+      .def_readonly("stalls", &framework::FileReadStats::stalls);
+
   py::class_<framework::Dataset, std::unique_ptr<framework::Dataset>>(*m,
                                                                       "Dataset")
       .def(py::init([](const std::string &name = "MultiSlotDataset") {
@@ -291,6 +299,16 @@ void BindDataset(py::module *m) {
            py::call_guard<py::gil_scoped_release>())
       .def("set_fleet_send_sleep_seconds",
            &framework::Dataset::SetFleetSendSleepSeconds,
+           py::call_guard<py::gil_scoped_release>())
+      .def("set_streaming_shuffle", &framework::Dataset::SetStreamingShuffle,
+           py::call_guard<py::gil_scoped_release>())
+      .def("wait_shuffle_done", &framework::Dataset::WaitShuffleDone,
+           py::call_guard<py::gil_scoped_release>())
+      .def("set_lock_free_channel", &framework::Dataset::SetLockFreeChannel,
+           py::call_guard<py::gil_scoped_release>())
+      .def("set_read_ahead", &framework::Dataset::SetReadAhead,
+           py::call_guard<py::gil_scoped_release>())
+      .def("get_read_stats", &framework::Dataset::GetReadStats,
            py::call_guard<py::gil_scoped_release>());
 
   py::class_<IterableDatasetWrapper>(*m, "IterableDatasetWrapper")
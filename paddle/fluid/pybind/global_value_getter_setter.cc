@@ -42,6 +42,8 @@ DECLARE_bool(enable_parallel_graph);
 DECLARE_string(pe_profile_fname);
 DECLARE_string(print_sub_graph_dir);
 DECLARE_bool(use_ngraph);
+DECLARE_int32(step_scope_pool_size);
+DECLARE_bool(use_execution_frame);
 // memory management
 DECLARE_string(allocator_strategy);
 DECLARE_double(eager_delete_tensor_gb);
@@ -344,7 +346,8 @@ static void RegisterGlobalVarGetterSetter() {
       FLAGS_fuse_parameter_memory_size, FLAGS_init_allocated_mem,
       FLAGS_initial_cpu_memory_in_mb, FLAGS_memory_fraction_of_eager_deletion,
       FLAGS_use_pinned_memory, FLAGS_benchmark, FLAGS_inner_op_parallelism,
-      FLAGS_tracer_profile_fname, FLAGS_paddle_num_threads);
+      FLAGS_tracer_profile_fname, FLAGS_paddle_num_threads,
+      FLAGS_step_scope_pool_size, FLAGS_use_execution_frame);
 
 #ifdef PADDLE_WITH_CUDA
   REGISTER_PUBLIC_GLOBAL_VAR(
@@ -2189,7 +2189,9 @@ All parameter, weight, gradient are variables in Paddle.
           R"DOC((bool, optional): Whether to enable fusing subgraph to a
                 fusion_group. Now we only support fusing subgraph that composed
                 of elementwise-like operators, such as elementwise_add/mul
-                without broadcast and activations.
+                without broadcast and activations. The fused kernels are
+                compiled with NVRTC on GPU, and with the system compiler on
+                CPU, see FLAGS_cpu_device_code_compiler.
 
                 Examples:
                     .. code-block:: python
@@ -92,6 +92,25 @@ class DatasetBase(object):
         """
         self.proto_desc.pipe_command = pipe_command
 
+    def set_data_format(self, data_format):
+        """
+        Set the format of the data files, "text" for the MultiSlot text
+        lines, or "binary" for the binary columnar files converted from
+        them, which are loaded without parsing the text.
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+              dataset.set_data_format("binary")
+
+        Args:
+            data_format(str): "text" or "binary", default is "text"
+
+        """
+        self.proto_desc.data_format = data_format
+
     def set_rank_offset(self, rank_offset):
         """
         Set rank_offset for merge_pv. It set the message of Pv.
@@ -346,6 +365,12 @@ class InMemoryDataset(DatasetBase):
         self.enable_pv_merge = False
         self.merge_by_lineid = False
         self.fleet_send_sleep_seconds = None
+        self.streaming_shuffle = False
+        self.streaming_channel_capacity = 0
+        self.lock_free_channel = False
+        self.read_ahead_file_num = 0
+        self.read_ahead_chunk_num = 0
+        self.read_ahead_chunk_size = 0
 
     def set_feed_type(self, data_feed_type):
         """
@@ -369,17 +394,22 @@ class InMemoryDataset(DatasetBase):
         self.dataset.set_parse_logkey(self.parse_logkey)
         self.dataset.set_merge_by_sid(self.merge_by_sid)
         self.dataset.set_enable_pv_merge(self.enable_pv_merge)
+        self.dataset.set_lock_free_channel(self.lock_free_channel)
+        self.dataset.set_read_ahead(self.read_ahead_file_num,
+                                    self.read_ahead_chunk_num,
+                                    self.read_ahead_chunk_size)
         self.dataset.set_data_feed_desc(self.desc())
         self.dataset.create_channel()
         self.dataset.create_readers()
 
     def _dynamic_adjust_before_train(self, thread_num):
-        if not self.is_user_set_queue_num:
+        # the channels of a streaming shuffle are filled while training
+        if not self.is_user_set_queue_num and not self.streaming_shuffle:
             self.dataset.dynamic_adjust_channel_num(thread_num, False)
         self.dataset.dynamic_adjust_readers_num(thread_num)
 
     def _dynamic_adjust_after_train(self):
-        if not self.is_user_set_queue_num:
+        if not self.is_user_set_queue_num and not self.streaming_shuffle:
             self.dataset.dynamic_adjust_channel_num(self.thread_num, False)
         self.dataset.dynamic_adjust_readers_num(self.thread_num)
 
@@ -575,6 +605,109 @@ class InMemoryDataset(DatasetBase):
         """
         self.fleet_send_sleep_seconds = fleet_send_sleep_seconds
 
+    def set_streaming_shuffle(self, streaming=True, channel_capacity=100000):
+        """
+        Set streaming global shuffle. global_shuffle returns once the data
+        starts to be sent, and the first pass of training reads the data
+        while it is still being received. Each queue holds at most
+        channel_capacity instances, beyond that the receiving trainer makes
+        the senders wait. The following passes read the shuffled data as
+        usual.
+
+        Args:
+            streaming(bool): whether to shuffle in streaming mode.
+            channel_capacity(int): max instance num of each queue while
+                                   streaming. Default is 100000.
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+              dataset.set_streaming_shuffle(True, 100000)
+
+        """
+        self.streaming_shuffle = streaming
+        self.streaming_channel_capacity = channel_capacity
+
+    def set_lock_free_channel(self, lock_free=True):
+        """
+        Set lock-free queues. While training, the queues become bounded
+        lock-free rings, so that many threads reading the same queue do not
+        contend on its lock. The first pass which reads the loaded data
+        without a shuffle, and the first pass of a streaming shuffle, still
+        use the default queues.
+
+        Args:
+            lock_free(bool): whether to use lock-free queues. Default is True.
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+              dataset.set_lock_free_channel(True)
+
+        """
+        self.lock_free_channel = lock_free
+
+    def set_read_ahead(self, file_num, chunk_num=4, chunk_size=1 << 20):
+        """
+        Set read-ahead of load_into_memory and preload_into_memory. file_num
+        I/O threads open the next files of the filelist, and each reads its
+        file into at most chunk_num chunks of chunk_size bytes, so opening
+        the pipe commands and reading the files overlap with the parsing.
+
+        Args:
+            file_num(int): the number of the files read at a time, 0 turns
+                           off read-ahead.
+            chunk_num(int): the max number of the chunks per file.
+                            Default is 4.
+            chunk_size(int): the bytes of a chunk. Default is 1MB.
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+              dataset.set_read_ahead(8)
+
+        """
+        self.read_ahead_file_num = file_num
+        self.read_ahead_chunk_num = chunk_num
+        self.read_ahead_chunk_size = chunk_size
+
+    def get_read_stats(self):
+        """
+        Get the I/O counters of the files read ahead by the last
+        load_into_memory or preload_into_memory.
+
+        Returns:
+            A list of dicts, one per file, with the path, the bytes, the
+            seconds opening and reading the file, and the seconds and the
+            times the readers waited for its data.
+
+        Examples:
+            .. code-block:: python
+
+              import paddle.fluid as fluid
+              dataset = fluid.DatasetFactory().create_dataset("InMemoryDataset")
+              dataset.set_read_ahead(8)
+              dataset.set_filelist(["a.txt", "b.txt"])
+              dataset.load_into_memory()
+              for stats in dataset.get_read_stats():
+                  print(stats["path"], stats["stall_seconds"])
+
+        """
+        return [{
+            "path": stats.path,
+            "bytes": stats.bytes,
+            "open_seconds": stats.open_seconds,
+            "read_seconds": stats.read_seconds,
+            "stall_seconds": stats.stall_seconds,
+            "stalls": stats.stalls
+        } for stats in self.dataset.get_read_stats()]
+
     def set_merge_by_lineid(self, merge_size=2):
         """
         Set merge by line id, instances of same line id will be merged after
@@ -713,6 +846,12 @@ class InMemoryDataset(DatasetBase):
         self.dataset.set_trainer_num(trainer_num)
         self.dataset.set_fleet_send_batch_size(self.fleet_send_batch_size)
         self.dataset.set_fleet_send_sleep_seconds(self.fleet_send_sleep_seconds)
+        if self.streaming_shuffle and self.merge_by_lineid:
+            raise ValueError(
+                "merge_by_lineid needs all the data, it can not be used "
+                "with the streaming shuffle")
+        self.dataset.set_streaming_shuffle(self.streaming_shuffle,
+                                           self.streaming_channel_capacity)
         if fleet is not None:
             fleet._role_maker.barrier_worker()
         self.dataset.global_shuffle(thread_num)
@@ -44,6 +44,14 @@ class TrainerRuntimeConfig(object):
             "FLAGS_communicator_send_wait_times", "5")
         self.runtime_configs['communicator_is_sgd_optimizer'] = os.getenv(
             "FLAGS_communicator_is_sgd_optimizer", "1")
+        # none, fp16, topk or int8
+        self.runtime_configs['communicator_grad_compress_type'] = os.getenv(
+            "FLAGS_communicator_grad_compress_type", "none")
+        self.runtime_configs['communicator_grad_compress_ratio'] = os.getenv(
+            "FLAGS_communicator_grad_compress_ratio", "0.01")
+        self.runtime_configs[
+            'communicator_grad_compress_block_size'] = os.getenv(
+                "FLAGS_communicator_grad_compress_block_size", "256")
 
         # not used 
         self.runtime_configs['rpc_deadline'] = os.getenv("FLAGS_rpc_deadline",
@@ -63,7 +71,10 @@ class TrainerRuntimeConfig(object):
             need_keys = [
                 'communicator_max_merge_var_num',
                 'communicator_send_wait_times', 'communicator_thread_pool_size',
-                'communicator_send_queue_size'
+                'communicator_send_queue_size',
+                'communicator_grad_compress_type',
+                'communicator_grad_compress_ratio',
+                'communicator_grad_compress_block_size'
             ]
         elif self.mode == DistributedMode.GEO:
             mode_str = "GEO"
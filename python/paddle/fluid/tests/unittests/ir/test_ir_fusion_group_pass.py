@@ -72,6 +72,8 @@ class FusionGroupPassTest(PassTest):
         return feeds
 
     def test_check_output(self):
+        self.pass_attrs = {"fusion_group_pass": {"use_gpu": False}}
+        self.check_output_with_place(fluid.CPUPlace())
         if core.is_compiled_with_cuda():
             self.pass_attrs = {"fusion_group_pass": {"use_gpu": True}}
             self.check_output_with_place(fluid.CUDAPlace(0))
@@ -144,6 +146,12 @@ class FusionGroupPassTestFP16(FusionGroupPassTest):
         self.num_fused_ops = 3
         self.fetch_list = [tmp_5, self.grad(tmp_0)]
 
+    def test_check_output(self):
+        # float16 is not fused on CPU.
+        if core.is_compiled_with_cuda():
+            self.pass_attrs = {"fusion_group_pass": {"use_gpu": True}}
+            self.check_output_with_place(fluid.CUDAPlace(0))
+
 
 class FusionGroupPassSumTest(FusionGroupPassTest):
     def build_program(self, dtype):